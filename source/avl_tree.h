@@ -7,6 +7,13 @@
 #include <utility>     // For pair
 #include <iterator>    // For iterator, reverse_iterator
 #include <stdexcept>   // For out_of_range
+#include <type_traits> // For conditional
+#include <cstddef>     // For size_t, ptrdiff_t
+#include <cstdlib>     // For abs
+#include <limits>      // For numeric_limits
+#include <thread>      // For thread, hardware_concurrency
+#include <exception>   // For exception_ptr
+#include <system_error> // For system_error
 #include <cassert>
 
 /**
@@ -14,7 +21,151 @@
  */
 namespace util {
 
-template <typename Key, typename Value, typename Comparator = std::less<Key> >
+/**
+ * Augmentation policies: no_augmentation, order_statistics,
+ *                        monoid_augmentation<Monoid>
+ * Usage: avl_tree<string, int, less<string>, order_statistics> myAVLTree;
+ * -------------------------------------------------------------------------
+ * The fourth template argument of avl_tree chooses what summary of its
+ * subtree each node carries.  A policy supplies a NodeData type that every
+ * node inherits from, and a static update(node) that recomputes that summary
+ * from the node and its children.  The tree calls update everywhere it
+ * recomputes a height, so the summary stays correct through insertion,
+ * erasure and rotations at no extra asymptotic cost.  A policy also names
+ * its aggregate_type, which is void unless it supports aggregate().
+ *
+ * no_augmentation is the default and adds nothing to a node.
+ * order_statistics stores the number of nodes in each subtree, which is what
+ * select, rank, count_range and random-access iterator arithmetic need to
+ * run in O(log n).
+ */
+struct no_augmentation {
+  static const bool kOrderStatistics = false;
+  typedef void aggregate_type;
+
+  struct NodeData {};
+
+  template <typename Node>
+  static void update(Node*) {
+    // Nothing to maintain.
+  }
+};
+
+struct order_statistics {
+  static const bool kOrderStatistics = true;
+  typedef void aggregate_type;
+
+  struct NodeData {
+    /* The number of nodes in the subtree rooted here, this one included. */
+    size_t mCount;
+
+    NodeData() : mCount(1) {
+      // Handled in initializer list.
+    }
+  };
+
+  template <typename Node>
+  static void update(Node* node) {
+    node->mCount = 1 + (node->mChildren[0]? node->mChildren[0]->mCount : 0)
+                     + (node->mChildren[1]? node->mChildren[1]->mCount : 0);
+  }
+};
+
+/**
+ * Augmentation policy: monoid_augmentation<Monoid>
+ * Usage: avl_tree<int, double, less<int>,
+ *                 monoid_augmentation<sum_monoid<double> > > myAVLTree;
+ *        double total = myAVLTree.aggregate(100, 200);
+ * -------------------------------------------------------------------------
+ * Stores, in every node, the monoid product of all the elements in its
+ * subtree taken in sorted order, which lets aggregate(lo, hi) combine any key
+ * range in O(log n).  A Monoid is a type with
+ *
+ *   typedef ... value_type;
+ *   static value_type identity();
+ *   static value_type lift(const std::pair<const Key, Value>& entry);
+ *   static value_type combine(const value_type& lhs, const value_type& rhs);
+ *
+ * where combine is associative and identity is its identity element.  combine
+ * need not be commutative; its arguments always arrive in key order.  Subtree
+ * sizes are kept as well, so the order_statistics operations stay available.
+ *
+ * Since the product depends on the stored values, a value changed in place
+ * through an iterator, at() or operator[] leaves the aggregates on its path
+ * stale until refresh() is called on it.
+ */
+template <typename MonoidType>
+struct monoid_augmentation {
+  typedef MonoidType Monoid;
+  static const bool kOrderStatistics = true;
+  typedef typename Monoid::value_type aggregate_type;
+
+  struct NodeData: order_statistics::NodeData {
+    /* The product of every element in the subtree rooted here. */
+    aggregate_type mAggregate;
+  };
+
+  template <typename Node>
+  static void update(Node* node) {
+    order_statistics::update(node);
+
+    /* Fold left subtree, this node, right subtree, in that order. */
+    aggregate_type result = Monoid::lift(node->mValue);
+    if (node->mChildren[0])
+      result = Monoid::combine(node->mChildren[0]->mAggregate, result);
+    if (node->mChildren[1])
+      result = Monoid::combine(result, node->mChildren[1]->mAggregate);
+    node->mAggregate = result;
+  }
+};
+
+/**
+ * Monoids: sum_monoid<T>, min_monoid<T>, max_monoid<T>
+ * Usage: monoid_augmentation<max_monoid<int> >
+ * -------------------------------------------------------------------------
+ * Ready-made monoids over the mapped values of a tree, converted to T.  The
+ * empty range sums to T(), and has numeric_limits<T>::max() as its minimum
+ * and numeric_limits<T>::lowest() as its maximum.
+ */
+template <typename T>
+struct sum_monoid {
+  typedef T value_type;
+  static T identity() { return T(); }
+  template <typename Entry>
+  static T lift(const Entry& entry) { return T(entry.second); }
+  static T combine(const T& lhs, const T& rhs) { return lhs + rhs; }
+};
+
+template <typename T>
+struct min_monoid {
+  typedef T value_type;
+  static T identity() { return std::numeric_limits<T>::max(); }
+  template <typename Entry>
+  static T lift(const Entry& entry) { return T(entry.second); }
+  static T combine(const T& lhs, const T& rhs) { return std::min(lhs, rhs); }
+};
+
+template <typename T>
+struct max_monoid {
+  typedef T value_type;
+  static T identity() { return std::numeric_limits<T>::lowest(); }
+  template <typename Entry>
+  static T lift(const Entry& entry) { return T(entry.second); }
+  static T combine(const T& lhs, const T& rhs) { return std::max(lhs, rhs); }
+};
+
+/**
+ * Tag: sorted_range
+ * Usage: avl_tree<int, int> myAVLTree(sorted_range, v.begin(), v.end());
+ * -------------------------------------------------------------------------
+ * Marks the range handed to an avl_tree constructor as already sorted by
+ * key, which lets the tree be built in linear time.
+ */
+struct sorted_range_t {};
+static const sorted_range_t sorted_range = sorted_range_t();
+
+template <typename Key, typename Value, typename Comparator = std::less<Key>,
+          typename Augment = no_augmentation>
 class avl_tree {
 public:
   /**
@@ -46,6 +197,33 @@ public:
   avl_tree(const avl_tree& other);
   avl_tree& operator= (const avl_tree& other);
 
+  /**
+   * Constructor: avl_tree(sorted_range_t, InputIterator first,
+   *                       InputIterator last, Comparator comp = Comparator());
+   * Usage: avl_tree<string, int> myAVLTree(sorted_range, v.begin(), v.end());
+   * -------------------------------------------------------------------------
+   * Constructs a new AVL tree holding the key/value pairs in [first, last),
+   * which must be sorted by key.  See assign_sorted for details.
+   */
+  template <typename InputIterator>
+  avl_tree(sorted_range_t, InputIterator first, InputIterator last,
+           Comparator comp = Comparator());
+
+  /**
+   * void assign_sorted(InputIterator first, InputIterator last);
+   * Usage: myAVLTree.assign_sorted(v.begin(), v.end());
+   * -------------------------------------------------------------------------
+   * Replaces the contents of the AVL tree with the key/value pairs in
+   * [first, last), which must be sorted in ascending order of key.  A key
+   * equal to the one before it is skipped, just as insert would skip it.
+   * Rather than n separate inserts, this builds a perfectly balanced tree
+   * directly in O(n) time, allocating the nodes in sorted order.  All
+   * outstanding iterators are invalidated.  If an allocation throws, the tree
+   * is left unchanged.
+   */
+  template <typename InputIterator>
+  void assign_sorted(InputIterator first, InputIterator last);
+
   /**
    * Type: iterator
    * Type: const_iterator
@@ -186,6 +364,116 @@ public:
   std::pair<iterator, iterator> equal_range(const Key& key);
   std::pair<const_iterator, const_iterator> equal_range(const Key& key) const;
 
+  /**
+   * (const_)iterator select(size_t index) (const);
+   * Usage: int median = myAVLTree.select(myAVLTree.size() / 2)->second;
+   * -------------------------------------------------------------------------
+   * Returns an iterator to the element at the specified zero-based position
+   * in sorted order, or end() if index is not less than size().  Runs in
+   * O(log n).  Requires the order_statistics augmentation.
+   */
+  iterator select(size_t index);
+  const_iterator select(size_t index) const;
+
+  /**
+   * size_t rank(const Key& key) const;
+   * Usage: size_t below = myAVLTree.rank("skiplist");
+   * -------------------------------------------------------------------------
+   * Returns the number of keys in the AVL tree that are strictly less than
+   * key, which is the position key has (or would have) in sorted order.  Runs
+   * in O(log n).  Requires the order_statistics augmentation.
+   */
+  size_t rank(const Key& key) const;
+
+  /**
+   * size_t count_range(const Key& lo, const Key& hi) const;
+   * Usage: size_t n = myAVLTree.count_range("AVL", "skiplist");
+   * -------------------------------------------------------------------------
+   * Returns the number of keys k with lo <= k <= hi; that is, the number of
+   * elements visited walking from lower_bound(lo) to upper_bound(hi).  An
+   * empty range (hi < lo) counts zero.  Runs in O(log n).  Requires the
+   * order_statistics augmentation.
+   */
+  size_t count_range(const Key& lo, const Key& hi) const;
+
+  /**
+   * Type: aggregate_type
+   * -------------------------------------------------------------------------
+   * The type of a range aggregate; void unless the augmentation supplies one.
+   */
+  typedef typename Augment::aggregate_type aggregate_type;
+
+  /**
+   * aggregate_type aggregate(const Key& lo, const Key& hi) const;
+   * aggregate_type aggregate() const;
+   * Usage: double windowTotal = myAVLTree.aggregate(start, stop);
+   * -------------------------------------------------------------------------
+   * Returns the monoid product, in key order, of every element whose key k
+   * satisfies lo <= k <= hi, or of the whole tree.  An empty range yields the
+   * monoid's identity.  The ranged form runs in O(log n) and the other in
+   * O(1).  Requires a monoid_augmentation.
+   */
+  aggregate_type aggregate(const Key& lo, const Key& hi) const;
+  aggregate_type aggregate() const;
+
+  /**
+   * void refresh(iterator where);
+   * Usage: myAVLTree.find("skiplist")->second = 137;
+   *        myAVLTree.refresh(myAVLTree.find("skiplist"));
+   * -------------------------------------------------------------------------
+   * Recomputes the augmented summaries that depend on the element at where,
+   * which is necessary after changing that element's value in place when the
+   * augmentation reads values.  Runs in O(log n).
+   */
+  void refresh(iterator where);
+
+  /**
+   * void join(const Key& key, const Value& value, avl_tree& right);
+   * void join(avl_tree& right);
+   * Usage: lower.join("m", 137, upper);
+   * -------------------------------------------------------------------------
+   * Appends the contents of right to this AVL tree, optionally preceded by
+   * one new key/value pair, and leaves right empty.  Every key in this tree
+   * must be less than key, and key less than every key in right (without a
+   * key, every key here must be less than every key in right).  Rather than
+   * reinserting right element by element, this walks down the taller tree
+   * to the height of the shorter one and links them there, in O(log n).
+   */
+  void join(const Key& key, const Value& value, avl_tree& right);
+  void join(avl_tree& right);
+
+  /**
+   * void split(const Key& key, avl_tree& right);
+   * Usage: lower.split("m", upper);
+   * -------------------------------------------------------------------------
+   * Moves every element whose key is at least key into right, discarding
+   * whatever right held before, and keeps the rest.  The tree is cut apart
+   * in O(log n).  Working out the sizes of the two halves is O(1) with the
+   * order_statistics augmentation and otherwise takes time linear in the
+   * smaller half.
+   */
+  void split(const Key& key, avl_tree& right);
+
+  /**
+   * void union_with(avl_tree& other, unsigned threads = 0);
+   * void intersect_with(avl_tree& other, unsigned threads = 0);
+   * void difference_with(avl_tree& other, unsigned threads = 0);
+   * Usage: shard.union_with(incoming);
+   * -------------------------------------------------------------------------
+   * Replaces the contents of this AVL tree with its union, intersection or
+   * difference with other, which is consumed and left empty.  Where both
+   * trees hold a key, this tree's value is the one kept.  Nodes are relinked
+   * rather than copied, using split and join, so with sizes m <= n each
+   * operation does O(m log(n/m + 1)) work plus the cost of freeing whatever
+   * is dropped.  On large inputs the two independent halves of the
+   * recursion run on separate threads, up to threads of them at once; 0
+   * stands for std::thread::hardware_concurrency().  All outstanding
+   * iterators into either tree are invalidated.
+   */
+  void union_with(avl_tree& other, unsigned threads = 0);
+  void intersect_with(avl_tree& other, unsigned threads = 0);
+  void difference_with(avl_tree& other, unsigned threads = 0);
+
   /**
    * size_t size() const;
    * Usage: cout << "avl_tree contains " << s.size() << " entries." << endl;
@@ -212,8 +500,11 @@ public:
   void swap(avl_tree& other);
 
 private:
-  /* A type representing a node in the AVL tree. */
-  struct Node {
+  /* A type representing a node in the AVL tree.  It inherits whatever
+   * per-subtree summary the augmentation policy asks for, which costs nothing
+   * for no_augmentation.
+   */
+  struct Node: Augment::NodeData {
     std::pair<const Key, Value> mValue; // The actual value stored here
 
     /* The children are stored in an array to make it easier to implement tree
@@ -267,12 +558,19 @@ private:
   friend class iterator;
   friend class const_iterator;
 
+  /* Iterators are random-access when subtree sizes are available, since
+   * every jump can then be done in O(log n), and bidirectional otherwise.
+   */
+  typedef typename std::conditional<Augment::kOrderStatistics,
+                                    std::random_access_iterator_tag,
+                                    std::bidirectional_iterator_tag>::type
+    IteratorCategory;
+
   /* A utility function to perform a tree rotation to pull the child above its
-   * parent.  This function is semantically const but not bitwise const, since
-   * it changes the structure but not the content of the elements being
-   * stored.
+   * parent.  It touches only the nodes involved, so if the child ends up with
+   * no parent, the caller is responsible for recording it as the new root.
    */
-  void rotateUp(Node* child);
+  static void rotateUp(Node* child);
 
   /* A utility function that, given a node, returns the height of that node.
    * If the node is NULL, 0 is returned.
@@ -293,17 +591,19 @@ private:
 
   /* A utility function which walks up from the indicated node up to the root,
    * performing the tree rotations necessary to restore the balances in the
-   * tree.
+   * tree.  It returns the root it ends at (NULL if where is NULL), since
+   * rotations may have changed it.
    */
-  void rebalanceFrom(Node* where);
+  static Node* rebalanceFrom(Node* where);
 
   /* A utility function which, given a node with at most one child, splices
    * that node out of the tree by replacing it with its one child.  The next
    * and previous pointers of that node are not modified, since this function
    * can be used to structurally remove nodes from the tree while remembering
-   * where they are in sorted order.
+   * where they are in sorted order.  It returns the child that took the
+   * node's place, which is the new root if the node had no parent.
    */
-  void spliceOut(Node* where);
+  static Node* spliceOut(Node* where);
 
   /* A utility function which, given a node and the node to use as its parent,
    * recursively deep-copies the tree rooted at that node, using the parent
@@ -317,39 +617,145 @@ private:
    * with the highest key.
    */
   static Node* rethreadLinkedList(Node* root, Node* predecessor);
+
+  /* A utility function which builds a perfectly balanced tree out of the
+   * next count nodes of a linked list, advancing cursor past them.  Heights
+   * and augmented summaries are filled in; the root's parent is left for the
+   * caller to set.
+   */
+  static Node* buildBalanced(Node*& cursor, size_t count);
+
+  /* A detached subtree, used while splitting and joining.  The root has no
+   * parent, and the linked list is correct from the first node through the
+   * last one.  The outward pointers of those two nodes are left for whoever
+   * joins the fragment into something larger to fill in.  An empty fragment
+   * has all three pointers NULL.
+   */
+  struct Fragment {
+    Node* mRoot;
+    Node* mFirst, *mLast;
+  };
+
+  /* Fragments only pay for forking a thread once both inputs are at least
+   * this tall.
+   */
+  static const int kForkHeight = 12;
+
+  /* Utility functions which convert the whole tree to a fragment, leaving
+   * the tree empty, and install a fragment of the indicated size as the
+   * contents of an empty tree.
+   */
+  Fragment release();
+  void adopt(Fragment fragment, size_t size);
+
+  /* A utility function which detaches the given child of a fragment's root
+   * as a fragment of its own.  outer is the fragment's first node for the
+   * left child, or its last node for the right child.
+   */
+  static Fragment childFragment(Node* root, int side, Node* outer);
+
+  /* A utility function which joins two trees whose keys are ordered around
+   * a detached middle node, returning the root of the result.
+   */
+  static Node* joinTrees(Node* left, Node* mid, Node* right);
+
+  /* Utility functions which join two fragments, with or without a middle
+   * node, linked list included.
+   */
+  static Fragment joinFragments(Fragment left, Node* mid, Fragment right);
+  static Fragment joinFragments(Fragment left, Fragment right);
+
+  /* A utility function which splits a fragment into the keys less than and
+   * greater than the given one, detaching the node with that key, if any,
+   * into found.
+   */
+  void splitFragment(Fragment tree, const Key& key, Fragment& less,
+                     Node*& found, Fragment& greater) const;
+
+  /* A utility function which frees every node of a fragment. */
+  static void destroyFragment(Fragment fragment);
+
+  /* A utility function which returns the size of the first of two fragments
+   * holding total nodes between them.
+   */
+  static size_t firstFragmentSize(Fragment first, Fragment second,
+                                  size_t total);
+
+  /* Recursive set operations on fragments.  forks is how many more levels
+   * of the recursion may fork a thread, and the count is of duplicates
+   * dropped, nodes kept and nodes removed respectively.
+   */
+  Fragment unionOf(Fragment a, Fragment b, int forks,
+                   size_t& duplicates) const;
+  Fragment intersectionOf(Fragment a, Fragment b, int forks,
+                          size_t& kept) const;
+  Fragment differenceOf(Fragment a, Fragment b, int forks,
+                        size_t& removed) const;
+
+  /* A utility function which converts a thread budget into the number of
+   * recursion levels that may fork.
+   */
+  static int forkDepth(unsigned threads);
+
+  /* A utility function which runs two independent tasks, the first one on a
+   * thread of its own if fork is set.
+   */
+  template <typename First, typename Second>
+  static void forkJoin(bool fork, const First& first, const Second& second);
+
+  /* A utility function that, given a node, returns the number of nodes in
+   * its subtree, or 0 if the node is NULL.  Only usable with the
+   * order_statistics augmentation.
+   */
+  static size_t subtreeSize(const Node* node);
+
+  /* A utility function that returns the node at the indicated position in
+   * sorted order, or NULL if there is no such node.
+   */
+  Node* selectNode(size_t index) const;
+
+  /* A utility function that returns the position of the indicated node in
+   * sorted order.  NULL, the end of the sequence, is at position size().
+   */
+  size_t indexOf(const Node* node) const;
+
+  /* A utility function that returns the number of keys less than the given
+   * key, or less than or equal to it if inclusive is set.
+   */
+  size_t countBelow(const Key& key, bool inclusive) const;
 };
 
 /* Comparison operators for AVLTrees. */
-template <typename Key, typename Value, typename Comparator>
-bool operator<  (const avl_tree<Key, Value, Comparator>& lhs,
-                 const avl_tree<Key, Value, Comparator>& rhs);
-template <typename Key, typename Value, typename Comparator>
-bool operator<= (const avl_tree<Key, Value, Comparator>& lhs,
-                 const avl_tree<Key, Value, Comparator>& rhs);
-template <typename Key, typename Value, typename Comparator>
-bool operator== (const avl_tree<Key, Value, Comparator>& lhs,
-                 const avl_tree<Key, Value, Comparator>& rhs);
-template <typename Key, typename Value, typename Comparator>
-bool operator!= (const avl_tree<Key, Value, Comparator>& lhs,
-                 const avl_tree<Key, Value, Comparator>& rhs);
-template <typename Key, typename Value, typename Comparator>
-bool operator>= (const avl_tree<Key, Value, Comparator>& lhs,
-                 const avl_tree<Key, Value, Comparator>& rhs);
-template <typename Key, typename Value, typename Comparator>
-bool operator>  (const avl_tree<Key, Value, Comparator>& lhs,
-                 const avl_tree<Key, Value, Comparator>& rhs);
+template <typename Key, typename Value, typename Comparator, typename Augment>
+bool operator<  (const avl_tree<Key, Value, Comparator, Augment>& lhs,
+                 const avl_tree<Key, Value, Comparator, Augment>& rhs);
+template <typename Key, typename Value, typename Comparator, typename Augment>
+bool operator<= (const avl_tree<Key, Value, Comparator, Augment>& lhs,
+                 const avl_tree<Key, Value, Comparator, Augment>& rhs);
+template <typename Key, typename Value, typename Comparator, typename Augment>
+bool operator== (const avl_tree<Key, Value, Comparator, Augment>& lhs,
+                 const avl_tree<Key, Value, Comparator, Augment>& rhs);
+template <typename Key, typename Value, typename Comparator, typename Augment>
+bool operator!= (const avl_tree<Key, Value, Comparator, Augment>& lhs,
+                 const avl_tree<Key, Value, Comparator, Augment>& rhs);
+template <typename Key, typename Value, typename Comparator, typename Augment>
+bool operator>= (const avl_tree<Key, Value, Comparator, Augment>& lhs,
+                 const avl_tree<Key, Value, Comparator, Augment>& rhs);
+template <typename Key, typename Value, typename Comparator, typename Augment>
+bool operator>  (const avl_tree<Key, Value, Comparator, Augment>& lhs,
+                 const avl_tree<Key, Value, Comparator, Augment>& rhs);
 
 /* * * * * Implementation Below This Point * * * * */
 
 /* Definition of the IteratorBase type, which is used to provide a common
  * implementation for iterator and const_iterator.
  */
-template <typename Key, typename Value, typename Comparator>
+template <typename Key, typename Value, typename Comparator, typename Augment>
 template <typename DerivedType, typename Pointer, typename Reference>
-class avl_tree<Key, Value, Comparator>::IteratorBase {
+class avl_tree<Key, Value, Comparator, Augment>::IteratorBase {
 public:
   /* Utility typedef to talk about nodes. */
-  typedef typename avl_tree<Key, Value, Comparator>::Node Node;
+  typedef typename avl_tree<Key, Value, Comparator, Augment>::Node Node;
 
   /* Advance operators just construct derived type instances of the proper
    * type, then advance them.
@@ -419,6 +825,61 @@ public:
   Reference operator* () const {
     return mCurr->mValue;
   }
+
+  /* Random-access operators, usable only with the order_statistics
+   * augmentation.  Each converts the iterator to its position in sorted
+   * order, does the arithmetic on positions, and selects the resulting node,
+   * so every one of them runs in O(log n).
+   */
+  DerivedType& operator+= (std::ptrdiff_t n) {
+    mCurr = mOwner->selectNode(mOwner->indexOf(mCurr) + n);
+    return static_cast<DerivedType&>(*this);
+  }
+  DerivedType& operator-= (std::ptrdiff_t n) {
+    return *this += -n;
+  }
+  DerivedType operator+ (std::ptrdiff_t n) const {
+    DerivedType result = static_cast<const DerivedType&>(*this);
+    return result += n;
+  }
+  DerivedType operator- (std::ptrdiff_t n) const {
+    DerivedType result = static_cast<const DerivedType&>(*this);
+    return result -= n;
+  }
+  friend DerivedType operator+ (std::ptrdiff_t n, const DerivedType& itr) {
+    return itr + n;
+  }
+  Reference operator[] (std::ptrdiff_t n) const {
+    return *(*this + n);
+  }
+
+  /* The distance between two iterators is the difference of their positions.
+   * Like equality, this works between iterator and const_iterator.
+   */
+  template <typename DerivedType2, typename Pointer2, typename Reference2>
+  std::ptrdiff_t
+  operator- (const IteratorBase<DerivedType2, Pointer2, Reference2>& rhs) const {
+    return std::ptrdiff_t(mOwner->indexOf(mCurr)) -
+           std::ptrdiff_t(rhs.mOwner->indexOf(rhs.mCurr));
+  }
+
+  /* Ordering comparisons are phrased in terms of distance. */
+  template <typename DerivedType2, typename Pointer2, typename Reference2>
+  bool operator<  (const IteratorBase<DerivedType2, Pointer2, Reference2>& rhs) const {
+    return *this - rhs < 0;
+  }
+  template <typename DerivedType2, typename Pointer2, typename Reference2>
+  bool operator<= (const IteratorBase<DerivedType2, Pointer2, Reference2>& rhs) const {
+    return *this - rhs <= 0;
+  }
+  template <typename DerivedType2, typename Pointer2, typename Reference2>
+  bool operator>  (const IteratorBase<DerivedType2, Pointer2, Reference2>& rhs) const {
+    return *this - rhs > 0;
+  }
+  template <typename DerivedType2, typename Pointer2, typename Reference2>
+  bool operator>= (const IteratorBase<DerivedType2, Pointer2, Reference2>& rhs) const {
+    return *this - rhs >= 0;
+  }
   
   /* Arrow operator returns a pointer. */
   Pointer operator-> () const {
@@ -456,9 +917,9 @@ protected:
  * Additionally, we inherit from std::iterator to import all the necessary
  * typedefs to qualify as an iterator.
  */
-template <typename Key, typename Value, typename Comparator>
-class avl_tree<Key, Value, Comparator>::iterator:
-  public std::iterator< std::bidirectional_iterator_tag,
+template <typename Key, typename Value, typename Comparator, typename Augment>
+class avl_tree<Key, Value, Comparator, Augment>::iterator:
+  public std::iterator< IteratorCategory,
                         std::pair<const Key, Value> >,
   public IteratorBase<iterator,                       // Our type
                       std::pair<const Key, Value>*,   // Reference type
@@ -477,7 +938,7 @@ private:
    * type of the base is so complex.
    */
   iterator(const avl_tree* owner,
-           typename avl_tree<Key, Value, Comparator>::Node* node) :
+           typename avl_tree<Key, Value, Comparator, Augment>::Node* node) :
     IteratorBase<iterator,
                  std::pair<const Key, Value>*,
                  std::pair<const Key, Value>&>(owner, node) {
@@ -494,9 +955,9 @@ private:
 };
 
 /* Same as above, but with const added in. */
-template <typename Key, typename Value, typename Comparator>
-class avl_tree<Key, Value, Comparator>::const_iterator:
-  public std::iterator< std::bidirectional_iterator_tag,
+template <typename Key, typename Value, typename Comparator, typename Augment>
+class avl_tree<Key, Value, Comparator, Augment>::const_iterator:
+  public std::iterator< IteratorCategory,
                         const std::pair<const Key, Value> >,
   public IteratorBase<const_iterator,                       // Our type
                       const std::pair<const Key, Value>*,   // Reference type
@@ -522,7 +983,7 @@ public:
 private:
   /* See iterator implementation for details about what this does. */
   const_iterator(const avl_tree* owner,
-                 typename avl_tree<Key, Value, Comparator>::Node* node) :
+                 typename avl_tree<Key, Value, Comparator, Augment>::Node* node) :
     IteratorBase<const_iterator,
                  const std::pair<const Key, Value>*,
                  const std::pair<const Key, Value>&>(owner, node) {
@@ -538,10 +999,10 @@ private:
 /* Constructor sets up the key and value, then sets the height to one.  The
  * linked list fields are left uninitialized.
  */
-template <typename Key, typename Value, typename Comparator>
-avl_tree<Key, Value, Comparator>::Node::Node(const Key& key,
-                                            const Value& value,
-                                            int height) 
+template <typename Key, typename Value, typename Comparator, typename Augment>
+avl_tree<Key, Value, Comparator, Augment>::Node::Node(const Key& key,
+                                                     const Value& value,
+                                                     int height) 
   : mValue(key, value), mHeight(height) {
   // Handled in initializer list.
 }
@@ -549,8 +1010,8 @@ avl_tree<Key, Value, Comparator>::Node::Node(const Key& key,
 /**** avl_tree Implementation ****/
 
 /* Constructor sets up a new, empty avl_tree. */
-template <typename Key, typename Value, typename Comparator>
-avl_tree<Key, Value, Comparator>::avl_tree(Comparator comp) : mComp(comp) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+avl_tree<Key, Value, Comparator, Augment>::avl_tree(Comparator comp) : mComp(comp) {
   /* Initially, the list of elements is empty and the tree is NULL. */
   mHead = mTail = mRoot = NULL;
 
@@ -561,8 +1022,8 @@ avl_tree<Key, Value, Comparator>::avl_tree(Comparator comp) : mComp(comp) {
 /* Destructor walks the linked list of elements, deleting all nodes it
  * encounters.
  */
-template <typename Key, typename Value, typename Comparator>
-avl_tree<Key, Value, Comparator>::~avl_tree() {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+avl_tree<Key, Value, Comparator, Augment>::~avl_tree() {
   /* Start at the head of the list. */
   Node* curr = mHead;
   while (curr != NULL) {
@@ -578,9 +1039,9 @@ avl_tree<Key, Value, Comparator>::~avl_tree() {
 /* Inserting a node works by walking down the tree until the insert point is
  * found, adding the value, then fixing up the balance factors on each node.
  */
-template <typename Key, typename Value, typename Comparator>
-std::pair<typename avl_tree<Key, Value, Comparator>::iterator, bool>
-avl_tree<Key, Value, Comparator>::insert(const Key& key, const Value& value) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+std::pair<typename avl_tree<Key, Value, Comparator, Augment>::iterator, bool>
+avl_tree<Key, Value, Comparator, Augment>::insert(const Key& key, const Value& value) {
   /* Recursively walk down the tree from the root, looking for where the value
    * should go.  In the course of doing so, we'll maintain some extra
    * information about the node's successor and predecessor so that we can
@@ -661,7 +1122,7 @@ avl_tree<Key, Value, Comparator>::insert(const Key& key, const Value& value) {
     mHead = toInsert;
   
   /* Rebalance the tree from this node upward. */
-  rebalanceFrom(toInsert);
+  mRoot = rebalanceFrom(toInsert);
 
   /* Increase the size of the tree, since we just added a node. */
   ++mSize;
@@ -697,11 +1158,12 @@ avl_tree<Key, Value, Comparator>::insert(const Key& key, const Value& value) {
  * OPPOSITE-SIDE child, and the node's OPPOSITE-SIDE child becomes the
  * parent's SIDE child.
  *
- * This code also updates the root if the tree root gets rotated out.  It also
- * ensures that the heights of the rotated nodes are properly adjusted.
+ * This code touches only the nodes involved, so if the node ends up with no
+ * parent, the caller is responsible for recording it as the new root.  It
+ * also ensures that the heights of the rotated nodes are properly adjusted.
  */
-template <typename Key, typename Value, typename Comparator>
-void avl_tree<Key, Value, Comparator>::rotateUp(Node* node) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+void avl_tree<Key, Value, Comparator, Augment>::rotateUp(Node* node) {
   /* Determine which side the node is on.  It's on the left (side 0) if the
    * parent's first pointer matches it, and is on the right (side 1) if the
    * node's first pointer doesn't match it.  This is, coincidentally, whether
@@ -729,13 +1191,12 @@ void avl_tree<Key, Value, Comparator>::rotateUp(Node* node) {
 
   /* Update the grandparent (if any) so that its child is now the rotated
    * element rather than the parent.  If there is no grandparent, the node is
-   * now the root.
+   * now the root, which the caller picks up from rebalanceFrom.
    */
   if (parent->mParent) {
     const int parentSide = (parent != parent->mParent->mChildren[0]);
     parent->mParent->mChildren[parentSide] = node;
-  } else
-    mRoot = node;
+  }
 
   /* In either case, change the parent so that it now treats the node as the
    * parent.
@@ -750,21 +1211,27 @@ void avl_tree<Key, Value, Comparator>::rotateUp(Node* node) {
                                  height(parent->mChildren[1]));
   node->mHeight = 1 + std::max(height(node->mChildren[0]), 
                                height(node->mChildren[1]));
+
+  /* The augmented summaries change in exactly the same two places, and in
+   * the same order.
+   */
+  Augment::update(parent);
+  Augment::update(node);
 }
 
 /* To determine the height of a node, we just hand back the node's recorded
  * height, or 0 if the node is NULL.
  */
-template <typename Key, typename Value, typename Comparator>
-int avl_tree<Key, Value, Comparator>::height(const Node* node) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+int avl_tree<Key, Value, Comparator, Augment>::height(const Node* node) {
   return node? node->mHeight : 0;
 }
 
 /* Computing the balance factor just computes the difference in heights
  * between a node's left and right children.
  */
-template <typename Key, typename Value, typename Comparator>
-int avl_tree<Key, Value, Comparator>::balanceFactor(const Node* node) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+int avl_tree<Key, Value, Comparator, Augment>::balanceFactor(const Node* node) {
   return height(node->mChildren[0]) - height(node->mChildren[1]);
 }
 
@@ -779,8 +1246,14 @@ int avl_tree<Key, Value, Comparator>::balanceFactor(const Node* node) {
  *    opposite of the real node's balance factor, rotate its child on its
  *    tall side upward, then rotate it again with the original node.
  */
-template <typename Key, typename Value, typename Comparator>
-void avl_tree<Key, Value, Comparator>::rebalanceFrom(Node* where) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::Node*
+avl_tree<Key, Value, Comparator, Augment>::rebalanceFrom(Node* where) {
+  /* Track the last node we moved up from; once we walk off the top, it's the
+   * root.
+   */
+  Node* top = where;
+
   /* Start walking up from the node toward the root, checking for any new
    * imbalances and recomputing heights as appropriate.
    */
@@ -789,6 +1262,11 @@ void avl_tree<Key, Value, Comparator>::rebalanceFrom(Node* where) {
     where->mHeight = 1 + std::max(height(where->mChildren[0]), 
                                   height(where->mChildren[1]));
 
+    /* Recompute its augmented summary as well.  Since this loop always runs
+     * all the way to the root, every ancestor of a spliced-out or inserted
+     * node is refreshed here.
+     */
+    Augment::update(where);
 
     /* Get the balance factor. */
     const int balance = balanceFactor(where);
@@ -815,6 +1293,7 @@ void avl_tree<Key, Value, Comparator>::rebalanceFrom(Node* where) {
          * elsewhere in the tree.  Set the search to continue from the parent
          * of this node.
          */
+        top = tallChild;
         where = tallChild->mParent;
       }
       /* Otherwise, we need to do a double rotation. */
@@ -829,6 +1308,7 @@ void avl_tree<Key, Value, Comparator>::rebalanceFrom(Node* where) {
         rotateUp(tallGrandchild);
 
         /* Again, pick up the search from this point. */
+        top = tallGrandchild;
         where = tallGrandchild->mParent;
       }
     }
@@ -837,25 +1317,28 @@ void avl_tree<Key, Value, Comparator>::rebalanceFrom(Node* where) {
      */
     else {
       /* Pick up the search from the parent of this node. */
+      top = where;
       where = where->mParent;
     }
   }
+
+  return top;
 }
 
 /* const version of find works by doing a standard BST search for the node in
  * question.
  */
-template <typename Key, typename Value, typename Comparator>
-typename avl_tree<Key, Value, Comparator>::const_iterator
-avl_tree<Key, Value, Comparator>::find(const Key& key) const {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::const_iterator
+avl_tree<Key, Value, Comparator, Augment>::find(const Key& key) const {
   /* Do a standard BST search and wrap up whataver we found. */
   return const_iterator(this, findNode(key).first);
 }
 
 /* Non-const version of find implemented in terms of const find. */
-template <typename Key, typename Value, typename Comparator>
-typename avl_tree<Key, Value, Comparator>::iterator
-avl_tree<Key, Value, Comparator>::find(const Key& key) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::iterator
+avl_tree<Key, Value, Comparator, Augment>::find(const Key& key) {
   /* Get the underlying const_iterator by calling the const version of this
    * function.
    */
@@ -868,10 +1351,10 @@ avl_tree<Key, Value, Comparator>::find(const Key& key) {
 /* findNode just does a standard BST lookup, recording the last node that was
  * found before the one that was ultimately returned.
  */
-template <typename Key, typename Value, typename Comparator>
-std::pair<typename avl_tree<Key, Value, Comparator>::Node*,
-          typename avl_tree<Key, Value, Comparator>::Node*>
-avl_tree<Key, Value, Comparator>::findNode(const Key& key) const {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+std::pair<typename avl_tree<Key, Value, Comparator, Augment>::Node*,
+          typename avl_tree<Key, Value, Comparator, Augment>::Node*>
+avl_tree<Key, Value, Comparator, Augment>::findNode(const Key& key) const {
   /* Start the search at the root and work downwards.  Keep track of the last
    * node we visited.
    */
@@ -907,68 +1390,69 @@ avl_tree<Key, Value, Comparator>::findNode(const Key& key) const {
 /* begin and end return iterators wrapping the head of the list or NULL,
  * respectively.
  */
-template <typename Key, typename Value, typename Comparator>
-typename avl_tree<Key, Value, Comparator>::iterator
-avl_tree<Key, Value, Comparator>::begin() {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::iterator
+avl_tree<Key, Value, Comparator, Augment>::begin() {
   return iterator(this, mHead);
 }
-template <typename Key, typename Value, typename Comparator>
-typename avl_tree<Key, Value, Comparator>::const_iterator
-avl_tree<Key, Value, Comparator>::begin() const {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::const_iterator
+avl_tree<Key, Value, Comparator, Augment>::begin() const {
   return iterator(this, mHead);
 }
-template <typename Key, typename Value, typename Comparator>
-typename avl_tree<Key, Value, Comparator>::iterator
-avl_tree<Key, Value, Comparator>::end() {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::iterator
+avl_tree<Key, Value, Comparator, Augment>::end() {
   return iterator(this, NULL);
 }
-template <typename Key, typename Value, typename Comparator>
-typename avl_tree<Key, Value, Comparator>::const_iterator
-avl_tree<Key, Value, Comparator>::end() const {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::const_iterator
+avl_tree<Key, Value, Comparator, Augment>::end() const {
   return iterator(this, NULL);
 }
 
 /* rbegin and rend return wrapped versions of end() and begin(),
  * respectively.
  */
-template <typename Key, typename Value, typename Comparator>
-typename avl_tree<Key, Value, Comparator>::reverse_iterator
-avl_tree<Key, Value, Comparator>::rbegin() {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::reverse_iterator
+avl_tree<Key, Value, Comparator, Augment>::rbegin() {
   return reverse_iterator(end());
 }
-template <typename Key, typename Value, typename Comparator>
-typename avl_tree<Key, Value, Comparator>::const_reverse_iterator
-avl_tree<Key, Value, Comparator>::rbegin() const {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::const_reverse_iterator
+avl_tree<Key, Value, Comparator, Augment>::rbegin() const {
   return const_reverse_iterator(end());
 }
-template <typename Key, typename Value, typename Comparator>
-typename avl_tree<Key, Value, Comparator>::reverse_iterator
-avl_tree<Key, Value, Comparator>::rend() {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::reverse_iterator
+avl_tree<Key, Value, Comparator, Augment>::rend() {
   return reverse_iterator(begin());
 }
-template <typename Key, typename Value, typename Comparator>
-typename avl_tree<Key, Value, Comparator>::const_reverse_iterator
-avl_tree<Key, Value, Comparator>::rend() const {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::const_reverse_iterator
+avl_tree<Key, Value, Comparator, Augment>::rend() const {
   return const_reverse_iterator(begin());
 }
 
 /* size just returns the cached size of the AVL tree. */
-template <typename Key, typename Value, typename Comparator>
-size_t avl_tree<Key, Value, Comparator>::size() const {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+size_t avl_tree<Key, Value, Comparator, Augment>::size() const {
   return mSize;
 }
 
 /* empty returns whether the size is zero. */
-template <typename Key, typename Value, typename Comparator>
-bool avl_tree<Key, Value, Comparator>::empty() const {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+bool avl_tree<Key, Value, Comparator, Augment>::empty() const {
   return size() == 0;
 }
 
 /* To splice out a node in the tree, we determine where its singleton child is
  * (if there even is one), then replace it with that node.
  */
-template <typename Key, typename Value, typename Comparator>
-void avl_tree<Key, Value, Comparator>::spliceOut(Node* node) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::Node*
+avl_tree<Key, Value, Comparator, Augment>::spliceOut(Node* node) {
   /* Confirm that this node has at most one child. */
   assert (!node->mChildren[0] || !node->mChildren[1]);
 
@@ -994,7 +1478,8 @@ void avl_tree<Key, Value, Comparator>::spliceOut(Node* node) {
   
   /* Change the parent of the node being deleted to use the new child node
    * instead of the node to delete.  However, the node in question might be
-   * the root, in which case we need to change the root of the tree.
+   * the root, in which case the child is the new root, and the caller has to
+   * record that.
    */
   if (parent) {
     /* We need to change the correct pointer in the parent.  If the node is
@@ -1003,9 +1488,8 @@ void avl_tree<Key, Value, Comparator>::spliceOut(Node* node) {
      */
     parent->mChildren[node == parent->mChildren[1]] = child;
   }
-  /* If there is no parent, then the new node is at the root of the tree. */
-  else
-    mRoot = child;
+
+  return child;
 }
 
 /* Removing a node from the AVL tree is perhaps the most difficult part of the
@@ -1014,9 +1498,9 @@ void avl_tree<Key, Value, Comparator>::spliceOut(Node* node) {
  * the node.  Then, we have to do a pass upward from where we did the switch 
  * to fix up the tree structure and confirm that the invariants hold.
  */
-template <typename Key, typename Value, typename Comparator>
-typename avl_tree<Key, Value, Comparator>::iterator
-avl_tree<Key, Value, Comparator>::erase(iterator where) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::iterator
+avl_tree<Key, Value, Comparator, Augment>::erase(iterator where) {
   /* Extract the node pointer from the iterator. */
   Node* node = where.mCurr;
 
@@ -1034,8 +1518,8 @@ avl_tree<Key, Value, Comparator>::erase(iterator where) {
   
   /* Case 1: Missing at least one child. */
   if (!node->mChildren[0] || !node->mChildren[1]) {
-    spliceOut(node);
-    rebalanceFrom(parent);
+    Node* child = spliceOut(node);
+    mRoot = parent? rebalanceFrom(parent) : child;
   }
   /* Case 2: Both children present.  Replace the node with its successor. */
   else {
@@ -1085,8 +1569,6 @@ avl_tree<Key, Value, Comparator>::erase(iterator where) {
        */
       parent->mChildren[node == parent->mChildren[1]] = successor;
     }
-    else
-      mRoot = successor;
 
     /* Whew!  We've successfully spliced out the node.  Now, run a fixup pass
      * from where we cut the successor.  There are two cases to consider,
@@ -1094,9 +1576,10 @@ avl_tree<Key, Value, Comparator>::erase(iterator where) {
      * that we're deleting, we need to run the fixup pass from the successor
      * node, which has been moved.  Second, if the successor was not a direct
      * child of the node to remove, then its parent might be dealing with an
-     * imbalanced tree and we need to fix it up.
+     * imbalanced tree and we need to fix it up.  Either way the pass ends at
+     * the root, which covers the case where the successor replaced it.
      */
-    rebalanceFrom(node == successorParent? successor : successorParent);
+    mRoot = rebalanceFrom(node == successorParent? successor : successorParent);
   }
 
   /* We've now removed the node in question from the tree structure, and now
@@ -1133,8 +1616,8 @@ avl_tree<Key, Value, Comparator>::erase(iterator where) {
 /* Erasing a single value just calls find to locate the element and the
  * iterator version of erase to remove it.
  */
-template <typename Key, typename Value, typename Comparator>
-bool avl_tree<Key, Value, Comparator>::erase(const Key& key) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+bool avl_tree<Key, Value, Comparator, Augment>::erase(const Key& key) {
   /* Look up where this node is, then remove it if it exists. */
   iterator where = find(key);
   if (where == end()) return false;
@@ -1144,8 +1627,8 @@ bool avl_tree<Key, Value, Comparator>::erase(const Key& key) {
 }
 
 /* Square brackets implemented in terms of insert(). */
-template <typename Key, typename Value, typename Comparator>
-Value& avl_tree<Key, Value, Comparator>::operator[] (const Key& key) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+Value& avl_tree<Key, Value, Comparator, Augment>::operator[] (const Key& key) {
   /* Call insert to get a pair of an iterator and a bool.  Look at the
    * iterator, then consider its second field.
    */
@@ -1153,8 +1636,8 @@ Value& avl_tree<Key, Value, Comparator>::operator[] (const Key& key) {
 }
 
 /* at implemented in terms of find. */
-template <typename Key, typename Value, typename Comparator>
-const Value& avl_tree<Key, Value, Comparator>::at(const Key& key) const {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+const Value& avl_tree<Key, Value, Comparator, Augment>::at(const Key& key) const {
   /* Look up the key, failing if we can't find it. */
   const_iterator result = find(key);
   if (result == end())
@@ -1167,8 +1650,8 @@ const Value& avl_tree<Key, Value, Comparator>::at(const Key& key) const {
 /* non-const at implemented in terms of at using the const_cast/static_cast
  * trick.
  */
-template <typename Key, typename Value, typename Comparator>
-Value& avl_tree<Key, Value, Comparator>::at(const Key& key) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+Value& avl_tree<Key, Value, Comparator, Augment>::at(const Key& key) {
   return const_cast<Value&>(static_cast<const avl_tree*>(this)->at(key));
 }
 
@@ -1178,8 +1661,8 @@ Value& avl_tree<Key, Value, Comparator>::at(const Key& key) {
  * pointers threaded through.  Next, we run a recursive pass over the cloned
  * tree, fixing up all of the next and previous pointers as we go.
  */
-template <typename Key, typename Value, typename Comparator>
-avl_tree<Key, Value, Comparator>::avl_tree(const avl_tree& other) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+avl_tree<Key, Value, Comparator, Augment>::avl_tree(const avl_tree& other) {
   /* Start off with the simple bits - copy over the size field and 
    * comparator. 
    */
@@ -1201,9 +1684,9 @@ avl_tree<Key, Value, Comparator>::avl_tree(const avl_tree& other) {
 }
 
 /* Cloning a tree is a simple structural recursion. */
-template <typename Key, typename Value, typename Comparator>
-typename avl_tree<Key, Value, Comparator>::Node*
-avl_tree<Key, Value, Comparator>::cloneTree(Node* toClone, Node* parent) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::Node*
+avl_tree<Key, Value, Comparator, Augment>::cloneTree(Node* toClone, Node* parent) {
   /* Base case: the clone of the empty tree is that tree itself. */
   if (toClone == NULL) return NULL;
 
@@ -1215,6 +1698,9 @@ avl_tree<Key, Value, Comparator>::cloneTree(Node* toClone, Node* parent) {
   for (int i = 0; i < 2; ++i)
     result->mChildren[i] = cloneTree(toClone->mChildren[i], result);
 
+  /* The subtree is identical, so its augmented summary is too. */
+  static_cast<typename Augment::NodeData&>(*result) = *toClone;
+
   /* Set the parent. */
   result->mParent = parent;
 
@@ -1227,9 +1713,9 @@ avl_tree<Key, Value, Comparator>::cloneTree(Node* toClone, Node* parent) {
  * node).  We then chain the current node into the linked list, then fix up
  * the nodes to the right (which have the current node as their predecessor).
  */
-template <typename Key, typename Value, typename Comparator>
-typename avl_tree<Key, Value, Comparator>::Node*
-avl_tree<Key, Value, Comparator>::rethreadLinkedList(Node* root, Node* predecessor) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::Node*
+avl_tree<Key, Value, Comparator, Augment>::rethreadLinkedList(Node* root, Node* predecessor) {
   /* Base case: if the root is null, then the largest element visited so far
    * is whatever we were told it was.
    */
@@ -1252,18 +1738,601 @@ avl_tree<Key, Value, Comparator>::rethreadLinkedList(Node* root, Node* predecess
   return rethreadLinkedList(root->mChildren[1], root);
 }
 
+/* The sorted-range constructor starts out empty and then bulk loads. */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+template <typename InputIterator>
+avl_tree<Key, Value, Comparator, Augment>::avl_tree(sorted_range_t,
+                                                   InputIterator first,
+                                                   InputIterator last,
+                                                   Comparator comp)
+  : mComp(comp) {
+  mHead = mTail = mRoot = NULL;
+  mSize = 0;
+
+  assign_sorted(first, last);
+}
+
+/* Bulk loading runs in two linear passes.  The first allocates the nodes in
+ * order and threads them into the linked list, which is all the destructor
+ * needs to clean up if an allocation fails partway through.  The second
+ * carves that list into a balanced tree.  Both happen in a scratch tree that
+ * is only swapped in once it is complete.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+template <typename InputIterator>
+void avl_tree<Key, Value, Comparator, Augment>::assign_sorted(InputIterator first, InputIterator last) {
+  avl_tree result(mComp);
+
+  for (; first != last; ++first) {
+    /* Drop a repeated key, as insert would. */
+    if (result.mTail && !mComp(result.mTail->mValue.first, first->first)) {
+      assert (!mComp(first->first, result.mTail->mValue.first));
+      continue;
+    }
+
+    Node* node = new Node(first->first, first->second, 1);
+    node->mChildren[0] = node->mChildren[1] = node->mParent = NULL;
+
+    /* Append it to the list. */
+    node->mNext = NULL;
+    node->mPrev = result.mTail;
+    if (result.mTail)
+      result.mTail->mNext = node;
+    else
+      result.mHead = node;
+    result.mTail = node;
+    ++result.mSize;
+  }
+
+  Node* cursor = result.mHead;
+  result.mRoot = buildBalanced(cursor, result.mSize);
+  if (result.mRoot)
+    result.mRoot->mParent = NULL;
+
+  swap(result);
+}
+
+/* buildBalanced is an inorder traversal of the tree it is building: it builds
+ * the left half of the nodes, takes the next list node as the root, then
+ * builds the right half.  Splitting the count in half each time makes the
+ * two subtrees differ in height by at most one.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::Node*
+avl_tree<Key, Value, Comparator, Augment>::buildBalanced(Node*& cursor, size_t count) {
+  /* Base case: no nodes make an empty tree. */
+  if (count == 0) return NULL;
+
+  /* The left subtree takes the smaller half of the remaining nodes. */
+  const size_t leftCount = (count - 1) / 2;
+  Node* left = buildBalanced(cursor, leftCount);
+
+  /* The next node in sorted order is the root. */
+  Node* root = cursor;
+  cursor = cursor->mNext;
+
+  Node* right = buildBalanced(cursor, count - 1 - leftCount);
+
+  /* Wire up the children. */
+  root->mChildren[0] = left;
+  root->mChildren[1] = right;
+  for (int i = 0; i < 2; ++i)
+    if (root->mChildren[i])
+      root->mChildren[i]->mParent = root;
+
+  /* Children are complete, so the height and summary can be computed. */
+  root->mHeight = 1 + std::max(height(left), height(right));
+  Augment::update(root);
+  return root;
+}
+
+/* release hands the whole tree over as a fragment. */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::Fragment
+avl_tree<Key, Value, Comparator, Augment>::release() {
+  Fragment result = { mRoot, mHead, mTail };
+  mRoot = mHead = mTail = NULL;
+  mSize = 0;
+  return result;
+}
+
+/* adopt installs a fragment, closing off the ends of its linked list. */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+void
+avl_tree<Key, Value, Comparator, Augment>::adopt(Fragment fragment,
+                                                 size_t size) {
+  mRoot = fragment.mRoot;
+  mHead = fragment.mFirst;
+  mTail = fragment.mLast;
+  mSize = size;
+
+  if (mHead) mHead->mPrev = NULL;
+  if (mTail) mTail->mNext = NULL;
+}
+
+/* A child subtree of a fragment's root stretches from the fragment's end on
+ * that side to the root's neighbor in the linked list, which is intact since
+ * the root is not at either end of the list when it has that child.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::Fragment
+avl_tree<Key, Value, Comparator, Augment>::childFragment(Node* root, int side,
+                                                         Node* outer) {
+  Fragment result = { root->mChildren[side], NULL, NULL };
+  if (result.mRoot == NULL) return result;
+
+  result.mRoot->mParent = NULL;
+  result.mFirst = side == 0? outer : root->mNext;
+  result.mLast  = side == 0? root->mPrev : outer;
+  return result;
+}
+
+/* If the two trees are within one of each other's height, the middle node
+ * can simply go on top.  Otherwise, we walk down the inner edge of the
+ * taller tree (its right spine if it is the left tree, and vice-versa) until
+ * reaching a subtree no more than one taller than the shorter tree, put the
+ * middle node in its place with it and the shorter tree as children, and
+ * rebalance upward from there as after an insertion.  The walk is as long as
+ * the difference in heights, so this is O(log n).
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::Node*
+avl_tree<Key, Value, Comparator, Augment>::joinTrees(Node* left, Node* mid,
+                                                     Node* right) {
+  mid->mChildren[0] = left;
+  mid->mChildren[1] = right;
+  mid->mParent = NULL;
+
+  /* Balanced case: the middle node becomes the root. */
+  if (std::abs(height(left) - height(right)) <= 1) {
+    for (int i = 0; i < 2; ++i)
+      if (mid->mChildren[i])
+        mid->mChildren[i]->mParent = mid;
+
+    mid->mHeight = 1 + std::max(height(left), height(right));
+    Augment::update(mid);
+    return mid;
+  }
+
+  /* Otherwise find which side is taller; we descend along the other side of
+   * it.
+   */
+  const int tallSide = height(left) < height(right);
+  Node* tall  = mid->mChildren[tallSide];
+  Node* small = mid->mChildren[!tallSide];
+
+  Node* parent = NULL;
+  Node* curr = tall;
+  while (height(curr) > height(small) + 1) {
+    parent = curr;
+    curr = curr->mChildren[!tallSide];
+  }
+
+  /* Put the middle node where we stopped. */
+  mid->mChildren[tallSide] = curr;
+  mid->mChildren[!tallSide] = small;
+  for (int i = 0; i < 2; ++i)
+    if (mid->mChildren[i])
+      mid->mChildren[i]->mParent = mid;
+  mid->mParent = parent;
+  parent->mChildren[!tallSide] = mid;
+
+  return rebalanceFrom(mid);
+}
+
+/* Joining fragments links the middle node in between the last node of the
+ * left fragment and the first node of the right one, then joins the trees.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::Fragment
+avl_tree<Key, Value, Comparator, Augment>::joinFragments(Fragment left,
+                                                         Node* mid,
+                                                         Fragment right) {
+  mid->mPrev = left.mLast;
+  if (left.mLast) left.mLast->mNext = mid;
+  mid->mNext = right.mFirst;
+  if (right.mFirst) right.mFirst->mPrev = mid;
+
+  Fragment result = { joinTrees(left.mRoot, mid, right.mRoot),
+                      left.mFirst? left.mFirst : mid,
+                      right.mLast? right.mLast : mid };
+  return result;
+}
+
+/* Without a middle node, borrow the last node of the left fragment.  It has
+ * no right child, so it can be spliced out like an erased node.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::Fragment
+avl_tree<Key, Value, Comparator, Augment>::joinFragments(Fragment left,
+                                                         Fragment right) {
+  if (left.mRoot == NULL) return right;
+  if (right.mRoot == NULL) return left;
+
+  Node* mid = left.mLast;
+  Node* parent = mid->mParent;
+  Node* child = spliceOut(mid);
+
+  if (mid == left.mFirst) {
+    Fragment empty = { NULL, NULL, NULL };
+    left = empty;
+  } else {
+    left.mRoot = parent? rebalanceFrom(parent) : child;
+    left.mLast = mid->mPrev;
+  }
+
+  return joinFragments(left, mid, right);
+}
+
+/* Splitting walks down the search path for the key.  Each node passed along
+ * the way is joined back together with the subtree on the side away from
+ * the key and whatever the recursion returns on that side.  These joins are
+ * between trees of increasing height, so their costs telescope to O(log n)
+ * in total.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+void
+avl_tree<Key, Value, Comparator, Augment>::splitFragment(Fragment tree,
+                                                         const Key& key,
+                                                         Fragment& less,
+                                                         Node*& found,
+                                                         Fragment& greater) const {
+  /* Base case: the empty tree splits into two empty trees. */
+  if (tree.mRoot == NULL) {
+    less = greater = tree;
+    found = NULL;
+    return;
+  }
+
+  Node* root = tree.mRoot;
+  Fragment left  = childFragment(root, 0, tree.mFirst);
+  Fragment right = childFragment(root, 1, tree.mLast);
+
+  if (mComp(key, root->mValue.first)) {
+    Fragment middle;
+    splitFragment(left, key, less, found, middle);
+    greater = joinFragments(middle, root, right);
+  } else if (mComp(root->mValue.first, key)) {
+    Fragment middle;
+    splitFragment(right, key, middle, found, greater);
+    less = joinFragments(left, root, middle);
+  } else {
+    less = left;
+    found = root;
+    greater = right;
+  }
+}
+
+/* Freeing a fragment walks its linked list, stopping at the last node since
+ * its outward pointer may point anywhere.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+void
+avl_tree<Key, Value, Comparator, Augment>::destroyFragment(Fragment fragment) {
+  Node* curr = fragment.mFirst;
+  while (curr != NULL) {
+    Node* next = curr == fragment.mLast? NULL : curr->mNext;
+    delete curr;
+    curr = next;
+  }
+}
+
+/* With subtree sizes the answer is at the root.  Otherwise we walk both
+ * lists in lockstep until one runs out, which costs time linear in the
+ * smaller fragment only.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+size_t
+avl_tree<Key, Value, Comparator, Augment>::firstFragmentSize(Fragment first,
+                                                             Fragment second,
+                                                             size_t total) {
+  if constexpr (Augment::kOrderStatistics) {
+    (void)second;
+    (void)total;
+    return subtreeSize(first.mRoot);
+  } else {
+    Node* x = first.mFirst, *y = second.mFirst;
+    for (size_t count = 0; ; ++count) {
+      if (x == NULL) return count;
+      if (y == NULL) return total - count;
+      x = x == first.mLast?  NULL : x->mNext;
+      y = y == second.mLast? NULL : y->mNext;
+    }
+  }
+}
+
+/* The union splits b around the root of a, recursively unions the pieces on
+ * either side, and joins the results back together around the root.  When
+ * b holds the root's key too, its copy is dropped.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::Fragment
+avl_tree<Key, Value, Comparator, Augment>::unionOf(Fragment a, Fragment b,
+                                                   int forks,
+                                                   size_t& duplicates) const {
+  if (a.mRoot == NULL) return b;
+  if (b.mRoot == NULL) return a;
+
+  const bool fork = forks > 0 &&
+                    std::min(height(a.mRoot), height(b.mRoot)) >= kForkHeight;
+
+  Node* root = a.mRoot;
+  Fragment aLess    = childFragment(root, 0, a.mFirst);
+  Fragment aGreater = childFragment(root, 1, a.mLast);
+
+  Fragment bLess, bGreater;
+  Node* found;
+  splitFragment(b, root->mValue.first, bLess, found, bGreater);
+  if (found) {
+    delete found;
+    ++duplicates;
+  }
+
+  /* The two halves share no nodes, so they can safely run in parallel. */
+  Fragment less, greater;
+  size_t greaterDuplicates = 0;
+  forkJoin(fork,
+           [&] { less = unionOf(aLess, bLess, forks - 1, duplicates); },
+           [&] { greater = unionOf(aGreater, bGreater, forks - 1,
+                                   greaterDuplicates); });
+  duplicates += greaterDuplicates;
+
+  return joinFragments(less, root, greater);
+}
+
+/* The intersection has the same shape as the union, but keeps the root of a
+ * only if b holds its key, and frees whatever is left over once either side
+ * runs out.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::Fragment
+avl_tree<Key, Value, Comparator, Augment>::intersectionOf(Fragment a,
+                                                          Fragment b, int forks,
+                                                          size_t& kept) const {
+  if (a.mRoot == NULL || b.mRoot == NULL) {
+    destroyFragment(a);
+    destroyFragment(b);
+    Fragment empty = { NULL, NULL, NULL };
+    return empty;
+  }
+
+  const bool fork = forks > 0 &&
+                    std::min(height(a.mRoot), height(b.mRoot)) >= kForkHeight;
+
+  Node* root = a.mRoot;
+  Fragment aLess    = childFragment(root, 0, a.mFirst);
+  Fragment aGreater = childFragment(root, 1, a.mLast);
+
+  Fragment bLess, bGreater;
+  Node* found;
+  splitFragment(b, root->mValue.first, bLess, found, bGreater);
+
+  Fragment less, greater;
+  size_t greaterKept = 0;
+  forkJoin(fork,
+           [&] { less = intersectionOf(aLess, bLess, forks - 1, kept); },
+           [&] { greater = intersectionOf(aGreater, bGreater, forks - 1,
+                                          greaterKept); });
+  kept += greaterKept;
+
+  if (found) {
+    delete found;
+    ++kept;
+    return joinFragments(less, root, greater);
+  }
+
+  delete root;
+  return joinFragments(less, greater);
+}
+
+/* The difference splits a around the root of b instead, since that root is
+ * known to be removed from a, and then joins what's left of the two halves.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::Fragment
+avl_tree<Key, Value, Comparator, Augment>::differenceOf(Fragment a, Fragment b,
+                                                        int forks,
+                                                        size_t& removed) const {
+  if (a.mRoot == NULL || b.mRoot == NULL) {
+    destroyFragment(b);
+    return a;
+  }
+
+  const bool fork = forks > 0 &&
+                    std::min(height(a.mRoot), height(b.mRoot)) >= kForkHeight;
+
+  Node* root = b.mRoot;
+  Fragment bLess    = childFragment(root, 0, b.mFirst);
+  Fragment bGreater = childFragment(root, 1, b.mLast);
+
+  Fragment aLess, aGreater;
+  Node* found;
+  splitFragment(a, root->mValue.first, aLess, found, aGreater);
+  delete root;
+  if (found) {
+    delete found;
+    ++removed;
+  }
+
+  Fragment less, greater;
+  size_t greaterRemoved = 0;
+  forkJoin(fork,
+           [&] { less = differenceOf(aLess, bLess, forks - 1, removed); },
+           [&] { greater = differenceOf(aGreater, bGreater, forks - 1,
+                                        greaterRemoved); });
+  removed += greaterRemoved;
+
+  return joinFragments(less, greater);
+}
+
+/* Each level of forking doubles the number of threads at work, so we fork
+ * at as many levels as it takes to reach the budget.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+int avl_tree<Key, Value, Comparator, Augment>::forkDepth(unsigned threads) {
+  if (threads == 0) threads = std::thread::hardware_concurrency();
+
+  int depth = 0;
+  while (depth < 16 && (1u << depth) < threads)
+    ++depth;
+  return depth;
+}
+
+/* forkJoin runs the first task on a new thread and the second one here.  If
+ * no thread can be started, both run here.  An exception from the first task
+ * is handed back once both are done.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+template <typename First, typename Second>
+void
+avl_tree<Key, Value, Comparator, Augment>::forkJoin(bool fork,
+                                                    const First& first,
+                                                    const Second& second) {
+  if (!fork) {
+    first();
+    second();
+    return;
+  }
+
+  std::exception_ptr error;
+  std::thread worker;
+  try {
+    worker = std::thread([&first, &error] {
+      try {
+        first();
+      } catch (...) {
+        error = std::current_exception();
+      }
+    });
+  } catch (const std::system_error&) {
+    first();
+    second();
+    return;
+  }
+
+  try {
+    second();
+  } catch (...) {
+    worker.join();
+    throw;
+  }
+  worker.join();
+
+  if (error) std::rethrow_exception(error);
+}
+
+/* join with a key allocates the middle node first, so that a failed
+ * allocation leaves both trees as they were.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+void
+avl_tree<Key, Value, Comparator, Augment>::join(const Key& key,
+                                                const Value& value,
+                                                avl_tree& right) {
+  assert (&right != this);
+  assert (!mTail || mComp(mTail->mValue.first, key));
+  assert (!right.mHead || mComp(key, right.mHead->mValue.first));
+
+  Node* mid = new Node(key, value, 1);
+  const size_t total = mSize + right.mSize + 1;
+  Fragment left = release();
+  adopt(joinFragments(left, mid, right.release()), total);
+}
+template <typename Key, typename Value, typename Comparator, typename Augment>
+void avl_tree<Key, Value, Comparator, Augment>::join(avl_tree& right) {
+  if (&right == this) return;
+  assert (!mTail || !right.mHead ||
+          mComp(mTail->mValue.first, right.mHead->mValue.first));
+
+  const size_t total = mSize + right.mSize;
+  Fragment left = release();
+  adopt(joinFragments(left, right.release()), total);
+}
+
+/* split puts the node with the key itself, if there is one, at the front of
+ * the upper half.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+void
+avl_tree<Key, Value, Comparator, Augment>::split(const Key& key,
+                                                 avl_tree& right) {
+  assert (&right != this);
+
+  destroyFragment(right.release());
+  right.mComp = mComp;
+
+  const size_t total = mSize;
+  Fragment less, greater;
+  Node* found;
+  splitFragment(release(), key, less, found, greater);
+  if (found) {
+    Fragment empty = { NULL, NULL, NULL };
+    greater = joinFragments(empty, found, greater);
+  }
+
+  const size_t lessSize = firstFragmentSize(less, greater, total);
+  adopt(less, lessSize);
+  right.adopt(greater, total - lessSize);
+}
+
+/* The set operations hand both trees to the recursive implementations as
+ * fragments, and install the result here.  The sizes follow from what the
+ * recursion counted.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+void
+avl_tree<Key, Value, Comparator, Augment>::union_with(avl_tree& other,
+                                                      unsigned threads) {
+  if (&other == this) return;
+
+  const size_t total = mSize + other.mSize;
+  size_t duplicates = 0;
+  Fragment a = release();
+  Fragment result = unionOf(a, other.release(), forkDepth(threads),
+                            duplicates);
+  adopt(result, total - duplicates);
+}
+template <typename Key, typename Value, typename Comparator, typename Augment>
+void
+avl_tree<Key, Value, Comparator, Augment>::intersect_with(avl_tree& other,
+                                                          unsigned threads) {
+  if (&other == this) return;
+
+  size_t kept = 0;
+  Fragment a = release();
+  Fragment result = intersectionOf(a, other.release(), forkDepth(threads),
+                                   kept);
+  adopt(result, kept);
+}
+template <typename Key, typename Value, typename Comparator, typename Augment>
+void
+avl_tree<Key, Value, Comparator, Augment>::difference_with(avl_tree& other,
+                                                           unsigned threads) {
+  if (&other == this) {
+    destroyFragment(release());
+    return;
+  }
+
+  const size_t total = mSize;
+  size_t removed = 0;
+  Fragment a = release();
+  Fragment result = differenceOf(a, other.release(), forkDepth(threads),
+                                 removed);
+  adopt(result, total - removed);
+}
+
 /* Assignment operator implemented using copy-and-swap. */
-template <typename Key, typename Value, typename Comparator>
-avl_tree<Key, Value, Comparator>&
-avl_tree<Key, Value, Comparator>::operator= (const avl_tree& other) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+avl_tree<Key, Value, Comparator, Augment>&
+avl_tree<Key, Value, Comparator, Augment>::operator= (const avl_tree& other) {
   avl_tree clone = other;
   swap(clone);
   return *this;
 }
 
 /* swap just does an element-by-element swap. */
-template <typename Key, typename Value, typename Comparator>
-void avl_tree<Key, Value, Comparator>::swap(avl_tree& other) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+void avl_tree<Key, Value, Comparator, Augment>::swap(avl_tree& other) {
   /* Use std::swap to get the job done. */
   std::swap(mRoot, other.mRoot);
   std::swap(mSize, other.mSize);
@@ -1277,9 +2346,9 @@ void avl_tree<Key, Value, Comparator>::swap(avl_tree& other) {
  * found the predecessor or successor of the node in question, and correct it
  * to the resulting node.
  */
-template <typename Key, typename Value, typename Comparator>
-typename avl_tree<Key, Value, Comparator>::const_iterator
-avl_tree<Key, Value, Comparator>::lower_bound(const Key& key) const {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::const_iterator
+avl_tree<Key, Value, Comparator, Augment>::lower_bound(const Key& key) const {
   /* One unusual edge case that complicates the logic here is what to do if
    * the tree is empty.  If this happens, then the lower_bound is end().
    */
@@ -1311,9 +2380,9 @@ avl_tree<Key, Value, Comparator>::lower_bound(const Key& key) const {
 /* Non-const version of this function implemented by calling the const version
  * and stripping constness.
  */
-template <typename Key, typename Value, typename Comparator>
-typename avl_tree<Key, Value, Comparator>::iterator
-avl_tree<Key, Value, Comparator>::lower_bound(const Key& key) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::iterator
+avl_tree<Key, Value, Comparator, Augment>::lower_bound(const Key& key) {
   /* Call the const version to get the answer. */
   const_iterator result = static_cast<const avl_tree*>(this)->lower_bound(key);
 
@@ -1325,10 +2394,10 @@ avl_tree<Key, Value, Comparator>::lower_bound(const Key& key) {
  * back iterators spanning it.  If not, it just hands back two iterators to the
  * same spot.
  */
-template <typename Key, typename Value, typename Comparator>
-std::pair<typename avl_tree<Key, Value, Comparator>::const_iterator,
-          typename avl_tree<Key, Value, Comparator>::const_iterator>
-avl_tree<Key, Value, Comparator>::equal_range(const Key& key) const {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+std::pair<typename avl_tree<Key, Value, Comparator, Augment>::const_iterator,
+          typename avl_tree<Key, Value, Comparator, Augment>::const_iterator>
+avl_tree<Key, Value, Comparator, Augment>::equal_range(const Key& key) const {
   /* Call lower_bound to find out where we should start looking. */
   std::pair<const_iterator, const_iterator> result;
   result.first = result.second = lower_bound(key);
@@ -1346,10 +2415,10 @@ avl_tree<Key, Value, Comparator>::equal_range(const Key& key) const {
 }
 
 /* Non-const version calls the const version, then strips off constness. */
-template <typename Key, typename Value, typename Comparator>
-std::pair<typename avl_tree<Key, Value, Comparator>::iterator,
-          typename avl_tree<Key, Value, Comparator>::iterator>
-avl_tree<Key, Value, Comparator>::equal_range(const Key& key) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+std::pair<typename avl_tree<Key, Value, Comparator, Augment>::iterator,
+          typename avl_tree<Key, Value, Comparator, Augment>::iterator>
+avl_tree<Key, Value, Comparator, Augment>::equal_range(const Key& key) {
   /* Invoke const version to get the iterators. */
   std::pair<const_iterator, const_iterator> result =
     static_cast<const avl_tree*>(this)->equal_range(key);
@@ -1360,57 +2429,242 @@ avl_tree<Key, Value, Comparator>::equal_range(const Key& key) {
 }
 
 /* upper_bound just calls equal_range and returns the second value. */
-template <typename Key, typename Value, typename Comparator>
-typename avl_tree<Key, Value, Comparator>::iterator
-avl_tree<Key, Value, Comparator>::upper_bound(const Key& key) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::iterator
+avl_tree<Key, Value, Comparator, Augment>::upper_bound(const Key& key) {
   return equal_range(key).second;
 }
-template <typename Key, typename Value, typename Comparator>
-typename avl_tree<Key, Value, Comparator>::const_iterator
-avl_tree<Key, Value, Comparator>::upper_bound(const Key& key) const {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::const_iterator
+avl_tree<Key, Value, Comparator, Augment>::upper_bound(const Key& key) const {
   return equal_range(key).second;
 }
 
+/* subtreeSize reads the count kept by the order_statistics augmentation.
+ * Every order-statistic operation funnels through here, so this is also where
+ * a tree without that augmentation is rejected at compile time.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+size_t avl_tree<Key, Value, Comparator, Augment>::subtreeSize(const Node* node) {
+  static_assert(Augment::kOrderStatistics,
+                "select, rank, count_range and iterator arithmetic require "
+                "the order_statistics augmentation");
+  return node? node->mCount : 0;
+}
+
+/* selectNode walks down from the root.  The left subtree holds exactly the
+ * first subtreeSize(left) elements, so the index either falls in there, names
+ * the current node, or falls in the right subtree once those elements and the
+ * current node are skipped.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::Node*
+avl_tree<Key, Value, Comparator, Augment>::selectNode(size_t index) const {
+  Node* curr = mRoot;
+  while (curr != NULL) {
+    const size_t leftSize = subtreeSize(curr->mChildren[0]);
+
+    if (index < leftSize)
+      curr = curr->mChildren[0];
+    else if (index == leftSize)
+      return curr;
+    else {
+      index -= leftSize + 1;
+      curr = curr->mChildren[1];
+    }
+  }
+
+  /* Walking off the tree means the index was past the end. */
+  return NULL;
+}
+
+/* indexOf runs the same computation in reverse: the node is preceded by its
+ * left subtree, and by the left subtree and the node itself of every ancestor
+ * that it is reached from on the right.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+size_t avl_tree<Key, Value, Comparator, Augment>::indexOf(const Node* node) const {
+  /* The end of the sequence sits just past the last element. */
+  if (node == NULL) return subtreeSize(mRoot);
+
+  size_t index = subtreeSize(node->mChildren[0]);
+  for (; node->mParent != NULL; node = node->mParent) {
+    if (node == node->mParent->mChildren[1])
+      index += subtreeSize(node->mParent->mChildren[0]) + 1;
+  }
+  return index;
+}
+
+/* countBelow does a BST search for the key, and every time the search goes
+ * right it counts the node it leaves behind along with that node's left
+ * subtree, all of which are below the key.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+size_t avl_tree<Key, Value, Comparator, Augment>::countBelow(const Key& key, bool inclusive) const {
+  size_t result = 0;
+  for (Node* curr = mRoot; curr != NULL; ) {
+    /* Go right if this node's key belongs in the count. */
+    const bool below = inclusive? !mComp(key, curr->mValue.first)
+                                :  mComp(curr->mValue.first, key);
+    if (below) {
+      result += subtreeSize(curr->mChildren[0]) + 1;
+      curr = curr->mChildren[1];
+    } else
+      curr = curr->mChildren[0];
+  }
+  return result;
+}
+
+/* select wraps up whatever selectNode finds; running off the end of the tree
+ * yields NULL, which is end().
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::const_iterator
+avl_tree<Key, Value, Comparator, Augment>::select(size_t index) const {
+  return const_iterator(this, selectNode(index));
+}
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::iterator
+avl_tree<Key, Value, Comparator, Augment>::select(size_t index) {
+  return iterator(this, selectNode(index));
+}
+
+/* rank counts the keys strictly below the given one. */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+size_t avl_tree<Key, Value, Comparator, Augment>::rank(const Key& key) const {
+  return countBelow(key, false);
+}
+
+/* count_range counts keys up to and including hi, minus those strictly
+ * below lo.  If hi < lo the first count is the smaller one, so check for
+ * that rather than wrapping around.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+size_t avl_tree<Key, Value, Comparator, Augment>::count_range(const Key& lo, const Key& hi) const {
+  if (mComp(hi, lo)) return 0;
+  return countBelow(hi, true) - countBelow(lo, false);
+}
+
+/* aggregate first walks down to the highest node inside [lo, hi], the one
+ * where the searches for lo and hi part ways.  Everything in range then lies
+ * on either side of that node: continuing toward lo inside its left subtree,
+ * each node at or above lo contributes itself and its whole right subtree,
+ * and symmetrically for hi on the right.  Both walks are O(log n), and the
+ * pieces are combined in key order throughout.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::aggregate_type
+avl_tree<Key, Value, Comparator, Augment>::aggregate(const Key& lo, const Key& hi) const {
+  static_assert(!std::is_void<aggregate_type>::value,
+                "aggregate requires a monoid_augmentation");
+  typedef typename Augment::Monoid Monoid;
+
+  /* Find where the two searches diverge. */
+  Node* split = mRoot;
+  while (split != NULL) {
+    if (mComp(split->mValue.first, lo))
+      split = split->mChildren[1];
+    else if (mComp(hi, split->mValue.first))
+      split = split->mChildren[0];
+    else
+      break;
+  }
+
+  /* If they never did, nothing is in range (possibly because hi < lo). */
+  if (split == NULL) return Monoid::identity();
+
+  /* Collect the part of the range below the split node.  Each node found is
+   * smaller than everything collected so far, so it goes on the front.
+   */
+  aggregate_type below = Monoid::identity();
+  for (Node* curr = split->mChildren[0]; curr != NULL; ) {
+    if (mComp(curr->mValue.first, lo))
+      curr = curr->mChildren[1];
+    else {
+      aggregate_type piece = Monoid::lift(curr->mValue);
+      if (curr->mChildren[1])
+        piece = Monoid::combine(piece, curr->mChildren[1]->mAggregate);
+      below = Monoid::combine(piece, below);
+      curr = curr->mChildren[0];
+    }
+  }
+
+  /* Collect the part above it the same way, appending to the back. */
+  aggregate_type above = Monoid::identity();
+  for (Node* curr = split->mChildren[1]; curr != NULL; ) {
+    if (mComp(hi, curr->mValue.first))
+      curr = curr->mChildren[0];
+    else {
+      aggregate_type piece = Monoid::lift(curr->mValue);
+      if (curr->mChildren[0])
+        piece = Monoid::combine(curr->mChildren[0]->mAggregate, piece);
+      above = Monoid::combine(above, piece);
+      curr = curr->mChildren[1];
+    }
+  }
+
+  return Monoid::combine(Monoid::combine(below, Monoid::lift(split->mValue)),
+                         above);
+}
+
+/* The aggregate of the whole tree is cached at the root. */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+typename avl_tree<Key, Value, Comparator, Augment>::aggregate_type
+avl_tree<Key, Value, Comparator, Augment>::aggregate() const {
+  static_assert(!std::is_void<aggregate_type>::value,
+                "aggregate requires a monoid_augmentation");
+  return mRoot? mRoot->mAggregate : Augment::Monoid::identity();
+}
+
+/* refresh recomputes every summary on the path from the node to the root,
+ * which are exactly the ones whose subtrees contain it.
+ */
+template <typename Key, typename Value, typename Comparator, typename Augment>
+void avl_tree<Key, Value, Comparator, Augment>::refresh(iterator where) {
+  for (Node* curr = where.mCurr; curr != NULL; curr = curr->mParent)
+    Augment::update(curr);
+}
+
 /* Comparison operators == and < use the standard STL algorithms. */
-template <typename Key, typename Value, typename Comparator>
-bool operator<  (const avl_tree<Key, Value, Comparator>& lhs,
-                 const avl_tree<Key, Value, Comparator>& rhs) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+bool operator<  (const avl_tree<Key, Value, Comparator, Augment>& lhs,
+                 const avl_tree<Key, Value, Comparator, Augment>& rhs) {
   return std::lexicographical_compare(lhs.begin(), lhs.end(),
                                       rhs.begin(), rhs.end());
 }
-template <typename Key, typename Value, typename Comparator>
-bool operator== (const avl_tree<Key, Value, Comparator>& lhs,
-                 const avl_tree<Key, Value, Comparator>& rhs) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+bool operator== (const avl_tree<Key, Value, Comparator, Augment>& lhs,
+                 const avl_tree<Key, Value, Comparator, Augment>& rhs) {
   return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), 
                                                 rhs.begin());
 }
 
 /* Remaining comparisons implemented in terms of the above comparisons. */
-template <typename Key, typename Value, typename Comparator>
-bool operator<= (const avl_tree<Key, Value, Comparator>& lhs,
-                 const avl_tree<Key, Value, Comparator>& rhs) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+bool operator<= (const avl_tree<Key, Value, Comparator, Augment>& lhs,
+                 const avl_tree<Key, Value, Comparator, Augment>& rhs) {
   /* x <= y   iff !(x > y)   iff !(y < x) */
   return !(rhs < lhs);
 }
-template <typename Key, typename Value, typename Comparator>
-bool operator!= (const avl_tree<Key, Value, Comparator>& lhs,
-                 const avl_tree<Key, Value, Comparator>& rhs) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+bool operator!= (const avl_tree<Key, Value, Comparator, Augment>& lhs,
+                 const avl_tree<Key, Value, Comparator, Augment>& rhs) {
   return !(lhs == rhs);
 }
-template <typename Key, typename Value, typename Comparator>
-bool operator>= (const avl_tree<Key, Value, Comparator>& lhs,
-                 const avl_tree<Key, Value, Comparator>& rhs) {
+template <typename Key, typename Value, typename Comparator, typename Augment>
+bool operator>= (const avl_tree<Key, Value, Comparator, Augment>& lhs,
+                 const avl_tree<Key, Value, Comparator, Augment>& rhs) {
   /* x >= y   iff !(x < y) */
   return !(lhs < rhs);
 }
-template <typename Key, typename Value, typename Comparator>
+template <typename Key, typename Value, typename Comparator, typename Augment>
 
-bool operator>  (const avl_tree<Key, Value, Comparator>& lhs,
-                 const avl_tree<Key, Value, Comparator>& rhs) {
+bool operator>  (const avl_tree<Key, Value, Comparator, Augment>& lhs,
+                 const avl_tree<Key, Value, Comparator, Augment>& rhs) {
   /* x > y iff y < x */
   return rhs < lhs;
 }
 
 } // namespace util.
 
-#endif AVL_TREE_H_
\ No newline at end of file
+#endif // AVL_TREE_H_
\ No newline at end of file
@@ -0,0 +1,141 @@
+// Times building an avl_tree from sorted input, one insert per key against
+// assign_sorted, then a pass of random finds over each result to show the
+// effect of node placement on lookups. Then times merging a second tree of
+// a tenth and of the same size into it, inserting its elements one by one
+// against union_with on one thread and on every hardware thread, and moving
+// the upper half into another tree with erase and insert against split.
+// Usage: avl_tree_benchmark [keys]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "avl_tree.h"
+
+namespace {
+
+typedef util::avl_tree<uint64_t, uint64_t> tree_type;
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Looks up every probe key and returns ns per lookup.
+double time_finds(const tree_type& tree, const std::vector<uint64_t>& probes) {
+  uint64_t found = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t k : probes) {
+    found += tree.find(k) != tree.end();
+  }
+  double elapsed = seconds_since(start);
+  if (found != probes.size()) {
+    std::printf("lookup mismatch\n");
+    std::exit(1);
+  }
+  return elapsed * 1e9 / probes.size();
+}
+
+// A tree of n keys from a shuffled range, so that two such trees overlap
+// but are not identical.
+tree_type random_tree(size_t n, uint64_t seed) {
+  std::vector<std::pair<uint64_t, uint64_t>> input;
+  input.reserve(n);
+  std::mt19937_64 rng(seed);
+  for (size_t i = 0; i < n; ++i) {
+    input.emplace_back(rng() % (n * 4), i);
+  }
+  std::sort(input.begin(), input.end());
+  return tree_type(util::sorted_range, input.begin(), input.end());
+}
+
+// Times union_with on the given number of threads, in ms.
+double time_union(size_t n, size_t m, unsigned threads) {
+  tree_type a = random_tree(n, 2);
+  tree_type b = random_tree(m, 3);
+  auto start = std::chrono::steady_clock::now();
+  a.union_with(b, threads);
+  return seconds_since(start) * 1e3;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+
+  std::vector<std::pair<uint64_t, uint64_t>> input;
+  input.reserve(n);
+  for (uint64_t i = 0; i < n; ++i) {
+    input.emplace_back(i * 2, i);
+  }
+  std::vector<uint64_t> probes(n);
+  std::mt19937_64 rng(1);
+  for (uint64_t& k : probes) {
+    k = (rng() % n) * 2;
+  }
+
+  std::printf("%zu sorted keys\n", n);
+  std::printf("%-14s %12s %12s\n", "build", "ns/key", "find ns");
+
+  {
+    auto start = std::chrono::steady_clock::now();
+    tree_type tree;
+    for (const auto& kv : input) {
+      tree.insert(kv.first, kv.second);
+    }
+    double build = seconds_since(start) * 1e9 / n;
+    std::printf("%-14s %12.1f %12.1f\n", "insert", build, time_finds(tree, probes));
+  }
+  {
+    auto start = std::chrono::steady_clock::now();
+    tree_type tree(util::sorted_range, input.begin(), input.end());
+    double build = seconds_since(start) * 1e9 / n;
+    std::printf("%-14s %12.1f %12.1f\n", "assign_sorted", build,
+                time_finds(tree, probes));
+  }
+
+  unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+  std::printf("\nmerge into %zu keys (ms)\n", n);
+  std::printf("%-10s %12s %12s %12s\n", "other", "insert", "union 1t", "union all");
+  const size_t others[] = {n / 10, n};
+  for (size_t m : others) {
+    double insert;
+    {
+      tree_type a = random_tree(n, 2);
+      tree_type b = random_tree(m, 3);
+      auto start = std::chrono::steady_clock::now();
+      for (const auto& kv : b) {
+        a.insert(kv.first, kv.second);
+      }
+      insert = seconds_since(start) * 1e3;
+    }
+    std::printf("%-10zu %12.1f %12.1f %12.1f\n", m, insert, time_union(n, m, 1),
+                time_union(n, m, hardware));
+  }
+
+  std::printf("\nmove the upper half out (ms)\n");
+  {
+    tree_type a = random_tree(n, 2);
+    tree_type b;
+    uint64_t cut = n * 2;
+    auto start = std::chrono::steady_clock::now();
+    for (auto itr = a.lower_bound(cut); itr != a.end();) {
+      b.insert(itr->first, itr->second);
+      itr = a.erase(itr);
+    }
+    std::printf("%-14s %12.1f\n", "erase+insert", seconds_since(start) * 1e3);
+  }
+  {
+    tree_type a = random_tree(n, 2);
+    tree_type b;
+    auto start = std::chrono::steady_clock::now();
+    a.split(n * 2, b);
+    std::printf("%-14s %12.1f\n", "split", seconds_since(start) * 1e3);
+  }
+  return 0;
+}
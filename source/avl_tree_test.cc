@@ -1,4 +1,9 @@
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <random>
 #include <string>
+#include <vector>
 
 #include "avl_tree.h"
 #include "gtest/gtest.h"
@@ -8,6 +13,325 @@ TEST(MyAvlTree, DefaultConstructor) {
 
   EXPECT_EQ(0u, tree.size());
 }
+
+TEST(MyAvlTree, OrderStatistics) {
+  typedef util::avl_tree<int, int, std::less<int>, util::order_statistics> Tree;
+  Tree tree;
+
+  std::vector<int> keys;
+  for (int i = 0; i < 2000; i += 2) keys.push_back(i);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(7));
+  for (int key : keys) tree.insert(key, -key);
+
+  // Erase every multiple of three so the counts go through both erase cases.
+  for (int key : keys)
+    if (key % 3 == 0) tree.erase(key);
+
+  std::vector<int> expected;
+  for (int i = 0; i < 2000; i += 2)
+    if (i % 3 != 0) expected.push_back(i);
+  ASSERT_EQ(expected.size(), tree.size());
+
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_EQ(expected[i], tree.select(i)->first);
+  }
+  EXPECT_TRUE(tree.select(expected.size()) == tree.end());
+
+  for (int key = -1; key <= 2001; ++key) {
+    const size_t below =
+      std::lower_bound(expected.begin(), expected.end(), key) - expected.begin();
+    ASSERT_EQ(below, tree.rank(key));
+  }
+
+  EXPECT_EQ(expected.size(), tree.count_range(-10, 5000));
+  EXPECT_EQ(2u, tree.count_range(2, 4));
+  EXPECT_EQ(1u, tree.count_range(3, 4));
+  EXPECT_EQ(0u, tree.count_range(6, 6));
+  EXPECT_EQ(0u, tree.count_range(10, 2));
+  EXPECT_EQ(size_t(std::distance(tree.lower_bound(100), tree.upper_bound(900))),
+            tree.count_range(100, 900));
+
+  // A copy carries its counts along.
+  const Tree copy(tree);
+  EXPECT_EQ(expected[expected.size() / 2], copy.select(copy.size() / 2)->first);
+  EXPECT_EQ(tree.rank(1000), copy.rank(1000));
+}
+
+TEST(MyAvlTree, OrderStatisticsIterators) {
+  util::avl_tree<int, int, std::less<int>, util::order_statistics> tree;
+  for (int i = 0; i < 500; ++i) tree.insert(i * 10, i);
+
+  util::avl_tree<int, int, std::less<int>, util::order_statistics>::iterator
+    itr = tree.begin();
+  itr += 250;
+  EXPECT_EQ(2500, itr->first);
+  itr -= 100;
+  EXPECT_EQ(1500, itr->first);
+  EXPECT_EQ(1510, (itr + 1)->first);
+  EXPECT_EQ(1490, (itr - 1)->first);
+  EXPECT_EQ(1600, (10 + itr)->first);
+  EXPECT_EQ(2, itr[2 - 150].second);
+  EXPECT_EQ(150, itr - tree.begin());
+  EXPECT_EQ(500, tree.end() - tree.begin());
+  EXPECT_EQ(350, std::distance(itr, tree.end()));
+  EXPECT_TRUE(tree.begin() + 500 == tree.end());
+  EXPECT_TRUE(tree.end() - 1 == tree.find(4990));
+  EXPECT_TRUE(tree.begin() < itr);
+  EXPECT_TRUE(itr <= itr);
+  EXPECT_FALSE(itr > tree.end());
+
+  // Arithmetic mixes iterator and const_iterator like equality does.
+  const auto& constTree = tree;
+  EXPECT_EQ(0, constTree.find(1500) - itr);
+  EXPECT_EQ(3, constTree.rbegin().base() - (tree.end() - 3));
+}
+
+namespace {
+
+// Concatenates keys in order, so any out-of-order combine shows up.
+struct KeyOrderMonoid {
+  typedef std::string value_type;
+  static std::string identity() { return std::string(); }
+  static std::string lift(const std::pair<const int, int>& entry) {
+    return std::to_string(entry.first) + ",";
+  }
+  static std::string combine(const std::string& lhs, const std::string& rhs) {
+    return lhs + rhs;
+  }
+};
+
+}  // namespace
+
+TEST(MyAvlTree, MonoidAggregates) {
+  util::avl_tree<int, int, std::less<int>,
+                 util::monoid_augmentation<util::sum_monoid<long> > > sums;
+  util::avl_tree<int, int, std::less<int>,
+                 util::monoid_augmentation<util::min_monoid<int> > > mins;
+  util::avl_tree<int, int, std::less<int>,
+                 util::monoid_augmentation<util::max_monoid<int> > > maxes;
+  util::avl_tree<int, int, std::less<int>,
+                 util::monoid_augmentation<KeyOrderMonoid> > order;
+
+  std::vector<int> keys;
+  for (int i = 0; i < 300; ++i) keys.push_back(i);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(11));
+  for (int key : keys) {
+    const int value = (key * 37) % 101 - 50;
+    sums.insert(key, value);
+    mins.insert(key, value);
+    maxes.insert(key, value);
+    order.insert(key, value);
+  }
+  for (int key : keys) {
+    if (key % 4 == 1) {
+      sums.erase(key);
+      mins.erase(key);
+      maxes.erase(key);
+      order.erase(key);
+    }
+  }
+
+  for (int lo = -5; lo < 310; lo += 7) {
+    for (int hi = lo - 3; hi < 310; hi += 13) {
+      long sum = 0;
+      int least = std::numeric_limits<int>::max();
+      int most = std::numeric_limits<int>::lowest();
+      std::string seen;
+      for (auto itr = sums.lower_bound(lo);
+           itr != sums.end() && itr->first <= hi; ++itr) {
+        sum += itr->second;
+        least = std::min(least, itr->second);
+        most = std::max(most, itr->second);
+        seen += std::to_string(itr->first) + ",";
+      }
+      ASSERT_EQ(sum, sums.aggregate(lo, hi));
+      ASSERT_EQ(least, mins.aggregate(lo, hi));
+      ASSERT_EQ(most, maxes.aggregate(lo, hi));
+      ASSERT_EQ(seen, order.aggregate(lo, hi));
+    }
+  }
+  EXPECT_EQ(sums.aggregate(-1, 1000), sums.aggregate());
+
+  // Subtree sizes come along with the aggregates.
+  EXPECT_EQ(sums.size(), sums.count_range(0, 299));
+
+  // Changing a value in place needs a refresh before aggregates see it.
+  const long before = sums.aggregate(10, 20);
+  sums.find(12)->second += 1000;
+  sums.refresh(sums.find(12));
+  EXPECT_EQ(before + 1000, sums.aggregate(10, 20));
+
+  // A copy keeps its aggregates.
+  const util::avl_tree<int, int, std::less<int>,
+                 util::monoid_augmentation<util::sum_monoid<long> > > copy(sums);
+  EXPECT_EQ(sums.aggregate(), copy.aggregate());
+}
+
+TEST(MyAvlTree, AssignSorted) {
+  std::vector<std::pair<int, int> > input;
+  for (int i = 0; i < 1000; ++i) {
+    input.push_back(std::make_pair(i * 3, i));
+    if (i % 100 == 0) input.push_back(std::make_pair(i * 3, -1));
+  }
+
+  typedef util::avl_tree<int, int, std::less<int>,
+                         util::monoid_augmentation<util::sum_monoid<long> > > Tree;
+  Tree tree(util::sorted_range, input.begin(), input.end());
+  ASSERT_EQ(1000u, tree.size());
+
+  // Repeated keys keep their first value, and the list runs in order.
+  int expected = 0;
+  for (Tree::iterator itr = tree.begin(); itr != tree.end(); ++itr, ++expected) {
+    ASSERT_EQ(expected * 3, itr->first);
+    ASSERT_EQ(expected, itr->second);
+  }
+  EXPECT_EQ(999, (--tree.end())->second);
+  EXPECT_EQ(2, Tree::reverse_iterator(tree.find(2994)) - tree.rbegin());
+
+  // Sizes and aggregates are built along with the tree.
+  EXPECT_EQ(500, tree.select(500)->second);
+  EXPECT_EQ(999L * 1000 / 2, tree.aggregate());
+  EXPECT_EQ(10 + 11 + 12, tree.aggregate(30, 36));
+
+  // The result is an ordinary tree afterwards.
+  tree.insert(1, 1);
+  EXPECT_TRUE(tree.erase(0));
+  EXPECT_TRUE(tree.erase(1500));
+  EXPECT_EQ(999u, tree.size());
+  EXPECT_EQ(1, tree.select(0)->first);
+  EXPECT_EQ(999L * 1000 / 2 + 1 - 500, tree.aggregate());
+
+  // Reassigning replaces the old contents entirely.
+  std::vector<std::pair<int, int> > small(1, std::make_pair(42, 7));
+  tree.assign_sorted(small.begin(), small.end());
+  EXPECT_EQ(1u, tree.size());
+  EXPECT_EQ(7, tree.at(42));
+  EXPECT_TRUE(tree.find(3) == tree.end());
+
+  tree.assign_sorted(small.end(), small.end());
+  EXPECT_TRUE(tree.empty());
+  EXPECT_TRUE(tree.begin() == tree.end());
+}
+
+namespace {
+
+// Checks that tree holds exactly the keys of expected, in order both ways,
+// each mapped to its key's value in expected.
+template <typename Tree>
+void ExpectContents(const std::vector<std::pair<int, int> >& expected,
+                    const Tree& tree) {
+  auto same = [](const std::pair<int, int>& lhs,
+                 const std::pair<const int, int>& rhs) {
+    return lhs.first == rhs.first && lhs.second == rhs.second;
+  };
+  ASSERT_EQ(expected.size(), tree.size());
+  EXPECT_TRUE(std::equal(expected.begin(), expected.end(), tree.begin(), same));
+  EXPECT_TRUE(std::equal(expected.rbegin(), expected.rend(), tree.rbegin(), same));
+}
+
+}  // namespace
+
+TEST(MyAvlTree, JoinAndSplit) {
+  util::avl_tree<int, int> lower, upper;
+  std::vector<std::pair<int, int> > all;
+  for (int i = 0; i < 1000; ++i) {
+    all.push_back(std::make_pair(i, i * i));
+    (i < 10 ? lower : upper).insert(i, i * i);
+  }
+  upper.erase(500);
+
+  // Very different heights on either side of the new key.
+  lower.join(upper);
+  EXPECT_TRUE(upper.empty());
+  lower.insert(500, 500 * 500);
+  ExpectContents(all, lower);
+
+  // Split at a present key, an absent key, and past either end.
+  const int cuts[] = { 500, 2000, 0, -5, 999 };
+  for (int cut : cuts) {
+    lower.split(cut, upper);
+    std::vector<std::pair<int, int> > below(all.begin(),
+                                           all.begin() + std::max(0, std::min(cut, 1000)));
+    std::vector<std::pair<int, int> > above(all.begin() + below.size(), all.end());
+    ExpectContents(below, lower);
+    ExpectContents(above, upper);
+
+    lower.join(upper);
+    ExpectContents(all, lower);
+  }
+
+  // Join around a new middle key.
+  util::avl_tree<int, int, std::less<int>, util::order_statistics> left, right;
+  for (int i = 0; i < 100; ++i) left.insert(i, 0);
+  for (int i = 101; i < 103; ++i) right.insert(i, 0);
+  left.join(100, 1, right);
+  EXPECT_EQ(103u, left.size());
+  EXPECT_EQ(1, left.select(100)->second);
+  EXPECT_EQ(102, left.select(102)->first);
+
+  left.split(50, right);
+  EXPECT_EQ(50u, left.size());
+  EXPECT_EQ(53u, right.size());
+  EXPECT_EQ(50, right.select(0)->first);
+}
+
+TEST(MyAvlTree, SetOperations) {
+  std::mt19937 rng(3);
+  const unsigned threadCounts[] = { 1, 4 };
+  for (unsigned threads : threadCounts) {
+    for (int round = 0; round < 12; ++round) {
+      const int sizes[] = { 0, 1, 50, 3000, 20000 };
+      const int aSize = sizes[round % 5], bSize = sizes[(round * 3 + 1) % 5];
+
+      std::vector<std::pair<int, int> > a, b;
+      for (int i = 0; i < aSize; ++i) a.push_back(std::make_pair(int(rng() % 40000), 1));
+      for (int i = 0; i < bSize; ++i) b.push_back(std::make_pair(int(rng() % 40000), 2));
+      typedef std::pair<int, int> Entry;
+      auto byKey = [](const Entry& x, const Entry& y) { return x.first < y.first; };
+      std::sort(a.begin(), a.end(), byKey);
+      a.erase(std::unique(a.begin(), a.end()), a.end());
+      std::sort(b.begin(), b.end(), byKey);
+      b.erase(std::unique(b.begin(), b.end()), b.end());
+
+      std::vector<Entry> unioned, intersected, differenced;
+      std::set_union(a.begin(), a.end(), b.begin(), b.end(),
+                     std::back_inserter(unioned), byKey);
+      std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                            std::back_inserter(intersected), byKey);
+      std::set_difference(a.begin(), a.end(), b.begin(), b.end(),
+                          std::back_inserter(differenced), byKey);
+
+      typedef util::avl_tree<int, int, std::less<int>,
+                             util::monoid_augmentation<util::sum_monoid<long> > > Tree;
+      {
+        Tree lhs(util::sorted_range, a.begin(), a.end());
+        Tree rhs(util::sorted_range, b.begin(), b.end());
+        lhs.union_with(rhs, threads);
+        EXPECT_TRUE(rhs.empty());
+        ExpectContents(unioned, lhs);
+        EXPECT_EQ(long(a.size() + 2 * (unioned.size() - a.size())), lhs.aggregate());
+      }
+      {
+        Tree lhs(util::sorted_range, a.begin(), a.end());
+        Tree rhs(util::sorted_range, b.begin(), b.end());
+        lhs.intersect_with(rhs, threads);
+        EXPECT_TRUE(rhs.empty());
+        ExpectContents(intersected, lhs);
+        EXPECT_EQ(long(intersected.size()), lhs.aggregate());
+      }
+      {
+        // Plain trees, built by insertion so that their shapes differ.
+        util::avl_tree<int, int> lhs, rhs;
+        for (const Entry& entry : a) lhs.insert(entry.first, entry.second);
+        for (const Entry& entry : b) rhs.insert(entry.first, entry.second);
+        lhs.difference_with(rhs, threads);
+        EXPECT_TRUE(rhs.empty());
+        ExpectContents(differenced, lhs);
+      }
+    }
+  }
+}
+
 /*
 TEST(MyAvlTree, CopyConstructor_Small) {
   util::avl_tree<int> tree1;
@@ -0,0 +1,346 @@
+#ifndef CONCURRENT_HASH_MAP_H_
+#define CONCURRENT_HASH_MAP_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <utility>
+
+#include "hash_map.h"
+
+namespace util {
+
+	// A hash map that can be used from many threads at once. Keys are
+	// partitioned over a fixed number of shards, each an ordinary hash_map
+	// guarded by its own reader-writer lock, so threads only contend when
+	// they touch the same shard. Each shard sits on its own cache lines so
+	// that locking one shard doesn't slow down its neighbours.
+	//
+	// There are no iterators: elements are reached through visitor
+	// functions that run while the shard is locked. Visitors must not call
+	// back into the same map. Every operation on a single key is atomic;
+	// size() and for_each() see each shard at a different moment.
+	//
+	// Usage:
+	//   util::concurrent_hash_map<std::string, int> counts;
+	//   counts.insert_or_update("word", 1, [](int& count) { ++count; });
+	template <typename Key, typename T,
+		typename KeyEqual = std::equal_to<>,
+		typename Hash = hash<Key>,
+		typename Policy = chaining>
+	class concurrent_hash_map
+	{
+	public:
+		using key_type = Key;
+		using mapped_type = T;
+		using value_type = std::pair<const Key, T>;
+		using hasher = Hash;
+		using key_equal = KeyEqual;
+		using size_type = size_t;
+		using map_type = hash_map<Key, T, KeyEqual, Hash, Policy>;
+
+		// Assumed size of a cache line.
+		static constexpr size_t kCacheLineSize = 64;
+
+		// The number of shards is rounded up to a power of two.
+		// Throws invalid_argument if shardCount is 0.
+		explicit concurrent_hash_map(size_type shardCount = 64, const KeyEqual& equal = KeyEqual(),
+			const Hash& hash = Hash());
+
+		// The shards hold locks, which can't be copied or moved.
+		concurrent_hash_map(const concurrent_hash_map& src) = delete;
+		concurrent_hash_map& operator=(const concurrent_hash_map& rhs) = delete;
+
+		// Inserts k with value if k is not in the map yet. Returns true if
+		// it inserted.
+		template <typename M>
+		bool insert(const key_type& k, M&& value);
+
+		// Inserts or overwrites the value of k. Returns true if it inserted.
+		template <typename M>
+		bool insert_or_assign(const key_type& k, M&& value);
+
+		// Inserts k with value if k is not in the map yet, and otherwise
+		// calls update(T&) on the existing value. Either way, this happens
+		// as one atomic step. Returns true if it inserted.
+		template <typename M, typename F>
+		bool insert_or_update(const key_type& k, M&& value, F update);
+
+		// Returns a copy of the value of k. If k is missing, the value is
+		// first computed with compute() and inserted; concurrent callers
+		// with the same key see the same value and only one of them runs
+		// compute().
+		template <typename F>
+		mapped_type compute_if_absent(const key_type& k, F compute);
+
+		// Returns a copy of the value of k, if there is one.
+		std::optional<mapped_type> find(const key_type& k) const;
+		bool contains(const key_type& k) const;
+
+		// Calls f(const T&) on the value of k under a shared lock, or
+		// f(T&) under an exclusive lock for the non-const version. Returns
+		// false if k is missing.
+		template <typename F>
+		bool visit(const key_type& k, F f) const;
+		template <typename F>
+		bool visit(const key_type& k, F f);
+
+		size_type erase(const key_type& k);
+
+		// Calls f(const value_type&) on every element, or f(value_type&)
+		// for the non-const version, one shard at a time.
+		template <typename F>
+		void for_each(F f) const;
+		template <typename F>
+		void for_each(F f);
+
+		// The sum of the shard sizes.
+		size_type size() const;
+		bool empty() const;
+		void clear();
+
+		size_type shard_count() const;
+
+	private:
+		// One partition of the keys.
+		struct alignas(kCacheLineSize) shard
+		{
+			mutable std::shared_mutex mMutex;
+			map_type mMap;
+		};
+
+		// The shard for a key. Shards are picked by the top bits of the
+		// remixed hash, which the shard's map doesn't rely on.
+		shard& shardFor(const key_type& k);
+		const shard& shardFor(const key_type& k) const;
+
+		std::unique_ptr<shard[]> mShards;
+		size_type mShardCount;
+		unsigned mShardShift;
+		Hash mHash;
+	};
+
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy>
+	concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::concurrent_hash_map(size_type shardCount,
+		const KeyEqual& equal, const Hash& hash)
+		: mHash(hash)
+	{
+		if (shardCount == 0) {
+			throw std::invalid_argument("Number of shards must be positive");
+		}
+
+		// Round up to a power of two, and remember how far the hash has to
+		// be shifted to leave just the shard bits.
+		mShardCount = 1;
+		mShardShift = 64;
+		while (mShardCount < shardCount) {
+			mShardCount *= 2;
+			mShardShift--;
+		}
+
+		mShards.reset(new shard[mShardCount]);
+		for (size_type i = 0; i < mShardCount; i++) {
+			mShards[i].mMap = map_type(equal, 101, hash);
+		}
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy>
+	typename concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::shard&
+		concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::shardFor(const key_type& k)
+	{
+		if (mShardCount == 1) {
+			return mShards[0];
+		}
+		uint64_t mixed = hash_integer(mHash(k));
+		return mShards[static_cast<size_type>(mixed >> mShardShift)];
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy>
+	const typename concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::shard&
+		concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::shardFor(const key_type& k) const
+	{
+		return const_cast<concurrent_hash_map*>(this)->shardFor(k);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy>
+	template <typename M>
+	bool concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::insert(const key_type& k, M&& value)
+	{
+		shard& s = shardFor(k);
+		std::unique_lock<std::shared_mutex> lock(s.mMutex);
+		return s.mMap.try_emplace(k, std::forward<M>(value)).second;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy>
+	template <typename M>
+	bool concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::insert_or_assign(const key_type& k, M&& value)
+	{
+		shard& s = shardFor(k);
+		std::unique_lock<std::shared_mutex> lock(s.mMutex);
+		return s.mMap.insert_or_assign(k, std::forward<M>(value)).second;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy>
+	template <typename M, typename F>
+	bool concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::insert_or_update(const key_type& k, M&& value, F update)
+	{
+		shard& s = shardFor(k);
+		std::unique_lock<std::shared_mutex> lock(s.mMutex);
+		// try_emplace() leaves value alone if the key exists.
+		auto result = s.mMap.try_emplace(k, std::forward<M>(value));
+		if (!result.second) {
+			update(result.first->second);
+		}
+		return result.second;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy>
+	template <typename F>
+	typename concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::mapped_type
+		concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::compute_if_absent(const key_type& k, F compute)
+	{
+		shard& s = shardFor(k);
+
+		// Most of the time the value is there already, and readers don't
+		// have to exclude each other.
+		{
+			std::shared_lock<std::shared_mutex> lock(s.mMutex);
+			auto it = s.mMap.find(k);
+			if (it != s.mMap.end()) {
+				return it->second;
+			}
+		}
+
+		// Look again under the exclusive lock: another thread may have
+		// inserted k in between.
+		std::unique_lock<std::shared_mutex> lock(s.mMutex);
+		auto it = s.mMap.find(k);
+		if (it == s.mMap.end()) {
+			it = s.mMap.try_emplace(k, compute()).first;
+		}
+		return it->second;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy>
+	std::optional<typename concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::mapped_type>
+		concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::find(const key_type& k) const
+	{
+		const shard& s = shardFor(k);
+		std::shared_lock<std::shared_mutex> lock(s.mMutex);
+		auto it = s.mMap.find(k);
+		if (it == s.mMap.end()) {
+			return std::nullopt;
+		}
+		return it->second;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy>
+	bool concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::contains(const key_type& k) const
+	{
+		const shard& s = shardFor(k);
+		std::shared_lock<std::shared_mutex> lock(s.mMutex);
+		return s.mMap.count(k) != 0;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy>
+	template <typename F>
+	bool concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::visit(const key_type& k, F f) const
+	{
+		const shard& s = shardFor(k);
+		std::shared_lock<std::shared_mutex> lock(s.mMutex);
+		auto it = s.mMap.find(k);
+		if (it == s.mMap.end()) {
+			return false;
+		}
+		f(static_cast<const mapped_type&>(it->second));
+		return true;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy>
+	template <typename F>
+	bool concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::visit(const key_type& k, F f)
+	{
+		shard& s = shardFor(k);
+		std::unique_lock<std::shared_mutex> lock(s.mMutex);
+		auto it = s.mMap.find(k);
+		if (it == s.mMap.end()) {
+			return false;
+		}
+		f(it->second);
+		return true;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy>
+	typename concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::size_type
+		concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::erase(const key_type& k)
+	{
+		shard& s = shardFor(k);
+		std::unique_lock<std::shared_mutex> lock(s.mMutex);
+		return s.mMap.erase(k);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy>
+	template <typename F>
+	void concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::for_each(F f) const
+	{
+		for (size_type i = 0; i < mShardCount; i++) {
+			std::shared_lock<std::shared_mutex> lock(mShards[i].mMutex);
+			for (const value_type& element : mShards[i].mMap) {
+				f(element);
+			}
+		}
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy>
+	template <typename F>
+	void concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::for_each(F f)
+	{
+		for (size_type i = 0; i < mShardCount; i++) {
+			std::unique_lock<std::shared_mutex> lock(mShards[i].mMutex);
+			for (value_type& element : mShards[i].mMap) {
+				f(element);
+			}
+		}
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy>
+	typename concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::size_type
+		concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::size() const
+	{
+		size_type total = 0;
+		for (size_type i = 0; i < mShardCount; i++) {
+			std::shared_lock<std::shared_mutex> lock(mShards[i].mMutex);
+			total += mShards[i].mMap.size();
+		}
+		return total;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy>
+	bool concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::empty() const
+	{
+		return size() == 0;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy>
+	void concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::clear()
+	{
+		for (size_type i = 0; i < mShardCount; i++) {
+			std::unique_lock<std::shared_mutex> lock(mShards[i].mMutex);
+			mShards[i].mMap.clear();
+		}
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy>
+	typename concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::size_type
+		concurrent_hash_map<Key, T, KeyEqual, Hash, Policy>::shard_count() const
+	{
+		return mShardCount;
+	}
+
+} //namespace util
+
+#endif // CONCURRENT_HASH_MAP_H_
@@ -0,0 +1,76 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrent_hash_map.h"
+#include "gtest/gtest.h"
+
+TEST(MyConcurrentHashMap, SingleThreaded) {
+  util::concurrent_hash_map<std::string, int> map(5);
+  EXPECT_EQ(map.shard_count(), 8u);
+  EXPECT_TRUE(map.insert("one", 1));
+  EXPECT_FALSE(map.insert("one", 2));
+  EXPECT_EQ(map.find("one"), 1);
+  EXPECT_FALSE(map.find("two").has_value());
+
+  EXPECT_FALSE(map.insert_or_assign("one", 3));
+  EXPECT_EQ(map.find("one"), 3);
+  EXPECT_TRUE(map.insert_or_update("two", 1, [](int& value) { value++; }));
+  EXPECT_FALSE(map.insert_or_update("two", 1, [](int& value) { value++; }));
+  EXPECT_EQ(map.find("two"), 2);
+
+  EXPECT_TRUE(map.visit("two", [](int& value) { value *= 10; }));
+  EXPECT_FALSE(map.visit("three", [](int&) {}));
+  EXPECT_EQ(map.find("two"), 20);
+
+  int total = 0;
+  map.for_each([&total](const std::pair<const std::string, int>& element) { total += element.second; });
+  EXPECT_EQ(total, 23);
+
+  EXPECT_EQ(map.erase("one"), 1u);
+  EXPECT_FALSE(map.contains("one"));
+  EXPECT_EQ(map.size(), 1u);
+  map.clear();
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(MyConcurrentHashMap, ConcurrentUpdates) {
+  util::concurrent_hash_map<int, int> map;
+  const int kThreads = 8;
+  const int kKeys = 1000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&map]() {
+      for (int i = 0; i < kKeys; i++) {
+        map.insert_or_update(i, 1, [](int& count) { count++; });
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(map.size(), static_cast<size_t>(kKeys));
+  for (int i = 0; i < kKeys; i++) {
+    EXPECT_EQ(map.find(i), kThreads);
+  }
+}
+
+TEST(MyConcurrentHashMap, ComputeIfAbsentRunsOnce) {
+  util::concurrent_hash_map<int, int> map;
+  std::atomic<int> computations(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < 100; i++) {
+        int value = map.compute_if_absent(i, [&]() { computations++; return i * 2; });
+        EXPECT_EQ(value, i * 2);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(computations.load(), 100);
+}
@@ -0,0 +1,434 @@
+#ifndef CONSTEXPR_HASH_MAP_H_
+#define CONSTEXPR_HASH_MAP_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "hash_map.h"
+
+namespace util {
+
+	// A hash object that can run at compile time, for integral and
+	// enumeration keys and string views. Integers go through
+	// hash_integer(); strings are read 8 bytes at a time and finished with
+	// hash_integer() as well.
+	template <typename T>
+	class constexpr_hash
+	{
+	public:
+		constexpr constexpr_hash() = default;
+		explicit constexpr constexpr_hash(size_t seed);
+
+		constexpr size_t operator()(const T& key) const;
+
+	private:
+		size_t mSeed = 0;
+	};
+
+	template <>
+	class constexpr_hash<std::string_view>
+	{
+	public:
+		constexpr constexpr_hash() = default;
+		explicit constexpr constexpr_hash(size_t seed);
+
+		constexpr size_t operator()(std::string_view key) const;
+
+	private:
+		size_t mSeed = 0;
+	};
+
+	// A map whose keys and values are fixed at compile time, such as a
+	// keyword or opcode table. The compiler searches for a minimal perfect
+	// hash function over the keys and lays the elements out in a flat
+	// array of exactly N slots, so the map needs no construction at run
+	// time and no heap memory. A lookup hashes the key once, reads one
+	// pilot value and compares one key, with no branches on the way.
+	//
+	// The perfect hash works like static_hash_map's: keys fall into N
+	// buckets, and each bucket has a pilot chosen so that all keys land on
+	// distinct slots.
+	//
+	// Build the map with make_constexpr_hash_map(), which deduces N:
+	//   constexpr auto kOpcodes = util::make_constexpr_hash_map<std::string_view, int>({
+	//     { "add", 0x01 }, { "sub", 0x02 }, { "jmp", 0x10 } });
+	//   static_assert(kOpcodes.at("sub") == 0x02);
+	template <typename Key, typename T, size_t N,
+		typename KeyEqual = std::equal_to<>,
+		typename Hash = constexpr_hash<Key>>
+	class constexpr_hash_map
+	{
+		static_assert(N > 0, "constexpr_hash_map needs at least one element");
+		static_assert(N <= UINT32_MAX, "constexpr_hash_map is meant for small tables");
+
+	public:
+		using key_type = Key;
+		using mapped_type = T;
+		using value_type = std::pair<Key, T>;
+		using hasher = Hash;
+		using key_equal = KeyEqual;
+		using const_reference = const value_type&;
+		using size_type = size_t;
+		using difference_type = ptrdiff_t;
+		using const_iterator = const value_type*;
+		using iterator = const_iterator;
+
+		// Finds the perfect hash function and places the elements. Throws
+		// invalid_argument if two keys are equal (or have the same hash),
+		// which fails compilation when done at compile time.
+		constexpr constexpr_hash_map(const value_type (&items)[N], const KeyEqual& equal = KeyEqual(),
+			const Hash& hash = Hash());
+
+		// Iterator methods. Elements are in slot order.
+		constexpr const_iterator begin() const;
+		constexpr const_iterator end() const;
+		constexpr const_iterator cbegin() const;
+		constexpr const_iterator cend() const;
+
+		// Size methods
+		constexpr bool empty() const;
+		constexpr size_type size() const;
+
+		// Access methods for Standard Library conformity
+		constexpr key_equal key_eq() const;
+		constexpr hasher hash_function() const;
+
+		// Lookup methods
+		constexpr const_iterator find(const key_type& k) const;
+		constexpr size_type count(const key_type& k) const;
+		constexpr bool contains(const key_type& k) const;
+		// Throws out_of_range if k is missing.
+		constexpr const T& at(const key_type& k) const;
+
+	private:
+		// The outcome of the perfect hash search.
+		struct index_type
+		{
+			uint64_t mSeed = 0;
+			std::array<uint64_t, N> mPilots{};
+			// The element that goes into each slot.
+			std::array<size_t, N> mOrder{};
+		};
+
+		template <size_t... I>
+		constexpr constexpr_hash_map(const value_type (&items)[N], const index_type& index,
+			std::index_sequence<I...>, const KeyEqual& equal, const Hash& hash);
+
+		static constexpr index_type buildIndex(const value_type (&items)[N], const Hash& hash);
+
+		// Maps h uniformly onto [0, N), using its high 32 bits.
+		static constexpr size_t reduce(uint64_t h);
+		static constexpr size_t slotOf(uint64_t keyHash, uint64_t pilot);
+
+		std::array<value_type, N> mItems;
+		uint64_t mSeed;
+		std::array<uint64_t, N> mPilots;
+		KeyEqual mEqual;
+		Hash mHash;
+	};
+
+	// Builds a constexpr_hash_map from a braced list of key/value pairs.
+	template <typename Key, typename T, typename KeyEqual = std::equal_to<>,
+		typename Hash = constexpr_hash<Key>, size_t N>
+	constexpr constexpr_hash_map<Key, T, N, KeyEqual, Hash> make_constexpr_hash_map(
+		const std::pair<Key, T> (&items)[N], const KeyEqual& equal = KeyEqual(), const Hash& hash = Hash());
+
+
+	namespace detail {
+
+		// Read 8 or 4 bytes of s starting at i as a little-endian word.
+		// Written out byte by byte so that they work at compile time;
+		// compilers turn them into a single load at run time.
+		constexpr uint64_t read_le64(std::string_view s, size_t i)
+		{
+			return static_cast<uint64_t>(static_cast<unsigned char>(s[i]))
+				| static_cast<uint64_t>(static_cast<unsigned char>(s[i + 1])) << 8
+				| static_cast<uint64_t>(static_cast<unsigned char>(s[i + 2])) << 16
+				| static_cast<uint64_t>(static_cast<unsigned char>(s[i + 3])) << 24
+				| static_cast<uint64_t>(static_cast<unsigned char>(s[i + 4])) << 32
+				| static_cast<uint64_t>(static_cast<unsigned char>(s[i + 5])) << 40
+				| static_cast<uint64_t>(static_cast<unsigned char>(s[i + 6])) << 48
+				| static_cast<uint64_t>(static_cast<unsigned char>(s[i + 7])) << 56;
+		}
+
+		constexpr uint64_t read_le32(std::string_view s, size_t i)
+		{
+			return static_cast<uint64_t>(static_cast<unsigned char>(s[i]))
+				| static_cast<uint64_t>(static_cast<unsigned char>(s[i + 1])) << 8
+				| static_cast<uint64_t>(static_cast<unsigned char>(s[i + 2])) << 16
+				| static_cast<uint64_t>(static_cast<unsigned char>(s[i + 3])) << 24;
+		}
+
+	} // namespace detail
+
+	template <typename T>
+	constexpr constexpr_hash<T>::constexpr_hash(size_t seed)
+		: mSeed(seed)
+	{
+	}
+
+	template <typename T>
+	constexpr size_t constexpr_hash<T>::operator()(const T& key) const
+	{
+		static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+			"constexpr_hash supports integral, enumeration and string_view keys");
+		return static_cast<size_t>(hash_integer(static_cast<uint64_t>(key), mSeed));
+	}
+
+	constexpr constexpr_hash<std::string_view>::constexpr_hash(size_t seed)
+		: mSeed(seed)
+	{
+	}
+
+	constexpr size_t constexpr_hash<std::string_view>::operator()(std::string_view key) const
+	{
+		// Like hash_bytes(), short keys are read in a few overlapping
+		// pieces rather than byte by byte, and the length goes in first so
+		// that those overlaps can't make two keys collide.
+		const size_t len = key.size();
+		uint64_t h = len * 0x9e3779b97f4a7c15ULL;
+		if (len >= 8) {
+			for (size_t i = 0; i + 8 < len; i += 8) {
+				h = (h ^ detail::read_le64(key, i)) * 0x9fb21c651e98df25ULL;
+				h ^= h >> 29;
+			}
+			h ^= detail::read_le64(key, len - 8);
+		} else if (len >= 4) {
+			h ^= detail::read_le32(key, 0) << 32 | detail::read_le32(key, len - 4);
+		} else if (len > 0) {
+			h ^= static_cast<uint64_t>(static_cast<unsigned char>(key[0])) << 16
+				| static_cast<uint64_t>(static_cast<unsigned char>(key[len / 2])) << 8
+				| static_cast<uint64_t>(static_cast<unsigned char>(key[len - 1]));
+		}
+		return static_cast<size_t>(hash_integer(h, mSeed));
+	}
+
+
+	template <typename Key, typename T, size_t N, typename KeyEqual, typename Hash>
+	constexpr constexpr_hash_map<Key, T, N, KeyEqual, Hash>::constexpr_hash_map(const value_type (&items)[N],
+		const KeyEqual& equal, const Hash& hash)
+		: constexpr_hash_map(items, buildIndex(items, hash), std::make_index_sequence<N>(), equal, hash)
+	{
+	}
+
+	// The elements are copied straight into their slots, since pair
+	// assignment can't run at compile time before C++20.
+	template <typename Key, typename T, size_t N, typename KeyEqual, typename Hash>
+	template <size_t... I>
+	constexpr constexpr_hash_map<Key, T, N, KeyEqual, Hash>::constexpr_hash_map(const value_type (&items)[N],
+		const index_type& index, std::index_sequence<I...>, const KeyEqual& equal, const Hash& hash)
+		: mItems{ { items[index.mOrder[I]]... } }, mSeed(index.mSeed), mPilots(index.mPilots),
+		mEqual(equal), mHash(hash)
+	{
+	}
+
+	template <typename Key, typename T, size_t N, typename KeyEqual, typename Hash>
+	constexpr size_t constexpr_hash_map<Key, T, N, KeyEqual, Hash>::reduce(uint64_t h)
+	{
+		return static_cast<size_t>(((h >> 32) * N) >> 32);
+	}
+
+	template <typename Key, typename T, size_t N, typename KeyEqual, typename Hash>
+	constexpr size_t constexpr_hash_map<Key, T, N, KeyEqual, Hash>::slotOf(uint64_t keyHash, uint64_t pilot)
+	{
+		return reduce((keyHash ^ pilot) * 0x9fb21c651e98df25ULL);
+	}
+
+	// Tries seeds until every bucket, largest first, has a pilot that
+	// places its keys on free slots. Everything lives in fixed-size
+	// arrays, as this normally runs inside the compiler.
+	template <typename Key, typename T, size_t N, typename KeyEqual, typename Hash>
+	constexpr typename constexpr_hash_map<Key, T, N, KeyEqual, Hash>::index_type
+		constexpr_hash_map<Key, T, N, KeyEqual, Hash>::buildIndex(const value_type (&items)[N], const Hash& hash)
+	{
+		// The last key placed needs about N tries on average.
+		constexpr uint64_t kMaxPilot = 64 * uint64_t(N) + 1024;
+
+		std::array<uint64_t, N> userHashes{};
+		for (size_t i = 0; i < N; ++i) {
+			userHashes[i] = hash(items[i].first);
+		}
+
+		index_type index;
+		std::array<uint64_t, N> hashes{};
+		std::array<size_t, N + 1> bucketStart{};
+		std::array<size_t, N> keysByBucket{};
+		std::array<size_t, N> fill{};
+		std::array<size_t, N> slots{};
+		std::array<bool, N> taken{};
+		for (uint64_t seed = 0; ; ++seed) {
+			for (size_t i = 0; i < N; ++i) {
+				hashes[i] = userHashes[i] ^ (seed == 0 ? 0 : hash_integer(seed));
+			}
+
+			// Group the keys by bucket, with a counting sort.
+			for (size_t b = 0; b <= N; ++b) {
+				bucketStart[b] = 0;
+			}
+			for (size_t i = 0; i < N; ++i) {
+				++bucketStart[reduce(hashes[i]) + 1];
+			}
+			size_t largest = 0;
+			for (size_t b = 0; b < N; ++b) {
+				largest = std::max(largest, bucketStart[b + 1]);
+				fill[b] = bucketStart[b];
+				bucketStart[b + 1] += bucketStart[b];
+			}
+			for (size_t i = 0; i < N; ++i) {
+				keysByBucket[fill[reduce(hashes[i])]++] = i;
+			}
+
+			for (size_t s = 0; s < N; ++s) {
+				taken[s] = false;
+			}
+			bool placed = true;
+			for (size_t count = largest; count > 0 && placed; --count) {
+				for (size_t b = 0; b < N && placed; ++b) {
+					if (bucketStart[b + 1] - bucketStart[b] != count) {
+						continue;
+					}
+					const size_t first = bucketStart[b];
+					// Keys with equal hashes collide under every pilot, and
+					// always share a bucket.
+					for (size_t j = 0; j < count; ++j) {
+						for (size_t k = 0; k < j; ++k) {
+							if (hashes[keysByBucket[first + j]] == hashes[keysByBucket[first + k]]) {
+								throw std::invalid_argument("constexpr_hash_map: duplicate keys or colliding hashes");
+							}
+						}
+					}
+					placed = false;
+					for (uint64_t pilot = 0; pilot < kMaxPilot && !placed; ++pilot) {
+						placed = true;
+						for (size_t j = 0; j < count && placed; ++j) {
+							size_t slot = slotOf(hashes[keysByBucket[first + j]], hash_integer(pilot));
+							placed = !taken[slot];
+							for (size_t k = 0; k < j && placed; ++k) {
+								placed = slots[keysByBucket[first + k]] != slot;
+							}
+							slots[keysByBucket[first + j]] = slot;
+						}
+						if (placed) {
+							for (size_t j = 0; j < count; ++j) {
+								taken[slots[keysByBucket[first + j]]] = true;
+							}
+							index.mPilots[b] = hash_integer(pilot);
+						}
+					}
+				}
+			}
+
+			if (placed) {
+				index.mSeed = seed == 0 ? 0 : hash_integer(seed);
+				for (size_t i = 0; i < N; ++i) {
+					index.mOrder[slots[i]] = i;
+				}
+				return index;
+			}
+		}
+	}
+
+	template <typename Key, typename T, size_t N, typename KeyEqual, typename Hash>
+	constexpr typename constexpr_hash_map<Key, T, N, KeyEqual, Hash>::const_iterator
+		constexpr_hash_map<Key, T, N, KeyEqual, Hash>::begin() const
+	{
+		return mItems.data();
+	}
+
+	template <typename Key, typename T, size_t N, typename KeyEqual, typename Hash>
+	constexpr typename constexpr_hash_map<Key, T, N, KeyEqual, Hash>::const_iterator
+		constexpr_hash_map<Key, T, N, KeyEqual, Hash>::end() const
+	{
+		return mItems.data() + N;
+	}
+
+	template <typename Key, typename T, size_t N, typename KeyEqual, typename Hash>
+	constexpr typename constexpr_hash_map<Key, T, N, KeyEqual, Hash>::const_iterator
+		constexpr_hash_map<Key, T, N, KeyEqual, Hash>::cbegin() const
+	{
+		return begin();
+	}
+
+	template <typename Key, typename T, size_t N, typename KeyEqual, typename Hash>
+	constexpr typename constexpr_hash_map<Key, T, N, KeyEqual, Hash>::const_iterator
+		constexpr_hash_map<Key, T, N, KeyEqual, Hash>::cend() const
+	{
+		return end();
+	}
+
+	template <typename Key, typename T, size_t N, typename KeyEqual, typename Hash>
+	constexpr bool constexpr_hash_map<Key, T, N, KeyEqual, Hash>::empty() const
+	{
+		return false;
+	}
+
+	template <typename Key, typename T, size_t N, typename KeyEqual, typename Hash>
+	constexpr typename constexpr_hash_map<Key, T, N, KeyEqual, Hash>::size_type
+		constexpr_hash_map<Key, T, N, KeyEqual, Hash>::size() const
+	{
+		return N;
+	}
+
+	template <typename Key, typename T, size_t N, typename KeyEqual, typename Hash>
+	constexpr typename constexpr_hash_map<Key, T, N, KeyEqual, Hash>::key_equal
+		constexpr_hash_map<Key, T, N, KeyEqual, Hash>::key_eq() const
+	{
+		return mEqual;
+	}
+
+	template <typename Key, typename T, size_t N, typename KeyEqual, typename Hash>
+	constexpr typename constexpr_hash_map<Key, T, N, KeyEqual, Hash>::hasher
+		constexpr_hash_map<Key, T, N, KeyEqual, Hash>::hash_function() const
+	{
+		return mHash;
+	}
+
+	template <typename Key, typename T, size_t N, typename KeyEqual, typename Hash>
+	constexpr typename constexpr_hash_map<Key, T, N, KeyEqual, Hash>::const_iterator
+		constexpr_hash_map<Key, T, N, KeyEqual, Hash>::find(const key_type& k) const
+	{
+		uint64_t h = mHash(k) ^ mSeed;
+		size_t slot = slotOf(h, mPilots[reduce(h)]);
+		return mEqual(mItems[slot].first, k) ? begin() + slot : end();
+	}
+
+	template <typename Key, typename T, size_t N, typename KeyEqual, typename Hash>
+	constexpr typename constexpr_hash_map<Key, T, N, KeyEqual, Hash>::size_type
+		constexpr_hash_map<Key, T, N, KeyEqual, Hash>::count(const key_type& k) const
+	{
+		return contains(k) ? 1 : 0;
+	}
+
+	template <typename Key, typename T, size_t N, typename KeyEqual, typename Hash>
+	constexpr bool constexpr_hash_map<Key, T, N, KeyEqual, Hash>::contains(const key_type& k) const
+	{
+		return find(k) != end();
+	}
+
+	template <typename Key, typename T, size_t N, typename KeyEqual, typename Hash>
+	constexpr const T& constexpr_hash_map<Key, T, N, KeyEqual, Hash>::at(const key_type& k) const
+	{
+		const_iterator it = find(k);
+		if (it == end()) {
+			throw std::out_of_range("constexpr_hash_map::at: key not found");
+		}
+		return it->second;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, size_t N>
+	constexpr constexpr_hash_map<Key, T, N, KeyEqual, Hash> make_constexpr_hash_map(
+		const std::pair<Key, T> (&items)[N], const KeyEqual& equal, const Hash& hash)
+	{
+		return constexpr_hash_map<Key, T, N, KeyEqual, Hash>(items, equal, hash);
+	}
+
+} //namespace util
+
+#endif // CONSTEXPR_HASH_MAP_H_
@@ -0,0 +1,119 @@
+// Compares constexpr_hash_map with the run-time hash_map on keyword tables
+// of 50 to 500 entries, the size of typical keyword and opcode tables.
+// The tables are generated at compile time. Usage:
+// constexpr_hash_map_benchmark [lookups]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "constexpr_hash_map.h"
+#include "hash_map.h"
+
+namespace {
+
+constexpr size_t kMaxKeywordLength = 12;
+
+template <size_t N>
+struct keyword_text {
+  char mText[N][kMaxKeywordLength];
+  size_t mLength[N];
+};
+
+// Keywords of 2 to 10 lower-case letters. The first two letters spell out
+// the index, so they are distinct.
+template <size_t N>
+constexpr keyword_text<N> makeKeywordText() {
+  keyword_text<N> text{};
+  for (size_t i = 0; i < N; i++) {
+    size_t length = 2 + (i * 7) % 9;
+    text.mText[i][0] = static_cast<char>('a' + i % 26);
+    text.mText[i][1] = static_cast<char>('a' + (i / 26) % 26);
+    for (size_t j = 2; j < length; j++) {
+      text.mText[i][j] = static_cast<char>('a' + (i * 31 + j * 17) % 26);
+    }
+    text.mLength[i] = length;
+  }
+  return text;
+}
+
+template <size_t N>
+constexpr keyword_text<N> kKeywordText = makeKeywordText<N>();
+
+template <size_t N, size_t... I>
+constexpr auto makeTable(std::index_sequence<I...>) {
+  return util::make_constexpr_hash_map<std::string_view, int>({
+    { std::string_view(kKeywordText<N>.mText[I], kKeywordText<N>.mLength[I]), static_cast<int>(I) }... });
+}
+
+template <size_t N>
+constexpr auto kTable = makeTable<N>(std::make_index_sequence<N>());
+
+template <typename Map>
+double timeLookups(const Map& map, const std::vector<std::string_view>& queries, long long& sum) {
+  auto start = std::chrono::steady_clock::now();
+  for (std::string_view query : queries) {
+    auto it = map.find(query);
+    if (it != map.end()) {
+      sum += it->second;
+    }
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / queries.size();
+}
+
+template <size_t N>
+void run(size_t lookups) {
+  using Clock = std::chrono::steady_clock;
+  const auto& text = kKeywordText<N>;
+
+  auto start = Clock::now();
+  util::hash_map<std::string, int> chaining;
+  util::hash_map<std::string, int, std::equal_to<>, util::hash<std::string>, util::group_probing> probing;
+  for (size_t i = 0; i < N; i++) {
+    std::string_view keyword(text.mText[i], text.mLength[i]);
+    chaining.try_emplace(std::string(keyword), static_cast<int>(i));
+    probing.try_emplace(std::string(keyword), static_cast<int>(i));
+  }
+  double setup = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+  // Three out of four queries hit. Misses are keywords with their last
+  // letter changed to an upper-case one.
+  std::vector<std::string> misses;
+  for (size_t i = 0; i < N; i++) {
+    std::string keyword(text.mText[i], text.mLength[i]);
+    keyword.back() = 'A';
+    misses.push_back(keyword);
+  }
+  std::mt19937_64 rng(42);
+  std::vector<std::string_view> queries(lookups);
+  for (auto& query : queries) {
+    size_t i = rng() % N;
+    query = rng() % 4 != 0 ? std::string_view(text.mText[i], text.mLength[i]) : std::string_view(misses[i]);
+  }
+
+  long long sums[3] = {};
+  double constexprNs = timeLookups(kTable<N>, queries, sums[0]);
+  double chainingNs = timeLookups(chaining, queries, sums[1]);
+  double probingNs = timeLookups(probing, queries, sums[2]);
+  std::printf("%4zu keywords  constexpr: %5.1f ns  chaining: %5.1f ns  group_probing: %5.1f ns  "
+    "(run-time setup %.0f us)%s\n", N, constexprNs, chainingNs, probingNs, setup,
+    sums[0] == sums[1] && sums[1] == sums[2] ? "" : "  (MISMATCH)");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  size_t lookups = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : size_t(1) << 24;
+
+  run<50>(lookups);
+  run<100>(lookups);
+  run<250>(lookups);
+  run<500>(lookups);
+  return 0;
+}
@@ -0,0 +1,71 @@
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "constexpr_hash_map.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+enum class Opcode { kAdd, kSub, kMul, kDiv, kJump, kCall, kReturn, kHalt };
+
+constexpr auto kOpcodes = util::make_constexpr_hash_map<std::string_view, Opcode>({
+  { "add", Opcode::kAdd }, { "sub", Opcode::kSub }, { "mul", Opcode::kMul },
+  { "div", Opcode::kDiv }, { "jump", Opcode::kJump }, { "call", Opcode::kCall },
+  { "return", Opcode::kReturn }, { "halt", Opcode::kHalt } });
+
+// The whole table, lookups included, is a constant expression.
+static_assert(kOpcodes.size() == 8, "");
+static_assert(kOpcodes.at("jump") == Opcode::kJump, "");
+static_assert(kOpcodes.contains("halt"), "");
+static_assert(!kOpcodes.contains("nop"), "");
+static_assert(kOpcodes.find("") == kOpcodes.end(), "");
+
+constexpr auto kSquares = util::make_constexpr_hash_map<int, int>({
+  { 1, 1 }, { 2, 4 }, { 3, 9 }, { 4, 16 }, { 5, 25 } });
+static_assert(kSquares.at(4) == 16, "");
+static_assert(kSquares.count(6) == 0, "");
+
+} // namespace
+
+TEST(MyConstexprHashMap, Keywords) {
+  EXPECT_EQ(kOpcodes.at("add"), Opcode::kAdd);
+  EXPECT_EQ(kOpcodes.at(std::string("return")), Opcode::kReturn);
+  EXPECT_TRUE(kOpcodes.contains("call"));
+  EXPECT_FALSE(kOpcodes.contains("calls"));
+  EXPECT_FALSE(kOpcodes.contains("cal"));
+  EXPECT_THROW(kOpcodes.at("nop"), std::out_of_range);
+
+  // Every element is in its own slot, and iteration visits each once.
+  int seen = 0;
+  for (const auto& element : kOpcodes) {
+    EXPECT_EQ(kOpcodes.find(element.first), &element);
+    seen |= 1 << static_cast<int>(element.second);
+  }
+  EXPECT_EQ(seen, 0xff);
+}
+
+TEST(MyConstexprHashMap, LongKeys) {
+  constexpr auto map = util::make_constexpr_hash_map<std::string_view, int>({
+    { "a", 1 }, { "abcdefgh", 8 }, { "abcdefghi", 9 }, { "abcdefghijklmnop", 16 },
+    { "abcdefghijklmnopq", 17 }, { "abcdefghijklmnopqrstuvwxyz", 26 } });
+  for (const auto& element : map) {
+    EXPECT_EQ(static_cast<int>(element.first.size()), element.second);
+    EXPECT_EQ(map.at(element.first), element.second);
+  }
+  EXPECT_FALSE(map.contains("abcdefghijklmnopqrstuvwxy"));
+  EXPECT_FALSE(map.contains("abcdefgi"));
+}
+
+TEST(MyConstexprHashMap, RuntimeConstruction) {
+  // Building outside a constant expression works too, and reports
+  // duplicate keys with an exception.
+  std::pair<int, int> items[] = { { 10, 1 }, { 20, 2 }, { 10, 3 } };
+  using Map = util::constexpr_hash_map<int, int, 3>;
+  EXPECT_THROW(Map map(items), std::invalid_argument);
+
+  items[2].first = 30;
+  Map map(items);
+  EXPECT_EQ(map.at(30), 3);
+  EXPECT_FALSE(map.contains(40));
+}
@@ -0,0 +1,757 @@
+#ifndef FROZEN_HASH_MAP_H_
+#define FROZEN_HASH_MAP_H_
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hash_map.h"
+
+namespace util {
+
+	namespace detail {
+
+		// The start of a frozen image. Every offset is counted from the
+		// start of the image, so the image can be mapped at any address.
+		// Sections are aligned to kFrozenAlignment bytes.
+		struct frozen_header
+		{
+			char mMagic[8];
+			uint32_t mVersion;
+			// kFrozenByteOrder as written; images are in native byte order.
+			uint32_t mByteOrder;
+			// Sizes of the stored key and mapped types, to catch images
+			// opened with the wrong types.
+			uint32_t mKeySize;
+			uint32_t mValueSize;
+			uint32_t mEntrySize;
+			// Bit 0: keys are strings. Bit 1: mapped values are strings.
+			uint32_t mFlags;
+			uint64_t mSize;
+			uint64_t mCapacity;
+			uint64_t mCtrlOffset;
+			uint64_t mEntriesOffset;
+			uint64_t mStringsOffset;
+			uint64_t mStringsSize;
+			uint64_t mImageSize;
+		};
+
+		constexpr char kFrozenMagic[8] = { 'U', 'T', 'I', 'L', 'F', 'R', 'Z', 'N' };
+		constexpr uint32_t kFrozenVersion = 1;
+		constexpr uint32_t kFrozenByteOrder = 0x01020304;
+		constexpr uint64_t kFrozenAlignment = 16;
+
+		inline uint64_t frozen_align(uint64_t offset)
+		{
+			return (offset + kFrozenAlignment - 1) & ~(kFrozenAlignment - 1);
+		}
+
+		// A string in the string pool of an image.
+		struct frozen_string
+		{
+			uint64_t mOffset;
+			uint64_t mLength;
+		};
+
+		// How a key or mapped type is stored in an image. Trivially
+		// copyable types are stored as they are and viewed in place.
+		template <typename T>
+		struct frozen_field
+		{
+			static_assert(std::is_trivially_copyable<T>::value,
+				"frozen_hash_map stores trivially copyable types and std::string only");
+
+			static constexpr bool kIsString = false;
+			using stored_type = T;
+			using view_type = const T&;
+			using lookup_type = const T&;
+
+			static view_type view(const stored_type& stored, const char* /*strings*/) { return stored; }
+			static uint64_t length(const T& /*value*/) { return 0; }
+			static stored_type store(const T& value, uint64_t /*offset*/) { return value; }
+			static void write(std::ostream& /*out*/, const T& /*value*/) {}
+		};
+
+		// Strings go to the string pool; the entry holds where.
+		template <>
+		struct frozen_field<std::string>
+		{
+			static constexpr bool kIsString = true;
+			using stored_type = frozen_string;
+			using view_type = std::string_view;
+			using lookup_type = std::string_view;
+
+			static view_type view(const stored_type& stored, const char* strings)
+			{
+				return std::string_view(strings + stored.mOffset, stored.mLength);
+			}
+			static uint64_t length(std::string_view value) { return value.size(); }
+			static stored_type store(std::string_view value, uint64_t offset) { return frozen_string{ offset, value.size() }; }
+			static void write(std::ostream& out, std::string_view value)
+			{
+				out.write(value.data(), static_cast<std::streamsize>(value.size()));
+			}
+		};
+
+		// A read-only, shared mapping of a whole file. Processes that map
+		// the same file share its pages through the page cache.
+		class mapped_file
+		{
+		public:
+			mapped_file() = default;
+			// Throws system_error if the file can't be opened or mapped.
+			explicit mapped_file(const std::string& path);
+			~mapped_file();
+
+			mapped_file(const mapped_file& src) = delete;
+			mapped_file& operator=(const mapped_file& rhs) = delete;
+			mapped_file(mapped_file&& src) noexcept;
+			mapped_file& operator=(mapped_file&& rhs) noexcept;
+
+			const void* data() const;
+			size_t size() const;
+
+		private:
+			void* mData = nullptr;
+			size_t mSize = 0;
+		};
+
+	} // namespace detail
+
+	// A read-only hash map that lives in a position-independent memory
+	// image. freeze() writes the image of any map (or range of key/value
+	// pairs); a frozen_hash_map then views the image in place, either in
+	// memory or mapped from a file, without deserializing anything.
+	// Mapping the same file from many processes shares its pages.
+	//
+	// Keys and mapped values must be trivially copyable or std::string.
+	// Trivially copyable values are stored verbatim; strings go to a
+	// string pool and are viewed as std::string_view. The table uses the
+	// same layout and probing as the group_probing policy, so lookups
+	// cost about as much as in an in-memory hash_map.
+	//
+	// The image stores only the 7-bit H2 part of each key's hash, in the
+	// control bytes. Lookups recompute the full hash to find the probe
+	// sequence and compare its H2 against those bytes, so Hash must give
+	// the same results when the image is frozen and when it is opened.
+	// util::hash does, for equal seeds. Images are in native byte order,
+	// and are trusted: only the header is checked when an image is
+	// opened.
+	//
+	// Usage:
+	//   util::hash_map<std::string, int> counts = ...;
+	//   util::freeze(counts, "counts.frozen");
+	//   util::frozen_hash_map<std::string, int> frozen("counts.frozen");
+	//   int n = frozen.at("word");
+	template <typename Key, typename T, typename Hash = hash<Key>>
+	class frozen_hash_map
+	{
+	private:
+		using key_field = detail::frozen_field<Key>;
+		using mapped_field = detail::frozen_field<T>;
+
+	public:
+		using key_type = Key;
+		using mapped_type = T;
+		using hasher = Hash;
+		using size_type = size_t;
+		// Keys are looked up as lookup_type; string keys as string_view.
+		using lookup_type = typename key_field::lookup_type;
+		using key_view = typename key_field::view_type;
+		using mapped_view = typename mapped_field::view_type;
+		// Elements are viewed through pairs of references into the image
+		// (or string_views).
+		using value_type = std::pair<key_view, mapped_view>;
+
+		class const_iterator;
+		using iterator = const_iterator;
+
+		// Views the image of size bytes at image, which must be aligned
+		// to 8 bytes and must outlive the view. Throws runtime_error if
+		// it isn't a valid image for these types.
+		frozen_hash_map(const void* image, size_t size, const Hash& hash = Hash());
+
+		// Maps the image in the file at path. Throws system_error if the
+		// file can't be mapped, and runtime_error if it isn't a valid
+		// image for these types.
+		explicit frozen_hash_map(const std::string& path, const Hash& hash = Hash());
+
+		// A view may own a mapping, so it can be moved but not copied.
+		// Moving invalidates iterators.
+		frozen_hash_map(const frozen_hash_map& src) = delete;
+		frozen_hash_map& operator=(const frozen_hash_map& rhs) = delete;
+		frozen_hash_map(frozen_hash_map&& src) noexcept = default;
+		frozen_hash_map& operator=(frozen_hash_map&& rhs) noexcept = default;
+
+		// Writes the image of a range of key/value pairs, such as a
+		// hash_map, to out. Keys must be unique. The range is traversed
+		// twice and must yield the same elements in the same order both
+		// times. Throws runtime_error if writing fails.
+		template <typename Range>
+		static void freeze(const Range& elements, std::ostream& out, const Hash& hash = Hash());
+
+		// Writes the image to the file at path. The file is replaced in
+		// one step, so processes that have the old file mapped keep a
+		// consistent view of it.
+		template <typename Range>
+		static void freeze(const Range& elements, const std::string& path, const Hash& hash = Hash());
+
+		// Lookup methods
+		const_iterator find(lookup_type k) const;
+		bool contains(lookup_type k) const;
+		size_type count(lookup_type k) const;
+		// Throws out_of_range if k is missing.
+		mapped_view at(lookup_type k) const;
+
+		// Iteration in slot order
+		const_iterator begin() const;
+		const_iterator end() const;
+		const_iterator cbegin() const;
+		const_iterator cend() const;
+
+		bool empty() const;
+		size_type size() const;
+		size_type bucket_count() const;
+		hasher hash_function() const;
+
+		// The image being viewed
+		const void* data() const;
+		size_t image_size() const;
+
+	private:
+		// One slot of the table.
+		struct entry
+		{
+			typename key_field::stored_type mKey;
+			typename mapped_field::stored_type mValue;
+		};
+
+		using ctrl_t = detail::ctrl_t;
+		using group = detail::ctrl_group;
+
+		// These are part of the image format. The hash is mixed with
+		// hash_integer(); the low 7 bits (H2) go into the control byte and
+		// the rest (H1) picks the first group.
+		static size_t mix(size_t hash);
+		static ctrl_t h2(size_t mixed);
+		static size_t h1(size_t mixed);
+
+		// The smallest power of two, at least one group, that holds n
+		// elements at a load factor of at most 7/8.
+		static size_t capacityFor(size_t n);
+		static uint32_t formatFlags();
+
+		// Checks the header and sets up the section pointers.
+		void attach(const void* image, size_t size);
+
+		// Returns the slot holding k, or mCapacity.
+		size_t findSlot(lookup_type k) const;
+		// Returns the first full slot at or after i, or mCapacity.
+		size_t nextFull(size_t i) const;
+		value_type element(size_t slot) const;
+
+		detail::mapped_file mFile;
+		const char* mImage = nullptr;
+		size_t mImageSize = 0;
+		const ctrl_t* mCtrl = nullptr;
+		const entry* mEntries = nullptr;
+		const char* mStrings = nullptr;
+		size_t mSize = 0;
+		size_t mCapacity = 0;
+		Hash mHash;
+	};
+
+	// A forward iterator over the elements of a frozen_hash_map. It
+	// yields value_type by value, since the pairs don't exist in the image.
+	template <typename Key, typename T, typename Hash>
+	class frozen_hash_map<Key, T, Hash>::const_iterator
+	{
+	public:
+		using value_type = typename frozen_hash_map::value_type;
+		using difference_type = ptrdiff_t;
+		using iterator_category = std::forward_iterator_tag;
+		using reference = value_type;
+
+		// Makes -> work on a pair that only exists as a temporary.
+		struct pointer
+		{
+			value_type mValue;
+			const value_type* operator->() const { return &mValue; }
+		};
+
+		const_iterator() = default;
+
+		value_type operator*() const { return mMap->element(mSlot); }
+		pointer operator->() const { return pointer{ **this }; }
+
+		const_iterator& operator++()
+		{
+			mSlot = mMap->nextFull(mSlot + 1);
+			return *this;
+		}
+		const_iterator operator++(int)
+		{
+			const_iterator old = *this;
+			++*this;
+			return old;
+		}
+
+		bool operator==(const const_iterator& rhs) const { return mMap == rhs.mMap && mSlot == rhs.mSlot; }
+		bool operator!=(const const_iterator& rhs) const { return !(*this == rhs); }
+
+	private:
+		friend class frozen_hash_map;
+
+		const_iterator(const frozen_hash_map* map, size_t slot)
+			: mMap(map), mSlot(slot)
+		{
+		}
+
+		const frozen_hash_map* mMap = nullptr;
+		size_t mSlot = 0;
+	};
+
+	// Freezes a hash_map with its own hash function. The image must be
+	// opened with a frozen_hash_map<Key, T, Hash> whose hash function
+	// behaves the same.
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void freeze(const hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>& map, const std::string& path);
+
+
+	namespace detail {
+
+		inline mapped_file::mapped_file(const std::string& path)
+		{
+			int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0) {
+				throw std::system_error(errno, std::generic_category(), "open " + path);
+			}
+			struct stat status;
+			if (::fstat(fd, &status) != 0) {
+				int error = errno;
+				::close(fd);
+				throw std::system_error(error, std::generic_category(), "fstat " + path);
+			}
+			mSize = static_cast<size_t>(status.st_size);
+			// An empty file can't be mapped; it views as zero bytes.
+			if (mSize != 0) {
+				void* data = ::mmap(nullptr, mSize, PROT_READ, MAP_SHARED, fd, 0);
+				if (data == MAP_FAILED) {
+					int error = errno;
+					::close(fd);
+					throw std::system_error(error, std::generic_category(), "mmap " + path);
+				}
+				mData = data;
+			}
+			// The mapping stays valid after the descriptor is closed.
+			::close(fd);
+		}
+
+		inline mapped_file::~mapped_file()
+		{
+			if (mData != nullptr) {
+				::munmap(mData, mSize);
+			}
+		}
+
+		inline mapped_file::mapped_file(mapped_file&& src) noexcept
+			: mData(src.mData), mSize(src.mSize)
+		{
+			src.mData = nullptr;
+			src.mSize = 0;
+		}
+
+		inline mapped_file& mapped_file::operator=(mapped_file&& rhs) noexcept
+		{
+			std::swap(mData, rhs.mData);
+			std::swap(mSize, rhs.mSize);
+			return *this;
+		}
+
+		inline const void* mapped_file::data() const
+		{
+			return mData;
+		}
+
+		inline size_t mapped_file::size() const
+		{
+			return mSize;
+		}
+
+	} // namespace detail
+
+
+	template <typename Key, typename T, typename Hash>
+	frozen_hash_map<Key, T, Hash>::frozen_hash_map(const void* image, size_t size, const Hash& hash)
+		: mHash(hash)
+	{
+		attach(image, size);
+	}
+
+	template <typename Key, typename T, typename Hash>
+	frozen_hash_map<Key, T, Hash>::frozen_hash_map(const std::string& path, const Hash& hash)
+		: mFile(path), mHash(hash)
+	{
+		attach(mFile.data(), mFile.size());
+	}
+
+	template <typename Key, typename T, typename Hash>
+	size_t frozen_hash_map<Key, T, Hash>::mix(size_t hash)
+	{
+		return static_cast<size_t>(hash_integer(static_cast<uint64_t>(hash)));
+	}
+
+	template <typename Key, typename T, typename Hash>
+	detail::ctrl_t frozen_hash_map<Key, T, Hash>::h2(size_t mixed)
+	{
+		return static_cast<ctrl_t>(mixed & 0x7f);
+	}
+
+	template <typename Key, typename T, typename Hash>
+	size_t frozen_hash_map<Key, T, Hash>::h1(size_t mixed)
+	{
+		return mixed >> 7;
+	}
+
+	template <typename Key, typename T, typename Hash>
+	size_t frozen_hash_map<Key, T, Hash>::capacityFor(size_t n)
+	{
+		size_t capacity = group::kWidth;
+		while (capacity - capacity / 8 < n) {
+			capacity *= 2;
+		}
+		return capacity;
+	}
+
+	template <typename Key, typename T, typename Hash>
+	uint32_t frozen_hash_map<Key, T, Hash>::formatFlags()
+	{
+		return (key_field::kIsString ? 1u : 0u) | (mapped_field::kIsString ? 2u : 0u);
+	}
+
+	template <typename Key, typename T, typename Hash>
+	template <typename Range>
+	void frozen_hash_map<Key, T, Hash>::freeze(const Range& elements, std::ostream& out, const Hash& hash)
+	{
+		using std::begin;
+		using std::end;
+
+		size_t count = static_cast<size_t>(std::distance(begin(elements), end(elements)));
+		size_t capacity = capacityFor(count);
+		size_t mask = capacity - 1;
+
+		// Place every element in the first empty slot of its probe
+		// sequence, exactly as group_probing would. Strings are given
+		// their place in the pool in the order of the range.
+		std::vector<ctrl_t> ctrl(capacity + group::kWidth, detail::kEmpty);
+		std::vector<char> entries(capacity * sizeof(entry), 0);
+		uint64_t stringsSize = 0;
+		for (const auto& element : elements) {
+			size_t mixed = mix(hash(element.first));
+			size_t pos = h1(mixed) & mask;
+			size_t step = 0;
+			uint32_t empty;
+			while ((empty = group(ctrl.data() + pos).match_empty()) == 0) {
+				step += group::kWidth;
+				pos = (pos + step) & mask;
+			}
+			size_t slot = (pos + detail::count_trailing_zeros(empty)) & mask;
+			ctrl[slot] = h2(mixed);
+			if (slot < group::kWidth) {
+				ctrl[capacity + slot] = h2(mixed);
+			}
+
+			uint64_t keyOffset = stringsSize;
+			stringsSize += key_field::length(element.first);
+			uint64_t valueOffset = stringsSize;
+			stringsSize += mapped_field::length(element.second);
+			entry e{ key_field::store(element.first, keyOffset), mapped_field::store(element.second, valueOffset) };
+			std::memcpy(entries.data() + slot * sizeof(entry), &e, sizeof(entry));
+		}
+
+		detail::frozen_header header{};
+		std::memcpy(header.mMagic, detail::kFrozenMagic, sizeof(header.mMagic));
+		header.mVersion = detail::kFrozenVersion;
+		header.mByteOrder = detail::kFrozenByteOrder;
+		header.mKeySize = sizeof(typename key_field::stored_type);
+		header.mValueSize = sizeof(typename mapped_field::stored_type);
+		header.mEntrySize = sizeof(entry);
+		header.mFlags = formatFlags();
+		header.mSize = count;
+		header.mCapacity = capacity;
+		header.mCtrlOffset = detail::frozen_align(sizeof(header));
+		header.mEntriesOffset = detail::frozen_align(header.mCtrlOffset + ctrl.size());
+		header.mStringsOffset = detail::frozen_align(header.mEntriesOffset + entries.size());
+		header.mStringsSize = stringsSize;
+		header.mImageSize = header.mStringsOffset + stringsSize;
+
+		// Writes zeros up to the given offset.
+		uint64_t written = 0;
+		auto padTo = [&out, &written](uint64_t offset) {
+			static const char zeros[detail::kFrozenAlignment] = {};
+			out.write(zeros, static_cast<std::streamsize>(offset - written));
+			written = offset;
+		};
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		written = sizeof(header);
+		padTo(header.mCtrlOffset);
+		out.write(reinterpret_cast<const char*>(ctrl.data()), static_cast<std::streamsize>(ctrl.size()));
+		written += ctrl.size();
+		padTo(header.mEntriesOffset);
+		out.write(entries.data(), static_cast<std::streamsize>(entries.size()));
+		written += entries.size();
+		padTo(header.mStringsOffset);
+
+		// The pool, in the same order as the offsets were handed out.
+		if (key_field::kIsString || mapped_field::kIsString) {
+			for (const auto& element : elements) {
+				key_field::write(out, element.first);
+				mapped_field::write(out, element.second);
+			}
+		}
+		if (!out) {
+			throw std::runtime_error("frozen_hash_map: writing the image failed");
+		}
+	}
+
+	template <typename Key, typename T, typename Hash>
+	template <typename Range>
+	void frozen_hash_map<Key, T, Hash>::freeze(const Range& elements, const std::string& path, const Hash& hash)
+	{
+		// Write a new file and move it into place, rather than overwrite
+		// a file that others may have mapped.
+		std::string temporary = path + ".tmp";
+		{
+			std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+			if (!out) {
+				throw std::runtime_error("frozen_hash_map: cannot create " + temporary);
+			}
+			freeze(elements, out, hash);
+			out.close();
+			if (!out) {
+				std::remove(temporary.c_str());
+				throw std::runtime_error("frozen_hash_map: writing " + temporary + " failed");
+			}
+		}
+		if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+			int error = errno;
+			std::remove(temporary.c_str());
+			throw std::system_error(error, std::generic_category(), "rename " + temporary);
+		}
+	}
+
+	template <typename Key, typename T, typename Hash>
+	void frozen_hash_map<Key, T, Hash>::attach(const void* image, size_t size)
+	{
+		if (reinterpret_cast<uintptr_t>(image) % alignof(detail::frozen_header) != 0) {
+			throw std::invalid_argument("frozen_hash_map: the image is not aligned");
+		}
+		auto invalid = [](const char* what) {
+			return std::runtime_error(std::string("frozen_hash_map: ") + what);
+		};
+		if (size < sizeof(detail::frozen_header)) {
+			throw invalid("not an image");
+		}
+
+		const auto& header = *static_cast<const detail::frozen_header*>(image);
+		if (std::memcmp(header.mMagic, detail::kFrozenMagic, sizeof(header.mMagic)) != 0) {
+			throw invalid("not an image");
+		}
+		if (header.mVersion != detail::kFrozenVersion || header.mByteOrder != detail::kFrozenByteOrder) {
+			throw invalid("unsupported image version or byte order");
+		}
+		if (header.mKeySize != sizeof(typename key_field::stored_type) ||
+			header.mValueSize != sizeof(typename mapped_field::stored_type) ||
+			header.mEntrySize != sizeof(entry) || header.mFlags != formatFlags()) {
+			throw invalid("the image holds different key or mapped types");
+		}
+
+		// Every section must lie inside the image, in order.
+		uint64_t capacity = header.mCapacity;
+		if (capacity < group::kWidth || (capacity & (capacity - 1)) != 0 ||
+			header.mSize > capacity - capacity / 8 ||
+			header.mImageSize > size ||
+			header.mCtrlOffset < sizeof(header) ||
+			header.mEntriesOffset < header.mCtrlOffset + capacity + group::kWidth ||
+			header.mEntriesOffset % alignof(entry) != 0 ||
+			header.mStringsOffset < header.mEntriesOffset + capacity * sizeof(entry) ||
+			header.mStringsOffset + header.mStringsSize > header.mImageSize) {
+			throw invalid("corrupt image header");
+		}
+
+		mImage = static_cast<const char*>(image);
+		mImageSize = static_cast<size_t>(header.mImageSize);
+		mCtrl = reinterpret_cast<const ctrl_t*>(mImage + header.mCtrlOffset);
+		mEntries = reinterpret_cast<const entry*>(mImage + header.mEntriesOffset);
+		mStrings = mImage + header.mStringsOffset;
+		mSize = static_cast<size_t>(header.mSize);
+		mCapacity = static_cast<size_t>(capacity);
+	}
+
+	template <typename Key, typename T, typename Hash>
+	size_t frozen_hash_map<Key, T, Hash>::findSlot(lookup_type k) const
+	{
+		if (mCapacity == 0) {
+			return mCapacity;
+		}
+		size_t mixed = mix(mHash(k));
+		ctrl_t tag = h2(mixed);
+		size_t mask = mCapacity - 1;
+		size_t pos = h1(mixed) & mask;
+		size_t step = 0;
+		while (true) {
+			group g(mCtrl + pos);
+			for (uint32_t match = g.match(tag); match != 0; match &= match - 1) {
+				size_t i = (pos + detail::count_trailing_zeros(match)) & mask;
+				if (key_field::view(mEntries[i].mKey, mStrings) == k) {
+					return i;
+				}
+			}
+			// A frozen table has no deleted slots, and at least one
+			// empty one.
+			if (g.match_empty() != 0) {
+				return mCapacity;
+			}
+			step += group::kWidth;
+			pos = (pos + step) & mask;
+		}
+	}
+
+	template <typename Key, typename T, typename Hash>
+	size_t frozen_hash_map<Key, T, Hash>::nextFull(size_t i) const
+	{
+		while (i < mCapacity) {
+			uint32_t full = group(mCtrl + i).match_full();
+			// Bytes past the end are the mirrored first group.
+			if (mCapacity - i < group::kWidth) {
+				full &= (1u << (mCapacity - i)) - 1;
+			}
+			if (full != 0) {
+				return i + detail::count_trailing_zeros(full);
+			}
+			i += group::kWidth;
+		}
+		return mCapacity;
+	}
+
+	template <typename Key, typename T, typename Hash>
+	typename frozen_hash_map<Key, T, Hash>::value_type frozen_hash_map<Key, T, Hash>::element(size_t slot) const
+	{
+		const entry& e = mEntries[slot];
+		return value_type(key_field::view(e.mKey, mStrings), mapped_field::view(e.mValue, mStrings));
+	}
+
+	template <typename Key, typename T, typename Hash>
+	typename frozen_hash_map<Key, T, Hash>::const_iterator frozen_hash_map<Key, T, Hash>::find(lookup_type k) const
+	{
+		return const_iterator(this, findSlot(k));
+	}
+
+	template <typename Key, typename T, typename Hash>
+	bool frozen_hash_map<Key, T, Hash>::contains(lookup_type k) const
+	{
+		return findSlot(k) != mCapacity;
+	}
+
+	template <typename Key, typename T, typename Hash>
+	typename frozen_hash_map<Key, T, Hash>::size_type frozen_hash_map<Key, T, Hash>::count(lookup_type k) const
+	{
+		return contains(k) ? 1 : 0;
+	}
+
+	template <typename Key, typename T, typename Hash>
+	typename frozen_hash_map<Key, T, Hash>::mapped_view frozen_hash_map<Key, T, Hash>::at(lookup_type k) const
+	{
+		size_t slot = findSlot(k);
+		if (slot == mCapacity) {
+			throw std::out_of_range("frozen_hash_map::at: key not found");
+		}
+		return mapped_field::view(mEntries[slot].mValue, mStrings);
+	}
+
+	template <typename Key, typename T, typename Hash>
+	typename frozen_hash_map<Key, T, Hash>::const_iterator frozen_hash_map<Key, T, Hash>::begin() const
+	{
+		return const_iterator(this, nextFull(0));
+	}
+
+	template <typename Key, typename T, typename Hash>
+	typename frozen_hash_map<Key, T, Hash>::const_iterator frozen_hash_map<Key, T, Hash>::end() const
+	{
+		return const_iterator(this, mCapacity);
+	}
+
+	template <typename Key, typename T, typename Hash>
+	typename frozen_hash_map<Key, T, Hash>::const_iterator frozen_hash_map<Key, T, Hash>::cbegin() const
+	{
+		return begin();
+	}
+
+	template <typename Key, typename T, typename Hash>
+	typename frozen_hash_map<Key, T, Hash>::const_iterator frozen_hash_map<Key, T, Hash>::cend() const
+	{
+		return end();
+	}
+
+	template <typename Key, typename T, typename Hash>
+	bool frozen_hash_map<Key, T, Hash>::empty() const
+	{
+		return mSize == 0;
+	}
+
+	template <typename Key, typename T, typename Hash>
+	typename frozen_hash_map<Key, T, Hash>::size_type frozen_hash_map<Key, T, Hash>::size() const
+	{
+		return mSize;
+	}
+
+	template <typename Key, typename T, typename Hash>
+	typename frozen_hash_map<Key, T, Hash>::size_type frozen_hash_map<Key, T, Hash>::bucket_count() const
+	{
+		return mCapacity;
+	}
+
+	template <typename Key, typename T, typename Hash>
+	typename frozen_hash_map<Key, T, Hash>::hasher frozen_hash_map<Key, T, Hash>::hash_function() const
+	{
+		return mHash;
+	}
+
+	template <typename Key, typename T, typename Hash>
+	const void* frozen_hash_map<Key, T, Hash>::data() const
+	{
+		return mImage;
+	}
+
+	template <typename Key, typename T, typename Hash>
+	size_t frozen_hash_map<Key, T, Hash>::image_size() const
+	{
+		return mImageSize;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void freeze(const hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>& map, const std::string& path)
+	{
+		frozen_hash_map<Key, T, Hash>::freeze(map, path, map.hash_function());
+	}
+
+} //namespace util
+
+#endif // FROZEN_HASH_MAP_H_
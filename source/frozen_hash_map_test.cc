@@ -0,0 +1,107 @@
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "frozen_hash_map.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+// Copies an image into suitably aligned memory.
+std::vector<uint64_t> alignedCopy(const std::string& image) {
+  std::vector<uint64_t> buffer((image.size() + 7) / 8);
+  std::memcpy(buffer.data(), image.data(), image.size());
+  return buffer;
+}
+
+std::string temporaryPath(const char* name) {
+  return "/tmp/" + std::string(name) + "." + std::to_string(::getpid());
+}
+
+} // namespace
+
+TEST(MyFrozenHashMap, TriviallyCopyable) {
+  util::hash_map<int, double> map;
+  for (int i = 0; i < 1000; i++) {
+    map[i * 3] = i / 2.0;
+  }
+  std::ostringstream out;
+  util::frozen_hash_map<int, double>::freeze(map, out);
+  std::string image = out.str();
+  auto buffer = alignedCopy(image);
+
+  util::frozen_hash_map<int, double> frozen(buffer.data(), image.size());
+  EXPECT_EQ(frozen.size(), 1000u);
+  EXPECT_EQ(frozen.image_size(), image.size());
+  for (int i = 0; i < 3000; i++) {
+    EXPECT_EQ(frozen.contains(i), i % 3 == 0);
+  }
+  EXPECT_EQ(frozen.at(300), 50.0);
+  EXPECT_EQ(frozen.find(301), frozen.end());
+  EXPECT_EQ(frozen.find(3)->second, 0.5);
+  EXPECT_THROW(frozen.at(1), std::out_of_range);
+
+  // Iteration visits every element once.
+  size_t visited = 0;
+  for (auto element : frozen) {
+    EXPECT_EQ(map.find(element.first)->second, element.second);
+    visited++;
+  }
+  EXPECT_EQ(visited, 1000u);
+}
+
+TEST(MyFrozenHashMap, StringsFromFile) {
+  util::hash_map<std::string, std::string> map;
+  for (int i = 0; i < 200; i++) {
+    map[std::to_string(i)] = std::string(i % 7, 'x') + std::to_string(i * i);
+  }
+  map[""] = "empty key";
+  std::string path = temporaryPath("frozen_strings");
+  util::freeze(map, path);
+
+  util::frozen_hash_map<std::string, std::string> frozen(path);
+  EXPECT_EQ(frozen.size(), 201u);
+  for (const auto& element : map) {
+    EXPECT_EQ(frozen.at(element.first), element.second);
+  }
+  EXPECT_EQ(frozen.at(""), "empty key");
+  EXPECT_FALSE(frozen.contains("200"));
+  EXPECT_EQ(frozen.count("12"), 1u);
+
+  // The view survives being moved.
+  util::frozen_hash_map<std::string, std::string> moved(std::move(frozen));
+  EXPECT_EQ(moved.at("13"), "xxxxxx169");
+  std::remove(path.c_str());
+}
+
+TEST(MyFrozenHashMap, EmptyMap) {
+  util::hash_map<int, int> map;
+  std::ostringstream out;
+  util::frozen_hash_map<int, int>::freeze(map, out);
+  std::string image = out.str();
+  auto buffer = alignedCopy(image);
+  util::frozen_hash_map<int, int> frozen(buffer.data(), image.size());
+  EXPECT_TRUE(frozen.empty());
+  EXPECT_EQ(frozen.begin(), frozen.end());
+  EXPECT_FALSE(frozen.contains(0));
+}
+
+TEST(MyFrozenHashMap, RejectsBadImages) {
+  util::hash_map<int, int> map({ { 1, 2 } });
+  std::ostringstream out;
+  util::frozen_hash_map<int, int>::freeze(map, out);
+  std::string image = out.str();
+  auto buffer = alignedCopy(image);
+
+  // Wrong types, truncated, and corrupted images.
+  using WrongType = util::frozen_hash_map<int, std::string>;
+  EXPECT_THROW(WrongType(buffer.data(), image.size()), std::runtime_error);
+  using Map = util::frozen_hash_map<int, int>;
+  EXPECT_THROW(Map(buffer.data(), image.size() - 1), std::runtime_error);
+  EXPECT_THROW(Map(buffer.data(), 10), std::runtime_error);
+  reinterpret_cast<char*>(buffer.data())[0] = 'X';
+  EXPECT_THROW(Map(buffer.data(), image.size()), std::runtime_error);
+  EXPECT_THROW(Map(temporaryPath("does_not_exist")), std::system_error);
+}
@@ -2,35 +2,759 @@
 #define HASH_MAP_H_
 
 #include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
 #include <vector>
 #include <list>
-#include <iterator> 
+#include <iterator>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <initializer_list>
 #include <functional>
 #include <stdexcept>
+#include <system_error>
 #include <algorithm>
+#include <numeric>
 #include <utility>
+#include <tuple>
+#include <memory>
+#include <new>
+#include <limits>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTIL_HASH_MAP_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace util {
 
-	// A default hash object
+	// Hashes len bytes starting at data, in the style of wyhash: 16 bytes
+	// at a time are folded into the state with a 64x64->128 bit multiply,
+	// on three independent lanes for long inputs.
+	uint64_t hash_bytes(const void* data, size_t len, uint64_t seed = 0);
+
+	// Hashes a 64-bit integer with the splitmix64 finalizer, a
+	// multiply-xorshift mixer. For any seed it is a bijection, so distinct
+	// integers never collide before the table reduces the hash.
+	constexpr uint64_t hash_integer(uint64_t x, uint64_t seed = 0);
+
+	// The default hash object. Integral, enumeration and pointer keys go
+	// through hash_integer(), floating-point keys through their value bits
+	// (so that 0.0 and -0.0 agree), and any other type is hashed as its
+	// object representation with hash_bytes(). Hashes with different seeds
+	// are independent.
 	template <typename T>
 	class hash
 	{
 	public:
+		hash() = default;
+		explicit hash(size_t seed);
+
 		size_t operator()(const T& key) const;
+
+	private:
+		size_t mSeed = 0;
 	};
 
-	// A hash specialization for strings
+	// A hash specialization for strings: hashes the characters. It is
+	// transparent, so a map keyed on std::string can be searched with a
+	// string view or a C string without building a temporary string.
 	template <>
 	class hash<std::string>
 	{
 	public:
-		size_t operator()(const std::string& key) const;
+		using is_transparent = void;
+
+		hash() = default;
+		explicit hash(size_t seed);
+
+		size_t operator()(std::string_view key) const;
+
+	private:
+		size_t mSeed = 0;
+	};
+
+	// A hash specialization for string views. A view hashes the same as a
+	// std::string holding the same characters.
+	template <>
+	class hash<std::string_view>
+	{
+	public:
+		using is_transparent = void;
+
+		hash() = default;
+		explicit hash(size_t seed);
+
+		size_t operator()(std::string_view key) const;
+
+	private:
+		size_t mSeed = 0;
+	};
+
+
+	// Storage policies for hash_map. A policy supplies the table type that
+	// holds the elements; hash_map itself only deals with keys, hashing
+	// and the public interface.
+
+	// Separate chaining: each bucket is a std::list of elements.
+	// This is the default, and keeps element addresses stable forever.
+	struct chaining
+	{
+		template <typename Value, typename Allocator = std::allocator<Value>, bool Incremental = false>
+		class table;
+	};
+
+	// Separate chaining with incremental growth: instead of rehashing all
+	// elements at once, each insertion or erasure by key moves a bounded
+	// number of buckets from the old array to the new one. This bounds the
+	// latency of any single operation. Lookups never move anything, so
+	// they don't invalidate iterators.
+	struct incremental_chaining
+	{
+		template <typename Value, typename Allocator = std::allocator<Value>>
+		using table = chaining::table<Value, Allocator, true>;
+	};
+
+	// Open addressing with SIMD group probing: elements are stored inline
+	// in one contiguous slot array, next to an array of one-byte control
+	// codes. A lookup compares 16 control bytes at a time against 7 bits
+	// of the hash, so most probes touch a single cache line of metadata
+	// and then exactly one slot. Element addresses are not stable across
+	// insertions.
+	struct group_probing
+	{
+		template <typename Value, typename Allocator = std::allocator<Value>>
+		class table;
+	};
+
+	// Open addressing with Robin Hood linear probing: an insertion takes
+	// over the slot of any element that is closer to its home slot than
+	// the new one, and erasure shifts the following elements back instead
+	// of leaving tombstones. Displacements stay short and even, and are
+	// bounded: no element is ever more than robin_hood::table::
+	// kMaxDisplacement slots from home. Element addresses are not stable
+	// across insertions or erasures.
+	struct robin_hood
+	{
+		template <typename Value, typename Allocator = std::allocator<Value>>
+		class table;
+	};
+
+	// Bucketized cuckoo hashing: every element lives in one of two
+	// buckets of four slots, so a lookup never checks more than eight
+	// slots, however full the table is. An insertion into two full
+	// buckets moves ("kicks") other elements to their alternate buckets to
+	// make room. Element addresses are not stable across insertions.
+	struct cuckoo
+	{
+		template <typename Value, typename Allocator = std::allocator<Value>>
+		class table;
+	};
+
+	// Wraps another policy and stores each element's full hash next to
+	// it. Lookups compare the stored hash before calling KeyEqual, and
+	// rehashing, erasing or moving an element never calls Hash again. This
+	// costs a size_t per element, and pays off for keys that are slow to
+	// hash or compare, such as long strings. Element addresses are as
+	// stable as with Policy.
+	template <typename Policy>
+	struct cached_hash
+	{
+		template <typename Value, typename Allocator = std::allocator<Value>>
+		class table;
+	};
+
+	// Probe-length statistics of a hash_map's current contents, as
+	// returned by hash_map::probe_stats(). What a probe is depends on the
+	// policy: a list node for chaining, a group of 16 control bytes for
+	// group_probing, a slot for robin_hood and a bucket for cuckoo.
+	struct probe_stats
+	{
+		size_t size = 0;
+		// Probes a successful lookup makes, counting the first one.
+		double mean_probe_length = 0.0;
+		size_t max_probe_length = 0;
+		// displacement_histogram[d] elements are found d probes after the
+		// first.
+		std::vector<size_t> displacement_histogram;
+		// Elements moved to make room for others during insertion, over the
+		// table's lifetime. Always 0 for chaining and group_probing.
+		size_t kicks = 0;
+		// Growths forced before the maximum load factor was reached, by the
+		// displacement limit or a failed cuckoo insertion.
+		size_t forced_growths = 0;
+	};
+
+	// Bucket occupancy of a hash_map, as returned by
+	// hash_map::bucket_stats(). The buckets are those of the bucket
+	// interface, so with open addressing none holds more than one element,
+	// and probe_stats() says more.
+	struct bucket_stats
+	{
+		size_t bucket_count = 0;
+		// occupancy_histogram[k] buckets hold k elements.
+		std::vector<size_t> occupancy_histogram;
+		size_t longest_chain = 0;
+	};
+
+	// Selects hash_map's parallel range constructor, and says how many
+	// threads it may use.
+	struct parallel_build
+	{
+		// 0 stands for std::thread::hardware_concurrency().
+		unsigned threads = 0;
+	};
+
+
+	namespace detail {
+
+		// Index of the lowest set bit. Behavior is undefined if x is 0.
+		inline unsigned count_trailing_zeros(uint32_t x)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward(&index, x);
+			return static_cast<unsigned>(index);
+#else
+			return static_cast<unsigned>(__builtin_ctz(x));
+#endif
+		}
+
+		// Number of leading zeros of the low 16 bits. x may be 0.
+		inline unsigned count_leading_zeros16(uint32_t x)
+		{
+			unsigned n = 0;
+			for (uint32_t bit = 0x8000; bit != 0 && (x & bit) == 0; bit >>= 1) {
+				++n;
+			}
+			return n;
+		}
+
+		// Index of the lowest set bit. Behavior is undefined if x is 0.
+		inline unsigned count_trailing_zeros64(uint64_t x)
+		{
+#if defined(_MSC_VER) && defined(_M_X64)
+			unsigned long index;
+			_BitScanForward64(&index, x);
+			return static_cast<unsigned>(index);
+#elif defined(_MSC_VER)
+			uint32_t low = static_cast<uint32_t>(x);
+			return low != 0 ? count_trailing_zeros(low) : 32 + count_trailing_zeros(static_cast<uint32_t>(x >> 32));
+#else
+			return static_cast<unsigned>(__builtin_ctzll(x));
+#endif
+		}
+
+		// Index of the highest set bit. Behavior is undefined if x is 0.
+		inline unsigned highest_bit64(uint64_t x)
+		{
+#if defined(_MSC_VER) && defined(_M_X64)
+			unsigned long index;
+			_BitScanReverse64(&index, x);
+			return static_cast<unsigned>(index);
+#elif defined(_MSC_VER)
+			unsigned long index;
+			uint32_t high = static_cast<uint32_t>(x >> 32);
+			if (high != 0) {
+				_BitScanReverse(&index, high);
+				return 32 + static_cast<unsigned>(index);
+			}
+			_BitScanReverse(&index, static_cast<uint32_t>(x));
+			return static_cast<unsigned>(index);
+#else
+			return 63 - static_cast<unsigned>(__builtin_clzll(x));
+#endif
+		}
+
+		// Occupancy bitmaps are arrays of 64-bit words; bit i lives in word
+		// i / 64. These scan them a word at a time.
+
+		// Returns the index of the first set bit in [from, size), or size.
+		inline size_t find_next_bit(const uint64_t* words, size_t from, size_t size)
+		{
+			if (from >= size) {
+				return size;
+			}
+			// Most calls find a bit in the first word.
+			size_t w = from / 64;
+			uint64_t bits = words[w] >> (from % 64);
+			if (bits != 0) {
+				return from + count_trailing_zeros64(bits);
+			}
+			// Bits past size are never set.
+			for (size_t lastWord = (size - 1) / 64; ++w <= lastWord;) {
+				if (words[w] != 0) {
+					return w * 64 + count_trailing_zeros64(words[w]);
+				}
+			}
+			return size;
+		}
+
+		// Returns the index of the last set bit before before, or size_t(-1).
+		inline size_t find_prev_bit(const uint64_t* words, size_t before)
+		{
+			if (before == 0) {
+				return static_cast<size_t>(-1);
+			}
+			size_t last = before - 1;
+			size_t w = last / 64;
+			uint64_t bits = words[w] & (~uint64_t(0) >> (63 - last % 64));
+			while (bits == 0) {
+				if (w-- == 0) {
+					return static_cast<size_t>(-1);
+				}
+				bits = words[w];
+			}
+			return w * 64 + highest_bit64(bits);
+		}
+
+		// Multiplies a and b to a 128-bit product, and returns its low and
+		// high halves in a and b.
+		inline void multiply128(uint64_t& a, uint64_t& b)
+		{
+#if defined(__SIZEOF_INT128__)
+			unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+			a = static_cast<uint64_t>(product);
+			b = static_cast<uint64_t>(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+			a = _umul128(a, b, &b);
+#else
+			uint64_t ha = a >> 32, hb = b >> 32, la = static_cast<uint32_t>(a), lb = static_cast<uint32_t>(b);
+			uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+			uint64_t t = rl + (rm0 << 32);
+			uint64_t carry = t < rl;
+			uint64_t lo = t + (rm1 << 32);
+			carry += lo < t;
+			a = lo;
+			b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+		}
+
+		// The basic mixing step: multiply, then fold the product.
+		inline uint64_t fold_multiply(uint64_t a, uint64_t b)
+		{
+			multiply128(a, b);
+			return a ^ b;
+		}
+
+		// The 64-bit finalizer from MurmurHash3. It spreads every input bit
+		// over the whole word, so weak hashes still fill every bit the
+		// open-addressing tables use.
+		inline uint64_t fmix64(uint64_t h)
+		{
+			h ^= h >> 33;
+			h *= 0xff51afd7ed558ccdULL;
+			h ^= h >> 33;
+			h *= 0xc4ceb9fe1a85ec53ULL;
+			h ^= h >> 33;
+			return h;
+		}
+
+		inline uint64_t read64(const unsigned char* p)
+		{
+			uint64_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		}
+
+		inline uint64_t read32(const unsigned char* p)
+		{
+			uint32_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return v;
+		}
+
+		// Asks the CPU to start loading the cache line at p. Never faults,
+		// whatever p is.
+		inline void prefetch(const void* p)
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			__builtin_prefetch(p);
+#elif defined(UTIL_HASH_MAP_SSE2)
+			_mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+			(void)p;
+#endif
+		}
+
+		// Constants of the byte hasher.
+		constexpr uint64_t kHashSecret[4] = {
+			0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL };
+
+		// Control bytes of the group_probing table. A full slot stores the
+		// low 7 bits of its hash (so the sign bit is clear); the special
+		// states all have the sign bit set.
+		using ctrl_t = int8_t;
+		constexpr ctrl_t kEmpty = -128;   // 0b10000000
+		constexpr ctrl_t kDeleted = -2;   // 0b11111110
+
+		// A group of 16 consecutive control bytes. Every match function
+		// returns a bitmask with bit i set if control byte i matched.
+		class ctrl_group
+		{
+		public:
+			static constexpr size_t kWidth = 16;
+
+			explicit ctrl_group(const ctrl_t* pos)
+			{
+#ifdef UTIL_HASH_MAP_SSE2
+				mCtrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+#else
+				std::memcpy(mCtrl, pos, kWidth);
+#endif
+			}
+
+			// Slots whose control byte equals h2.
+			uint32_t match(ctrl_t h2) const
+			{
+#ifdef UTIL_HASH_MAP_SSE2
+				return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), mCtrl)));
+#else
+				uint32_t mask = 0;
+				for (size_t i = 0; i < kWidth; ++i) {
+					mask |= static_cast<uint32_t>(mCtrl[i] == h2) << i;
+				}
+				return mask;
+#endif
+			}
+
+			uint32_t match_empty() const
+			{
+				return match(kEmpty);
+			}
+
+			// Empty and deleted are the only states below kSentinel (-1).
+			uint32_t match_empty_or_deleted() const
+			{
+#ifdef UTIL_HASH_MAP_SSE2
+				return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), mCtrl)));
+#else
+				uint32_t mask = 0;
+				for (size_t i = 0; i < kWidth; ++i) {
+					mask |= static_cast<uint32_t>(mCtrl[i] < -1) << i;
+				}
+				return mask;
+#endif
+			}
+
+			// Full slots are exactly those with the sign bit clear.
+			uint32_t match_full() const
+			{
+#ifdef UTIL_HASH_MAP_SSE2
+				return static_cast<uint32_t>(~_mm_movemask_epi8(mCtrl)) & 0xffff;
+#else
+				uint32_t mask = 0;
+				for (size_t i = 0; i < kWidth; ++i) {
+					mask |= static_cast<uint32_t>(mCtrl[i] >= 0) << i;
+				}
+				return mask;
+#endif
+			}
+
+		private:
+#ifdef UTIL_HASH_MAP_SSE2
+			__m128i mCtrl;
+#else
+			ctrl_t mCtrl[kWidth];
+#endif
+		};
+
+		// Returns the shared control bytes of an open-addressing table with
+		// no slots. Never written to: a table without slots has no room, so
+		// the first insertion allocates real storage.
+		inline ctrl_t* empty_group()
+		{
+			alignas(16) static ctrl_t empty[ctrl_group::kWidth] = {
+				kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty,
+				kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty };
+			return empty;
+		}
+
+		// Maps store std::pair<const Key, T>, but open addressing has to
+		// move elements around when it rehashes. Internally such slots are
+		// constructed as std::pair<Key, T> (which has the same layout) so
+		// that keys can be moved instead of copied.
+		template <typename Value>
+		struct mutable_value
+		{
+			using type = Value;
+		};
+
+		template <typename Key, typename T>
+		struct mutable_value<std::pair<const Key, T>>
+		{
+			using type = std::pair<Key, T>;
+		};
+
+		// Hashes a slot number to the hash of the element in that slot,
+		// for laying out a resized table before moving anything.
+		struct slot_hash
+		{
+			const size_t* mHashes;
+
+			size_t operator()(size_t slot) const { return mHashes[slot]; }
+		};
+
+		// Counts one element, found displacement probes after the first,
+		// into stats.
+		inline void add_probe(probe_stats& stats, size_t displacement)
+		{
+			if (stats.displacement_histogram.size() <= displacement) {
+				stats.displacement_histogram.resize(displacement + 1);
+			}
+			++stats.displacement_histogram[displacement];
+			++stats.size;
+			stats.mean_probe_length += static_cast<double>(displacement + 1);
+			stats.max_probe_length = std::max(stats.max_probe_length, displacement + 1);
+		}
+
+		// Turns the sum of probe lengths into their mean.
+		inline void finish_probe_stats(probe_stats& stats)
+		{
+			if (stats.size != 0) {
+				stats.mean_probe_length /= static_cast<double>(stats.size);
+			}
+		}
+
+		// Collects the bucket_stats of a storage table.
+		template <typename Table>
+		bucket_stats bucket_stats_of(const Table& table)
+		{
+			bucket_stats stats;
+			stats.bucket_count = table.bucket_count();
+			for (size_t n = 0; n < stats.bucket_count; n++) {
+				size_t size = table.bucket_size(n);
+				if (stats.occupancy_histogram.size() <= size) {
+					stats.occupancy_histogram.resize(size + 1);
+				}
+				++stats.occupancy_histogram[size];
+				stats.longest_chain = std::max(stats.longest_chain, size);
+			}
+			return stats;
+		}
+
+		// Returns the smallest bucket count from a list of primes that is at
+		// least n. The primes roughly double and sit between powers of two,
+		// so a modulo keeps using all the bits of even a weak hash.
+		inline size_t next_prime(size_t n)
+		{
+			static const unsigned long long primes[] = {
+				7ULL, 13ULL, 29ULL, 53ULL,
+				97ULL, 193ULL, 389ULL, 769ULL,
+				1543ULL, 3079ULL, 6151ULL, 12289ULL,
+				24593ULL, 49157ULL, 98317ULL, 196613ULL,
+				393241ULL, 786433ULL, 1572869ULL, 3145739ULL,
+				6291469ULL, 12582917ULL, 25165843ULL, 50331653ULL,
+				100663319ULL, 201326611ULL, 402653189ULL, 805306457ULL,
+				1610612741ULL, 3221225473ULL, 6442450967ULL, 12884901893ULL,
+				25769803799ULL, 51539607599ULL, 103079215111ULL, 206158430209ULL,
+				412316860441ULL, 824633720837ULL, 1649267441681ULL, 3298534883417ULL,
+				6597069766657ULL, 13194139533349ULL, 26388279066671ULL, 52776558133303ULL,
+				105553116266509ULL, 211106232533047ULL, 422212465066001ULL, 844424930132057ULL,
+				1688849860263953ULL, 3377699720527897ULL, 6755399441055827ULL, 13510798882111519ULL,
+				27021597764223071ULL, 54043195528445957ULL, 108086391056891941ULL, 216172782113783843ULL,
+				432345564227567621ULL, 864691128455135281ULL, 1729382256910270481ULL, 3458764513820540933ULL,
+				6917529027641081903ULL };
+			auto it = std::lower_bound(std::begin(primes), std::end(primes), static_cast<unsigned long long>(n));
+			if (it == std::end(primes) || *it > std::numeric_limits<size_t>::max()) {
+				throw std::length_error("Too many buckets");
+			}
+			return static_cast<size_t>(*it);
+		}
+
+		// Whether a hash or comparison object declares that it accepts
+		// keys of other types than the key type.
+		template <typename T, typename = void>
+		struct is_transparent : std::false_type {};
+
+		template <typename T>
+		struct is_transparent<T, std::void_t<typename T::is_transparent>> : std::true_type {};
+
+		// Whether a storage table can be filled from several threads at
+		// once, through begin_partitions() and emplace_in_partition().
+		template <typename Table, typename = void>
+		struct partitioned_build : std::false_type {};
+
+		template <typename Table>
+		struct partitioned_build<Table, std::void_t<decltype(Table::kPartitionedBuild)>>
+			: std::bool_constant<Table::kPartitionedBuild> {};
+
+		// Calls work(t) for every t in [0, threads), each on a thread of its
+		// own (t == 0 on the calling one), and waits for all of them. The
+		// first exception thrown by any call is rethrown. If a thread can't
+		// be started, its share runs on the calling thread instead.
+		template <typename Work>
+		void run_threads(size_t threads, const Work& work)
+		{
+			std::vector<std::exception_ptr> errors(threads);
+			auto guarded = [&work, &errors](size_t t) {
+				try {
+					work(t);
+				} catch (...) {
+					errors[t] = std::current_exception();
+				}
+			};
+
+			// Reserved up front, so that nothing but starting a thread can
+			// fail once one is running.
+			std::vector<std::thread> workers;
+			std::vector<size_t> leftOver;
+			workers.reserve(threads);
+			leftOver.reserve(threads);
+			for (size_t t = 1; t < threads; t++) {
+				try {
+					workers.emplace_back(guarded, t);
+				} catch (const std::system_error&) {
+					leftOver.push_back(t);
+				}
+			}
+			guarded(0);
+			for (size_t t : leftOver) {
+				guarded(t);
+			}
+			for (auto& worker : workers) {
+				worker.join();
+			}
+			for (auto& error : errors) {
+				if (error) {
+					std::rethrow_exception(error);
+				}
+			}
+		}
+
+		// Declares is_transparent exactly when F does, for wrappers that
+		// forward any key type to F.
+		template <typename F, typename = void>
+		struct transparent_base {};
+
+		template <typename F>
+		struct transparent_base<F, std::void_t<typename F::is_transparent>>
+		{
+			using is_transparent = void;
+		};
+
+		// An element of a cached_hash table, stored with its full hash.
+		template <typename Value>
+		struct hashed_value
+		{
+			template <typename... Args>
+			explicit hashed_value(size_t h, Args&&... args)
+				: hash(h), value(std::forward<Args>(args)...)
+			{
+			}
+
+			// Converts between the const-key and mutable forms of a map
+			// element, like mutable_value does for plain elements.
+			template <typename Other>
+			hashed_value(const hashed_value<Other>& other)
+				: hash(other.hash), value(other.value)
+			{
+			}
+
+			size_t hash;
+			Value value;
+		};
+
+		template <typename Value>
+		struct mutable_value<hashed_value<Value>>
+		{
+			using type = hashed_value<typename mutable_value<Value>::type>;
+		};
+
+		// A local iterator of a cached_hash table: walks a bucket of the
+		// wrapped table and yields the elements without their hashes.
+		template <typename Iterator, typename Value>
+		class hashed_local_iterator
+		{
+		public:
+			using value_type = std::remove_const_t<Value>;
+			using difference_type = ptrdiff_t;
+			using iterator_category = std::forward_iterator_tag;
+			using pointer = Value*;
+			using reference = Value&;
+
+			hashed_local_iterator() = default;
+			explicit hashed_local_iterator(Iterator it) : mIterator(it) {}
+
+			reference operator*() const { return mIterator->value; }
+			pointer operator->() const { return &mIterator->value; }
+
+			hashed_local_iterator& operator++()
+			{
+				++mIterator;
+				return *this;
+			}
+
+			hashed_local_iterator operator++(int)
+			{
+				hashed_local_iterator old = *this;
+				++mIterator;
+				return old;
+			}
+
+			bool operator==(const hashed_local_iterator& rhs) const { return mIterator == rhs.mIterator; }
+			bool operator!=(const hashed_local_iterator& rhs) const { return mIterator != rhs.mIterator; }
+
+		private:
+			Iterator mIterator{};
+		};
+
+	} // namespace detail
+
+
+	// Hash and key comparison objects that count their calls, to measure
+	// how much work a table does and to catch hashes that cluster. Copies
+	// share one count, so it includes the calls made through the copy a
+	// hash_map keeps; read it through hash_function() or key_eq(). The
+	// count is atomic, so concurrently used maps can be measured too. Each
+	// is transparent if what it wraps is.
+	template <typename Hash>
+	class counting_hash : public detail::transparent_base<Hash>
+	{
+	public:
+		counting_hash() = default;
+		explicit counting_hash(const Hash& hash);
+
+		template <typename K>
+		size_t operator()(const K& key) const;
+
+		// The number of calls so far, through this object or any copy.
+		size_t calls() const;
+		void reset_calls();
+
+	private:
+		Hash mHash;
+		std::shared_ptr<std::atomic<size_t>> mCalls = std::make_shared<std::atomic<size_t>>(0);
+	};
+
+	template <typename KeyEqual = std::equal_to<>>
+	class counting_equal : public detail::transparent_base<KeyEqual>
+	{
+	public:
+		counting_equal() = default;
+		explicit counting_equal(const KeyEqual& equal);
+
+		template <typename K1, typename K2>
+		bool operator()(const K1& lhs, const K2& rhs) const;
+
+		size_t calls() const;
+		void reset_calls();
+
+	private:
+		KeyEqual mEqual;
+		std::shared_ptr<std::atomic<size_t>> mCalls = std::make_shared<std::atomic<size_t>>(0);
 	};
 
-	
+
 	// const_hash_map_iterator class definition
 	template <typename HashMap>
 	class const_hash_map_iterator
@@ -44,14 +768,14 @@ namespace util {
 		using iterator_category = std::bidirectional_iterator_tag;
 		using pointer = value_type*;
 		using reference = value_type&;
-		using list_iterator_type = typename HashMap::ListType::const_iterator;
+		using position_type = typename HashMap::table_type::position;
 
 		// Bidirectional iterators must supply a default constructor.
 		// Using an iterator constructed with the default constructor
 		// is undefined, so it doesn't matter how it's initialized.
 		const_hash_map_iterator() = default;
 
-		const_hash_map_iterator(size_t bucket, list_iterator_type listIt, const HashMap* hashmap);
+		const_hash_map_iterator(position_type position, const HashMap* hashmap);
 
 		// Don't need to define a copy constructor or operator= because the
 		// default behavior is what we want.
@@ -78,8 +802,9 @@ namespace util {
 		bool operator!=(const const_hash_map_iterator<HashMap>& rhs) const;
 
 	protected:
-		size_t mBucketIndex = 0;
-		list_iterator_type mListIterator;
+		// Where the element lives in the storage table. What this is
+		// depends on the storage policy of the hash_map.
+		position_type mPosition{};
 		const HashMap* mHashmap = nullptr;
 
 		// Helper methods for operator++ and operator--
@@ -99,11 +824,11 @@ namespace util {
 		using iterator_category = std::bidirectional_iterator_tag;
 		using pointer = value_type*;
 		using reference = value_type&;
-		using list_iterator_type = typename HashMap::ListType::iterator;
+		using position_type = typename const_hash_map_iterator<HashMap>::position_type;
 
 		hash_map_iterator() = default;
-		hash_map_iterator(size_t bucket, list_iterator_type listIt, HashMap* hashmap);
-		
+		hash_map_iterator(position_type position, HashMap* hashmap);
+
 		value_type& operator*();
 		value_type* operator->();
 
@@ -117,9 +842,51 @@ namespace util {
 
 
 
+	// A node handle: owns one element that has been extracted from a
+	// hash_map, and can be inserted into another hash_map of the same
+	// type whose allocator compares equal. With chaining the element's
+	// memory moves along with it.
+	template <typename HashMap>
+	class hash_map_node
+	{
+		// The hash_map class needs access to the table node
+		friend HashMap;
+
+	public:
+		using key_type = typename HashMap::key_type;
+		using mapped_type = typename HashMap::mapped_type;
+
+		// Constructs an empty node.
+		hash_map_node() = default;
+
+		// Nodes can only be moved; the source is left empty.
+		hash_map_node(hash_map_node<HashMap>&& src) = default;
+		hash_map_node<HashMap>& operator=(hash_map_node<HashMap>&& rhs) = default;
+
+		bool empty() const;
+		explicit operator bool() const;
+
+		// The key can't be changed: with chaining it is stored const.
+		// Behavior is undefined if the node is empty.
+		const key_type& key() const;
+		mapped_type& mapped();
+		const mapped_type& mapped() const;
+
+		void swap(hash_map_node<HashMap>& other) noexcept;
+
+	private:
+		using node_type = typename HashMap::table_type::node;
+
+		explicit hash_map_node(node_type&& node);
+
+		node_type mNode;
+	};
+
 	template <typename Key, typename T,
 		typename KeyEqual = std::equal_to<>,
-		typename Hash = hash<Key>>
+		typename Hash = hash<Key>,
+		typename Policy = chaining,
+		typename Allocator = std::allocator<std::pair<const Key, T>>>
 	class hash_map
 	{
 	public:
@@ -128,39 +895,76 @@ namespace util {
 		using value_type = std::pair<const Key, T>;
 		using hasher = Hash;
 		using key_equal = KeyEqual;
+		using storage_policy = Policy;
+		using allocator_type = Allocator;
 		using reference = value_type&;
 		using const_reference = const value_type&;
 		using size_type = size_t;
 		using difference_type = ptrdiff_t;
-		using hash_map_type = hash_map<Key, T, KeyEqual, Hash>;
+		using hash_map_type = hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>;
 		using iterator = hash_map_iterator<hash_map_type>;
 		using const_iterator = const_hash_map_iterator<hash_map_type>;
 
 	private:
-		using ListType = std::list<value_type>;
+		using table_type = typename Policy::template table<value_type, Allocator>;
+		using position = typename table_type::position;
+		// Yields K if both Hash and KeyEqual are transparent, and fails to
+		// substitute otherwise.
+		template <typename K>
+		using transparent_key = std::enable_if_t<
+			detail::is_transparent<Hash>::value && detail::is_transparent<KeyEqual>::value, K>;
 	public:
-		using local_iterator = typename ListType::iterator;
-		using const_local_iterator = typename ListType::const_iterator;
-
-		// The iterator classes need access to all members of the hash_map
+		using local_iterator = typename table_type::local_iterator;
+		using const_local_iterator = typename table_type::const_local_iterator;
+		using node_type = hash_map_node<hash_map_type>;
+
+		// The result of inserting a node: where the element with the node's
+		// key is, whether the node was inserted, and the node itself if it
+		// wasn't.
+		struct insert_return_type
+		{
+			iterator position;
+			bool inserted;
+			node_type node;
+		};
+
+		// The iterator and node classes need access to all members of the hash_map
 		friend class hash_map_iterator<hash_map_type>;
 		friend class const_hash_map_iterator<hash_map_type>;
+		friend class hash_map_node<hash_map_type>;
 
 		// Virtual destructor
 		virtual ~hash_map() = default;
 
 		// Throws invalid_argument if the number of buckets is illegal.
-		explicit hash_map(const KeyEqual& equal = KeyEqual(), size_type numBuckets = 101, const Hash& hash = Hash());
+		explicit hash_map(const KeyEqual& equal = KeyEqual(), size_type numBuckets = 101, const Hash& hash = Hash(),
+			const Allocator& alloc = Allocator());
+
+		// Uses alloc for all of its memory, with the other defaults.
+		explicit hash_map(const Allocator& alloc);
 
 		// Throws invalid_argument if the number of buckets is illegal.
 		template <typename InputIterator>
 		hash_map(InputIterator first, InputIterator last, const KeyEqual& equal = KeyEqual(),
-			size_type numBuckets = 101, const Hash& hash = Hash());
+			size_type numBuckets = 101, const Hash& hash = Hash(), const Allocator& alloc = Allocator());
+
+		// Builds the map from a random-access range on several threads.
+		// All keys are hashed in parallel and radix-partitioned by hash;
+		// then each thread fills whole partitions of the table, which is
+		// sized for the entire range up front. Of equal keys, the first in
+		// the range is kept, as with the constructor above. Only chaining,
+		// incremental_chaining, group_probing and cached_hash of these fill
+		// partitions in parallel; other policies insert the hashed
+		// elements on one thread. Hash, KeyEqual and the allocator are used
+		// from all threads at once.
+		template <typename RandomAccessIterator>
+		hash_map(parallel_build options, RandomAccessIterator first, RandomAccessIterator last,
+			const KeyEqual& equal = KeyEqual(), const Hash& hash = Hash(), const Allocator& alloc = Allocator());
 
 		// Initializer list constructor
-		// Throws invalid_argument if the number of buckets is illegal. 
+		// Throws invalid_argument if the number of buckets is illegal.
 		explicit hash_map(std::initializer_list<value_type> il, const KeyEqual& equal = KeyEqual(),
-			size_type numBuckets = 101, const Hash& hash = Hash());
+			size_type numBuckets = 101, const Hash& hash = Hash(), const Allocator& alloc = Allocator());
 
 		// Copy constructor
 		hash_map(const hash_map_type& src) = default;
@@ -189,14 +993,57 @@ namespace util {
 
 		// Element insert methods
 		T& operator[](const key_type& k);
+		T& operator[](key_type&& k);
+		template <typename K, typename = transparent_key<K>>
+		T& operator[](K&& k);
 		std::pair<iterator, bool> insert(const value_type& x);
+		std::pair<iterator, bool> insert(value_type&& x);
 		iterator insert(const_iterator hint, const value_type& x);
+		iterator insert(const_iterator hint, value_type&& x);
 		template <typename InputIterator>
 		void insert(InputIterator first, InputIterator last);
 		void insert(std::initializer_list<value_type> il);
+		// Inserting an empty node does nothing.
+		insert_return_type insert(node_type&& node);
+		iterator insert(const_iterator hint, node_type&& node);
+
+		// Constructs an element from args in place. The element is built
+		// before its key is known, and dropped again if the key exists.
+		template <typename... Args>
+		std::pair<iterator, bool> emplace(Args&&... args);
+		template <typename... Args>
+		iterator emplace_hint(const_iterator hint, Args&&... args);
+
+		// Constructs the mapped value from args, but only if k is not in
+		// the map yet. Otherwise args are left untouched.
+		template <typename... Args>
+		std::pair<iterator, bool> try_emplace(const key_type& k, Args&&... args);
+		template <typename... Args>
+		std::pair<iterator, bool> try_emplace(key_type&& k, Args&&... args);
+		template <typename... Args>
+		iterator try_emplace(const_iterator hint, const key_type& k, Args&&... args);
+		template <typename... Args>
+		iterator try_emplace(const_iterator hint, key_type&& k, Args&&... args);
+
+		// Inserts obj under k, or assigns it if k is already there.
+		template <typename M>
+		std::pair<iterator, bool> insert_or_assign(const key_type& k, M&& obj);
+		template <typename M>
+		std::pair<iterator, bool> insert_or_assign(key_type&& k, M&& obj);
+		template <typename M>
+		iterator insert_or_assign(const_iterator hint, const key_type& k, M&& obj);
+		template <typename M>
+		iterator insert_or_assign(const_iterator hint, key_type&& k, M&& obj);
 
 		// Element delete methods
+		// Takes an element out of the map without destroying it. extract()
+		// of a missing key returns an empty node.
+		node_type extract(const_iterator position);
+		node_type extract(const key_type& k);
 		size_type erase(const key_type& k);
+		template <typename K, typename = transparent_key<K>,
+			typename = std::enable_if_t<!std::is_convertible<const K&, const_iterator>::value>>
+		size_type erase(const K& k);
 		iterator erase(iterator position);
 		iterator erase(iterator first, iterator last);
 
@@ -207,6 +1054,7 @@ namespace util {
 		// Access methods for Standard Library conformity
 		key_equal key_eq() const;
 		hasher hash_function() const;
+		allocator_type get_allocator() const;
 
 		// Lookup methods
 		iterator find(const key_type& k);
@@ -216,6 +1064,39 @@ namespace util {
 
 		size_type count(const key_type& k) const;
 
+		// Heterogeneous lookup. These overloads take part only when both
+		// Hash and KeyEqual define is_transparent; k must then hash and
+		// compare equal exactly like the key it stands for.
+		template <typename K, typename = transparent_key<K>>
+		iterator find(const K& k);
+		template <typename K, typename = transparent_key<K>>
+		const_iterator find(const K& k) const;
+		template <typename K, typename = transparent_key<K>>
+		std::pair<iterator, iterator> equal_range(const K& k);
+		template <typename K, typename = transparent_key<K>>
+		std::pair<const_iterator, const_iterator> equal_range(const K& k) const;
+		template <typename K, typename = transparent_key<K>>
+		size_type count(const K& k) const;
+
+		// Batched lookup: writes find(k), or whether k is present, to out
+		// for every key k in [first, last), in order, and returns the end
+		// of the output. Keys are hashed and their buckets prefetched
+		// kBatchSize at a time before any of them is compared, so the
+		// cache misses of neighbouring lookups overlap instead of
+		// following one another. This pays off once the table no longer
+		// fits in cache. KeyIterator is a forward iterator over key_type,
+		// or over anything Hash and KeyEqual accept if they are
+		// transparent.
+		static constexpr size_type kBatchSize = 16;
+		template <typename KeyIterator, typename OutputIterator>
+		OutputIterator find_batch(KeyIterator first, KeyIterator last, OutputIterator out);
+		template <typename KeyIterator, typename OutputIterator>
+		OutputIterator find_batch(KeyIterator first, KeyIterator last, OutputIterator out) const;
+		template <typename KeyIterator, typename OutputIterator>
+		OutputIterator contains_batch(KeyIterator first, KeyIterator last, OutputIterator out) const;
+
+		// Bucket interface. With open addressing every slot is a bucket
+		// holding at most one element.
 		size_type bucket_count() const;
 		size_type max_bucket_count() const;
 		size_type bucket(const Key& k) const;
@@ -227,241 +1108,4017 @@ namespace util {
 		const_local_iterator end(size_type n) const;
 		const_local_iterator cend(size_type n) const;
 
-	private:
-		// Returns a pair containing an iterator to the found element with
-		// a given key, and the index of that element's bucket.
-		std::pair<typename ListType::iterator, size_t> findElement(const key_type& k);
+		// Hash policy methods. The table grows automatically on insertion
+		// once the load factor would exceed max_load_factor().
+		float load_factor() const;
+		float max_load_factor() const;
+		// Throws invalid_argument if ml is not positive. The new maximum
+		// takes effect at the next rehash.
+		void max_load_factor(float ml);
+		// Sets the number of buckets to at least n, and to at least what
+		// size() elements need under max_load_factor().
+		void rehash(size_type n);
+		// Makes room for n elements without further rehashing.
+		void reserve(size_type n);
+
+		// Probe-length statistics of the current contents. This walks the
+		// whole table and rehashes every key, so it is meant for tuning and
+		// tests, not for hot paths.
+		util::probe_stats probe_stats() const;
+
+		// The number of elements in each bucket, in the sense of the bucket
+		// interface. Like probe_stats(), this walks the whole table.
+		util::bucket_stats bucket_stats() const;
 
-		std::vector<ListType> mBuckets;
-		size_type mSize = 0;
+	private:
+		// Returns a pair containing the table position of the element with
+		// a given key (the table's end position if there is none), and the
+		// hash of that key. K is key_type or, for transparent lookup, any
+		// type Hash and KeyEqual accept.
+		template <typename K>
+		std::pair<position, size_t> findElement(const K& k) const;
+
+		// The work of the batched lookups: calls found(position) for every
+		// key in [first, last), in order.
+		template <typename KeyIterator, typename Callback>
+		void findBatch(KeyIterator first, KeyIterator last, const Callback& found) const;
+
+		// Erases the element with key k, if any, and returns the number of
+		// elements erased.
+		template <typename K>
+		size_type eraseKey(const K& k);
+
+		// The work of try_emplace(): the key is only converted to key_type
+		// (from whatever K is) when a new element is constructed.
+		template <typename K, typename... Args>
+		std::pair<iterator, bool> tryEmplaceKey(K&& k, Args&&... args);
+
+		// The work of insert_or_assign().
+		template <typename K, typename M>
+		std::pair<iterator, bool> insertOrAssignKey(K&& k, M&& obj);
+
+		// Returns a function object computing the hash of a stored element,
+		// which the table needs when it moves elements around.
+		auto elementHasher() const;
+
+		// The work of the parallel constructor, on an empty map.
+		template <typename RandomAccessIterator>
+		void buildParallel(RandomAccessIterator first, RandomAccessIterator last, size_t threads);
+
+		table_type mTable;
 		KeyEqual mEqual;
 		Hash mHash;
 	};
 
 
-	// Calculate a hash by treating the key as a sequence
-	// of bytes and summing the ASCII values of the bytes.
-	template <typename T>
-	size_t hash<T>::operator()(const T& key) const
+	inline uint64_t hash_bytes(const void* data, size_t len, uint64_t seed)
 	{
-		size_t bytes = sizeof(key);
-		size_t sum = 0;
-		for (size_t i = 0; i < bytes; ++i) {
-			unsigned char b = *(reinterpret_cast<const unsigned char*>(&key) + i);
-			sum += b;
+		using namespace detail;
+
+		const unsigned char* p = static_cast<const unsigned char*>(data);
+		const size_t totalLength = len;
+		uint64_t a = 0;
+		uint64_t b = 0;
+		seed ^= fold_multiply(seed ^ kHashSecret[0], kHashSecret[1]);
+
+		if (len <= 16) {
+			// Short keys are read with (possibly overlapping) loads that
+			// together cover every byte.
+			if (len >= 4) {
+				a = (read32(p) << 32) | read32(p + ((len >> 3) << 2));
+				b = (read32(p + len - 4) << 32) | read32(p + len - 4 - ((len >> 3) << 2));
+			} else if (len > 0) {
+				a = (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[len >> 1]) << 8) | p[len - 1];
+			}
+		} else {
+			if (len > 48) {
+				// Bulk input runs through three independent lanes of 16
+				// bytes each, which keeps several multipliers busy.
+				uint64_t see1 = seed;
+				uint64_t see2 = seed;
+				do {
+					seed = fold_multiply(read64(p) ^ kHashSecret[1], read64(p + 8) ^ seed);
+					see1 = fold_multiply(read64(p + 16) ^ kHashSecret[2], read64(p + 24) ^ see1);
+					see2 = fold_multiply(read64(p + 32) ^ kHashSecret[3], read64(p + 40) ^ see2);
+					p += 48;
+					len -= 48;
+				} while (len > 48);
+				seed ^= see1 ^ see2;
+			}
+			while (len > 16) {
+				seed = fold_multiply(read64(p) ^ kHashSecret[1], read64(p + 8) ^ seed);
+				p += 16;
+				len -= 16;
+			}
+			// The last 16 bytes of the input, overlapping what was already
+			// consumed if need be.
+			a = read64(p + len - 16);
+			b = read64(p + len - 8);
 		}
-		return sum;
+
+		a ^= kHashSecret[1];
+		b ^= seed;
+		multiply128(a, b);
+		return fold_multiply(a ^ kHashSecret[0] ^ totalLength, b ^ kHashSecret[1]);
+	}
+
+	constexpr uint64_t hash_integer(uint64_t x, uint64_t seed)
+	{
+		x += seed + 0x9e3779b97f4a7c15ULL;
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+		return x ^ (x >> 31);
 	}
 
 
 
 
-	// Calculate a hash by summing the ASCII values of all characters.
-	size_t hash<std::string>::operator()(const std::string& key) const
+	template <typename T>
+	hash<T>::hash(size_t seed)
+		: mSeed(seed)
+	{
+	}
+
+	template <typename T>
+	size_t hash<T>::operator()(const T& key) const
 	{
-		size_t sum = 0;
-		for (auto c : key) {
-			sum += static_cast<unsigned char>(c);
+		if constexpr (std::is_integral<T>::value || std::is_enum<T>::value) {
+			return static_cast<size_t>(hash_integer(static_cast<uint64_t>(key), mSeed));
+		} else if constexpr (std::is_pointer<T>::value) {
+			return static_cast<size_t>(hash_integer(reinterpret_cast<uintptr_t>(key), mSeed));
+		} else if constexpr (std::is_floating_point<T>::value && sizeof(T) <= sizeof(uint64_t)) {
+			// Equal values must hash alike, and -0.0 == 0.0.
+			T value = (key == 0) ? T(0) : key;
+			uint64_t bits = 0;
+			std::memcpy(&bits, &value, sizeof(value));
+			return static_cast<size_t>(hash_integer(bits, mSeed));
+		} else {
+			// Treat the key as a sequence of bytes.
+			return static_cast<size_t>(hash_bytes(&key, sizeof(key), mSeed));
 		}
-		return sum;
 	}
 
 
 
 
-	template<typename HashMap>
-	const_hash_map_iterator<HashMap>::const_hash_map_iterator(size_t bucket, list_iterator_type listIt, const HashMap* hashmap)
-		: mBucketIndex(bucket), mListIterator(listIt), mHashmap(hashmap)
+	inline hash<std::string>::hash(size_t seed)
+		: mSeed(seed)
 	{
 	}
 
-	// Return a reference to the actual element.
-	template<typename HashMap>
-	const typename const_hash_map_iterator<HashMap>::value_type&
-		const_hash_map_iterator<HashMap>::operator*() const
+	// Calculate a hash of all characters.
+	inline size_t hash<std::string>::operator()(std::string_view key) const
 	{
-		return *mListIterator;
+		return static_cast<size_t>(hash_bytes(key.data(), key.size(), mSeed));
 	}
 
-	// Return a pointer to the actual element, so the compiler can
-	// apply -> to it to access the actual desired field.
-	template<typename HashMap>
-	const typename const_hash_map_iterator<HashMap>::value_type*
-		const_hash_map_iterator<HashMap>::operator->() const
+	inline hash<std::string_view>::hash(size_t seed)
+		: mSeed(seed)
 	{
-		return &(*mListIterator);
 	}
 
-	// Defer the details to the increment() helper.
-	template<typename HashMap>
-	const_hash_map_iterator<HashMap>& const_hash_map_iterator<HashMap>::operator++()
+	inline size_t hash<std::string_view>::operator()(std::string_view key) const
 	{
-		increment();
-		return *this;
+		return static_cast<size_t>(hash_bytes(key.data(), key.size(), mSeed));
 	}
 
-	// Defer the details to the increment() helper.
-	template<typename HashMap>
-	const_hash_map_iterator<HashMap> const_hash_map_iterator<HashMap>::operator++(int)
+
+
+
+	template <typename Hash>
+	counting_hash<Hash>::counting_hash(const Hash& hash)
+		: mHash(hash)
 	{
-		auto oldIt = *this;
-		increment();
-		return oldIt;
 	}
 
-	// Defer the details to the decrement() helper.
-	template<typename HashMap>
-	const_hash_map_iterator<HashMap>& const_hash_map_iterator<HashMap>::operator--()
+	template <typename Hash>
+	template <typename K>
+	size_t counting_hash<Hash>::operator()(const K& key) const
 	{
-		decrement();
-		return *this;
+		mCalls->fetch_add(1, std::memory_order_relaxed);
+		return mHash(key);
 	}
 
-	// Defer the details to the decrement() helper.
-	template<typename HashMap>
-	const_hash_map_iterator<HashMap> const_hash_map_iterator<HashMap>::operator--(int)
+	template <typename Hash>
+	size_t counting_hash<Hash>::calls() const
 	{
-		auto oldIt = *this;
-		decrement();
-		return oldIt;
+		return mCalls->load(std::memory_order_relaxed);
 	}
 
-	template<typename HashMap>
-	bool const_hash_map_iterator<HashMap>::operator==(const const_hash_map_iterator<HashMap>& rhs) const
+	template <typename Hash>
+	void counting_hash<Hash>::reset_calls()
 	{
-		// All fields, including the hash_map to which the iterators refer,
-		// must be equal.
-		return (mHashmap == rhs.mHashmap &&
-			mBucketIndex == rhs.mBucketIndex &&
-			mListIterator == rhs.mListIterator);
+		mCalls->store(0, std::memory_order_relaxed);
 	}
 
-	template<typename HashMap>
-	bool const_hash_map_iterator<HashMap>::operator!=(const const_hash_map_iterator<HashMap>& rhs) const
+	template <typename KeyEqual>
+	counting_equal<KeyEqual>::counting_equal(const KeyEqual& equal)
+		: mEqual(equal)
 	{
-		return !(*this == rhs);
 	}
 
-	// Behavior is undefined if mListIterator already refers to the past-the-end
-	// element, or is otherwise invalid.
-	template<typename HashMap>
-	void const_hash_map_iterator<HashMap>::increment()
+	template <typename KeyEqual>
+	template <typename K1, typename K2>
+	bool counting_equal<KeyEqual>::operator()(const K1& lhs, const K2& rhs) const
 	{
-		// mListIterator is an iterator into a single bucket. Increment it.
-		++mListIterator;
+		mCalls->fetch_add(1, std::memory_order_relaxed);
+		return mEqual(lhs, rhs);
+	}
 
-		// If we're at the end of the current bucket,
-		// find the next bucket with elements.
-		auto& buckets = mHashmap->mBuckets;
-		if (mListIterator == end(buckets[mBucketIndex])) {
-			for (size_t i = mBucketIndex + 1; i < buckets.size(); i++) {
-				if (!buckets[i].empty()) {
-					// We found a non-empty bucket.
-					// Make mListIterator refer to the first element in it.
-					mListIterator = begin(buckets[i]);
-					mBucketIndex = i;
-					return;
-				}
-			}
-			// No more non-empty buckets. Set mListIterator to refer to the
-			// end iterator of the last list.
-			mBucketIndex = buckets.size() - 1;
-			mListIterator = end(buckets[mBucketIndex]);
-		}
+	template <typename KeyEqual>
+	size_t counting_equal<KeyEqual>::calls() const
+	{
+		return mCalls->load(std::memory_order_relaxed);
 	}
 
-	// Behavior is undefined if mListIterator already refers to the first
-	// element, or is otherwise invalid.
-	template<typename HashMap>
-	void const_hash_map_iterator<HashMap>::decrement()
+	template <typename KeyEqual>
+	void counting_equal<KeyEqual>::reset_calls()
 	{
-		// mListIterator is an iterator into a single bucket.
-		// If it's at the beginning of the current bucket, don't decrement it.
-		// Instead, try to find a non-empty bucket before the current one.
-		auto& buckets = mHashmap->mBuckets;
-		if (mListIterator == begin(buckets[mBucketIndex])) {
-			for (int i = mBucketIndex - 1; i >= 0; --i) {
-				if (!buckets[i].empty()) {
-					mListIterator = --end(buckets[i]);
-					mBucketIndex = i;
-					return;
-				}
+		mCalls->store(0, std::memory_order_relaxed);
+	}
+
+
+
+
+
+	// The chaining table: a vector of buckets, each a std::list.
+	//
+	// With Incremental set, growing the table doesn't move every element at
+	// once. The old bucket array is kept next to the new one, and every
+	// insertion (and erasure by key) moves at most kMigrationStep old
+	// buckets over. Lookups consult both arrays until the old one is
+	// drained. Only the allocation of the new, empty bucket array happens
+	// in one go.
+	//
+	// While both arrays exist, bucket numbers run through the old array
+	// first and then through the new one, so bucket n still names the list
+	// that actually holds an element.
+	//
+	// Each array has a bitmap with one bit per non-empty bucket, and the
+	// table remembers its first non-empty bucket. begin() is O(1), and
+	// iteration skips 64 empty buckets per word of bitmap instead of
+	// visiting every list.
+	template <typename Value, typename Allocator, bool Incremental>
+	class chaining::table
+	{
+	public:
+		using ListType = std::list<Value, Allocator>;
+		using local_iterator = typename ListType::iterator;
+		using const_local_iterator = typename ListType::const_iterator;
+
+		// The number of old buckets moved per incremental step.
+		static constexpr size_t kMigrationStep = 8;
+
+		// An element is identified by its bucket and its place in that
+		// bucket's list.
+		struct position
+		{
+			size_t mBucketIndex = 0;
+			const_local_iterator mListIterator;
+
+			bool operator==(const position& rhs) const
+			{
+				return mBucketIndex == rhs.mBucketIndex && mListIterator == rhs.mListIterator;
+			}
+			bool operator!=(const position& rhs) const
+			{
+				return !(*this == rhs);
+			}
+		};
+
+		// Holds one element that belongs to no table.
+		class node;
+
+		// Every list node and the bucket array itself are allocated
+		// through (a copy of) alloc.
+		table(size_t numBuckets, const Allocator& alloc);
+
+		Allocator get_allocator() const;
+
+		// Traversal in bucket order
+		position first() const;
+		position end() const;
+		void next(position& pos) const;
+		void prev(position& pos) const;
+		Value& element(const position& pos) const;
+
+		// Returns the position of the element with the given hash for which
+		// equal(element) is true, or end() if there is none.
+		template <typename Pred>
+		position find(size_t hash, const Pred& equal) const;
+
+		// Start loading what find(hash, ...) will read: prefetch() the
+		// bucket, and, once that has arrived, prefetch_element() the first
+		// element in it. Neither waits for memory.
+		void prefetch(size_t hash) const;
+		void prefetch_element(size_t hash) const;
+
+		// Constructs a new element from args. The caller guarantees that no
+		// equal element exists.
+		template <typename HashFn, typename... Args>
+		position emplace(size_t hash, const HashFn& hashOf, Args&&... args);
+
+		// Moves the element out of a non-empty node into the table, under
+		// the same guarantee as emplace(). The list node is relinked, not
+		// reallocated.
+		template <typename HashFn>
+		position insert(size_t hash, const HashFn& hashOf, node& n);
+
+		// Like emplace() and insert(), but elements for which equal(element)
+		// is true may exist already. The new element goes right after
+		// them, so equal elements stay next to each other in traversal
+		// order, rehashing included. The multi containers rely on this.
+		template <typename Pred, typename HashFn, typename... Args>
+		position emplace_equal(size_t hash, const Pred& equal, const HashFn& hashOf, Args&&... args);
+		template <typename Pred, typename HashFn>
+		position insert_equal(size_t hash, const Pred& equal, const HashFn& hashOf, node& n);
+
+		// Unlinks the element at pos from the table into a node.
+		node extract(const position& pos);
+
+		// Returns the position of the element that followed the erased
+		// one.
+		position erase(const position& pos);
+		void clear() noexcept;
+		void swap(table& other) noexcept;
+
+		size_t size() const;
+		size_t max_size() const;
+		size_t bucket_count() const;
+		size_t max_bucket_count() const;
+		template <typename Pred>
+		size_t bucket(size_t hash, const Pred& equal) const;
+		size_t bucket_size(size_t n) const;
+		local_iterator begin(size_t n);
+		const_local_iterator begin(size_t n) const;
+		local_iterator end(size_t n);
+		const_local_iterator end(size_t n) const;
+
+		float max_load_factor() const;
+		void max_load_factor(float ml);
+
+		// Redistributes the elements over at least n buckets (a prime
+		// number of them), without copying or moving any element. This
+		// always completes immediately, even for an incremental table.
+		template <typename HashFn>
+		void rehash(size_t n, const HashFn& hashOf);
+
+		// Does one bounded step of pending incremental rehashing, if any.
+		// Invalidates positions, but not references to elements.
+		template <typename HashFn>
+		void rehash_step(const HashFn& hashOf);
+
+		// An element's displacement is its place in its bucket's list.
+		template <typename HashFn>
+		util::probe_stats probe_stats(const HashFn& hashOf) const;
+
+		// Filling the table from several threads at once, for hash_map's
+		// parallel constructor. begin_partitions() splits an empty table,
+		// already large enough for everything to come and not migrating,
+		// into at most parts partitions of whole bitmap words, and returns
+		// how many there are. emplace_in_partition() calls for elements of
+		// different partitions, as told by partition_of(), may then run
+		// concurrently. It returns the element for which equal(element) is
+		// true and false, or constructs one from args and returns it and
+		// true. Once all calls have returned, end_partitions() accounts for
+		// the added elements.
+		static constexpr bool kPartitionedBuild = true;
+		size_t begin_partitions(size_t parts);
+		size_t partition_of(size_t hash) const;
+		template <typename Pred, typename... Args>
+		std::pair<position, bool> emplace_in_partition(size_t hash, const Pred& equal, Args&&... args);
+		void end_partitions(size_t added);
+
+	private:
+		// Bucket n in the numbering described above.
+		ListType& bucketAt(size_t n);
+		const ListType& bucketAt(size_t n) const;
+		size_t totalBuckets() const;
+
+		// The first non-empty bucket at or after n, or totalBuckets().
+		size_t nextOccupied(size_t n) const;
+		// The last non-empty bucket before n, or size_t(-1).
+		size_t prevOccupied(size_t n) const;
+
+		// Keep the bitmaps and mFirst up to date after bucket n gained an
+		// element, or lost one.
+		void occupied(size_t n);
+		void vacated(size_t n);
+
+		// Appends to targets the bucket of each element of from, in order,
+		// in an array of bucketCount buckets.
+		template <typename HashFn>
+		void targetsOf(const ListType& from, size_t bucketCount, const HashFn& hashOf,
+			std::vector<size_t>& targets) const;
+
+		// Moves the elements of from into the buckets of mBuckets that
+		// targets gives for them, in order, and returns the targets past
+		// the last one used.
+		const size_t* spliceInto(ListType& from, const size_t* targets) noexcept;
+
+		template <typename HashFn>
+		void finishMigration(const HashFn& hashOf);
+
+		// Does the rehashing due before one more element is added.
+		template <typename HashFn>
+		void makeRoom(const HashFn& hashOf);
+
+		// Where emplace_equal() puts a new element: the bucket number and
+		// the list iterator to insert before.
+		template <typename Pred>
+		position insertionPoint(size_t hash, const Pred& equal) const;
+
+		using BucketArray = std::vector<ListType,
+			typename std::allocator_traits<Allocator>::template rebind_alloc<ListType>>;
+
+		using BitArray = std::vector<uint64_t,
+			typename std::allocator_traits<Allocator>::template rebind_alloc<uint64_t>>;
+
+		// Returns an array of n empty buckets using mAllocator.
+		BucketArray makeBuckets(size_t n) const;
+		// Returns an all-clear bitmap for n buckets.
+		BitArray makeBits(size_t n) const;
+
+		Allocator mAllocator;
+		BucketArray mBuckets;
+		BitArray mOccupied;
+		size_t mSize = 0;
+		float mMaxLoadFactor = 1.0f;
+
+		// The first non-empty bucket. Only meaningful while mSize != 0.
+		size_t mFirst = 0;
+
+		// Buckets per partition, during a partitioned build.
+		size_t mPartitionSize = 0;
+
+		// Buckets still waiting to be moved over, and how many of them
+		// (from the front) have been drained already.
+		BucketArray mOldBuckets;
+		BitArray mOldOccupied;
+		size_t mMigrated = 0;
+	};
+
+	// A chaining node is a list of at most one element, so that the
+	// element can be spliced in and out of buckets.
+	template <typename Value, typename Allocator, bool Incremental>
+	class chaining::table<Value, Allocator, Incremental>::node
+	{
+	public:
+		node() = default;
+
+		// The element can only be spliced into tables whose allocator
+		// compares equal to alloc.
+		template <typename... Args>
+		node(const Allocator& alloc, std::in_place_t, Args&&... args)
+			: mList(alloc)
+		{
+			mList.emplace_back(std::forward<Args>(args)...);
+		}
+
+		// Moving leaves the source empty.
+		node(node&& src) noexcept
+			: mList(std::move(src.mList))
+		{
+			src.mList.clear();
+		}
+
+		node& operator=(node&& rhs)
+		{
+			if (this != &rhs) {
+				mList = std::move(rhs.mList);
+				rhs.mList.clear();
+			}
+			return *this;
+		}
+
+		bool empty() const { return mList.empty(); }
+		Value& value() { return mList.front(); }
+		const Value& value() const { return mList.front(); }
+
+	private:
+		friend class table;
+
+		explicit node(const Allocator& alloc)
+			: mList(alloc)
+		{
+		}
+
+		ListType mList;
+	};
+
+
+	// The group probing table. Capacity is a power of two (or zero), and
+	// the control array carries ctrl_group::kWidth extra bytes mirroring the
+	// first group, so a group can be loaded at any slot without wrapping.
+	template <typename Value, typename Allocator>
+	class group_probing::table
+	{
+	public:
+		using local_iterator = Value*;
+		using const_local_iterator = const Value*;
+
+		// An element is identified by its slot index; capacity() is the end.
+		using position = size_t;
+
+		// Holds one element that belongs to no table.
+		class node;
+
+		// The control bytes and slots are allocated through (rebound
+		// copies of) alloc.
+		table(size_t numBuckets, const Allocator& alloc);
+		table(const table& src);
+		table(table&& src) noexcept;
+		~table();
+
+		// Copying and moving into an existing table are done by hash_map
+		// using copy-and-swap.
+		table& operator=(const table& rhs) = delete;
+		table& operator=(table&& rhs) = delete;
+
+		Allocator get_allocator() const;
+
+		// Traversal in slot order
+		position first() const;
+		position end() const;
+		void next(position& pos) const;
+		void prev(position& pos) const;
+		Value& element(position pos) const;
+
+		template <typename Pred>
+		position find(size_t hash, const Pred& equal) const;
+
+		// Start loading what find(hash, ...) will read: prefetch() the
+		// first control group, and, once that has arrived,
+		// prefetch_element() the first slot whose H2 matches.
+		void prefetch(size_t hash) const;
+		void prefetch_element(size_t hash) const;
+
+		template <typename HashFn, typename... Args>
+		position emplace(size_t hash, const HashFn& hashOf, Args&&... args);
+
+		// Moves the element out of a non-empty node into the table; the
+		// node is left empty. Elements live inline in the slots, so this
+		// is a move of the element itself.
+		template <typename HashFn>
+		position insert(size_t hash, const HashFn& hashOf, node& n);
+
+		// Moves the element at pos out of the table into a node.
+		node extract(position pos);
+
+		// Returns the position of the element that followed the erased
+		// one.
+		position erase(position pos);
+		void clear() noexcept;
+		void swap(table& other) noexcept;
+
+		size_t size() const;
+		size_t max_size() const;
+		size_t bucket_count() const;
+		size_t max_bucket_count() const;
+		template <typename Pred>
+		size_t bucket(size_t hash, const Pred& equal) const;
+		size_t bucket_size(size_t n) const;
+		local_iterator begin(size_t n);
+		const_local_iterator begin(size_t n) const;
+		local_iterator end(size_t n);
+		const_local_iterator end(size_t n) const;
+
+		// The maximum load factor can be lowered, but never raised above
+		// 7/8: probing relies on the table never filling up.
+		float max_load_factor() const;
+		void max_load_factor(float ml);
+
+		// Moves the elements into a table of at least n slots (a power of
+		// two), dropping all deleted markers on the way.
+		template <typename HashFn>
+		void rehash(size_t n, const HashFn& hashOf);
+
+		// Group probing always rehashes in one go; there is nothing to do.
+		template <typename HashFn>
+		void rehash_step(const HashFn& /*hashOf*/) {}
+
+		// An element's displacement is the number of groups its probe
+		// sequence passes before reaching it.
+		template <typename HashFn>
+		util::probe_stats probe_stats(const HashFn& hashOf) const;
+
+		// Filling the table from several threads at once, as for chaining.
+		// A partition is a run of slots, and an element belongs to the one
+		// its probe sequence starts in. emplace_in_partition() returns
+		// end() and false for an element whose probe sequence leaves its
+		// partition before it is resolved; the caller inserts those the
+		// usual way after end_partitions().
+		static constexpr bool kPartitionedBuild = true;
+		size_t begin_partitions(size_t parts);
+		size_t partition_of(size_t hash) const;
+		template <typename Pred, typename... Args>
+		std::pair<position, bool> emplace_in_partition(size_t hash, const Pred& equal, Args&&... args);
+		void end_partitions(size_t added);
+
+	private:
+		using ctrl_t = detail::ctrl_t;
+		using group = detail::ctrl_group;
+		using mutable_type = typename detail::mutable_value<Value>::type;
+
+		// Storage for one element. It is constructed through mutable_value
+		// and read through value, which have the same layout.
+		union slot_type
+		{
+			slot_type() {}
+			~slot_type() {}
+			Value value;
+			mutable_type mutable_value;
+		};
+
+		// The user's hash is mixed before use: the low 7 bits (H2) go into
+		// the control byte and the rest (H1) picks the first group.
+		static size_t mix(size_t hash);
+		static ctrl_t h2(size_t mixed);
+		static size_t h1(size_t mixed);
+
+		// Returns the shared control bytes of a table with no slots.
+		static ctrl_t* emptyGroup();
+
+		size_t mask() const;
+		void setCtrl(size_t i, ctrl_t c);
+
+		// Returns the first slot at or after i that is full, or mCapacity.
+		size_t nextFull(size_t i) const;
+
+		// Returns the first empty or deleted slot in the probe sequence.
+		size_t findFirstNonFull(size_t mixed) const;
+
+		// Allocates zeroed-out storage for newCapacity slots.
+		void allocate(size_t newCapacity);
+		void deallocate() noexcept;
+		void destroyAll() noexcept;
+
+		// The number of elements a table of the given capacity may hold.
+		size_t growthLimit(size_t capacity) const;
+		void resetGrowthLeft();
+
+		// Returns the smallest allowed capacity that is at least n.
+		static size_t normalizeCapacity(size_t n);
+
+		template <typename HashFn>
+		void resize(size_t newCapacity, const HashFn& hashOf);
+
+		using CtrlAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<ctrl_t>;
+		using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<slot_type>;
+
+		Allocator mAllocator;
+		ctrl_t* mCtrl = emptyGroup();
+		slot_type* mSlots = nullptr;
+		size_t mCapacity = 0;
+		size_t mSize = 0;
+
+		// The number of elements that can be added before the table has
+		// to grow. Deleted slots count against it until the next rehash.
+		size_t mGrowthLeft = 0;
+
+		// The first full slot, so that begin() doesn't scan. Only
+		// meaningful while mSize != 0.
+		size_t mFirstFull = 0;
+
+		float mMaxLoadFactor = 0.875f;
+
+		// Slots per partition, during a partitioned build.
+		size_t mPartitionSize = 0;
+	};
+
+	// A group probing node keeps its element in a slot of its own.
+	template <typename Value, typename Allocator>
+	class group_probing::table<Value, Allocator>::node
+	{
+	public:
+		node() = default;
+
+		// The element lives in the node itself, so alloc isn't needed; it
+		// is accepted for symmetry with the chaining node.
+		template <typename... Args>
+		node(const Allocator& /*alloc*/, std::in_place_t, Args&&... args)
+		{
+			new (&mSlot.mutable_value) mutable_type(std::forward<Args>(args)...);
+			mFull = true;
+		}
+
+		// Moving leaves the source empty.
+		node(node&& src) noexcept(std::is_nothrow_move_constructible<mutable_type>::value)
+		{
+			take(src);
+		}
+
+		node& operator=(node&& rhs) noexcept(std::is_nothrow_move_constructible<mutable_type>::value)
+		{
+			if (this != &rhs) {
+				reset();
+				take(rhs);
+			}
+			return *this;
+		}
+
+		~node() { reset(); }
+
+		bool empty() const { return !mFull; }
+		Value& value() { return mSlot.value; }
+		const Value& value() const { return mSlot.value; }
+
+	private:
+		friend class table;
+		// The other open-addressing tables keep their elements inline too,
+		// and share this node type.
+		template <typename, typename>
+		friend class robin_hood::table;
+		template <typename, typename>
+		friend class cuckoo::table;
+
+		void take(node& src)
+		{
+			if (src.mFull) {
+				new (&mSlot.mutable_value) mutable_type(std::move(src.mSlot.mutable_value));
+				mFull = true;
+				src.reset();
+			}
+		}
+
+		void reset() noexcept
+		{
+			if (mFull) {
+				mSlot.mutable_value.~mutable_type();
+				mFull = false;
+			}
+		}
+
+		slot_type mSlot;
+		bool mFull = false;
+	};
+
+	// The Robin Hood table. Capacity is a power of two (or zero); home
+	// slots are in [0, capacity), and kMaxDisplacement more slots follow
+	// them, so a probe sequence never wraps around. The control byte of a
+	// slot holds its element's displacement from its home slot, or kEmpty,
+	// and the control array ends in a group of kEmpty bytes that stops
+	// every probe.
+	template <typename Value, typename Allocator>
+	class robin_hood::table
+	{
+	public:
+		using local_iterator = Value*;
+		using const_local_iterator = const Value*;
+
+		// An element is identified by its slot index; bucket_count() is the
+		// end.
+		using position = size_t;
+
+		// Elements live inline, as in group_probing, and share its node.
+		using node = typename group_probing::table<Value, Allocator>::node;
+
+		// The longest distance of an element from its home slot. An
+		// insertion that would go further grows the table.
+		static constexpr size_t kMaxDisplacement = 64;
+
+		// The control bytes and slots are allocated through (rebound
+		// copies of) alloc. There are at least numBuckets slots.
+		table(size_t numBuckets, const Allocator& alloc);
+		table(const table& src);
+		table(table&& src) noexcept;
+		~table();
+
+		// Copying and moving into an existing table are done by hash_map
+		// using copy-and-swap.
+		table& operator=(const table& rhs) = delete;
+		table& operator=(table&& rhs) = delete;
+
+		Allocator get_allocator() const;
+
+		// Traversal in slot order
+		position first() const;
+		position end() const;
+		void next(position& pos) const;
+		void prev(position& pos) const;
+		Value& element(position pos) const;
+
+		// Probes from the home slot, and stops at the first slot whose
+		// element is closer to its own home than the key would be.
+		template <typename Pred>
+		position find(size_t hash, const Pred& equal) const;
+
+		void prefetch(size_t hash) const;
+		void prefetch_element(size_t hash) const;
+
+		// Throws overflow_error if so many elements share a home slot that
+		// even a nearly empty table can't keep them within
+		// kMaxDisplacement; only a broken hash function does that.
+		template <typename HashFn, typename... Args>
+		position emplace(size_t hash, const HashFn& hashOf, Args&&... args);
+
+		template <typename HashFn>
+		position insert(size_t hash, const HashFn& hashOf, node& n);
+
+		node extract(position pos);
+
+		// Shifts the elements after pos back by one slot, up to an empty
+		// slot or an element in its home slot. Returns the position of the
+		// element that followed the erased one, which may now be at pos.
+		position erase(position pos);
+		void clear() noexcept;
+		void swap(table& other) noexcept;
+
+		size_t size() const;
+		size_t max_size() const;
+		size_t bucket_count() const;
+		size_t max_bucket_count() const;
+		template <typename Pred>
+		size_t bucket(size_t hash, const Pred& equal) const;
+		size_t bucket_size(size_t n) const;
+		local_iterator begin(size_t n);
+		const_local_iterator begin(size_t n) const;
+		local_iterator end(size_t n);
+		const_local_iterator end(size_t n) const;
+
+		// The maximum load factor, relative to the home slots, can't be
+		// raised above 0.95. Above about 0.9, large tables reach the
+		// displacement limit and grow early; probe_stats() counts those
+		// forced growths.
+		float max_load_factor() const;
+		void max_load_factor(float ml);
+
+		template <typename HashFn>
+		void rehash(size_t n, const HashFn& hashOf);
+
+		// Robin Hood always rehashes in one go; there is nothing to do.
+		template <typename HashFn>
+		void rehash_step(const HashFn& /*hashOf*/) {}
+
+		// An element's displacement is its distance from its home slot.
+		template <typename HashFn>
+		util::probe_stats probe_stats(const HashFn& hashOf) const;
+
+	private:
+		// resize lays the new table out in a table of slot numbers.
+		template <typename, typename>
+		friend class table;
+
+		using ctrl_t = detail::ctrl_t;
+		using group = detail::ctrl_group;
+		using mutable_type = typename detail::mutable_value<Value>::type;
+		// Storage for one element, as in group_probing.
+		union slot_type
+		{
+			slot_type() {}
+			~slot_type() {}
+			Value value;
+			mutable_type mutable_value;
+		};
+
+		static size_t mix(size_t hash);
+		size_t mask() const;
+		// Home slots plus the overflow area behind them.
+		size_t slotCount() const;
+
+		// Returns the first slot at or after i that is full, or slotCount().
+		size_t nextFull(size_t i) const;
+
+		// Allocates empty storage for newCapacity home slots.
+		void allocate(size_t newCapacity);
+		void deallocate() noexcept;
+		void destroyAll() noexcept;
+
+		size_t growthLimit(size_t capacity) const;
+
+		// Returns the smallest allowed capacity with at least n slots in
+		// all.
+		static size_t normalizeCapacity(size_t n);
+
+		template <typename HashFn>
+		void resize(size_t newCapacity, const HashFn& hashOf);
+
+		// Moves value into the table, growing it as needed, and returns its
+		// slot.
+		template <typename HashFn>
+		size_t insertValue(size_t mixed, mutable_type& value, const HashFn& hashOf);
+
+		// Moves value into its slot, shifting the richer elements after it
+		// along. Returns slotCount(), and leaves everything as it was, if
+		// that would take some element past kMaxDisplacement.
+		size_t place(size_t mixed, mutable_type& value);
+
+		using CtrlAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<ctrl_t>;
+		using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<slot_type>;
+
+		Allocator mAllocator;
+		ctrl_t* mCtrl = detail::empty_group();
+		slot_type* mSlots = nullptr;
+		size_t mCapacity = 0;
+		size_t mSize = 0;
+
+		// The first full slot. Only meaningful while mSize != 0.
+		size_t mFirstFull = 0;
+
+		float mMaxLoadFactor = 0.875f;
+
+		size_t mKicks = 0;
+		size_t mForcedGrowths = 0;
+	};
+
+	// The cuckoo table. The number of buckets is a power of two (or zero).
+	// An element's home bucket comes from its hash, and its alternate
+	// bucket is the home bucket XORed with an offset derived from the 7-bit
+	// tag kept in its control byte. The same XOR leads back from the
+	// alternate bucket, so elements can be kicked around without hashing
+	// their keys again.
+	template <typename Value, typename Allocator>
+	class cuckoo::table
+	{
+	public:
+		using local_iterator = Value*;
+		using const_local_iterator = const Value*;
+
+		// An element is identified by its slot index; bucket_count() is the
+		// end. Slot i is in bucket i / kSlotsPerBucket.
+		using position = size_t;
+
+		// Elements live inline, as in group_probing, and share its node.
+		using node = typename group_probing::table<Value, Allocator>::node;
+
+		static constexpr size_t kSlotsPerBucket = 4;
+
+		// The control bytes and slots are allocated through (rebound
+		// copies of) alloc. There are at least numBuckets slots.
+		table(size_t numBuckets, const Allocator& alloc);
+		table(const table& src);
+		table(table&& src) noexcept;
+		~table();
+
+		// Copying and moving into an existing table are done by hash_map
+		// using copy-and-swap.
+		table& operator=(const table& rhs) = delete;
+		table& operator=(table&& rhs) = delete;
+
+		Allocator get_allocator() const;
+
+		// Traversal in slot order
+		position first() const;
+		position end() const;
+		void next(position& pos) const;
+		void prev(position& pos) const;
+		Value& element(position pos) const;
+
+		// Checks the tags in the two buckets of hash, and nothing else.
+		template <typename Pred>
+		position find(size_t hash, const Pred& equal) const;
+
+		// Prefetches the control bytes of both buckets, then the first
+		// slot whose tag matches.
+		void prefetch(size_t hash) const;
+		void prefetch_element(size_t hash) const;
+
+		// Throws overflow_error if so many elements share both buckets that
+		// even a nearly empty table can't hold them; only a broken hash
+		// function does that.
+		template <typename HashFn, typename... Args>
+		position emplace(size_t hash, const HashFn& hashOf, Args&&... args);
+
+		template <typename HashFn>
+		position insert(size_t hash, const HashFn& hashOf, node& n);
+
+		node extract(position pos);
+
+		// Returns the position of the element that followed the erased
+		// one.
+		position erase(position pos);
+		void clear() noexcept;
+		void swap(table& other) noexcept;
+
+		size_t size() const;
+		size_t max_size() const;
+		size_t bucket_count() const;
+		size_t max_bucket_count() const;
+		template <typename Pred>
+		size_t bucket(size_t hash, const Pred& equal) const;
+		size_t bucket_size(size_t n) const;
+		local_iterator begin(size_t n);
+		const_local_iterator begin(size_t n) const;
+		local_iterator end(size_t n);
+		const_local_iterator end(size_t n) const;
+
+		// The maximum load factor can't be raised above 0.95; beyond that,
+		// insertions rarely find a chain of kicks that ends in a free slot.
+		float max_load_factor() const;
+		void max_load_factor(float ml);
+
+		template <typename HashFn>
+		void rehash(size_t n, const HashFn& hashOf);
+
+		// Cuckoo hashing always rehashes in one go; there is nothing to do.
+		template <typename HashFn>
+		void rehash_step(const HashFn& /*hashOf*/) {}
+
+		// An element's displacement is 0 in its home bucket and 1 in its
+		// alternate bucket.
+		template <typename HashFn>
+		util::probe_stats probe_stats(const HashFn& hashOf) const;
+
+	private:
+		// resize lays the new table out in a table of slot numbers.
+		template <typename, typename>
+		friend class table;
+
+		using ctrl_t = detail::ctrl_t;
+		using group = detail::ctrl_group;
+		using mutable_type = typename detail::mutable_value<Value>::type;
+		// Storage for one element, as in group_probing.
+		union slot_type
+		{
+			slot_type() {}
+			~slot_type() {}
+			Value value;
+			mutable_type mutable_value;
+		};
+
+		// The most buckets an insertion examines while looking for a chain
+		// of kicks.
+		static constexpr size_t kMaxSearch = 256;
+
+		static size_t mix(size_t hash);
+		static ctrl_t tag(size_t mixed);
+		size_t homeBucket(size_t mixed) const;
+		size_t alternateBucket(size_t bucket, ctrl_t tag) const;
+		size_t slotCount() const;
+
+		// Returns the first free slot of bucket b, or slotCount().
+		size_t freeSlot(size_t b) const;
+
+		// Returns the first slot at or after i that is full, or slotCount().
+		size_t nextFull(size_t i) const;
+
+		// Moves the element in slot from to the free slot to.
+		void moveSlot(size_t from, size_t to);
+
+		// Allocates empty storage for newBucketCount buckets.
+		void allocate(size_t newBucketCount);
+		void deallocate() noexcept;
+		void destroyAll() noexcept;
+
+		size_t growthLimit(size_t slots) const;
+
+		// Returns the smallest allowed bucket count with at least n slots.
+		static size_t normalizeBucketCount(size_t n);
+
+		template <typename HashFn>
+		void resize(size_t newBucketCount, const HashFn& hashOf);
+
+		// Returns a free slot in one of the buckets of mixed, kicking other
+		// elements and growing the table as needed.
+		template <typename HashFn>
+		size_t makeRoom(size_t mixed, const HashFn& hashOf);
+
+		// Searches breadth-first for a chain of kicks that frees a slot in
+		// one of the buckets of mixed, and carries it out. Returns the free
+		// slot, or slotCount() if the search fails.
+		size_t kickToFree(size_t mixed);
+
+		using CtrlAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<ctrl_t>;
+		using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<slot_type>;
+
+		Allocator mAllocator;
+		ctrl_t* mCtrl = detail::empty_group();
+		slot_type* mSlots = nullptr;
+		size_t mBucketCount = 0;
+		size_t mSize = 0;
+
+		// The first full slot. Only meaningful while mSize != 0.
+		size_t mFirstFull = 0;
+
+		float mMaxLoadFactor = 0.9f;
+
+		size_t mKicks = 0;
+		size_t mForcedGrowths = 0;
+	};
+
+	// The cached_hash table: a table of the wrapped policy holding
+	// detail::hashed_value entries. It passes the stored hashes wherever
+	// the wrapped table wants to hash an element, so the hash function
+	// given by hash_map is never called. Positions are those of the
+	// wrapped table.
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	class cached_hash<Policy>::table
+	{
+		using entry_type = detail::hashed_value<Value>;
+		using EntryAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<entry_type>;
+		using inner_table = typename Policy::template table<entry_type, EntryAllocator>;
+
+	public:
+		using local_iterator = detail::hashed_local_iterator<typename inner_table::local_iterator, Value>;
+		using const_local_iterator =
+			detail::hashed_local_iterator<typename inner_table::const_local_iterator, const Value>;
+		using position = typename inner_table::position;
+
+		// Holds one entry that belongs to no table.
+		class node
+		{
+		public:
+			node() = default;
+
+			// The hash is filled in when the node is inserted.
+			template <typename... Args>
+			node(const Allocator& alloc, std::in_place_t, Args&&... args)
+				: mNode(EntryAllocator(alloc), std::in_place, size_t(0), std::forward<Args>(args)...)
+			{
+			}
+
+			bool empty() const { return mNode.empty(); }
+			Value& value() { return mNode.value().value; }
+			const Value& value() const { return mNode.value().value; }
+
+		private:
+			friend class table;
+
+			explicit node(typename inner_table::node&& n)
+				: mNode(std::move(n))
+			{
+			}
+
+			typename inner_table::node mNode;
+		};
+
+		table(size_t numBuckets, const Allocator& alloc);
+
+		Allocator get_allocator() const;
+
+		position first() const;
+		position end() const;
+		void next(position& pos) const;
+		void prev(position& pos) const;
+		Value& element(const position& pos) const;
+
+		// Calls equal only for elements whose stored hash is hash.
+		template <typename Pred>
+		position find(size_t hash, const Pred& equal) const;
+
+		void prefetch(size_t hash) const;
+		void prefetch_element(size_t hash) const;
+
+		// hashOf is never called; the stored hashes stand in for it.
+		template <typename HashFn, typename... Args>
+		position emplace(size_t hash, const HashFn& hashOf, Args&&... args);
+
+		// Stores hash in the node's entry, which may come from a table with
+		// a differently seeded hash function.
+		template <typename HashFn>
+		position insert(size_t hash, const HashFn& hashOf, node& n);
+
+		// Only for wrapped policies that have them.
+		template <typename Pred, typename HashFn, typename... Args>
+		position emplace_equal(size_t hash, const Pred& equal, const HashFn& hashOf, Args&&... args);
+		template <typename Pred, typename HashFn>
+		position insert_equal(size_t hash, const Pred& equal, const HashFn& hashOf, node& n);
+
+		node extract(const position& pos);
+		position erase(const position& pos);
+		void clear() noexcept;
+		void swap(table& other) noexcept;
+
+		size_t size() const;
+		size_t max_size() const;
+		size_t bucket_count() const;
+		size_t max_bucket_count() const;
+		template <typename Pred>
+		size_t bucket(size_t hash, const Pred& equal) const;
+		size_t bucket_size(size_t n) const;
+		local_iterator begin(size_t n);
+		const_local_iterator begin(size_t n) const;
+		local_iterator end(size_t n);
+		const_local_iterator end(size_t n) const;
+
+		float max_load_factor() const;
+		void max_load_factor(float ml);
+
+		template <typename HashFn>
+		void rehash(size_t n, const HashFn& hashOf);
+		template <typename HashFn>
+		void rehash_step(const HashFn& hashOf);
+
+		template <typename HashFn>
+		util::probe_stats probe_stats(const HashFn& hashOf) const;
+
+		// Only for wrapped policies that have them.
+		static constexpr bool kPartitionedBuild = detail::partitioned_build<inner_table>::value;
+		size_t begin_partitions(size_t parts);
+		size_t partition_of(size_t hash) const;
+		template <typename Pred, typename... Args>
+		std::pair<position, bool> emplace_in_partition(size_t hash, const Pred& equal, Args&&... args);
+		void end_partitions(size_t added);
+
+	private:
+		// Hashes an entry by reading its stored hash.
+		struct stored_hash
+		{
+			size_t operator()(const entry_type& entry) const { return entry.hash; }
+		};
+
+		inner_table mTable;
+	};
+
+
+
+
+	template<typename HashMap>
+	const_hash_map_iterator<HashMap>::const_hash_map_iterator(position_type position, const HashMap* hashmap)
+		: mPosition(position), mHashmap(hashmap)
+	{
+	}
+
+	// Return a reference to the actual element.
+	template<typename HashMap>
+	const typename const_hash_map_iterator<HashMap>::value_type&
+		const_hash_map_iterator<HashMap>::operator*() const
+	{
+		return mHashmap->mTable.element(mPosition);
+	}
+
+	// Return a pointer to the actual element, so the compiler can
+	// apply -> to it to access the actual desired field.
+	template<typename HashMap>
+	const typename const_hash_map_iterator<HashMap>::value_type*
+		const_hash_map_iterator<HashMap>::operator->() const
+	{
+		return &(mHashmap->mTable.element(mPosition));
+	}
+
+	// Defer the details to the increment() helper.
+	template<typename HashMap>
+	const_hash_map_iterator<HashMap>& const_hash_map_iterator<HashMap>::operator++()
+	{
+		increment();
+		return *this;
+	}
+
+	// Defer the details to the increment() helper.
+	template<typename HashMap>
+	const_hash_map_iterator<HashMap> const_hash_map_iterator<HashMap>::operator++(int)
+	{
+		auto oldIt = *this;
+		increment();
+		return oldIt;
+	}
+
+	// Defer the details to the decrement() helper.
+	template<typename HashMap>
+	const_hash_map_iterator<HashMap>& const_hash_map_iterator<HashMap>::operator--()
+	{
+		decrement();
+		return *this;
+	}
+
+	// Defer the details to the decrement() helper.
+	template<typename HashMap>
+	const_hash_map_iterator<HashMap> const_hash_map_iterator<HashMap>::operator--(int)
+	{
+		auto oldIt = *this;
+		decrement();
+		return oldIt;
+	}
+
+	template<typename HashMap>
+	bool const_hash_map_iterator<HashMap>::operator==(const const_hash_map_iterator<HashMap>& rhs) const
+	{
+		// All fields, including the hash_map to which the iterators refer,
+		// must be equal.
+		return (mHashmap == rhs.mHashmap &&
+			mPosition == rhs.mPosition);
+	}
+
+	template<typename HashMap>
+	bool const_hash_map_iterator<HashMap>::operator!=(const const_hash_map_iterator<HashMap>& rhs) const
+	{
+		return !(*this == rhs);
+	}
+
+	// Behavior is undefined if mPosition already refers to the past-the-end
+	// element, or is otherwise invalid.
+	template<typename HashMap>
+	void const_hash_map_iterator<HashMap>::increment()
+	{
+		mHashmap->mTable.next(mPosition);
+	}
+
+	// Behavior is undefined if mPosition already refers to the first
+	// element, or is otherwise invalid.
+	template<typename HashMap>
+	void const_hash_map_iterator<HashMap>::decrement()
+	{
+		mHashmap->mTable.prev(mPosition);
+	}
+
+
+
+
+	template<typename HashMap>
+	hash_map_iterator<HashMap>::hash_map_iterator(position_type position, HashMap* hashmap)
+		: const_hash_map_iterator<HashMap>(position, hashmap)
+	{
+	}
+
+	// Return a reference to the actual element.
+	template<typename HashMap>
+	typename hash_map_iterator<HashMap>::value_type&
+		hash_map_iterator<HashMap>::operator*()
+	{
+		return this->mHashmap->mTable.element(this->mPosition);
+	}
+
+	// Return a pointer to the actual element, so the compiler can
+	// apply -> to it to access the actual desired field.
+	template<typename HashMap>
+	typename hash_map_iterator<HashMap>::value_type*
+		hash_map_iterator<HashMap>::operator->()
+	{
+		return &(this->mHashmap->mTable.element(this->mPosition));
+	}
+
+	// Defer the details to the increment() helper in the base class.
+	template<typename HashMap>
+	hash_map_iterator<HashMap>& hash_map_iterator<HashMap>::operator++()
+	{
+		this->increment();
+		return *this;
+	}
+
+	// Defer the details to the increment() helper in the base class.
+	template<typename HashMap>
+	hash_map_iterator<HashMap> hash_map_iterator<HashMap>::operator++(int)
+	{
+		auto oldIt = *this;
+		this->increment();
+		return oldIt;
+	}
+
+	// Defer the details to the decrement() helper in the base class.
+	template<typename HashMap>
+	hash_map_iterator<HashMap>& hash_map_iterator<HashMap>::operator--()
+	{
+		this->decrement();
+		return *this;
+	}
+
+	// Defer the details to the decrement() helper in the base class.
+	template<typename HashMap>
+	hash_map_iterator<HashMap> hash_map_iterator<HashMap>::operator--(int)
+	{
+		auto oldIt = *this;
+		this->decrement();
+		return oldIt;
+	}
+
+
+	template <typename HashMap>
+	hash_map_node<HashMap>::hash_map_node(node_type&& node)
+		: mNode(std::move(node))
+	{
+	}
+
+	template <typename HashMap>
+	bool hash_map_node<HashMap>::empty() const
+	{
+		return mNode.empty();
+	}
+
+	template <typename HashMap>
+	hash_map_node<HashMap>::operator bool() const
+	{
+		return !empty();
+	}
+
+	template <typename HashMap>
+	const typename hash_map_node<HashMap>::key_type& hash_map_node<HashMap>::key() const
+	{
+		return mNode.value().first;
+	}
+
+	template <typename HashMap>
+	typename hash_map_node<HashMap>::mapped_type& hash_map_node<HashMap>::mapped()
+	{
+		return mNode.value().second;
+	}
+
+	template <typename HashMap>
+	const typename hash_map_node<HashMap>::mapped_type& hash_map_node<HashMap>::mapped() const
+	{
+		return mNode.value().second;
+	}
+
+	template <typename HashMap>
+	void hash_map_node<HashMap>::swap(hash_map_node<HashMap>& other) noexcept
+	{
+		node_type temp(std::move(mNode));
+		mNode = std::move(other.mNode);
+		other.mNode = std::move(temp);
+	}
+
+
+
+
+	template <typename Value, typename Allocator, bool Incremental>
+	chaining::table<Value, Allocator, Incremental>::table(size_t numBuckets, const Allocator& alloc)
+		: mAllocator(alloc), mBuckets(makeBuckets(numBuckets)), mOccupied(makeBits(numBuckets)),
+		mOldBuckets(mBuckets.get_allocator()), mOldOccupied(mOccupied.get_allocator())
+	{
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	Allocator chaining::table<Value, Allocator, Incremental>::get_allocator() const
+	{
+		return mAllocator;
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	typename chaining::table<Value, Allocator, Incremental>::BucketArray
+		chaining::table<Value, Allocator, Incremental>::makeBuckets(size_t n) const
+	{
+		// Built one by one: copying an empty list would require copyable
+		// elements.
+		BucketArray buckets{ typename BucketArray::allocator_type(mAllocator) };
+		buckets.reserve(n);
+		for (size_t i = 0; i < n; i++) {
+			buckets.emplace_back(mAllocator);
+		}
+		return buckets;
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	typename chaining::table<Value, Allocator, Incremental>::BitArray chaining::table<Value, Allocator, Incremental>::makeBits(size_t n) const
+	{
+		return BitArray((n + 63) / 64, 0, typename BitArray::allocator_type(mAllocator));
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	typename chaining::table<Value, Allocator, Incremental>::ListType&
+		chaining::table<Value, Allocator, Incremental>::bucketAt(size_t n)
+	{
+		if (Incremental && n < mOldBuckets.size()) {
+			return mOldBuckets[n];
+		}
+		return mBuckets[n - mOldBuckets.size()];
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	const typename chaining::table<Value, Allocator, Incremental>::ListType&
+		chaining::table<Value, Allocator, Incremental>::bucketAt(size_t n) const
+	{
+		return const_cast<table*>(this)->bucketAt(n);
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	size_t chaining::table<Value, Allocator, Incremental>::totalBuckets() const
+	{
+		return (Incremental ? mOldBuckets.size() : 0) + mBuckets.size();
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	size_t chaining::table<Value, Allocator, Incremental>::nextOccupied(size_t n) const
+	{
+		size_t oldCount = Incremental ? mOldBuckets.size() : 0;
+		if (Incremental && n < oldCount) {
+			size_t i = detail::find_next_bit(mOldOccupied.data(), n, oldCount);
+			if (i != oldCount) {
+				return i;
+			}
+			n = oldCount;
+		}
+		return oldCount + detail::find_next_bit(mOccupied.data(), n - oldCount, mBuckets.size());
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	size_t chaining::table<Value, Allocator, Incremental>::prevOccupied(size_t n) const
+	{
+		size_t oldCount = Incremental ? mOldBuckets.size() : 0;
+		if (!Incremental || n > oldCount) {
+			size_t i = detail::find_prev_bit(mOccupied.data(), n - oldCount);
+			if (i != static_cast<size_t>(-1)) {
+				return oldCount + i;
+			}
+			n = oldCount;
+		}
+		return detail::find_prev_bit(mOldOccupied.data(), n);
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	void chaining::table<Value, Allocator, Incremental>::occupied(size_t n)
+	{
+		size_t oldCount = Incremental ? mOldBuckets.size() : 0;
+		if (Incremental && n < oldCount) {
+			mOldOccupied[n / 64] |= uint64_t(1) << (n % 64);
+		} else {
+			mOccupied[(n - oldCount) / 64] |= uint64_t(1) << ((n - oldCount) % 64);
+		}
+		// Called after mSize has been incremented.
+		if (mSize == 1 || n < mFirst) {
+			mFirst = n;
+		}
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	void chaining::table<Value, Allocator, Incremental>::vacated(size_t n)
+	{
+		if (!bucketAt(n).empty()) {
+			return;
+		}
+		size_t oldCount = Incremental ? mOldBuckets.size() : 0;
+		if (Incremental && n < oldCount) {
+			mOldOccupied[n / 64] &= ~(uint64_t(1) << (n % 64));
+		} else {
+			mOccupied[(n - oldCount) / 64] &= ~(uint64_t(1) << ((n - oldCount) % 64));
+		}
+		// Only buckets after the old first one can hold the new first one.
+		if (n == mFirst) {
+			mFirst = nextOccupied(n + 1);
+		}
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	typename chaining::table<Value, Allocator, Incremental>::position chaining::table<Value, Allocator, Incremental>::first() const
+	{
+		if (mSize == 0) {
+			return end();
+		}
+		return position{ mFirst, std::begin(bucketAt(mFirst)) };
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	typename chaining::table<Value, Allocator, Incremental>::position chaining::table<Value, Allocator, Incremental>::end() const
+	{
+		// The end position is the end iterator of the list of the last bucket.
+		size_t bucket = totalBuckets() - 1;
+		return position{ bucket, std::end(bucketAt(bucket)) };
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	void chaining::table<Value, Allocator, Incremental>::next(position& pos) const
+	{
+		// mListIterator is an iterator into a single bucket. Increment it.
+		++pos.mListIterator;
+
+		// If we're at the end of the current bucket,
+		// find the next bucket with elements.
+		if (pos.mListIterator == std::end(bucketAt(pos.mBucketIndex))) {
+			size_t i = nextOccupied(pos.mBucketIndex + 1);
+			if (i != totalBuckets()) {
+				// We found a non-empty bucket.
+				// Make mListIterator refer to the first element in it.
+				pos.mListIterator = std::begin(bucketAt(i));
+				pos.mBucketIndex = i;
+				return;
+			}
+			// No more non-empty buckets. Set mListIterator to refer to the
+			// end iterator of the last list.
+			pos = end();
+		}
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	void chaining::table<Value, Allocator, Incremental>::prev(position& pos) const
+	{
+		// mListIterator is an iterator into a single bucket.
+		// If it's at the beginning of the current bucket, don't decrement it.
+		// Instead, try to find a non-empty bucket before the current one.
+		if (pos.mListIterator == std::begin(bucketAt(pos.mBucketIndex))) {
+			size_t i = prevOccupied(pos.mBucketIndex);
+			if (i != static_cast<size_t>(-1)) {
+				pos.mListIterator = --std::end(bucketAt(i));
+				pos.mBucketIndex = i;
+				return;
+			}
+			// No more non-empty buckets. This is an invalid decrement.
+			// Set mListIterator to refer to the end iterator of the last list.
+			pos = end();
+		} else {
+			// We're not at the beginning of the bucket, so just move down.
+			--pos.mListIterator;
+		}
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	Value& chaining::table<Value, Allocator, Incremental>::element(const position& pos) const
+	{
+		// Positions only hold const list iterators, but the table owns the
+		// element, so handing out a mutable reference is fine.
+		return const_cast<Value&>(*pos.mListIterator);
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	template <typename Pred>
+	typename chaining::table<Value, Allocator, Incremental>::position
+		chaining::table<Value, Allocator, Incremental>::find(size_t hash, const Pred& equal) const
+	{
+		// An element whose old bucket hasn't been drained yet is still there.
+		if (Incremental && !mOldBuckets.empty()) {
+			size_t oldBucket = hash % mOldBuckets.size();
+			if (oldBucket >= mMigrated) {
+				auto iter = std::find_if(std::begin(mOldBuckets[oldBucket]), std::end(mOldBuckets[oldBucket]), equal);
+				if (iter != std::end(mOldBuckets[oldBucket])) {
+					return position{ oldBucket, iter };
+				}
+			}
+		}
+
+		// Hash the key to get the bucket.
+		size_t bucket = hash % mBuckets.size();
+
+		// Search for the key in the bucket.
+		auto iter = std::find_if(std::begin(mBuckets[bucket]), std::end(mBuckets[bucket]), equal);
+		if (iter == std::end(mBuckets[bucket])) {
+			return end();
+		}
+		return position{ mOldBuckets.size() + bucket, iter };
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	void chaining::table<Value, Allocator, Incremental>::prefetch(size_t hash) const
+	{
+		if (Incremental && !mOldBuckets.empty()) {
+			detail::prefetch(&mOldBuckets[hash % mOldBuckets.size()]);
+		}
+		detail::prefetch(&mBuckets[hash % mBuckets.size()]);
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	void chaining::table<Value, Allocator, Incremental>::prefetch_element(size_t hash) const
+	{
+		// Reading the bucket is what prefetch() made cheap.
+		if (Incremental && !mOldBuckets.empty()) {
+			const ListType& oldBucket = mOldBuckets[hash % mOldBuckets.size()];
+			if (!oldBucket.empty()) {
+				detail::prefetch(&oldBucket.front());
+			}
+		}
+		const ListType& bucket = mBuckets[hash % mBuckets.size()];
+		if (!bucket.empty()) {
+			detail::prefetch(&bucket.front());
+		}
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	template <typename HashFn, typename... Args>
+	typename chaining::table<Value, Allocator, Incremental>::position
+		chaining::table<Value, Allocator, Incremental>::emplace(size_t hash, const HashFn& hashOf, Args&&... args)
+	{
+		makeRoom(hashOf);
+
+		size_t bucket = hash % mBuckets.size();
+		auto it = mBuckets[bucket].emplace(std::end(mBuckets[bucket]), std::forward<Args>(args)...);
+		mSize++;
+		occupied(mOldBuckets.size() + bucket);
+		return position{ mOldBuckets.size() + bucket, it };
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	template <typename HashFn>
+	typename chaining::table<Value, Allocator, Incremental>::position
+		chaining::table<Value, Allocator, Incremental>::insert(size_t hash, const HashFn& hashOf, node& n)
+	{
+		makeRoom(hashOf);
+
+		size_t bucket = hash % mBuckets.size();
+		auto it = std::begin(n.mList);
+		mBuckets[bucket].splice(std::end(mBuckets[bucket]), n.mList, it);
+		mSize++;
+		occupied(mOldBuckets.size() + bucket);
+		return position{ mOldBuckets.size() + bucket, it };
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	template <typename Pred, typename HashFn, typename... Args>
+	typename chaining::table<Value, Allocator, Incremental>::position
+		chaining::table<Value, Allocator, Incremental>::emplace_equal(size_t hash, const Pred& equal, const HashFn& hashOf,
+			Args&&... args)
+	{
+		makeRoom(hashOf);
+
+		position where = insertionPoint(hash, equal);
+		auto it = bucketAt(where.mBucketIndex).emplace(where.mListIterator, std::forward<Args>(args)...);
+		mSize++;
+		occupied(where.mBucketIndex);
+		return position{ where.mBucketIndex, it };
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	template <typename Pred, typename HashFn>
+	typename chaining::table<Value, Allocator, Incremental>::position
+		chaining::table<Value, Allocator, Incremental>::insert_equal(size_t hash, const Pred& equal, const HashFn& hashOf,
+			node& n)
+	{
+		makeRoom(hashOf);
+
+		position where = insertionPoint(hash, equal);
+		auto it = std::begin(n.mList);
+		bucketAt(where.mBucketIndex).splice(where.mListIterator, n.mList, it);
+		mSize++;
+		occupied(where.mBucketIndex);
+		return position{ where.mBucketIndex, it };
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	template <typename Pred>
+	typename chaining::table<Value, Allocator, Incremental>::position
+		chaining::table<Value, Allocator, Incremental>::insertionPoint(size_t hash, const Pred& equal) const
+	{
+		position pos = find(hash, equal);
+		if (pos == end()) {
+			// A new key goes to the end of its bucket, as with emplace().
+			size_t bucket = mOldBuckets.size() + hash % mBuckets.size();
+			return position{ bucket, std::end(bucketAt(bucket)) };
+		}
+		// After the last equal element. Equal elements are always in the
+		// same bucket, which may still be an old one.
+		const ListType& list = bucketAt(pos.mBucketIndex);
+		auto it = pos.mListIterator;
+		while (it != std::end(list) && equal(*it)) {
+			++it;
+		}
+		return position{ pos.mBucketIndex, it };
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	typename chaining::table<Value, Allocator, Incremental>::node
+		chaining::table<Value, Allocator, Incremental>::extract(const position& pos)
+	{
+		node n(mAllocator);
+		n.mList.splice(std::end(n.mList), bucketAt(pos.mBucketIndex), pos.mListIterator);
+		mSize--;
+		vacated(pos.mBucketIndex);
+		return n;
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	template <typename HashFn>
+	void chaining::table<Value, Allocator, Incremental>::makeRoom(const HashFn& hashOf)
+	{
+		rehash_step(hashOf);
+
+		// Grow by doubling once the new element would push the load
+		// factor over the maximum.
+		if (static_cast<double>(mSize + 1) > mBuckets.size() * static_cast<double>(mMaxLoadFactor)) {
+			if (Incremental) {
+				// Start moving over to a fresh array; new elements go
+				// straight into it. Bucket numbers, and so mFirst, stay
+				// the same.
+				finishMigration(hashOf);
+				BucketArray newBuckets = makeBuckets(detail::next_prime(mBuckets.size() * 2));
+				BitArray newOccupied = makeBits(newBuckets.size());
+				mOldBuckets.swap(mBuckets);
+				mBuckets.swap(newBuckets);
+				mOldOccupied.swap(mOccupied);
+				mOccupied.swap(newOccupied);
+				mMigrated = 0;
+			} else {
+				rehash(mBuckets.size() * 2, hashOf);
+			}
+		}
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	typename chaining::table<Value, Allocator, Incremental>::position
+		chaining::table<Value, Allocator, Incremental>::erase(const position& pos)
+	{
+		// Other elements don't move, so the next one can be found first.
+		position following = pos;
+		next(following);
+
+		bucketAt(pos.mBucketIndex).erase(pos.mListIterator);
+		mSize--;
+		vacated(pos.mBucketIndex);
+		return following;
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	void chaining::table<Value, Allocator, Incremental>::clear() noexcept
+	{
+		// Call clear on each bucket.
+		for (auto& bucket : mBuckets) {
+			bucket.clear();
+		}
+		std::fill(std::begin(mOccupied), std::end(mOccupied), 0);
+		mSize = 0;
+
+		// Nothing is left to migrate.
+		makeBuckets(0).swap(mOldBuckets);
+		makeBits(0).swap(mOldOccupied);
+		mMigrated = 0;
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	void chaining::table<Value, Allocator, Incremental>::swap(table& other) noexcept
+	{
+		using std::swap;
+
+		swap(mAllocator, other.mAllocator);
+		mBuckets.swap(other.mBuckets);
+		mOccupied.swap(other.mOccupied);
+		swap(mSize, other.mSize);
+		swap(mMaxLoadFactor, other.mMaxLoadFactor);
+		swap(mFirst, other.mFirst);
+		mOldBuckets.swap(other.mOldBuckets);
+		mOldOccupied.swap(other.mOldOccupied);
+		swap(mMigrated, other.mMigrated);
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	size_t chaining::table<Value, Allocator, Incremental>::size() const
+	{
+		return mSize;
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	size_t chaining::table<Value, Allocator, Incremental>::max_size() const
+	{
+		// In the worst case, all the elements hash to the same
+		// list, so the max_size is the max_size of a single list.
+		// This code assumes that all the lists have the same max_size.
+		return mBuckets[0].max_size();
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	size_t chaining::table<Value, Allocator, Incremental>::bucket_count() const
+	{
+		return totalBuckets();
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	size_t chaining::table<Value, Allocator, Incremental>::max_bucket_count() const
+	{
+		return mBuckets.max_size();
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	template <typename Pred>
+	size_t chaining::table<Value, Allocator, Incremental>::bucket(size_t hash, const Pred& equal) const
+	{
+		// While migrating, an element may still be in its old bucket.
+		if (Incremental && !mOldBuckets.empty()) {
+			auto pos = find(hash, equal);
+			if (pos != end()) {
+				return pos.mBucketIndex;
+			}
+		}
+		return mOldBuckets.size() + hash % mBuckets.size();
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	size_t chaining::table<Value, Allocator, Incremental>::bucket_size(size_t n) const
+	{
+		return bucketAt(n).size();
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	typename chaining::table<Value, Allocator, Incremental>::local_iterator chaining::table<Value, Allocator, Incremental>::begin(size_t n)
+	{
+		return bucketAt(n).begin();
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	typename chaining::table<Value, Allocator, Incremental>::const_local_iterator chaining::table<Value, Allocator, Incremental>::begin(size_t n) const
+	{
+		return bucketAt(n).begin();
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	typename chaining::table<Value, Allocator, Incremental>::local_iterator chaining::table<Value, Allocator, Incremental>::end(size_t n)
+	{
+		return bucketAt(n).end();
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	typename chaining::table<Value, Allocator, Incremental>::const_local_iterator chaining::table<Value, Allocator, Incremental>::end(size_t n) const
+	{
+		return bucketAt(n).end();
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	float chaining::table<Value, Allocator, Incremental>::max_load_factor() const
+	{
+		return mMaxLoadFactor;
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	void chaining::table<Value, Allocator, Incremental>::max_load_factor(float ml)
+	{
+		mMaxLoadFactor = ml;
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	template <typename HashFn>
+	void chaining::table<Value, Allocator, Incremental>::rehash(size_t n, const HashFn& hashOf)
+	{
+		finishMigration(hashOf);
+
+		// Never go below what the current elements need.
+		size_t needed = static_cast<size_t>(std::ceil(mSize / static_cast<double>(mMaxLoadFactor)));
+		size_t newCount = detail::next_prime(std::max(n, needed));
+		if (newCount == mBuckets.size()) {
+			return;
+		}
+
+		// Hash every element first, so that nothing past the swap can
+		// throw. Then splice every node into its new bucket. The nodes
+		// themselves are not touched, so no element is copied and no
+		// reference is invalidated.
+		std::vector<size_t> targets;
+		targets.reserve(mSize);
+		for (const auto& bucket : mBuckets) {
+			targetsOf(bucket, newCount, hashOf, targets);
+		}
+		BucketArray newBuckets = makeBuckets(newCount);
+		BitArray newOccupied = makeBits(newCount);
+		mBuckets.swap(newBuckets);
+		mOccupied.swap(newOccupied);
+		const size_t* next = targets.data();
+		for (auto& bucket : newBuckets) {
+			next = spliceInto(bucket, next);
+		}
+		mFirst = nextOccupied(0);
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	template <typename HashFn>
+	void chaining::table<Value, Allocator, Incremental>::rehash_step(const HashFn& hashOf)
+	{
+		if (!Incremental || mOldBuckets.empty()) {
+			return;
+		}
+
+		// A bucket only counts as migrated once it has been hashed and
+		// spliced in full, so a throwing hash leaves it where lookups
+		// still find it.
+		std::vector<size_t> targets;
+		for (size_t step = 0; step < kMigrationStep && mMigrated < mOldBuckets.size(); ++step) {
+			targets.clear();
+			targetsOf(mOldBuckets[mMigrated], mBuckets.size(), hashOf, targets);
+			spliceInto(mOldBuckets[mMigrated], targets.data());
+			mOldOccupied[mMigrated / 64] &= ~(uint64_t(1) << (mMigrated % 64));
+			++mMigrated;
+			// If the first element was in the drained bucket, it has moved
+			// on.
+			mFirst = nextOccupied(std::max(mFirst, mMigrated));
+		}
+
+		// Release the old array once it has been drained. Every bucket
+		// number drops by its size.
+		if (mMigrated == mOldBuckets.size()) {
+			mFirst -= mOldBuckets.size();
+			makeBuckets(0).swap(mOldBuckets);
+			makeBits(0).swap(mOldOccupied);
+			mMigrated = 0;
+		}
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	template <typename HashFn>
+	util::probe_stats chaining::table<Value, Allocator, Incremental>::probe_stats(const HashFn& /*hashOf*/) const
+	{
+		util::probe_stats stats;
+		for (size_t n = nextOccupied(0); n < totalBuckets(); n = nextOccupied(n + 1)) {
+			size_t displacement = 0;
+			for (auto it = std::begin(bucketAt(n)); it != std::end(bucketAt(n)); ++it) {
+				detail::add_probe(stats, displacement++);
+			}
+		}
+		detail::finish_probe_stats(stats);
+		return stats;
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	size_t chaining::table<Value, Allocator, Incremental>::begin_partitions(size_t parts)
+	{
+		// Partitions of whole bitmap words never set bits in the same word.
+		size_t words = (mBuckets.size() + 63) / 64;
+		mPartitionSize = (words + parts - 1) / parts * 64;
+		return (mBuckets.size() + mPartitionSize - 1) / mPartitionSize;
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	size_t chaining::table<Value, Allocator, Incremental>::partition_of(size_t hash) const
+	{
+		return hash % mBuckets.size() / mPartitionSize;
+	}
+
+	// Like find() followed by emplace(), but without touching mSize or
+	// mFirst, which all partitions share.
+	template <typename Value, typename Allocator, bool Incremental>
+	template <typename Pred, typename... Args>
+	std::pair<typename chaining::table<Value, Allocator, Incremental>::position, bool>
+		chaining::table<Value, Allocator, Incremental>::emplace_in_partition(size_t hash, const Pred& equal,
+			Args&&... args)
+	{
+		size_t bucket = hash % mBuckets.size();
+		ListType& list = mBuckets[bucket];
+		for (auto it = std::begin(list); it != std::end(list); ++it) {
+			if (equal(*it)) {
+				return std::make_pair(position{ bucket, it }, false);
+			}
+		}
+		auto it = list.emplace(std::end(list), std::forward<Args>(args)...);
+		mOccupied[bucket / 64] |= uint64_t(1) << (bucket % 64);
+		return std::make_pair(position{ bucket, it }, true);
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	void chaining::table<Value, Allocator, Incremental>::end_partitions(size_t added)
+	{
+		mSize += added;
+		mFirst = nextOccupied(0);
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	template <typename HashFn>
+	void chaining::table<Value, Allocator, Incremental>::targetsOf(const ListType& from, size_t bucketCount,
+		const HashFn& hashOf, std::vector<size_t>& targets) const
+	{
+		for (const auto& value : from) {
+			targets.push_back(hashOf(value) % bucketCount);
+		}
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	const size_t* chaining::table<Value, Allocator, Incremental>::spliceInto(ListType& from, const size_t* targets) noexcept
+	{
+		while (!from.empty()) {
+			size_t bucket = *targets++;
+			mBuckets[bucket].splice(std::end(mBuckets[bucket]), from, std::begin(from));
+			mOccupied[bucket / 64] |= uint64_t(1) << (bucket % 64);
+		}
+		return targets;
+	}
+
+	template <typename Value, typename Allocator, bool Incremental>
+	template <typename HashFn>
+	void chaining::table<Value, Allocator, Incremental>::finishMigration(const HashFn& hashOf)
+	{
+		while (Incremental && !mOldBuckets.empty()) {
+			rehash_step(hashOf);
+		}
+	}
+
+
+
+
+
+	// Round the requested number of buckets up to a power of two, and
+	// never go below one full group.
+	template <typename Value, typename Allocator>
+	group_probing::table<Value, Allocator>::table(size_t numBuckets, const Allocator& alloc)
+		: mAllocator(alloc)
+	{
+		allocate(normalizeCapacity(numBuckets));
+	}
+
+	template <typename Value, typename Allocator>
+	group_probing::table<Value, Allocator>::table(const table& src)
+		: mAllocator(std::allocator_traits<Allocator>::select_on_container_copy_construction(src.mAllocator)),
+		mMaxLoadFactor(src.mMaxLoadFactor)
+	{
+		if (src.mCapacity == 0) {
+			return;
+		}
+		allocate(src.mCapacity);
+		// Copy element by element into the same slots, so the control bytes
+		// (including deleted markers) can be copied verbatim.
+		try {
+			for (size_t i = src.nextFull(0); i < src.mCapacity; i = src.nextFull(i + 1)) {
+				new (&mSlots[i].mutable_value) mutable_type(src.mSlots[i].value);
+				mCtrl[i] = src.mCtrl[i];
+				++mSize;
+			}
+		} catch (...) {
+			destroyAll();
+			deallocate();
+			throw;
+		}
+		std::memcpy(mCtrl, src.mCtrl, mCapacity + group::kWidth);
+		mGrowthLeft = src.mGrowthLeft;
+		mFirstFull = src.mFirstFull;
+	}
+
+	// Steal the storage and leave the source as an empty table.
+	template <typename Value, typename Allocator>
+	group_probing::table<Value, Allocator>::table(table&& src) noexcept
+		: mAllocator(src.mAllocator)
+	{
+		swap(src);
+	}
+
+	template <typename Value, typename Allocator>
+	Allocator group_probing::table<Value, Allocator>::get_allocator() const
+	{
+		return mAllocator;
+	}
+
+	template <typename Value, typename Allocator>
+	group_probing::table<Value, Allocator>::~table()
+	{
+		destroyAll();
+		deallocate();
+	}
+
+	template <typename Value, typename Allocator>
+	size_t group_probing::table<Value, Allocator>::mix(size_t hash)
+	{
+		return static_cast<size_t>(detail::fmix64(static_cast<uint64_t>(hash)));
+	}
+
+	template <typename Value, typename Allocator>
+	detail::ctrl_t group_probing::table<Value, Allocator>::h2(size_t mixed)
+	{
+		return static_cast<ctrl_t>(mixed & 0x7f);
+	}
+
+	template <typename Value, typename Allocator>
+	size_t group_probing::table<Value, Allocator>::h1(size_t mixed)
+	{
+		return mixed >> 7;
+	}
+
+	template <typename Value, typename Allocator>
+	detail::ctrl_t* group_probing::table<Value, Allocator>::emptyGroup()
+	{
+		return detail::empty_group();
+	}
+
+	template <typename Value, typename Allocator>
+	size_t group_probing::table<Value, Allocator>::mask() const
+	{
+		return mCapacity == 0 ? 0 : mCapacity - 1;
+	}
+
+	// Set a control byte, keeping the mirrored copy of the first group
+	// in sync.
+	template <typename Value, typename Allocator>
+	void group_probing::table<Value, Allocator>::setCtrl(size_t i, ctrl_t c)
+	{
+		mCtrl[i] = c;
+		if (i < group::kWidth) {
+			mCtrl[mCapacity + i] = c;
+		}
+	}
+
+	template <typename Value, typename Allocator>
+	size_t group_probing::table<Value, Allocator>::nextFull(size_t i) const
+	{
+		while (i < mCapacity) {
+			uint32_t full = group(mCtrl + i).match_full();
+			// Bytes past the end are the mirrored first group; ignore them.
+			if (mCapacity - i < group::kWidth) {
+				full &= (1u << (mCapacity - i)) - 1;
+			}
+			if (full != 0) {
+				return i + detail::count_trailing_zeros(full);
+			}
+			i += group::kWidth;
+		}
+		return mCapacity;
+	}
+
+	// Probe group by group with a triangular sequence. Since the capacity
+	// is a power of two, the sequence visits every group, and the load
+	// factor limit guarantees that an empty slot exists.
+	template <typename Value, typename Allocator>
+	size_t group_probing::table<Value, Allocator>::findFirstNonFull(size_t mixed) const
+	{
+		size_t pos = h1(mixed) & mask();
+		size_t step = 0;
+		while (true) {
+			uint32_t candidates = group(mCtrl + pos).match_empty_or_deleted();
+			if (candidates != 0) {
+				return (pos + detail::count_trailing_zeros(candidates)) & mask();
+			}
+			step += group::kWidth;
+			pos = (pos + step) & mask();
+		}
+	}
+
+	template <typename Value, typename Allocator>
+	void group_probing::table<Value, Allocator>::allocate(size_t newCapacity)
+	{
+		CtrlAllocator ctrlAllocator(mAllocator);
+		SlotAllocator slotAllocator(mAllocator);
+		ctrl_t* ctrl = ctrlAllocator.allocate(newCapacity + group::kWidth);
+		try {
+			mSlots = slotAllocator.allocate(newCapacity);
+		} catch (...) {
+			ctrlAllocator.deallocate(ctrl, newCapacity + group::kWidth);
+			throw;
+		}
+		mCtrl = ctrl;
+		std::memset(mCtrl, static_cast<unsigned char>(detail::kEmpty), newCapacity + group::kWidth);
+		mCapacity = newCapacity;
+		mSize = 0;
+		resetGrowthLeft();
+	}
+
+	template <typename Value, typename Allocator>
+	void group_probing::table<Value, Allocator>::deallocate() noexcept
+	{
+		if (mCapacity != 0) {
+			CtrlAllocator(mAllocator).deallocate(mCtrl, mCapacity + group::kWidth);
+			SlotAllocator(mAllocator).deallocate(mSlots, mCapacity);
+		}
+		mCtrl = emptyGroup();
+		mSlots = nullptr;
+		mCapacity = 0;
+		mSize = 0;
+		mGrowthLeft = 0;
+	}
+
+	template <typename Value, typename Allocator>
+	size_t group_probing::table<Value, Allocator>::normalizeCapacity(size_t n)
+	{
+		size_t capacity = group::kWidth;
+		while (capacity < n) {
+			capacity *= 2;
+		}
+		return capacity;
+	}
+
+	template <typename Value, typename Allocator>
+	void group_probing::table<Value, Allocator>::destroyAll() noexcept
+	{
+		for (size_t i = nextFull(0); i < mCapacity; i = nextFull(i + 1)) {
+			mSlots[i].mutable_value.~mutable_type();
+		}
+	}
+
+	// Keep the load factor at or below the maximum, which is never more
+	// than 7/8.
+	template <typename Value, typename Allocator>
+	size_t group_probing::table<Value, Allocator>::growthLimit(size_t capacity) const
+	{
+		size_t limit = static_cast<size_t>(capacity * static_cast<double>(mMaxLoadFactor));
+		return std::min(limit, capacity - capacity / 8);
+	}
+
+	template <typename Value, typename Allocator>
+	void group_probing::table<Value, Allocator>::resetGrowthLeft()
+	{
+		size_t limit = growthLimit(mCapacity);
+		mGrowthLeft = limit > mSize ? limit - mSize : 0;
+	}
+
+	template <typename Value, typename Allocator>
+	template <typename HashFn>
+	void group_probing::table<Value, Allocator>::resize(size_t newCapacity, const HashFn& hashOf)
+	{
+		// Hash everything before touching any element, so that a throwing
+		// hash leaves this table as it was.
+		std::vector<size_t> mixed(mCapacity);
+		for (size_t i = nextFull(0); i < mCapacity; i = nextFull(i + 1)) {
+			mixed[i] = mix(hashOf(mSlots[i].value));
+		}
+
+		table newTable(newCapacity, mAllocator);
+		newTable.mMaxLoadFactor = mMaxLoadFactor;
+
+		// Copy or move every element over. This table keeps its own until
+		// the swap, and newTable destroys them; if a copy throws, newTable
+		// destroys the copies made so far instead.
+		for (size_t i = nextFull(0); i < mCapacity; i = nextFull(i + 1)) {
+			size_t target = newTable.findFirstNonFull(mixed[i]);
+			new (&newTable.mSlots[target].mutable_value) mutable_type(std::move_if_noexcept(mSlots[i].mutable_value));
+			newTable.setCtrl(target, h2(mixed[i]));
+			++newTable.mSize;
+		}
+		newTable.mFirstFull = newTable.nextFull(0);
+		newTable.resetGrowthLeft();
+		swap(newTable);
+	}
+
+	template <typename Value, typename Allocator>
+	typename group_probing::table<Value, Allocator>::position group_probing::table<Value, Allocator>::first() const
+	{
+		return mSize == 0 ? mCapacity : mFirstFull;
+	}
+
+	template <typename Value, typename Allocator>
+	typename group_probing::table<Value, Allocator>::position group_probing::table<Value, Allocator>::end() const
+	{
+		return mCapacity;
+	}
+
+	template <typename Value, typename Allocator>
+	void group_probing::table<Value, Allocator>::next(position& pos) const
+	{
+		pos = nextFull(pos + 1);
+	}
+
+	template <typename Value, typename Allocator>
+	void group_probing::table<Value, Allocator>::prev(position& pos) const
+	{
+		for (size_t i = pos; i-- > 0;) {
+			if (mCtrl[i] >= 0) {
+				pos = i;
+				return;
+			}
+		}
+		// This is an invalid decrement. Refer to the end position.
+		pos = mCapacity;
+	}
+
+	template <typename Value, typename Allocator>
+	Value& group_probing::table<Value, Allocator>::element(position pos) const
+	{
+		return mSlots[pos].value;
+	}
+
+	template <typename Value, typename Allocator>
+	template <typename Pred>
+	typename group_probing::table<Value, Allocator>::position
+		group_probing::table<Value, Allocator>::find(size_t hash, const Pred& equal) const
+	{
+		size_t mixed = mix(hash);
+		ctrl_t tag = h2(mixed);
+		size_t pos = h1(mixed) & mask();
+		size_t step = 0;
+		while (true) {
+			group g(mCtrl + pos);
+			// Only slots whose control byte matches H2 need a real compare.
+			for (uint32_t match = g.match(tag); match != 0; match &= match - 1) {
+				size_t i = (pos + detail::count_trailing_zeros(match)) & mask();
+				if (equal(mSlots[i].value)) {
+					return i;
+				}
+			}
+			// An empty slot ends the probe sequence: an element with this
+			// hash would have been placed there.
+			if (g.match_empty() != 0) {
+				return mCapacity;
+			}
+			step += group::kWidth;
+			pos = (pos + step) & mask();
+		}
+	}
+
+	template <typename Value, typename Allocator>
+	void group_probing::table<Value, Allocator>::prefetch(size_t hash) const
+	{
+		detail::prefetch(mCtrl + (h1(mix(hash)) & mask()));
+	}
+
+	// Almost every lookup ends in its first group, so only that group's
+	// first candidate is fetched.
+	template <typename Value, typename Allocator>
+	void group_probing::table<Value, Allocator>::prefetch_element(size_t hash) const
+	{
+		size_t mixed = mix(hash);
+		size_t pos = h1(mixed) & mask();
+		uint32_t match = group(mCtrl + pos).match(h2(mixed));
+		if (match != 0) {
+			detail::prefetch(&mSlots[(pos + detail::count_trailing_zeros(match)) & mask()]);
+		}
+	}
+
+	template <typename Value, typename Allocator>
+	template <typename HashFn, typename... Args>
+	typename group_probing::table<Value, Allocator>::position
+		group_probing::table<Value, Allocator>::emplace(size_t hash, const HashFn& hashOf, Args&&... args)
+	{
+		size_t mixed = mix(hash);
+		size_t target = findFirstNonFull(mixed);
+
+		// Reusing a deleted slot doesn't consume growth. Otherwise, if the
+		// table is out of growth, either squeeze out the deleted slots (when
+		// at most half of the table is live) or double the capacity.
+		if (mGrowthLeft == 0 && mCtrl[target] != detail::kDeleted) {
+			size_t newCapacity = mCapacity;
+			if (mCapacity == 0 || mSize >= growthLimit(mCapacity) / 2) {
+				newCapacity = mCapacity == 0 ? group::kWidth : mCapacity * 2;
+			}
+			while (growthLimit(newCapacity) <= mSize) {
+				newCapacity *= 2;
+			}
+			resize(newCapacity, hashOf);
+			target = findFirstNonFull(mixed);
+		}
+
+		new (&mSlots[target].mutable_value) mutable_type(std::forward<Args>(args)...);
+		if (mCtrl[target] == detail::kEmpty) {
+			--mGrowthLeft;
+		}
+		setCtrl(target, h2(mixed));
+		++mSize;
+		if (mSize == 1 || target < mFirstFull) {
+			mFirstFull = target;
+		}
+		return target;
+	}
+
+	template <typename Value, typename Allocator>
+	template <typename HashFn>
+	typename group_probing::table<Value, Allocator>::position
+		group_probing::table<Value, Allocator>::insert(size_t hash, const HashFn& hashOf, node& n)
+	{
+		position pos = emplace(hash, hashOf, std::move(n.mSlot.mutable_value));
+		n.reset();
+		return pos;
+	}
+
+	template <typename Value, typename Allocator>
+	typename group_probing::table<Value, Allocator>::node
+		group_probing::table<Value, Allocator>::extract(position pos)
+	{
+		node n(mAllocator, std::in_place, std::move(mSlots[pos].mutable_value));
+		erase(pos);
+		return n;
+	}
+
+	template <typename Value, typename Allocator>
+	typename group_probing::table<Value, Allocator>::position group_probing::table<Value, Allocator>::erase(position pos)
+	{
+		mSlots[pos].mutable_value.~mutable_type();
+		--mSize;
+
+		// If no group-wide window around this slot was ever completely full,
+		// no probe sequence can have passed over it, so it can go straight
+		// back to empty. Otherwise it must become a tombstone.
+		size_t before = (pos - group::kWidth) & mask();
+		uint32_t emptyAfter = group(mCtrl + pos).match_empty();
+		uint32_t emptyBefore = group(mCtrl + before).match_empty();
+		bool wasNeverFull = emptyBefore != 0 && emptyAfter != 0 &&
+			detail::count_trailing_zeros(emptyAfter) + detail::count_leading_zeros16(emptyBefore) < group::kWidth;
+
+		if (wasNeverFull) {
+			setCtrl(pos, detail::kEmpty);
+			++mGrowthLeft;
+		} else {
+			setCtrl(pos, detail::kDeleted);
+		}
+
+		size_t following = nextFull(pos + 1);
+		if (pos == mFirstFull) {
+			mFirstFull = following;
+		}
+		return following;
+	}
+
+	template <typename Value, typename Allocator>
+	void group_probing::table<Value, Allocator>::clear() noexcept
+	{
+		destroyAll();
+		if (mCapacity != 0) {
+			std::memset(mCtrl, static_cast<unsigned char>(detail::kEmpty), mCapacity + group::kWidth);
+		}
+		mSize = 0;
+		resetGrowthLeft();
+	}
+
+	template <typename Value, typename Allocator>
+	void group_probing::table<Value, Allocator>::swap(table& other) noexcept
+	{
+		using std::swap;
+
+		swap(mAllocator, other.mAllocator);
+		swap(mCtrl, other.mCtrl);
+		swap(mSlots, other.mSlots);
+		swap(mCapacity, other.mCapacity);
+		swap(mSize, other.mSize);
+		swap(mGrowthLeft, other.mGrowthLeft);
+		swap(mFirstFull, other.mFirstFull);
+		swap(mMaxLoadFactor, other.mMaxLoadFactor);
+	}
+
+	template <typename Value, typename Allocator>
+	size_t group_probing::table<Value, Allocator>::size() const
+	{
+		return mSize;
+	}
+
+	template <typename Value, typename Allocator>
+	size_t group_probing::table<Value, Allocator>::max_size() const
+	{
+		// The load factor limit keeps 1/8 of the slots empty.
+		return max_bucket_count() - max_bucket_count() / 8;
+	}
+
+	template <typename Value, typename Allocator>
+	size_t group_probing::table<Value, Allocator>::bucket_count() const
+	{
+		return mCapacity;
+	}
+
+	template <typename Value, typename Allocator>
+	size_t group_probing::table<Value, Allocator>::max_bucket_count() const
+	{
+		return std::allocator_traits<std::allocator<slot_type>>::max_size(std::allocator<slot_type>());
+	}
+
+	// An element lives in its own slot; a missing one would be inserted
+	// into the first free slot of its probe sequence.
+	template <typename Value, typename Allocator>
+	template <typename Pred>
+	size_t group_probing::table<Value, Allocator>::bucket(size_t hash, const Pred& equal) const
+	{
+		size_t pos = find(hash, equal);
+		if (pos != mCapacity) {
+			return pos;
+		}
+		return mCapacity == 0 ? 0 : findFirstNonFull(mix(hash));
+	}
+
+	template <typename Value, typename Allocator>
+	size_t group_probing::table<Value, Allocator>::bucket_size(size_t n) const
+	{
+		return mCtrl[n] >= 0 ? 1 : 0;
+	}
+
+	template <typename Value, typename Allocator>
+	typename group_probing::table<Value, Allocator>::local_iterator group_probing::table<Value, Allocator>::begin(size_t n)
+	{
+		return &mSlots[n].value;
+	}
+
+	template <typename Value, typename Allocator>
+	typename group_probing::table<Value, Allocator>::const_local_iterator group_probing::table<Value, Allocator>::begin(size_t n) const
+	{
+		return &mSlots[n].value;
+	}
+
+	template <typename Value, typename Allocator>
+	typename group_probing::table<Value, Allocator>::local_iterator group_probing::table<Value, Allocator>::end(size_t n)
+	{
+		return begin(n) + bucket_size(n);
+	}
+
+	template <typename Value, typename Allocator>
+	typename group_probing::table<Value, Allocator>::const_local_iterator group_probing::table<Value, Allocator>::end(size_t n) const
+	{
+		return begin(n) + bucket_size(n);
+	}
+
+	template <typename Value, typename Allocator>
+	float group_probing::table<Value, Allocator>::max_load_factor() const
+	{
+		return std::min(mMaxLoadFactor, 0.875f);
+	}
+
+	template <typename Value, typename Allocator>
+	void group_probing::table<Value, Allocator>::max_load_factor(float ml)
+	{
+		mMaxLoadFactor = ml;
+	}
+
+	template <typename Value, typename Allocator>
+	template <typename HashFn>
+	void group_probing::table<Value, Allocator>::rehash(size_t n, const HashFn& hashOf)
+	{
+		size_t newCapacity = normalizeCapacity(n);
+		while (growthLimit(newCapacity) < mSize) {
+			newCapacity *= 2;
+		}
+		resize(newCapacity, hashOf);
+	}
+
+	// Replay each element's probe sequence up to the group that holds it.
+	template <typename Value, typename Allocator>
+	template <typename HashFn>
+	util::probe_stats group_probing::table<Value, Allocator>::probe_stats(const HashFn& hashOf) const
+	{
+		util::probe_stats stats;
+		for (size_t i = nextFull(0); i < mCapacity; i = nextFull(i + 1)) {
+			size_t pos = h1(mix(hashOf(mSlots[i].value))) & mask();
+			size_t step = 0;
+			size_t groups = 0;
+			while (((i - pos) & mask()) >= group::kWidth) {
+				step += group::kWidth;
+				pos = (pos + step) & mask();
+				++groups;
+			}
+			detail::add_probe(stats, groups);
+		}
+		detail::finish_probe_stats(stats);
+		return stats;
+	}
+
+	// Partitions are a power of two of slots, and at least kMinPartition,
+	// so that few probe sequences cross into the next partition.
+	template <typename Value, typename Allocator>
+	size_t group_probing::table<Value, Allocator>::begin_partitions(size_t parts)
+	{
+		constexpr size_t kMinPartition = 4096;
+		size_t count = 1;
+		mPartitionSize = mCapacity;
+		while (count * 2 <= parts && mPartitionSize >= 2 * kMinPartition) {
+			mPartitionSize /= 2;
+			count *= 2;
+		}
+		return count;
+	}
+
+	template <typename Value, typename Allocator>
+	size_t group_probing::table<Value, Allocator>::partition_of(size_t hash) const
+	{
+		return (h1(mix(hash)) & mask()) / mPartitionSize;
+	}
+
+	// find() and emplace() in one probe, restricted to the groups that lie
+	// wholly inside the partition. The table never fills up during the
+	// build, and nothing is erased, so the first empty slot both ends the
+	// search and is where the element goes. setCtrl() may write the
+	// mirrored bytes past the end, but only groups that cross the end read
+	// them, and those lie in no partition.
+	template <typename Value, typename Allocator>
+	template <typename Pred, typename... Args>
+	std::pair<typename group_probing::table<Value, Allocator>::position, bool>
+		group_probing::table<Value, Allocator>::emplace_in_partition(size_t hash, const Pred& equal, Args&&... args)
+	{
+		size_t mixed = mix(hash);
+		ctrl_t tag = h2(mixed);
+		size_t pos = h1(mixed) & mask();
+		size_t low = pos / mPartitionSize * mPartitionSize;
+		size_t high = low + mPartitionSize;
+		size_t step = 0;
+		while (pos >= low && pos + group::kWidth <= high) {
+			group g(mCtrl + pos);
+			for (uint32_t match = g.match(tag); match != 0; match &= match - 1) {
+				size_t i = pos + detail::count_trailing_zeros(match);
+				if (equal(mSlots[i].value)) {
+					return std::make_pair(i, false);
+				}
+			}
+			uint32_t empty = g.match_empty();
+			if (empty != 0) {
+				size_t target = pos + detail::count_trailing_zeros(empty);
+				new (&mSlots[target].mutable_value) mutable_type(std::forward<Args>(args)...);
+				setCtrl(target, tag);
+				return std::make_pair(target, true);
+			}
+			step += group::kWidth;
+			pos = (pos + step) & mask();
+		}
+		return std::make_pair(mCapacity, false);
+	}
+
+	template <typename Value, typename Allocator>
+	void group_probing::table<Value, Allocator>::end_partitions(size_t added)
+	{
+		mSize += added;
+		resetGrowthLeft();
+		mFirstFull = nextFull(0);
+	}
+
+	template <typename Value, typename Allocator>
+	robin_hood::table<Value, Allocator>::table(size_t numBuckets, const Allocator& alloc)
+		: mAllocator(alloc)
+	{
+		allocate(normalizeCapacity(numBuckets));
+	}
+
+	template <typename Value, typename Allocator>
+	robin_hood::table<Value, Allocator>::table(const table& src)
+		: mAllocator(std::allocator_traits<Allocator>::select_on_container_copy_construction(src.mAllocator)),
+		mMaxLoadFactor(src.mMaxLoadFactor), mKicks(src.mKicks), mForcedGrowths(src.mForcedGrowths)
+	{
+		if (src.mCapacity == 0) {
+			return;
+		}
+		allocate(src.mCapacity);
+		// Same capacity, same slots: displacements stay valid.
+		try {
+			for (size_t i = src.nextFull(0); i < src.slotCount(); i = src.nextFull(i + 1)) {
+				new (&mSlots[i].mutable_value) mutable_type(src.mSlots[i].value);
+				mCtrl[i] = src.mCtrl[i];
+				++mSize;
+			}
+		} catch (...) {
+			destroyAll();
+			deallocate();
+			throw;
+		}
+		mFirstFull = src.mFirstFull;
+	}
+
+	// Steal the storage and leave the source as an empty table.
+	template <typename Value, typename Allocator>
+	robin_hood::table<Value, Allocator>::table(table&& src) noexcept
+		: mAllocator(src.mAllocator)
+	{
+		swap(src);
+	}
+
+	template <typename Value, typename Allocator>
+	Allocator robin_hood::table<Value, Allocator>::get_allocator() const
+	{
+		return mAllocator;
+	}
+
+	template <typename Value, typename Allocator>
+	robin_hood::table<Value, Allocator>::~table()
+	{
+		destroyAll();
+		deallocate();
+	}
+
+	template <typename Value, typename Allocator>
+	size_t robin_hood::table<Value, Allocator>::mix(size_t hash)
+	{
+		return static_cast<size_t>(detail::fmix64(static_cast<uint64_t>(hash)));
+	}
+
+	template <typename Value, typename Allocator>
+	size_t robin_hood::table<Value, Allocator>::mask() const
+	{
+		return mCapacity == 0 ? 0 : mCapacity - 1;
+	}
+
+	template <typename Value, typename Allocator>
+	size_t robin_hood::table<Value, Allocator>::slotCount() const
+	{
+		return mCapacity == 0 ? 0 : mCapacity + kMaxDisplacement;
+	}
+
+	template <typename Value, typename Allocator>
+	size_t robin_hood::table<Value, Allocator>::nextFull(size_t i) const
+	{
+		// The control bytes past the last slot are all kEmpty, so whole
+		// groups can be read up to the end.
+		size_t count = slotCount();
+		while (i < count) {
+			uint32_t full = group(mCtrl + i).match_full();
+			if (full != 0) {
+				return i + detail::count_trailing_zeros(full);
+			}
+			i += group::kWidth;
+		}
+		return count;
+	}
+
+	template <typename Value, typename Allocator>
+	void robin_hood::table<Value, Allocator>::allocate(size_t newCapacity)
+	{
+		size_t count = newCapacity + kMaxDisplacement;
+		CtrlAllocator ctrlAllocator(mAllocator);
+		SlotAllocator slotAllocator(mAllocator);
+		ctrl_t* ctrl = ctrlAllocator.allocate(count + group::kWidth);
+		try {
+			mSlots = slotAllocator.allocate(count);
+		} catch (...) {
+			ctrlAllocator.deallocate(ctrl, count + group::kWidth);
+			throw;
+		}
+		mCtrl = ctrl;
+		std::memset(mCtrl, static_cast<unsigned char>(detail::kEmpty), count + group::kWidth);
+		mCapacity = newCapacity;
+		mSize = 0;
+	}
+
+	template <typename Value, typename Allocator>
+	void robin_hood::table<Value, Allocator>::deallocate() noexcept
+	{
+		if (mCapacity != 0) {
+			CtrlAllocator(mAllocator).deallocate(mCtrl, slotCount() + group::kWidth);
+			SlotAllocator(mAllocator).deallocate(mSlots, slotCount());
+		}
+		mCtrl = detail::empty_group();
+		mSlots = nullptr;
+		mCapacity = 0;
+		mSize = 0;
+	}
+
+	template <typename Value, typename Allocator>
+	void robin_hood::table<Value, Allocator>::destroyAll() noexcept
+	{
+		for (size_t i = nextFull(0); i < slotCount(); i = nextFull(i + 1)) {
+			mSlots[i].mutable_value.~mutable_type();
+		}
+	}
+
+	template <typename Value, typename Allocator>
+	size_t robin_hood::table<Value, Allocator>::growthLimit(size_t capacity) const
+	{
+		return static_cast<size_t>(capacity * static_cast<double>(max_load_factor()));
+	}
+
+	template <typename Value, typename Allocator>
+	size_t robin_hood::table<Value, Allocator>::normalizeCapacity(size_t n)
+	{
+		size_t capacity = group::kWidth;
+		while (capacity + kMaxDisplacement < n) {
+			capacity *= 2;
+		}
+		return capacity;
+	}
+
+	template <typename Value, typename Allocator>
+	template <typename HashFn>
+	void robin_hood::table<Value, Allocator>::resize(size_t newCapacity, const HashFn& hashOf)
+	{
+		// Lay the new table out first, as a table of slot numbers, so that
+		// a throwing hash, an overflow or a failed allocation leaves every
+		// element where it is. In slot order, elements mostly arrive in
+		// order of their new home slots too, and little needs to be
+		// shifted.
+		std::vector<size_t> hashes(slotCount());
+		for (size_t i = nextFull(0); i < slotCount(); i = nextFull(i + 1)) {
+			hashes[i] = hashOf(mSlots[i].value);
+		}
+		detail::slot_hash slotHash{ hashes.data() };
+		table<size_t, std::allocator<size_t>> layout(newCapacity + kMaxDisplacement, std::allocator<size_t>());
+		layout.mMaxLoadFactor = mMaxLoadFactor;
+		for (size_t i = nextFull(0); i < slotCount(); i = nextFull(i + 1)) {
+			size_t slot = i;
+			layout.insertValue(mix(hashes[i]), slot, slotHash);
+		}
+
+		// Then copy or move the elements over. This table keeps its own
+		// until the swap, and newTable destroys them.
+		table newTable(layout.slotCount(), mAllocator);
+		newTable.mMaxLoadFactor = mMaxLoadFactor;
+		for (size_t i = layout.nextFull(0); i < layout.slotCount(); i = layout.nextFull(i + 1)) {
+			mutable_type& value = mSlots[layout.mSlots[i].value].mutable_value;
+			new (&newTable.mSlots[i].mutable_value) mutable_type(std::move_if_noexcept(value));
+			newTable.mCtrl[i] = layout.mCtrl[i];
+			++newTable.mSize;
+		}
+		newTable.mFirstFull = newTable.nextFull(0);
+		// Moving doesn't count as kicking.
+		newTable.mKicks = mKicks;
+		newTable.mForcedGrowths = mForcedGrowths + layout.mForcedGrowths;
+		swap(newTable);
+	}
+
+	template <typename Value, typename Allocator>
+	typename robin_hood::table<Value, Allocator>::position robin_hood::table<Value, Allocator>::first() const
+	{
+		return mSize == 0 ? slotCount() : mFirstFull;
+	}
+
+	template <typename Value, typename Allocator>
+	typename robin_hood::table<Value, Allocator>::position robin_hood::table<Value, Allocator>::end() const
+	{
+		return slotCount();
+	}
+
+	template <typename Value, typename Allocator>
+	void robin_hood::table<Value, Allocator>::next(position& pos) const
+	{
+		pos = nextFull(pos + 1);
+	}
+
+	template <typename Value, typename Allocator>
+	void robin_hood::table<Value, Allocator>::prev(position& pos) const
+	{
+		for (size_t i = pos; i-- > 0;) {
+			if (mCtrl[i] >= 0) {
+				pos = i;
+				return;
+			}
+		}
+		// This is an invalid decrement. Refer to the end position.
+		pos = slotCount();
+	}
+
+	template <typename Value, typename Allocator>
+	Value& robin_hood::table<Value, Allocator>::element(position pos) const
+	{
+		return mSlots[pos].value;
+	}
+
+	// A slot whose displacement equals the probe distance holds an element
+	// with the same home slot; only those need a real compare.
+	template <typename Value, typename Allocator>
+	template <typename Pred>
+	typename robin_hood::table<Value, Allocator>::position
+		robin_hood::table<Value, Allocator>::find(size_t hash, const Pred& equal) const
+	{
+		size_t pos = mix(hash) & mask();
+		for (ctrl_t distance = 0; mCtrl[pos] >= distance; ++pos, ++distance) {
+			if (mCtrl[pos] == distance && equal(mSlots[pos].value)) {
+				return pos;
+			}
+		}
+		return slotCount();
+	}
+
+	template <typename Value, typename Allocator>
+	void robin_hood::table<Value, Allocator>::prefetch(size_t hash) const
+	{
+		detail::prefetch(mCtrl + (mix(hash) & mask()));
+	}
+
+	template <typename Value, typename Allocator>
+	void robin_hood::table<Value, Allocator>::prefetch_element(size_t hash) const
+	{
+		detail::prefetch(mSlots + (mix(hash) & mask()));
+	}
+
+	template <typename Value, typename Allocator>
+	template <typename HashFn, typename... Args>
+	typename robin_hood::table<Value, Allocator>::position
+		robin_hood::table<Value, Allocator>::emplace(size_t hash, const HashFn& hashOf, Args&&... args)
+	{
+		// Build the element before anything is shifted, so that a throwing
+		// constructor leaves no gap in a probe sequence.
+		mutable_type value(std::forward<Args>(args)...);
+		return insertValue(mix(hash), value, hashOf);
+	}
+
+	template <typename Value, typename Allocator>
+	template <typename HashFn>
+	typename robin_hood::table<Value, Allocator>::position
+		robin_hood::table<Value, Allocator>::insert(size_t hash, const HashFn& hashOf, node& n)
+	{
+		position pos = insertValue(mix(hash), n.mSlot.mutable_value, hashOf);
+		n.reset();
+		return pos;
+	}
+
+	template <typename Value, typename Allocator>
+	template <typename HashFn>
+	size_t robin_hood::table<Value, Allocator>::insertValue(size_t mixed, mutable_type& value, const HashFn& hashOf)
+	{
+		if (mSize >= growthLimit(mCapacity)) {
+			size_t newCapacity = mCapacity == 0 ? group::kWidth : mCapacity * 2;
+			while (growthLimit(newCapacity) <= mSize) {
+				newCapacity *= 2;
+			}
+			resize(newCapacity, hashOf);
+		}
+		while (true) {
+			size_t pos = place(mixed, value);
+			if (pos != slotCount()) {
+				return pos;
+			}
+			// A well-spread hash reaches the displacement limit only in a
+			// crowded table; in a mostly empty one, growing won't help.
+			if (mSize < mCapacity / 8) {
+				throw std::overflow_error("robin_hood: too many elements with the same hash");
+			}
+			++mForcedGrowths;
+			resize(mCapacity * 2, hashOf);
+		}
+	}
+
+	template <typename Value, typename Allocator>
+	size_t robin_hood::table<Value, Allocator>::place(size_t mixed, mutable_type& value)
+	{
+		// Skip the elements that are at least as far from home as the new
+		// one would be.
+		size_t pos = mixed & mask();
+		ctrl_t distance = 0;
+		while (mCtrl[pos] >= distance) {
+			++pos;
+			++distance;
+		}
+		if (distance >= static_cast<ctrl_t>(kMaxDisplacement)) {
+			return slotCount();
+		}
+
+		// The new element takes pos, and the run of elements from pos to
+		// the next empty slot moves up by one.
+		size_t last = pos;
+		for (; mCtrl[last] != detail::kEmpty; ++last) {
+			if (mCtrl[last] + 1 >= static_cast<ctrl_t>(kMaxDisplacement)) {
+				return slotCount();
+			}
+		}
+		if (last >= slotCount()) {
+			return slotCount();
+		}
+		for (size_t i = last; i > pos; --i) {
+			new (&mSlots[i].mutable_value) mutable_type(std::move(mSlots[i - 1].mutable_value));
+			mSlots[i - 1].mutable_value.~mutable_type();
+			mCtrl[i] = static_cast<ctrl_t>(mCtrl[i - 1] + 1);
+		}
+		mKicks += last - pos;
+
+		new (&mSlots[pos].mutable_value) mutable_type(std::move(value));
+		mCtrl[pos] = distance;
+		++mSize;
+		if (mSize == 1 || pos < mFirstFull) {
+			mFirstFull = pos;
+		}
+		return pos;
+	}
+
+	template <typename Value, typename Allocator>
+	typename robin_hood::table<Value, Allocator>::node
+		robin_hood::table<Value, Allocator>::extract(position pos)
+	{
+		node n(mAllocator, std::in_place, std::move(mSlots[pos].mutable_value));
+		erase(pos);
+		return n;
+	}
+
+	template <typename Value, typename Allocator>
+	typename robin_hood::table<Value, Allocator>::position robin_hood::table<Value, Allocator>::erase(position pos)
+	{
+		mSlots[pos].mutable_value.~mutable_type();
+		--mSize;
+
+		// Pull the run after pos back by one. The kEmpty bytes past the
+		// last slot end it at the latest.
+		size_t i = pos;
+		for (; mCtrl[i + 1] > 0; ++i) {
+			new (&mSlots[i].mutable_value) mutable_type(std::move(mSlots[i + 1].mutable_value));
+			mSlots[i + 1].mutable_value.~mutable_type();
+			mCtrl[i] = static_cast<ctrl_t>(mCtrl[i + 1] - 1);
+		}
+		mCtrl[i] = detail::kEmpty;
+
+		size_t following = mCtrl[pos] >= 0 ? pos : nextFull(pos + 1);
+		if (pos == mFirstFull) {
+			mFirstFull = following;
+		}
+		return following;
+	}
+
+	template <typename Value, typename Allocator>
+	void robin_hood::table<Value, Allocator>::clear() noexcept
+	{
+		destroyAll();
+		if (mCapacity != 0) {
+			std::memset(mCtrl, static_cast<unsigned char>(detail::kEmpty), slotCount() + group::kWidth);
+		}
+		mSize = 0;
+	}
+
+	template <typename Value, typename Allocator>
+	void robin_hood::table<Value, Allocator>::swap(table& other) noexcept
+	{
+		using std::swap;
+
+		swap(mAllocator, other.mAllocator);
+		swap(mCtrl, other.mCtrl);
+		swap(mSlots, other.mSlots);
+		swap(mCapacity, other.mCapacity);
+		swap(mSize, other.mSize);
+		swap(mFirstFull, other.mFirstFull);
+		swap(mMaxLoadFactor, other.mMaxLoadFactor);
+		swap(mKicks, other.mKicks);
+		swap(mForcedGrowths, other.mForcedGrowths);
+	}
+
+	template <typename Value, typename Allocator>
+	size_t robin_hood::table<Value, Allocator>::size() const
+	{
+		return mSize;
+	}
+
+	template <typename Value, typename Allocator>
+	size_t robin_hood::table<Value, Allocator>::max_size() const
+	{
+		return static_cast<size_t>(max_bucket_count() * 0.95);
+	}
+
+	template <typename Value, typename Allocator>
+	size_t robin_hood::table<Value, Allocator>::bucket_count() const
+	{
+		return slotCount();
+	}
+
+	template <typename Value, typename Allocator>
+	size_t robin_hood::table<Value, Allocator>::max_bucket_count() const
+	{
+		return std::allocator_traits<std::allocator<slot_type>>::max_size(std::allocator<slot_type>());
+	}
+
+	// An element lives in its own slot; a missing one belongs to its home
+	// slot.
+	template <typename Value, typename Allocator>
+	template <typename Pred>
+	size_t robin_hood::table<Value, Allocator>::bucket(size_t hash, const Pred& equal) const
+	{
+		size_t pos = find(hash, equal);
+		return pos != slotCount() ? pos : mix(hash) & mask();
+	}
+
+	template <typename Value, typename Allocator>
+	size_t robin_hood::table<Value, Allocator>::bucket_size(size_t n) const
+	{
+		return mCtrl[n] >= 0 ? 1 : 0;
+	}
+
+	template <typename Value, typename Allocator>
+	typename robin_hood::table<Value, Allocator>::local_iterator robin_hood::table<Value, Allocator>::begin(size_t n)
+	{
+		return &mSlots[n].value;
+	}
+
+	template <typename Value, typename Allocator>
+	typename robin_hood::table<Value, Allocator>::const_local_iterator robin_hood::table<Value, Allocator>::begin(size_t n) const
+	{
+		return &mSlots[n].value;
+	}
+
+	template <typename Value, typename Allocator>
+	typename robin_hood::table<Value, Allocator>::local_iterator robin_hood::table<Value, Allocator>::end(size_t n)
+	{
+		return begin(n) + bucket_size(n);
+	}
+
+	template <typename Value, typename Allocator>
+	typename robin_hood::table<Value, Allocator>::const_local_iterator robin_hood::table<Value, Allocator>::end(size_t n) const
+	{
+		return begin(n) + bucket_size(n);
+	}
+
+	template <typename Value, typename Allocator>
+	float robin_hood::table<Value, Allocator>::max_load_factor() const
+	{
+		return std::min(mMaxLoadFactor, 0.95f);
+	}
+
+	template <typename Value, typename Allocator>
+	void robin_hood::table<Value, Allocator>::max_load_factor(float ml)
+	{
+		mMaxLoadFactor = ml;
+	}
+
+	template <typename Value, typename Allocator>
+	template <typename HashFn>
+	void robin_hood::table<Value, Allocator>::rehash(size_t n, const HashFn& hashOf)
+	{
+		// n counts home slots, as in the other tables, so that reserve()
+		// makes room for its elements before the overflow area is counted.
+		size_t newCapacity = normalizeCapacity(n);
+		while (newCapacity < n || growthLimit(newCapacity) < mSize) {
+			newCapacity *= 2;
+		}
+		resize(newCapacity, hashOf);
+	}
+
+	template <typename Value, typename Allocator>
+	template <typename HashFn>
+	util::probe_stats robin_hood::table<Value, Allocator>::probe_stats(const HashFn& /*hashOf*/) const
+	{
+		util::probe_stats stats;
+		for (size_t i = nextFull(0); i < slotCount(); i = nextFull(i + 1)) {
+			detail::add_probe(stats, static_cast<size_t>(mCtrl[i]));
+		}
+		detail::finish_probe_stats(stats);
+		stats.kicks = mKicks;
+		stats.forced_growths = mForcedGrowths;
+		return stats;
+	}
+
+	template <typename Value, typename Allocator>
+	cuckoo::table<Value, Allocator>::table(size_t numBuckets, const Allocator& alloc)
+		: mAllocator(alloc)
+	{
+		allocate(normalizeBucketCount(numBuckets));
+	}
+
+	template <typename Value, typename Allocator>
+	cuckoo::table<Value, Allocator>::table(const table& src)
+		: mAllocator(std::allocator_traits<Allocator>::select_on_container_copy_construction(src.mAllocator)),
+		mMaxLoadFactor(src.mMaxLoadFactor), mKicks(src.mKicks), mForcedGrowths(src.mForcedGrowths)
+	{
+		if (src.mBucketCount == 0) {
+			return;
+		}
+		allocate(src.mBucketCount);
+		try {
+			for (size_t i = src.nextFull(0); i < src.slotCount(); i = src.nextFull(i + 1)) {
+				new (&mSlots[i].mutable_value) mutable_type(src.mSlots[i].value);
+				mCtrl[i] = src.mCtrl[i];
+				++mSize;
 			}
-			// No more non-empty buckets. This is an invalid decrement.
-			// Set mListIterator to refer to the end iterator of the last list.
-			mBucketIndex = buckets.size() - 1;
-			mListIterator = end(buckets[mBucketIndex]);
-		} else {
-			// We're not at the beginning of the bucket, so just move down.
-			--mListIterator;
+		} catch (...) {
+			destroyAll();
+			deallocate();
+			throw;
+		}
+		mFirstFull = src.mFirstFull;
+	}
+
+	// Steal the storage and leave the source as an empty table.
+	template <typename Value, typename Allocator>
+	cuckoo::table<Value, Allocator>::table(table&& src) noexcept
+		: mAllocator(src.mAllocator)
+	{
+		swap(src);
+	}
+
+	template <typename Value, typename Allocator>
+	Allocator cuckoo::table<Value, Allocator>::get_allocator() const
+	{
+		return mAllocator;
+	}
+
+	template <typename Value, typename Allocator>
+	cuckoo::table<Value, Allocator>::~table()
+	{
+		destroyAll();
+		deallocate();
+	}
+
+	template <typename Value, typename Allocator>
+	size_t cuckoo::table<Value, Allocator>::mix(size_t hash)
+	{
+		return static_cast<size_t>(detail::fmix64(static_cast<uint64_t>(hash)));
+	}
+
+	template <typename Value, typename Allocator>
+	detail::ctrl_t cuckoo::table<Value, Allocator>::tag(size_t mixed)
+	{
+		return static_cast<ctrl_t>(mixed & 0x7f);
+	}
+
+	template <typename Value, typename Allocator>
+	size_t cuckoo::table<Value, Allocator>::homeBucket(size_t mixed) const
+	{
+		return mBucketCount == 0 ? 0 : (mixed >> 7) & (mBucketCount - 1);
+	}
+
+	// The offset is odd-multiplied from the tag, so different tags lead to
+	// well spread alternates. With a single bucket, both are the same.
+	template <typename Value, typename Allocator>
+	size_t cuckoo::table<Value, Allocator>::alternateBucket(size_t bucket, ctrl_t tag) const
+	{
+		uint64_t offset = (static_cast<uint64_t>(tag) + 1) * 0xc6a4a7935bd1e995ULL;
+		return mBucketCount == 0 ? 0 : (bucket ^ static_cast<size_t>(offset)) & (mBucketCount - 1);
+	}
+
+	template <typename Value, typename Allocator>
+	size_t cuckoo::table<Value, Allocator>::slotCount() const
+	{
+		return mBucketCount * kSlotsPerBucket;
+	}
+
+	template <typename Value, typename Allocator>
+	size_t cuckoo::table<Value, Allocator>::freeSlot(size_t b) const
+	{
+		for (size_t i = b * kSlotsPerBucket; i < (b + 1) * kSlotsPerBucket; ++i) {
+			if (mCtrl[i] == detail::kEmpty) {
+				return i;
+			}
+		}
+		return slotCount();
+	}
+
+	template <typename Value, typename Allocator>
+	size_t cuckoo::table<Value, Allocator>::nextFull(size_t i) const
+	{
+		// The control bytes past the last slot are all kEmpty, so whole
+		// groups can be read up to the end.
+		size_t count = slotCount();
+		while (i < count) {
+			uint32_t full = group(mCtrl + i).match_full();
+			if (full != 0) {
+				return i + detail::count_trailing_zeros(full);
+			}
+			i += group::kWidth;
+		}
+		return count;
+	}
+
+	template <typename Value, typename Allocator>
+	void cuckoo::table<Value, Allocator>::moveSlot(size_t from, size_t to)
+	{
+		new (&mSlots[to].mutable_value) mutable_type(std::move(mSlots[from].mutable_value));
+		mSlots[from].mutable_value.~mutable_type();
+		mCtrl[to] = mCtrl[from];
+		mCtrl[from] = detail::kEmpty;
+		++mKicks;
+	}
+
+	template <typename Value, typename Allocator>
+	void cuckoo::table<Value, Allocator>::allocate(size_t newBucketCount)
+	{
+		size_t count = newBucketCount * kSlotsPerBucket;
+		CtrlAllocator ctrlAllocator(mAllocator);
+		SlotAllocator slotAllocator(mAllocator);
+		ctrl_t* ctrl = ctrlAllocator.allocate(count + group::kWidth);
+		try {
+			mSlots = slotAllocator.allocate(count);
+		} catch (...) {
+			ctrlAllocator.deallocate(ctrl, count + group::kWidth);
+			throw;
+		}
+		mCtrl = ctrl;
+		std::memset(mCtrl, static_cast<unsigned char>(detail::kEmpty), count + group::kWidth);
+		mBucketCount = newBucketCount;
+		mSize = 0;
+	}
+
+	template <typename Value, typename Allocator>
+	void cuckoo::table<Value, Allocator>::deallocate() noexcept
+	{
+		if (mBucketCount != 0) {
+			CtrlAllocator(mAllocator).deallocate(mCtrl, slotCount() + group::kWidth);
+			SlotAllocator(mAllocator).deallocate(mSlots, slotCount());
+		}
+		mCtrl = detail::empty_group();
+		mSlots = nullptr;
+		mBucketCount = 0;
+		mSize = 0;
+	}
+
+	template <typename Value, typename Allocator>
+	void cuckoo::table<Value, Allocator>::destroyAll() noexcept
+	{
+		for (size_t i = nextFull(0); i < slotCount(); i = nextFull(i + 1)) {
+			mSlots[i].mutable_value.~mutable_type();
+		}
+	}
+
+	template <typename Value, typename Allocator>
+	size_t cuckoo::table<Value, Allocator>::growthLimit(size_t slots) const
+	{
+		return static_cast<size_t>(slots * static_cast<double>(max_load_factor()));
+	}
+
+	template <typename Value, typename Allocator>
+	size_t cuckoo::table<Value, Allocator>::normalizeBucketCount(size_t n)
+	{
+		size_t buckets = group::kWidth / kSlotsPerBucket;
+		while (buckets * kSlotsPerBucket < n) {
+			buckets *= 2;
+		}
+		return buckets;
+	}
+
+	template <typename Value, typename Allocator>
+	template <typename HashFn>
+	void cuckoo::table<Value, Allocator>::resize(size_t newBucketCount, const HashFn& hashOf)
+	{
+		// As in robin_hood, lay the new table out as a table of slot
+		// numbers before touching any element.
+		std::vector<size_t> hashes(slotCount());
+		for (size_t i = nextFull(0); i < slotCount(); i = nextFull(i + 1)) {
+			hashes[i] = hashOf(mSlots[i].value);
+		}
+		detail::slot_hash slotHash{ hashes.data() };
+		table<size_t, std::allocator<size_t>> layout(newBucketCount * kSlotsPerBucket, std::allocator<size_t>());
+		layout.mMaxLoadFactor = mMaxLoadFactor;
+		for (size_t i = nextFull(0); i < slotCount(); i = nextFull(i + 1)) {
+			size_t mixed = mix(hashes[i]);
+			size_t target = layout.makeRoom(mixed, slotHash);
+			new (&layout.mSlots[target].mutable_value) size_t(i);
+			layout.mCtrl[target] = tag(mixed);
+			++layout.mSize;
+		}
+
+		table newTable(layout.slotCount(), mAllocator);
+		newTable.mMaxLoadFactor = mMaxLoadFactor;
+		for (size_t i = layout.nextFull(0); i < layout.slotCount(); i = layout.nextFull(i + 1)) {
+			mutable_type& value = mSlots[layout.mSlots[i].value].mutable_value;
+			new (&newTable.mSlots[i].mutable_value) mutable_type(std::move_if_noexcept(value));
+			newTable.mCtrl[i] = layout.mCtrl[i];
+			++newTable.mSize;
+		}
+		newTable.mFirstFull = newTable.nextFull(0);
+		// Moving doesn't count as kicking.
+		newTable.mKicks = mKicks;
+		newTable.mForcedGrowths = mForcedGrowths + layout.mForcedGrowths;
+		swap(newTable);
+	}
+
+	template <typename Value, typename Allocator>
+	typename cuckoo::table<Value, Allocator>::position cuckoo::table<Value, Allocator>::first() const
+	{
+		return mSize == 0 ? slotCount() : mFirstFull;
+	}
+
+	template <typename Value, typename Allocator>
+	typename cuckoo::table<Value, Allocator>::position cuckoo::table<Value, Allocator>::end() const
+	{
+		return slotCount();
+	}
+
+	template <typename Value, typename Allocator>
+	void cuckoo::table<Value, Allocator>::next(position& pos) const
+	{
+		pos = nextFull(pos + 1);
+	}
+
+	template <typename Value, typename Allocator>
+	void cuckoo::table<Value, Allocator>::prev(position& pos) const
+	{
+		for (size_t i = pos; i-- > 0;) {
+			if (mCtrl[i] >= 0) {
+				pos = i;
+				return;
+			}
+		}
+		// This is an invalid decrement. Refer to the end position.
+		pos = slotCount();
+	}
+
+	template <typename Value, typename Allocator>
+	Value& cuckoo::table<Value, Allocator>::element(position pos) const
+	{
+		return mSlots[pos].value;
+	}
+
+	template <typename Value, typename Allocator>
+	template <typename Pred>
+	typename cuckoo::table<Value, Allocator>::position
+		cuckoo::table<Value, Allocator>::find(size_t hash, const Pred& equal) const
+	{
+		size_t mixed = mix(hash);
+		ctrl_t t = tag(mixed);
+		size_t home = homeBucket(mixed);
+		for (size_t b : { home, alternateBucket(home, t) }) {
+			for (size_t i = b * kSlotsPerBucket; i < (b + 1) * kSlotsPerBucket; ++i) {
+				if (mCtrl[i] == t && equal(mSlots[i].value)) {
+					return i;
+				}
+			}
+		}
+		return slotCount();
+	}
+
+	template <typename Value, typename Allocator>
+	void cuckoo::table<Value, Allocator>::prefetch(size_t hash) const
+	{
+		size_t mixed = mix(hash);
+		size_t home = homeBucket(mixed);
+		detail::prefetch(mCtrl + home * kSlotsPerBucket);
+		detail::prefetch(mCtrl + alternateBucket(home, tag(mixed)) * kSlotsPerBucket);
+	}
+
+	template <typename Value, typename Allocator>
+	void cuckoo::table<Value, Allocator>::prefetch_element(size_t hash) const
+	{
+		size_t mixed = mix(hash);
+		ctrl_t t = tag(mixed);
+		size_t home = homeBucket(mixed);
+		for (size_t b : { home, alternateBucket(home, t) }) {
+			for (size_t i = b * kSlotsPerBucket; i < (b + 1) * kSlotsPerBucket; ++i) {
+				if (mCtrl[i] == t) {
+					detail::prefetch(&mSlots[i]);
+					return;
+				}
+			}
+		}
+	}
+
+	template <typename Value, typename Allocator>
+	template <typename HashFn, typename... Args>
+	typename cuckoo::table<Value, Allocator>::position
+		cuckoo::table<Value, Allocator>::emplace(size_t hash, const HashFn& hashOf, Args&&... args)
+	{
+		size_t mixed = mix(hash);
+		size_t target = makeRoom(mixed, hashOf);
+		// Kicks only move elements between their own buckets, so if the
+		// constructor throws, the table is still intact.
+		new (&mSlots[target].mutable_value) mutable_type(std::forward<Args>(args)...);
+		mCtrl[target] = tag(mixed);
+		++mSize;
+		if (mSize == 1 || target < mFirstFull) {
+			mFirstFull = target;
+		}
+		return target;
+	}
+
+	template <typename Value, typename Allocator>
+	template <typename HashFn>
+	typename cuckoo::table<Value, Allocator>::position
+		cuckoo::table<Value, Allocator>::insert(size_t hash, const HashFn& hashOf, node& n)
+	{
+		position pos = emplace(hash, hashOf, std::move(n.mSlot.mutable_value));
+		n.reset();
+		return pos;
+	}
+
+	template <typename Value, typename Allocator>
+	template <typename HashFn>
+	size_t cuckoo::table<Value, Allocator>::makeRoom(size_t mixed, const HashFn& hashOf)
+	{
+		if (mSize >= growthLimit(slotCount())) {
+			size_t newBucketCount = mBucketCount == 0 ? group::kWidth / kSlotsPerBucket : mBucketCount * 2;
+			while (growthLimit(newBucketCount * kSlotsPerBucket) <= mSize) {
+				newBucketCount *= 2;
+			}
+			resize(newBucketCount, hashOf);
+		}
+		while (true) {
+			size_t target = kickToFree(mixed);
+			if (target != slotCount()) {
+				return target;
+			}
+			// A well-spread hash only runs out of kicks in a crowded table;
+			// in a mostly empty one, growing won't help.
+			if (mSize < slotCount() / 8) {
+				throw std::overflow_error("cuckoo: too many elements with the same hash");
+			}
+			++mForcedGrowths;
+			resize(mBucketCount * 2, hashOf);
+		}
+	}
+
+	template <typename Value, typename Allocator>
+	size_t cuckoo::table<Value, Allocator>::kickToFree(size_t mixed)
+	{
+		size_t home = homeBucket(mixed);
+		size_t alternate = alternateBucket(home, tag(mixed));
+		size_t target = freeSlot(home);
+		if (target == slotCount()) {
+			target = freeSlot(alternate);
 		}
+		if (target != slotCount()) {
+			return target;
+		}
+
+		// Breadth-first search over buckets. Entry k says that the element
+		// in slot mSlot of entry mParent's bucket could move to bucket
+		// mBucket. The roots are the two buckets of the new element.
+		struct entry
+		{
+			size_t mBucket;
+			size_t mParent;
+			size_t mSlot;
+		};
+		constexpr size_t kNone = static_cast<size_t>(-1);
+		entry queue[kMaxSearch];
+		size_t count = 0;
+		queue[count++] = { home, kNone, kNone };
+		if (alternate != home) {
+			queue[count++] = { alternate, kNone, kNone };
+		}
+
+		for (size_t head = 0; head < count; ++head) {
+			size_t bucket = queue[head].mBucket;
+			for (size_t slot = bucket * kSlotsPerBucket; slot < (bucket + 1) * kSlotsPerBucket; ++slot) {
+				size_t next = alternateBucket(bucket, mCtrl[slot]);
+				// Moves along the path must be between distinct buckets.
+				bool onPath = false;
+				for (size_t k = head; k != kNone && !onPath; k = queue[k].mParent) {
+					onPath = queue[k].mBucket == next;
+				}
+				if (onPath) {
+					continue;
+				}
+
+				size_t free = freeSlot(next);
+				if (free != slotCount()) {
+					// Carry out the chain from its end, so that every move
+					// goes into a slot that was just vacated.
+					moveSlot(slot, free);
+					size_t vacated = slot;
+					for (size_t k = head; queue[k].mParent != kNone; k = queue[k].mParent) {
+						moveSlot(queue[k].mSlot, vacated);
+						vacated = queue[k].mSlot;
+					}
+					if (free < mFirstFull) {
+						mFirstFull = free;
+					}
+					return vacated;
+				}
+				if (count < kMaxSearch) {
+					queue[count++] = { next, head, slot };
+				}
+			}
+		}
+		return slotCount();
+	}
+
+	template <typename Value, typename Allocator>
+	typename cuckoo::table<Value, Allocator>::node
+		cuckoo::table<Value, Allocator>::extract(position pos)
+	{
+		node n(mAllocator, std::in_place, std::move(mSlots[pos].mutable_value));
+		erase(pos);
+		return n;
+	}
+
+	template <typename Value, typename Allocator>
+	typename cuckoo::table<Value, Allocator>::position cuckoo::table<Value, Allocator>::erase(position pos)
+	{
+		mSlots[pos].mutable_value.~mutable_type();
+		mCtrl[pos] = detail::kEmpty;
+		--mSize;
+
+		size_t following = nextFull(pos + 1);
+		if (pos == mFirstFull) {
+			mFirstFull = following;
+		}
+		return following;
+	}
+
+	template <typename Value, typename Allocator>
+	void cuckoo::table<Value, Allocator>::clear() noexcept
+	{
+		destroyAll();
+		if (mBucketCount != 0) {
+			std::memset(mCtrl, static_cast<unsigned char>(detail::kEmpty), slotCount() + group::kWidth);
+		}
+		mSize = 0;
+	}
+
+	template <typename Value, typename Allocator>
+	void cuckoo::table<Value, Allocator>::swap(table& other) noexcept
+	{
+		using std::swap;
+
+		swap(mAllocator, other.mAllocator);
+		swap(mCtrl, other.mCtrl);
+		swap(mSlots, other.mSlots);
+		swap(mBucketCount, other.mBucketCount);
+		swap(mSize, other.mSize);
+		swap(mFirstFull, other.mFirstFull);
+		swap(mMaxLoadFactor, other.mMaxLoadFactor);
+		swap(mKicks, other.mKicks);
+		swap(mForcedGrowths, other.mForcedGrowths);
+	}
+
+	template <typename Value, typename Allocator>
+	size_t cuckoo::table<Value, Allocator>::size() const
+	{
+		return mSize;
+	}
+
+	template <typename Value, typename Allocator>
+	size_t cuckoo::table<Value, Allocator>::max_size() const
+	{
+		return static_cast<size_t>(max_bucket_count() * 0.95);
+	}
+
+	template <typename Value, typename Allocator>
+	size_t cuckoo::table<Value, Allocator>::bucket_count() const
+	{
+		return slotCount();
+	}
+
+	template <typename Value, typename Allocator>
+	size_t cuckoo::table<Value, Allocator>::max_bucket_count() const
+	{
+		return std::allocator_traits<std::allocator<slot_type>>::max_size(std::allocator<slot_type>());
+	}
+
+	// An element lives in its own slot; a missing one belongs to the first
+	// slot of its home bucket.
+	template <typename Value, typename Allocator>
+	template <typename Pred>
+	size_t cuckoo::table<Value, Allocator>::bucket(size_t hash, const Pred& equal) const
+	{
+		size_t pos = find(hash, equal);
+		return pos != slotCount() ? pos : homeBucket(mix(hash)) * kSlotsPerBucket;
+	}
+
+	template <typename Value, typename Allocator>
+	size_t cuckoo::table<Value, Allocator>::bucket_size(size_t n) const
+	{
+		return mCtrl[n] >= 0 ? 1 : 0;
+	}
+
+	template <typename Value, typename Allocator>
+	typename cuckoo::table<Value, Allocator>::local_iterator cuckoo::table<Value, Allocator>::begin(size_t n)
+	{
+		return &mSlots[n].value;
+	}
+
+	template <typename Value, typename Allocator>
+	typename cuckoo::table<Value, Allocator>::const_local_iterator cuckoo::table<Value, Allocator>::begin(size_t n) const
+	{
+		return &mSlots[n].value;
+	}
+
+	template <typename Value, typename Allocator>
+	typename cuckoo::table<Value, Allocator>::local_iterator cuckoo::table<Value, Allocator>::end(size_t n)
+	{
+		return begin(n) + bucket_size(n);
+	}
+
+	template <typename Value, typename Allocator>
+	typename cuckoo::table<Value, Allocator>::const_local_iterator cuckoo::table<Value, Allocator>::end(size_t n) const
+	{
+		return begin(n) + bucket_size(n);
+	}
+
+	template <typename Value, typename Allocator>
+	float cuckoo::table<Value, Allocator>::max_load_factor() const
+	{
+		return std::min(mMaxLoadFactor, 0.95f);
+	}
+
+	template <typename Value, typename Allocator>
+	void cuckoo::table<Value, Allocator>::max_load_factor(float ml)
+	{
+		mMaxLoadFactor = ml;
+	}
+
+	template <typename Value, typename Allocator>
+	template <typename HashFn>
+	void cuckoo::table<Value, Allocator>::rehash(size_t n, const HashFn& hashOf)
+	{
+		size_t newBucketCount = normalizeBucketCount(n);
+		while (growthLimit(newBucketCount * kSlotsPerBucket) < mSize) {
+			newBucketCount *= 2;
+		}
+		resize(newBucketCount, hashOf);
+	}
+
+	template <typename Value, typename Allocator>
+	template <typename HashFn>
+	util::probe_stats cuckoo::table<Value, Allocator>::probe_stats(const HashFn& hashOf) const
+	{
+		util::probe_stats stats;
+		for (size_t i = nextFull(0); i < slotCount(); i = nextFull(i + 1)) {
+			size_t home = homeBucket(mix(hashOf(mSlots[i].value)));
+			detail::add_probe(stats, i / kSlotsPerBucket == home ? 0 : 1);
+		}
+		detail::finish_probe_stats(stats);
+		stats.kicks = mKicks;
+		stats.forced_growths = mForcedGrowths;
+		return stats;
+	}
+
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	cached_hash<Policy>::table<Value, Allocator>::table(size_t numBuckets, const Allocator& alloc)
+		: mTable(numBuckets, EntryAllocator(alloc))
+	{
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	Allocator cached_hash<Policy>::table<Value, Allocator>::get_allocator() const
+	{
+		return Allocator(mTable.get_allocator());
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	typename cached_hash<Policy>::template table<Value, Allocator>::position cached_hash<Policy>::table<Value, Allocator>::first() const
+	{
+		return mTable.first();
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	typename cached_hash<Policy>::template table<Value, Allocator>::position cached_hash<Policy>::table<Value, Allocator>::end() const
+	{
+		return mTable.end();
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	void cached_hash<Policy>::table<Value, Allocator>::next(position& pos) const
+	{
+		mTable.next(pos);
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	void cached_hash<Policy>::table<Value, Allocator>::prev(position& pos) const
+	{
+		mTable.prev(pos);
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	Value& cached_hash<Policy>::table<Value, Allocator>::element(const position& pos) const
+	{
+		return mTable.element(pos).value;
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	template <typename Pred>
+	typename cached_hash<Policy>::template table<Value, Allocator>::position
+		cached_hash<Policy>::table<Value, Allocator>::find(size_t hash, const Pred& equal) const
+	{
+		return mTable.find(hash, [hash, &equal](const entry_type& entry) {
+			return entry.hash == hash && equal(entry.value);
+		});
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	void cached_hash<Policy>::table<Value, Allocator>::prefetch(size_t hash) const
+	{
+		mTable.prefetch(hash);
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	void cached_hash<Policy>::table<Value, Allocator>::prefetch_element(size_t hash) const
+	{
+		mTable.prefetch_element(hash);
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	template <typename HashFn, typename... Args>
+	typename cached_hash<Policy>::template table<Value, Allocator>::position
+		cached_hash<Policy>::table<Value, Allocator>::emplace(size_t hash, const HashFn& /*hashOf*/, Args&&... args)
+	{
+		return mTable.emplace(hash, stored_hash(), hash, std::forward<Args>(args)...);
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	template <typename HashFn>
+	typename cached_hash<Policy>::template table<Value, Allocator>::position
+		cached_hash<Policy>::table<Value, Allocator>::insert(size_t hash, const HashFn& /*hashOf*/, node& n)
+	{
+		n.mNode.value().hash = hash;
+		return mTable.insert(hash, stored_hash(), n.mNode);
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	template <typename Pred, typename HashFn, typename... Args>
+	typename cached_hash<Policy>::template table<Value, Allocator>::position
+		cached_hash<Policy>::table<Value, Allocator>::emplace_equal(size_t hash, const Pred& equal,
+			const HashFn& /*hashOf*/, Args&&... args)
+	{
+		return mTable.emplace_equal(hash, [hash, &equal](const entry_type& entry) {
+			return entry.hash == hash && equal(entry.value);
+		}, stored_hash(), hash, std::forward<Args>(args)...);
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	template <typename Pred, typename HashFn>
+	typename cached_hash<Policy>::template table<Value, Allocator>::position
+		cached_hash<Policy>::table<Value, Allocator>::insert_equal(size_t hash, const Pred& equal,
+			const HashFn& /*hashOf*/, node& n)
+	{
+		n.mNode.value().hash = hash;
+		return mTable.insert_equal(hash, [hash, &equal](const entry_type& entry) {
+			return entry.hash == hash && equal(entry.value);
+		}, stored_hash(), n.mNode);
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	typename cached_hash<Policy>::template table<Value, Allocator>::node cached_hash<Policy>::table<Value, Allocator>::extract(const position& pos)
+	{
+		return node(mTable.extract(pos));
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	typename cached_hash<Policy>::template table<Value, Allocator>::position cached_hash<Policy>::table<Value, Allocator>::erase(const position& pos)
+	{
+		return mTable.erase(pos);
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	void cached_hash<Policy>::table<Value, Allocator>::clear() noexcept
+	{
+		mTable.clear();
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	void cached_hash<Policy>::table<Value, Allocator>::swap(table& other) noexcept
+	{
+		mTable.swap(other.mTable);
 	}
 
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	size_t cached_hash<Policy>::table<Value, Allocator>::size() const
+	{
+		return mTable.size();
+	}
 
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	size_t cached_hash<Policy>::table<Value, Allocator>::max_size() const
+	{
+		return mTable.max_size();
+	}
 
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	size_t cached_hash<Policy>::table<Value, Allocator>::bucket_count() const
+	{
+		return mTable.bucket_count();
+	}
 
-	template<typename HashMap>
-	hash_map_iterator<HashMap>::hash_map_iterator(size_t bucket, list_iterator_type listIt, HashMap* hashmap)
-		: const_hash_map_iterator<HashMap>(bucket, listIt, hashmap)
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	size_t cached_hash<Policy>::table<Value, Allocator>::max_bucket_count() const
 	{
+		return mTable.max_bucket_count();
 	}
 
-	// Return a reference to the actual element.
-	template<typename HashMap>
-	typename hash_map_iterator<HashMap>::value_type&
-		hash_map_iterator<HashMap>::operator*()
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	template <typename Pred>
+	size_t cached_hash<Policy>::table<Value, Allocator>::bucket(size_t hash, const Pred& equal) const
 	{
-		return const_cast<value_type&>(*this->mListIterator);
+		return mTable.bucket(hash, [hash, &equal](const entry_type& entry) {
+			return entry.hash == hash && equal(entry.value);
+		});
 	}
 
-	// Return a pointer to the actual element, so the compiler can
-	// apply -> to it to access the actual desired field.
-	template<typename HashMap>
-	typename hash_map_iterator<HashMap>::value_type*
-		hash_map_iterator<HashMap>::operator->()
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	size_t cached_hash<Policy>::table<Value, Allocator>::bucket_size(size_t n) const
 	{
-		return const_cast<value_type*>(&(*this->mListIterator));
+		return mTable.bucket_size(n);
 	}
 
-	// Defer the details to the increment() helper in the base class.
-	template<typename HashMap>
-	hash_map_iterator<HashMap>& hash_map_iterator<HashMap>::operator++()
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	typename cached_hash<Policy>::template table<Value, Allocator>::local_iterator cached_hash<Policy>::table<Value, Allocator>::begin(size_t n)
 	{
-		this->increment();
-		return *this;
+		return local_iterator(mTable.begin(n));
 	}
 
-	// Defer the details to the increment() helper in the base class.
-	template<typename HashMap>
-	hash_map_iterator<HashMap> hash_map_iterator<HashMap>::operator++(int)
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	typename cached_hash<Policy>::template table<Value, Allocator>::const_local_iterator cached_hash<Policy>::table<Value, Allocator>::begin(size_t n) const
 	{
-		auto oldIt = *this;
-		this->increment();
-		return oldIt;
+		return const_local_iterator(mTable.begin(n));
 	}
 
-	// Defer the details to the decrement() helper in the base class.
-	template<typename HashMap>
-	hash_map_iterator<HashMap>& hash_map_iterator<HashMap>::operator--()
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	typename cached_hash<Policy>::template table<Value, Allocator>::local_iterator cached_hash<Policy>::table<Value, Allocator>::end(size_t n)
 	{
-		this->decrement();
-		return *this;
+		return local_iterator(mTable.end(n));
 	}
 
-	// Defer the details to the decrement() helper in the base class.
-	template<typename HashMap>
-	hash_map_iterator<HashMap> hash_map_iterator<HashMap>::operator--(int)
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	typename cached_hash<Policy>::template table<Value, Allocator>::const_local_iterator cached_hash<Policy>::table<Value, Allocator>::end(size_t n) const
 	{
-		auto oldIt = *this;
-		this->decrement();
-		return oldIt;
+		return const_local_iterator(mTable.end(n));
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	float cached_hash<Policy>::table<Value, Allocator>::max_load_factor() const
+	{
+		return mTable.max_load_factor();
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	void cached_hash<Policy>::table<Value, Allocator>::max_load_factor(float ml)
+	{
+		mTable.max_load_factor(ml);
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	template <typename HashFn>
+	void cached_hash<Policy>::table<Value, Allocator>::rehash(size_t n, const HashFn& /*hashOf*/)
+	{
+		mTable.rehash(n, stored_hash());
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	template <typename HashFn>
+	void cached_hash<Policy>::table<Value, Allocator>::rehash_step(const HashFn& /*hashOf*/)
+	{
+		mTable.rehash_step(stored_hash());
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	template <typename HashFn>
+	util::probe_stats cached_hash<Policy>::table<Value, Allocator>::probe_stats(const HashFn& /*hashOf*/) const
+	{
+		return mTable.probe_stats(stored_hash());
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	size_t cached_hash<Policy>::table<Value, Allocator>::begin_partitions(size_t parts)
+	{
+		return mTable.begin_partitions(parts);
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	size_t cached_hash<Policy>::table<Value, Allocator>::partition_of(size_t hash) const
+	{
+		return mTable.partition_of(hash);
+	}
+
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	template <typename Pred, typename... Args>
+	std::pair<typename cached_hash<Policy>::template table<Value, Allocator>::position, bool>
+		cached_hash<Policy>::table<Value, Allocator>::emplace_in_partition(size_t hash, const Pred& equal,
+			Args&&... args)
+	{
+		return mTable.emplace_in_partition(hash, [hash, &equal](const entry_type& entry) {
+			return entry.hash == hash && equal(entry.value);
+		}, hash, std::forward<Args>(args)...);
 	}
 
+	template <typename Policy>
+	template <typename Value, typename Allocator>
+	void cached_hash<Policy>::table<Value, Allocator>::end_partitions(size_t added)
+	{
+		mTable.end_partitions(added);
+	}
 
 
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	void swap(hash_map<Key, T, KeyEqual, Hash>& first, hash_map<Key, T, KeyEqual, Hash>& second) noexcept
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void swap(hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>& first, hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>& second) noexcept
 	{
 		first.swap(second);
 	}
@@ -469,36 +5126,158 @@ namespace util {
 
 
 
-	// Resize mBuckets with the number of buckets.
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	hash_map<Key, T, KeyEqual, Hash>::hash_map(const KeyEqual& equal, size_type numBuckets, const Hash& hash)
-		: mBuckets(numBuckets), mEqual(equal), mHash(hash)
+	// Create the storage table with the number of buckets.
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::hash_map(const KeyEqual& equal, size_type numBuckets, const Hash& hash,
+		const Allocator& alloc)
+		: mTable((numBuckets == 0 ? throw std::invalid_argument("Number of buckets must be positive") : numBuckets), alloc),
+		mEqual(equal), mHash(hash)
+	{
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::hash_map(const Allocator& alloc)
+		: hash_map(KeyEqual(), 101, Hash(), alloc)
 	{
-		if (numBuckets == 0) {
-			throw std::invalid_argument("Number of buckets must be positive");
-		}
 	}
 
 	// Make a call to insert() to actually insert the elements.
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
 	template <typename InputIterator>
-	hash_map<Key, T, KeyEqual, Hash>::hash_map(InputIterator first, InputIterator last, const KeyEqual& equal, size_type numBuckets, const Hash& hash)
-		: hash_map(equal, numBuckets, hash)
+	hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::hash_map(InputIterator first, InputIterator last, const KeyEqual& equal, size_type numBuckets, const Hash& hash,
+		const Allocator& alloc)
+		: hash_map(equal, numBuckets, hash, alloc)
 	{
 		insert(first, last);
 	}
 
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename RandomAccessIterator>
+	hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::hash_map(parallel_build options, RandomAccessIterator first, RandomAccessIterator last,
+		const KeyEqual& equal, const Hash& hash, const Allocator& alloc)
+		: hash_map(equal, 101, hash, alloc)
+	{
+		size_t threads = options.threads != 0 ? options.threads : std::thread::hardware_concurrency();
+		buildParallel(first, last, std::max<size_t>(threads, 1));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename RandomAccessIterator>
+	void hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::buildParallel(RandomAccessIterator first, RandomAccessIterator last, size_t threads)
+	{
+		// Below this many elements per thread, starting threads costs more
+		// than it saves.
+		constexpr size_t kMinPerThread = size_t(1) << 14;
+		size_t n = static_cast<size_t>(last - first);
+		threads = std::min(threads, n / kMinPerThread);
+		if (threads <= 1) {
+			insert(first, last);
+			return;
+		}
+		reserve(n);
+
+		// Thread t works on the elements from chunk(t) to chunk(t + 1).
+		auto chunk = [n, threads](size_t t) { return n / threads * t + std::min(t, n % threads); };
+		auto insertHashed = [this](size_t hash, const auto& x) {
+			auto equal = [this, &x](const value_type& element) { return mEqual(element.first, x.first); };
+			if (mTable.find(hash, equal) == mTable.end()) {
+				mTable.emplace(hash, elementHasher(), x);
+			}
+		};
+
+		std::vector<size_t> hashes(n);
+		detail::run_threads(threads, [&](size_t t) {
+			for (size_t i = chunk(t); i < chunk(t + 1); i++) {
+				hashes[i] = mHash(first[i].first);
+			}
+		});
+
+		if constexpr (!detail::partitioned_build<table_type>::value) {
+			for (size_t i = 0; i < n; i++) {
+				insertHashed(hashes[i], first[i]);
+			}
+		} else {
+			// More partitions than threads, so that they even out.
+			size_t parts = mTable.begin_partitions(threads * 8);
+
+			// Radix partition the element indices: count each thread's
+			// elements per partition, turn the counts into where each
+			// thread's share of each partition starts, and scatter. Every
+			// partition lists its elements in range order.
+			std::vector<size_t> offsets(threads * parts);
+			detail::run_threads(threads, [&](size_t t) {
+				for (size_t i = chunk(t); i < chunk(t + 1); i++) {
+					offsets[t * parts + mTable.partition_of(hashes[i])]++;
+				}
+			});
+			std::vector<size_t> partStart(parts + 1);
+			size_t total = 0;
+			for (size_t p = 0; p < parts; p++) {
+				partStart[p] = total;
+				for (size_t t = 0; t < threads; t++) {
+					size_t count = offsets[t * parts + p];
+					offsets[t * parts + p] = total;
+					total += count;
+				}
+			}
+			partStart[parts] = total;
+			std::vector<size_t> order(n);
+			detail::run_threads(threads, [&](size_t t) {
+				for (size_t i = chunk(t); i < chunk(t + 1); i++) {
+					order[offsets[t * parts + mTable.partition_of(hashes[i])]++] = i;
+				}
+			});
+
+			// Fill the partitions, each thread taking the next one left.
+			// Elements that don't fit in their partition are set aside.
+			std::atomic<size_t> nextPart(0);
+			std::vector<size_t> added(threads);
+			std::vector<std::vector<size_t>> deferred(parts);
+			try {
+				detail::run_threads(threads, [&](size_t t) {
+					for (size_t p = nextPart++; p < parts; p = nextPart++) {
+						for (size_t j = partStart[p]; j < partStart[p + 1]; j++) {
+							size_t i = order[j];
+							const auto& x = first[i];
+							auto result = mTable.emplace_in_partition(hashes[i],
+								[this, &x](const value_type& element) { return mEqual(element.first, x.first); }, x);
+							if (result.second) {
+								added[t]++;
+							} else if (result.first == mTable.end()) {
+								deferred[p].push_back(i);
+							}
+						}
+					}
+				});
+			} catch (...) {
+				// Leave the table consistent for the destructor.
+				mTable.end_partitions(std::accumulate(std::begin(added), std::end(added), size_t(0)));
+				throw;
+			}
+			mTable.end_partitions(std::accumulate(std::begin(added), std::end(added), size_t(0)));
+
+			// Equal keys share a partition, so the set-aside elements are
+			// still in range order where it matters.
+			for (const auto& indices : deferred) {
+				for (size_t i : indices) {
+					insertHashed(hashes[i], first[i]);
+				}
+			}
+		}
+	}
+
 	// Initializer list constructor
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	hash_map<Key, T, KeyEqual, Hash>::hash_map(std::initializer_list<value_type> il, const KeyEqual& equal, size_type numBuckets, const Hash& hash)
-		: hash_map(equal, numBuckets, hash)
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::hash_map(std::initializer_list<value_type> il, const KeyEqual& equal, size_type numBuckets, const Hash& hash,
+		const Allocator& alloc)
+		: hash_map(equal, numBuckets, hash, alloc)
 	{
 		insert(std::begin(il), std::end(il));
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	hash_map<Key, T, KeyEqual, Hash>&
-		hash_map<Key, T, KeyEqual, Hash>::operator=(const hash_map_type& rhs)
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>&
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::operator=(const hash_map_type& rhs)
 	{
 		// check for self-assignment
 		if (this == &rhs) {
@@ -511,82 +5290,182 @@ namespace util {
 		return *this;
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	hash_map<Key, T, KeyEqual, Hash>&
-		hash_map<Key, T, KeyEqual, Hash>::operator=(hash_map_type&& rhs) noexcept
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>&
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::operator=(hash_map_type&& rhs) noexcept
 	{
 		swap(rhs);
 		return *this;
 	}
 
 	// Initializer list assignment operator
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	hash_map<Key, T, KeyEqual, Hash>&
-		hash_map<Key, T, KeyEqual, Hash>::operator=(std::initializer_list<value_type> il)
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>&
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::operator=(std::initializer_list<value_type> il)
 	{
 		// Do all the work in a temporary instance
-		hash_map_type newHashMap(il, mEqual, mBuckets.size(), mHash);
+		hash_map_type newHashMap(il, mEqual, mTable.bucket_count(), mHash, get_allocator());
 		swap(newHashMap);  // Commit the work with only non-throwing operations
 		return *this;
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	std::pair<typename hash_map<Key, T, KeyEqual, Hash>::ListType::iterator, size_t>
-		hash_map<Key, T, KeyEqual, Hash>::findElement(const key_type& k)
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K>
+	std::pair<typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::position, size_t>
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::findElement(const K& k) const
 	{
-		// Hash the key to get the bucket.
-		size_t bucket = mHash(k) % mBuckets.size();
+		// Hash the key once; the table uses it to locate the candidates.
+		size_t hash = mHash(k);
 
-		// Search for the key in the bucket.
-		auto iter = find_if(std::begin(mBuckets[bucket]), std::end(mBuckets[bucket]),
-			[this, &k](const auto& element) { return mEqual(element.first, k); });
+		// Search for the key among the candidates.
+		auto pos = mTable.find(hash,
+			[this, &k](const value_type& element) { return mEqual(element.first, k); });
 
-		// Return a pair of the iterator and the bucket index.
-		return std::make_pair(iter, bucket);
+		// Return a pair of the position and the hash.
+		return std::make_pair(pos, hash);
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::iterator
-		hash_map<Key, T, KeyEqual, Hash>::find(const key_type& k)
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename KeyIterator, typename Callback>
+	void hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::findBatch(KeyIterator first, KeyIterator last,
+		const Callback& found) const
 	{
-		// Use the findElement() helper, and C++17 structured bindings.
-		auto[it, bucket] = findElement(k);
-		if (it == std::end(mBuckets[bucket])) {
-			// Element not found -- return the end iterator.
-			return end();
+		size_t hashes[kBatchSize];
+		while (first != last) {
+			// Hash a block of keys and start fetching their buckets.
+			KeyIterator blockStart = first;
+			size_t count = 0;
+			for (; count < kBatchSize && first != last; ++count, ++first) {
+				hashes[count] = mHash(*first);
+				mTable.prefetch(hashes[count]);
+			}
+
+			// By now the first buckets have arrived; use them to fetch
+			// the elements they lead to.
+			for (size_t i = 0; i < count; ++i) {
+				mTable.prefetch_element(hashes[i]);
+			}
+
+			// Resolve the block, mostly from cache.
+			for (size_t i = 0; i < count; ++i, ++blockStart) {
+				const auto& k = *blockStart;
+				found(mTable.find(hashes[i],
+					[this, &k](const value_type& element) { return mEqual(element.first, k); }));
+			}
 		}
-		// Element found -- convert the bucket/iterator to a hash_map_iterator.
-		return hash_map_iterator<hash_map_type>(bucket, it, this);
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::const_iterator
-		hash_map<Key, T, KeyEqual, Hash>::find(const key_type& k) const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename KeyIterator, typename OutputIterator>
+	OutputIterator hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::find_batch(KeyIterator first, KeyIterator last,
+		OutputIterator out)
+	{
+		findBatch(first, last, [this, &out](const position& pos) { *out++ = hash_map_iterator<hash_map_type>(pos, this); });
+		return out;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename KeyIterator, typename OutputIterator>
+	OutputIterator hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::find_batch(KeyIterator first, KeyIterator last,
+		OutputIterator out) const
+	{
+		findBatch(first, last, [this, &out](const position& pos) { *out++ = const_iterator(pos, this); });
+		return out;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename KeyIterator, typename OutputIterator>
+	OutputIterator hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::contains_batch(KeyIterator first, KeyIterator last,
+		OutputIterator out) const
+	{
+		position end = mTable.end();
+		findBatch(first, last, [end, &out](const position& pos) { *out++ = pos != end; });
+		return out;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	auto hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::elementHasher() const
+	{
+		return [this](const value_type& element) { return mHash(element.first); };
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::find(const key_type& k)
+	{
+		// Use the findElement() helper, and C++17 structured bindings.
+		auto[pos, hash] = findElement(k);
+		// The end position converts to the end iterator.
+		return hash_map_iterator<hash_map_type>(pos, this);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::find(const key_type& k) const
+	{
+		return const_cast<hash_map_type*>(this)->find(k);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::find(const K& k)
+	{
+		// Same as the key_type version; k is never converted to a Key.
+		auto[pos, hash] = findElement(k);
+		return hash_map_iterator<hash_map_type>(pos, this);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::find(const K& k) const
 	{
 		return const_cast<hash_map_type*>(this)->find(k);
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	std::pair<typename hash_map<Key, T, KeyEqual, Hash>::iterator,
-		typename hash_map<Key, T, KeyEqual, Hash>::iterator>
-		hash_map<Key, T, KeyEqual, Hash>::equal_range(const key_type& k)
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	std::pair<typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator,
+		typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator>
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::equal_range(const key_type& k)
+	{
+		// Keys are unique, so the range holds one element at most.
+		auto it = find(k);
+		return std::make_pair(it, it == end() ? it : std::next(it));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	std::pair<typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator,
+		typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator>
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::equal_range(const key_type& k) const
+	{
+		auto it = find(k);
+		return std::make_pair(it, it == end() ? it : std::next(it));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename>
+	std::pair<typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator,
+		typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator>
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::equal_range(const K& k)
 	{
 		auto it = find(k);
-		return std::make_pair(it, it);
+		return std::make_pair(it, it == end() ? it : std::next(it));
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	std::pair<typename hash_map<Key, T, KeyEqual, Hash>::const_iterator,
-		typename hash_map<Key, T, KeyEqual, Hash>::const_iterator>
-		hash_map<Key, T, KeyEqual, Hash>::equal_range(const key_type& k) const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename>
+	std::pair<typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator,
+		typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator>
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::equal_range(const K& k) const
 	{
 		auto it = find(k);
-		return std::make_pair(it, it);
+		return std::make_pair(it, it == end() ? it : std::next(it));
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::size_type
-		hash_map<Key, T, KeyEqual, Hash>::count(const key_type& k) const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::count(const key_type& k) const
 	{
 		// There are either 1 or 0 elements matching key k.
 		// If we can find a match, return 1, otherwise return 0.
@@ -597,44 +5476,85 @@ namespace util {
 		}
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	T& hash_map<Key, T, KeyEqual, Hash>::operator[] (const key_type& k)
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::count(const K& k) const
+	{
+		return find(k) == end() ? 0 : 1;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	T& hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::operator[] (const key_type& k)
 	{
-		// It's a bit cryptic, but it basically attempts to insert
-		// a new key/value pair of k and a zero-initialized value. Regardless
-		// of whether the insert succeeds or fails, insert() returns a pair of
-		// an iterator/bool. The iterator refers to a key/value pair, the
-		// second element of which is the value we want to return.
-		return ((insert(std::make_pair(k, T()))).first)->second;
+		// try_emplace() returns a pair of an iterator/bool, whether or not it
+		// inserted a new key/value pair of k and a value-initialized value.
+		// The iterator refers to a key/value pair, the second element of
+		// which is the value we want to return.
+		return tryEmplaceKey(k).first->second;
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	std::pair<typename hash_map<Key, T, KeyEqual, Hash>::iterator, bool>
-		hash_map<Key, T, KeyEqual, Hash>::insert(const value_type& x)
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	T& hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::operator[] (key_type&& k)
+	{
+		return tryEmplaceKey(std::move(k)).first->second;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename>
+	T& hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::operator[] (K&& k)
+	{
+		return tryEmplaceKey(std::forward<K>(k)).first->second;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	std::pair<typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator, bool>
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::insert(const value_type& x)
 	{
 		// Try to find the element.
-		auto[it, bucket] = findElement(x.first);
+		auto[pos, hash] = findElement(x.first);
 		bool inserted = false;
-		if (it == std::end(mBuckets[bucket])) {
+		if (pos == mTable.end()) {
 			// We didn't find the element, so insert a new one.
-			it = mBuckets[bucket].insert(it, x);
+			pos = mTable.emplace(hash, elementHasher(), x);
+			inserted = true;
+		}
+		return std::make_pair(hash_map_iterator<hash_map_type>(pos, this), inserted);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	std::pair<typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator, bool>
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::insert(value_type&& x)
+	{
+		// Same as above, but the mapped value is moved. The key is const,
+		// so it is still copied.
+		auto[pos, hash] = findElement(x.first);
+		bool inserted = false;
+		if (pos == mTable.end()) {
+			pos = mTable.emplace(hash, elementHasher(), std::move(x));
 			inserted = true;
-			mSize++;
 		}
-		return std::make_pair(hash_map_iterator<hash_map_type>(bucket, it, this), inserted);
+		return std::make_pair(hash_map_iterator<hash_map_type>(pos, this), inserted);
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::iterator
-		hash_map<Key, T, KeyEqual, Hash>::insert(const_iterator /*hint*/, const value_type& x)
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::insert(const_iterator /*hint*/, const value_type& x)
 	{
 		// Completely ignore position.
 		return insert(x).first;
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::insert(const_iterator /*hint*/, value_type&& x)
+	{
+		return insert(std::move(x)).first;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
 	template <typename InputIterator>
-	void hash_map<Key, T, KeyEqual, Hash>::insert(InputIterator first, InputIterator last)
+	void hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::insert(InputIterator first, InputIterator last)
 	{
 		// Copy each element in the range by using an insert_iterator adapter.
 		// Give begin() as a dummy position -- insert ignores it anyway.
@@ -642,22 +5562,199 @@ namespace util {
 		std::copy(first, last, inserter);
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	void hash_map<Key, T, KeyEqual, Hash>::insert(std::initializer_list<value_type> il)
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::insert(std::initializer_list<value_type> il)
 	{
 		insert(std::begin(il), std::end(il));
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::size_type
-		hash_map<Key, T, KeyEqual, Hash>::erase(const key_type& k)
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::insert_return_type
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::insert(node_type&& node)
+	{
+		if (node.empty()) {
+			return { end(), false, node_type() };
+		}
+
+		auto[pos, hash] = findElement(node.key());
+		if (pos != mTable.end()) {
+			// The key is taken; hand the node back to the caller.
+			return { hash_map_iterator<hash_map_type>(pos, this), false, std::move(node) };
+		}
+		pos = mTable.insert(hash, elementHasher(), node.mNode);
+		return { hash_map_iterator<hash_map_type>(pos, this), true, node_type() };
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::insert(const_iterator /*hint*/, node_type&& node)
+	{
+		return insert(std::move(node)).position;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename... Args>
+	std::pair<typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator, bool>
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::emplace(Args&&... args)
+	{
+		// Build the element in a node of its own to learn the key, then
+		// link that node into the table.
+		typename table_type::node node(mTable.get_allocator(), std::in_place, std::forward<Args>(args)...);
+		auto[pos, hash] = findElement(node.value().first);
+		if (pos != mTable.end()) {
+			return std::make_pair(hash_map_iterator<hash_map_type>(pos, this), false);
+		}
+		pos = mTable.insert(hash, elementHasher(), node);
+		return std::make_pair(hash_map_iterator<hash_map_type>(pos, this), true);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename... Args>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::emplace_hint(const_iterator /*hint*/, Args&&... args)
+	{
+		return emplace(std::forward<Args>(args)...).first;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename... Args>
+	std::pair<typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator, bool>
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::try_emplace(const key_type& k, Args&&... args)
+	{
+		return tryEmplaceKey(k, std::forward<Args>(args)...);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename... Args>
+	std::pair<typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator, bool>
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::try_emplace(key_type&& k, Args&&... args)
+	{
+		return tryEmplaceKey(std::move(k), std::forward<Args>(args)...);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename... Args>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::try_emplace(const_iterator /*hint*/, const key_type& k, Args&&... args)
+	{
+		return tryEmplaceKey(k, std::forward<Args>(args)...).first;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename... Args>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::try_emplace(const_iterator /*hint*/, key_type&& k, Args&&... args)
+	{
+		return tryEmplaceKey(std::move(k), std::forward<Args>(args)...).first;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename... Args>
+	std::pair<typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator, bool>
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::tryEmplaceKey(K&& k, Args&&... args)
+	{
+		auto[pos, hash] = findElement(k);
+		if (pos != mTable.end()) {
+			return std::make_pair(hash_map_iterator<hash_map_type>(pos, this), false);
+		}
+		pos = mTable.emplace(hash, elementHasher(), std::piecewise_construct,
+			std::forward_as_tuple(std::forward<K>(k)), std::forward_as_tuple(std::forward<Args>(args)...));
+		return std::make_pair(hash_map_iterator<hash_map_type>(pos, this), true);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename M>
+	std::pair<typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator, bool>
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::insert_or_assign(const key_type& k, M&& obj)
+	{
+		return insertOrAssignKey(k, std::forward<M>(obj));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename M>
+	std::pair<typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator, bool>
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::insert_or_assign(key_type&& k, M&& obj)
+	{
+		return insertOrAssignKey(std::move(k), std::forward<M>(obj));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename M>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::insert_or_assign(const_iterator /*hint*/, const key_type& k, M&& obj)
+	{
+		return insertOrAssignKey(k, std::forward<M>(obj)).first;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename M>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::insert_or_assign(const_iterator /*hint*/, key_type&& k, M&& obj)
+	{
+		return insertOrAssignKey(std::move(k), std::forward<M>(obj)).first;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename M>
+	std::pair<typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator, bool>
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::insertOrAssignKey(K&& k, M&& obj)
+	{
+		// obj is only consumed by one of the two branches.
+		auto result = tryEmplaceKey(std::forward<K>(k), std::forward<M>(obj));
+		if (!result.second) {
+			result.first->second = std::forward<M>(obj);
+		}
+		return result;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::node_type
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::extract(const_iterator position)
+	{
+		return node_type(mTable.extract(position.mPosition));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::node_type
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::extract(const key_type& k)
+	{
+		auto[pos, hash] = findElement(k);
+		if (pos == mTable.end()) {
+			return node_type();
+		}
+		node_type node(mTable.extract(pos));
+		// Give a pending incremental rehash the chance to progress.
+		mTable.rehash_step(elementHasher());
+		return node;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::erase(const key_type& k)
+	{
+		return eraseKey(k);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename, typename>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::erase(const K& k)
+	{
+		return eraseKey(k);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::eraseKey(const K& k)
 	{
 		// First, try to find the element.
-		auto[it, bucket] = findElement(k);
-		if (it != std::end(mBuckets[bucket])) {
+		auto[pos, hash] = findElement(k);
+		if (pos != mTable.end()) {
 			// The element exists -- erase it.
-			mBuckets[bucket].erase(it);
-			mSize--;
+			mTable.erase(pos);
+			// Give a pending incremental rehash the chance to progress.
+			mTable.rehash_step(elementHasher());
 			return 1;
 		}
 		else {
@@ -665,221 +5762,255 @@ namespace util {
 		}
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::iterator
-		hash_map<Key, T, KeyEqual, Hash>::erase(iterator position)
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::erase(iterator position)
 	{
-		iterator next = position;
-		++next;
-
-		// Erase the element from its bucket.
-		mBuckets[position.mBucketIndex].erase(position.mListIterator);
-		mSize--;
-
-		return next;
+		// Erase the element from the table. Tables that move elements
+		// around on erase know best where the next one is.
+		return iterator(mTable.erase(position.mPosition), this);
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::iterator
-		hash_map<Key, T, KeyEqual, Hash>::erase(iterator first, iterator last)
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::erase(iterator first, iterator last)
 	{
-		// Erase all the elements in the range.
-		for (iterator next = first; next != last;) {
-			next = erase(next);
+		// Erasing may move the elements after it, last included, so count
+		// the range first.
+		for (auto count = std::distance(first, last); count > 0; --count) {
+			first = erase(first);
 		}
 
-		return last;
+		return first;
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	void hash_map<Key, T, KeyEqual, Hash>::clear() noexcept
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::clear() noexcept
 	{
-		// Call clear on each bucket.
-		for (auto& bucket : mBuckets) {
-			bucket.clear();
-		}
-		mSize = 0;
+		mTable.clear();
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	bool hash_map<Key, T, KeyEqual, Hash>::empty() const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	bool hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::empty() const
 	{
-		return mSize == 0;
+		return mTable.size() == 0;
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::size_type
-		hash_map<Key, T, KeyEqual, Hash>::size() const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::size() const
 	{
-		return mSize;
+		return mTable.size();
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::size_type
-		hash_map<Key, T, KeyEqual, Hash>::max_size() const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::max_size() const
 	{
-		// In the worst case, all the elements hash to the same
-		// list, so the max_size is the max_size of a single list.
-		// This code assumes that all the lists have the same max_size.
-		return mBuckets[0].max_size();
+		return mTable.max_size();
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	void hash_map<Key, T, KeyEqual, Hash>::swap(hash_map_type& other) noexcept
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::swap(hash_map_type& other) noexcept
 	{
 		using std::swap;
 
-		swap(mBuckets, other.mBuckets);
-		swap(mSize, other.mSize);
+		mTable.swap(other.mTable);
 		swap(mEqual, other.mEqual);
 		swap(mHash, other.mHash);
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::iterator
-		hash_map<Key, T, KeyEqual, Hash>::begin()
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::begin()
 	{
-		if (mSize == 0) {
+		if (empty()) {
 			// Special case: there are no elements, so return the end iterator.
 			return end();
 		}
 
 		// We know there is at least one element. Find the first element.
-		for (size_t i = 0; i < mBuckets.size(); ++i) {
-			if (!mBuckets[i].empty()) {
-				return hash_map_iterator<hash_map_type>(i, std::begin(mBuckets[i]), this);
-			}
-		}
-		// Should never reach here, but if we do, return the end iterator.
-		return end();
+		return hash_map_iterator<hash_map_type>(mTable.first(), this);
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::const_iterator
-		hash_map<Key, T, KeyEqual, Hash>::begin() const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::begin() const
 	{
 		// Use const_cast to call the non-const version of begin(). That
 		// one returns an iterator which is convertible to a const_iterator.
 		return const_cast<hash_map_type*>(this)->begin();
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::const_iterator
-		hash_map<Key, T, KeyEqual, Hash>::cbegin() const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::cbegin() const
 	{
 		return begin();
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::iterator
-		hash_map<Key, T, KeyEqual, Hash>::end()
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::end()
 	{
-		// The end iterator is the end iterator of the list of the last bucket.
-		size_t bucket = mBuckets.size() - 1;
-		return hash_map_iterator<hash_map_type>(bucket, std::end(mBuckets[bucket]), this);
+		return hash_map_iterator<hash_map_type>(mTable.end(), this);
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::const_iterator
-		hash_map<Key, T, KeyEqual, Hash>::end() const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::end() const
 	{
 		// Use const_cast to call the non-const version of end(). That
 		// one returns an iterator which is convertible to a const_iterator.
 		return const_cast<hash_map_type*>(this)->end();
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::const_iterator
-		hash_map<Key, T, KeyEqual, Hash>::cend() const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::cend() const
 	{
 		return end();
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::key_equal
-		hash_map<Key, T, KeyEqual, Hash>::key_eq() const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::key_equal
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::key_eq() const
 	{
 		return mEqual;
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::hasher
-		hash_map<Key, T, KeyEqual, Hash>::hash_function() const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::hasher
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::hash_function() const
 	{
 		return mHash;
 	}
 
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::allocator_type
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::get_allocator() const
+	{
+		return mTable.get_allocator();
+	}
+
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::size_type
-		hash_map<Key, T, KeyEqual, Hash>::bucket_count() const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::bucket_count() const
 	{
-		return mBuckets.size();
+		return mTable.bucket_count();
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::size_type
-		hash_map<Key, T, KeyEqual, Hash>::max_bucket_count() const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::max_bucket_count() const
 	{
-		return mBuckets.max_size();
+		return mTable.max_bucket_count();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::bucket(const Key& k) const
+	{
+		return mTable.bucket(mHash(k),
+			[this, &k](const value_type& element) { return mEqual(element.first, k); });
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::bucket_size(size_type n) const
+	{
+		return mTable.bucket_size(n);
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::size_type
-		hash_map<Key, T, KeyEqual, Hash>::bucket(const Key& k) const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::local_iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::begin(size_type n)
 	{
-		return const_cast<hash_map_type*>(this)->findElement(k).second;
+		return mTable.begin(n);
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::size_type
-		hash_map<Key, T, KeyEqual, Hash>::bucket_size(size_type n) const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::const_local_iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::begin(size_type n) const
 	{
-		return mBuckets[n].size();
+		return mTable.begin(n);
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::local_iterator
-		hash_map<Key, T, KeyEqual, Hash>::begin(size_type n)
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::const_local_iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::cbegin(size_type n) const
 	{
-		return mBuckets[n].begin();
+		return mTable.begin(n);
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::const_local_iterator
-		hash_map<Key, T, KeyEqual, Hash>::begin(size_type n) const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::local_iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::end(size_type n)
 	{
-		return mBuckets[n].begin();
+		return mTable.end(n);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::const_local_iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::end(size_type n) const
+	{
+		return mTable.end(n);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::const_local_iterator
+		hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::cend(size_type n) const
+	{
+		return mTable.end(n);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	float hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::load_factor() const
+	{
+		return static_cast<float>(size()) / static_cast<float>(bucket_count());
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	float hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::max_load_factor() const
+	{
+		return mTable.max_load_factor();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::max_load_factor(float ml)
+	{
+		if (!(ml > 0.0f)) {
+			throw std::invalid_argument("Maximum load factor must be positive");
+		}
+		mTable.max_load_factor(ml);
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::const_local_iterator
-		hash_map<Key, T, KeyEqual, Hash>::cbegin(size_type n) const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::rehash(size_type n)
 	{
-		return mBuckets[n].cbegin();
+		mTable.rehash(n, elementHasher());
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::local_iterator
-		hash_map<Key, T, KeyEqual, Hash>::end(size_type n)
+	// Enough buckets for n elements is n / max_load_factor(), rounded up.
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::reserve(size_type n)
 	{
-		return mBuckets[n].end();
+		rehash(static_cast<size_type>(std::ceil(n / static_cast<double>(max_load_factor()))));
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::const_local_iterator
-		hash_map<Key, T, KeyEqual, Hash>::end(size_type n) const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	util::probe_stats hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::probe_stats() const
 	{
-		return mBuckets[n].end();
+		return mTable.probe_stats(elementHasher());
 	}
 
-	template <typename Key, typename T, typename KeyEqual, typename Hash>
-	typename hash_map<Key, T, KeyEqual, Hash>::const_local_iterator
-		hash_map<Key, T, KeyEqual, Hash>::cend(size_type n) const
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	util::bucket_stats hash_map<Key, T, KeyEqual, Hash, Policy, Allocator>::bucket_stats() const
 	{
-		return mBuckets[n].cend();
+		return detail::bucket_stats_of(mTable);
 	}
 
 } //namespace util
 
-#endif HASH_MAP_H_
+#endif // HASH_MAP_H_
@@ -0,0 +1,75 @@
+// Compares hash_map::find_batch and contains_batch with a loop of single
+// find() calls, on a table that is meant to be larger than the last-level
+// cache. Usage: hash_map_benchmark [elements] [lookups]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "hash_map.h"
+
+namespace {
+
+template <typename Map>
+void run(const char* name, size_t elements, size_t lookups) {
+  using Clock = std::chrono::steady_clock;
+
+  Map map;
+  map.reserve(elements);
+  for (size_t i = 0; i < elements; i++) {
+    map.try_emplace(static_cast<uint64_t>(i) * 2, i);
+  }
+
+  // Odd keys are missing, so about half of the lookups fail.
+  std::mt19937_64 rng(42);
+  std::vector<uint64_t> keys(lookups);
+  for (auto& key : keys) {
+    key = rng() % (elements * 2);
+  }
+
+  auto start = Clock::now();
+  size_t sum = 0;
+  for (uint64_t key : keys) {
+    auto it = map.find(key);
+    if (it != map.end()) {
+      sum += it->second;
+    }
+  }
+  auto single = Clock::now() - start;
+
+  std::vector<typename Map::iterator> found(lookups);
+  start = Clock::now();
+  map.find_batch(keys.begin(), keys.end(), found.begin());
+  size_t batchSum = 0;
+  for (auto it : found) {
+    if (it != map.end()) {
+      batchSum += it->second;
+    }
+  }
+  auto batch = Clock::now() - start;
+
+  std::vector<char> present(lookups);
+  start = Clock::now();
+  map.contains_batch(keys.begin(), keys.end(), present.begin());
+  auto contains = Clock::now() - start;
+
+  auto ns = [lookups](Clock::duration d) {
+    return std::chrono::duration<double, std::nano>(d).count() / lookups;
+  };
+  std::printf("%-14s find: %6.1f ns/key  find_batch: %6.1f ns/key  contains_batch: %6.1f ns/key%s\n",
+    name, ns(single), ns(batch), ns(contains), sum == batchSum ? "" : "  (MISMATCH)");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  size_t elements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : size_t(1) << 24;
+  size_t lookups = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : size_t(1) << 22;
+
+  run<util::hash_map<uint64_t, uint64_t>>("chaining", elements, lookups);
+  run<util::hash_map<uint64_t, uint64_t, std::equal_to<>, util::hash<uint64_t>, util::group_probing>>(
+    "group_probing", elements, lookups);
+  return 0;
+}
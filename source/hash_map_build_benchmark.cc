@@ -0,0 +1,60 @@
+// Compares the range constructor of hash_map with the parallel one, at
+// doubling thread counts up to the number of hardware threads (and at
+// least 4). Usage: hash_map_build_benchmark [elements]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "hash_map.h"
+
+namespace {
+
+template <typename Map>
+void run(const char* name, const std::vector<std::pair<uint64_t, uint64_t>>& pairs) {
+  using Clock = std::chrono::steady_clock;
+  auto seconds = [](Clock::duration d) { return std::chrono::duration<double>(d).count(); };
+
+  auto start = Clock::now();
+  size_t size;
+  {
+    Map map(pairs.begin(), pairs.end());
+    size = map.size();
+  }
+  double sequential = seconds(Clock::now() - start);
+  std::printf("%-14s range constructor: %7.2f s  (%zu elements)\n", name, sequential, size);
+
+  unsigned maxThreads = std::max(4u, std::thread::hardware_concurrency());
+  for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+    start = Clock::now();
+    {
+      Map map(util::parallel_build{ threads }, pairs.begin(), pairs.end());
+      size = map.size();
+    }
+    double parallel = seconds(Clock::now() - start);
+    std::printf("%-14s %2u threads:        %7.2f s  speedup %.2fx\n", name, threads, parallel, sequential / parallel);
+  }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  size_t elements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000000;
+
+  // Random keys, about one in 20 repeated.
+  std::mt19937_64 rng(42);
+  std::vector<std::pair<uint64_t, uint64_t>> pairs(elements);
+  for (size_t i = 0; i < elements; i++) {
+    pairs[i] = std::make_pair(rng() % (elements * 10), i);
+  }
+
+  run<util::hash_map<uint64_t, uint64_t, std::equal_to<>, util::hash<uint64_t>, util::group_probing>>(
+    "group_probing", pairs);
+  run<util::hash_map<uint64_t, uint64_t>>("chaining", pairs);
+  return 0;
+}
@@ -0,0 +1,58 @@
+// Compares the latency of single inserts while hash_map grows, with
+// chaining, which rehashes everything at once, and incremental_chaining,
+// which spreads each rehash over the inserts that follow. Starting from
+// an empty map, times every insert on its own through several doublings
+// of the table, and prints the percentiles and the worst case.
+// Usage: hash_map_growth_benchmark [keys]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "hash_map.h"
+
+namespace {
+
+template <typename Map>
+void run(const char* name, const std::vector<uint64_t>& keys) {
+  using Clock = std::chrono::steady_clock;
+
+  Map map;
+  std::vector<double> latencies(keys.size());
+  auto total = Clock::now();
+  for (size_t i = 0; i < keys.size(); i++) {
+    auto start = Clock::now();
+    map.try_emplace(keys[i], i);
+    latencies[i] = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  }
+  double mean = std::chrono::duration<double, std::nano>(Clock::now() - total).count() / keys.size();
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double p) {
+    return latencies[std::min(latencies.size() - 1, static_cast<size_t>(latencies.size() * p))];
+  };
+  std::printf("%-21s mean: %6.0f ns  p50: %6.0f ns  p99: %6.0f ns  p999: %8.0f ns  max: %11.0f ns%s\n",
+    name, mean, percentile(0.5), percentile(0.99), percentile(0.999), latencies.back(),
+    map.size() == keys.size() ? "" : "  (MISMATCH)");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  size_t elements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+
+  std::mt19937_64 rng(42);
+  std::vector<uint64_t> keys(elements);
+  for (auto& key : keys) {
+    key = rng();
+  }
+
+  run<util::hash_map<uint64_t, uint64_t>>("chaining", keys);
+  using Incremental =
+    util::hash_map<uint64_t, uint64_t, std::equal_to<>, util::hash<uint64_t>, util::incremental_chaining>;
+  run<Incremental>("incremental_chaining", keys);
+  return 0;
+}
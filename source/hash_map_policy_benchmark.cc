@@ -0,0 +1,94 @@
+// Compares the storage policies of hash_map at several load factors:
+// insertion, successful and failed lookups, and the probe-length
+// statistics of the resulting table. Usage:
+// hash_map_policy_benchmark [slots] [lookups]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "hash_map.h"
+
+namespace {
+
+template <typename Map>
+void run(const char* name, float loadFactor, size_t slots, size_t lookups) {
+  using Clock = std::chrono::steady_clock;
+
+  // Each policy caps this at what it can sustain.
+  Map map;
+  map.max_load_factor(0.95f);
+  if (loadFactor > map.max_load_factor()) {
+    std::printf("%-22s %4.2f  (above the maximum load factor)\n", name, loadFactor);
+    return;
+  }
+  map.rehash(slots);
+  size_t elements = static_cast<size_t>(map.bucket_count() * loadFactor);
+
+  std::mt19937_64 rng(42);
+  std::vector<uint64_t> keys(elements);
+  for (auto& key : keys) {
+    key = rng();
+  }
+
+  auto start = Clock::now();
+  for (size_t i = 0; i < elements; i++) {
+    map.try_emplace(keys[i], i);
+  }
+  auto insert = Clock::now() - start;
+
+  std::vector<uint64_t> hits(lookups);
+  std::vector<uint64_t> misses(lookups);
+  for (size_t i = 0; i < lookups; i++) {
+    hits[i] = keys[rng() % elements];
+    misses[i] = rng();
+  }
+
+  start = Clock::now();
+  size_t sum = 0;
+  for (uint64_t key : hits) {
+    sum += map.find(key)->second;
+  }
+  auto hit = Clock::now() - start;
+
+  start = Clock::now();
+  size_t found = 0;
+  for (uint64_t key : misses) {
+    found += map.count(key);
+  }
+  auto miss = Clock::now() - start;
+
+  auto ns = [](Clock::duration d, size_t n) {
+    return std::chrono::duration<double, std::nano>(d).count() / n;
+  };
+  util::probe_stats stats = map.probe_stats();
+  std::printf("%-22s %4.2f  insert: %6.1f ns  hit: %6.1f ns  miss: %6.1f ns"
+    "  probes: %4.2f mean %3zu max  kicks/elem: %5.2f  forced: %zu%s\n",
+    name, map.load_factor(), ns(insert, elements), ns(hit, lookups), ns(miss, lookups),
+    stats.mean_probe_length, stats.max_probe_length,
+    static_cast<double>(stats.kicks) / elements, stats.forced_growths,
+    sum != 0 && found <= lookups ? "" : "  (MISMATCH)");
+}
+
+template <typename Policy>
+void runAll(const char* name, size_t slots, size_t lookups) {
+  using Map = util::hash_map<uint64_t, uint64_t, std::equal_to<>, util::hash<uint64_t>, Policy>;
+  for (float loadFactor : { 0.5f, 0.75f, 0.85f, 0.93f }) {
+    run<Map>(name, loadFactor, slots, lookups);
+  }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  size_t slots = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : size_t(1) << 22;
+  size_t lookups = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : size_t(1) << 22;
+
+  runAll<util::chaining>("chaining", slots, lookups);
+  runAll<util::group_probing>("group_probing", slots, lookups);
+  runAll<util::robin_hood>("robin_hood", slots, lookups);
+  runAll<util::cuckoo>("cuckoo", slots, lookups);
+  return 0;
+}
@@ -0,0 +1,69 @@
+// Shows how hash_map scales as it grows on its own: for key counts rising
+// tenfold from a thousand up to the given maximum, inserts that many random
+// keys into an empty map, with no reserve(), then looks up as many present
+// keys. Both figures should stay near flat once the table outgrows the
+// caches. Usage: hash_map_scaling_benchmark [max keys] [lookups]
+// The full sweep to 100M keys needs about 8 GB of memory.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "hash_map.h"
+
+namespace {
+
+template <typename Map>
+void run(const char* name, size_t elements, size_t lookups) {
+  using Clock = std::chrono::steady_clock;
+
+  std::mt19937_64 rng(42);
+  std::vector<uint64_t> keys(elements);
+  for (auto& key : keys) {
+    key = rng();
+  }
+  std::vector<uint64_t> hits(lookups);
+  for (auto& key : hits) {
+    key = keys[rng() % elements];
+  }
+
+  Map map;
+  auto start = Clock::now();
+  for (size_t i = 0; i < elements; i++) {
+    map.try_emplace(keys[i], i);
+  }
+  auto insert = Clock::now() - start;
+
+  start = Clock::now();
+  size_t sum = 0;
+  for (uint64_t key : hits) {
+    sum += map.find(key)->second;
+  }
+  auto find = Clock::now() - start;
+
+  auto ns = [](Clock::duration d, size_t n) {
+    return std::chrono::duration<double, std::nano>(d).count() / n;
+  };
+  std::printf("%-14s %11zu keys  insert: %6.1f ns  find: %6.1f ns  buckets: %11zu  load: %4.2f%s\n",
+    name, elements, ns(insert, elements), ns(find, lookups), map.bucket_count(), map.load_factor(),
+    sum != 0 || elements == 1 ? "" : "  (MISMATCH)");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  size_t maxElements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000000;
+  size_t lookups = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000000;
+
+  for (size_t elements = 1000; elements <= maxElements; elements *= 10) {
+    run<util::hash_map<uint64_t, uint64_t>>("chaining", elements, std::min(lookups, elements * 10));
+  }
+  for (size_t elements = 1000; elements <= maxElements; elements *= 10) {
+    using Map = util::hash_map<uint64_t, uint64_t, std::equal_to<>, util::hash<uint64_t>, util::group_probing>;
+    run<Map>("group_probing", elements, std::min(lookups, elements * 10));
+  }
+  return 0;
+}
@@ -1,4 +1,11 @@
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <set>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "hash_map.h"
 #include "gtest/gtest.h"
@@ -8,4 +15,945 @@ TEST(MyAvlTree, DefaultConstructor) {
 
   EXPECT_EQ(0u, tree.size());
 }
-/*
\ No newline at end of file
+
+TEST(MyHashMap, InsertFindErase) {
+  util::hash_map<int, int> map;
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(map.insert(std::make_pair(i, i * i)).second);
+  }
+  EXPECT_FALSE(map.insert(std::make_pair(7, 0)).second);
+  EXPECT_EQ(1000u, map.size());
+  EXPECT_EQ(49, map.find(7)->second);
+
+  EXPECT_EQ(1u, map.erase(7));
+  EXPECT_EQ(0u, map.erase(7));
+  EXPECT_TRUE(map.find(7) == map.end());
+  EXPECT_EQ(999u, map.size());
+}
+
+TEST(MyHashMap, GroupProbing_InsertFindErase) {
+  util::hash_map<int, int, std::equal_to<>, util::hash<int>, util::group_probing> map;
+  for (int i = 0; i < 10000; i++) {
+    map[i] = i * 2;
+  }
+  EXPECT_EQ(10000u, map.size());
+  for (int i = 0; i < 10000; i++) {
+    ASSERT_EQ(i * 2, map.find(i)->second);
+  }
+  EXPECT_TRUE(map.find(10000) == map.end());
+
+  for (int i = 0; i < 10000; i += 2) {
+    EXPECT_EQ(1u, map.erase(i));
+  }
+  EXPECT_EQ(5000u, map.size());
+  for (int i = 0; i < 10000; i++) {
+    ASSERT_EQ(i % 2, static_cast<int>(map.count(i)));
+  }
+}
+
+TEST(MyHashMap, GroupProbing_Iteration) {
+  util::hash_map<std::string, int, std::equal_to<>, util::hash<std::string>, util::group_probing> map;
+  int sum = 0;
+  for (int i = 0; i < 500; i++) {
+    map[std::to_string(i)] = i;
+    sum += i;
+  }
+
+  int seen = 0;
+  size_t count = 0;
+  for (const auto& element : map) {
+    seen += element.second;
+    count++;
+  }
+  EXPECT_EQ(map.size(), count);
+  EXPECT_EQ(sum, seen);
+
+  // Erase every element through iterators.
+  for (auto it = map.begin(); it != map.end();) {
+    it = map.erase(it);
+  }
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.begin() == map.end());
+}
+
+TEST(MyHashMap, GroupProbing_CopyAndMove) {
+  util::hash_map<std::string, int, std::equal_to<>, util::hash<std::string>, util::group_probing>
+    map1{ { "one", 1 }, { "two", 2 }, { "three", 3 } };
+  map1.erase("two");
+
+  auto map2 = map1;
+  EXPECT_EQ(2u, map2.size());
+  EXPECT_EQ(3, map2.find("three")->second);
+  EXPECT_TRUE(map2.find("two") == map2.end());
+
+  auto map3 = std::move(map1);
+  EXPECT_EQ(2u, map3.size());
+  EXPECT_EQ(1, map3.find("one")->second);
+}
+
+TEST(MyHashMap, GrowsWithLoadFactor) {
+  util::hash_map<int, int> map;
+  EXPECT_FLOAT_EQ(1.0f, map.max_load_factor());
+  for (int i = 0; i < 100000; i++) {
+    map[i] = i;
+  }
+  EXPECT_LE(map.load_factor(), map.max_load_factor());
+  EXPECT_GT(map.bucket_count(), 100000u);
+  for (int i = 0; i < 100000; i++) {
+    ASSERT_EQ(i, map.find(i)->second);
+  }
+}
+
+TEST(MyHashMap, RehashAndReserve) {
+  util::hash_map<std::string, int> map;
+  map.max_load_factor(0.5f);
+  map.reserve(1000);
+  EXPECT_GE(map.bucket_count(), 2000u);
+
+  size_t buckets = map.bucket_count();
+  for (int i = 0; i < 1000; i++) {
+    map[std::to_string(i)] = i;
+  }
+  EXPECT_EQ(buckets, map.bucket_count());
+
+  // rehash never drops below what the elements need.
+  map.rehash(1);
+  EXPECT_LE(map.load_factor(), 0.5f);
+  EXPECT_EQ(1000u, map.size());
+  EXPECT_EQ(999, map.find("999")->second);
+
+  EXPECT_THROW(map.max_load_factor(0.0f), std::invalid_argument);
+}
+
+TEST(MyHashMap, GroupProbing_RehashAndReserve) {
+  util::hash_map<int, int, std::equal_to<>, util::hash<int>, util::group_probing> map;
+  map.reserve(1000);
+  size_t buckets = map.bucket_count();
+  for (int i = 0; i < 1000; i++) {
+    map[i] = i;
+  }
+  EXPECT_EQ(buckets, map.bucket_count());
+  EXPECT_LE(map.load_factor(), map.max_load_factor());
+
+  map.rehash(0);
+  EXPECT_EQ(1000u, map.size());
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(i, map.find(i)->second);
+  }
+}
+
+TEST(MyHashMap, IncrementalChaining_InsertFindErase) {
+  util::hash_map<int, int, std::equal_to<>, util::hash<int>, util::incremental_chaining> map;
+  std::vector<const int*> values;
+  for (int i = 0; i < 20000; i++) {
+    map[i] = i;
+    values.push_back(&map.find(i)->second);
+  }
+  EXPECT_EQ(20000u, map.size());
+
+  // Every element is found, whichever bucket array holds it, and growth
+  // never moved an element in memory.
+  for (int i = 0; i < 20000; i++) {
+    ASSERT_EQ(values[i], &map.find(i)->second);
+  }
+
+  size_t count = 0;
+  for (const auto& element : map) {
+    EXPECT_EQ(element.first, element.second);
+    count++;
+  }
+  EXPECT_EQ(map.size(), count);
+
+  for (int i = 0; i < 20000; i += 2) {
+    EXPECT_EQ(1u, map.erase(i));
+  }
+  EXPECT_EQ(10000u, map.size());
+  for (int i = 0; i < 20000; i++) {
+    ASSERT_EQ(i % 2, static_cast<int>(map.count(i)));
+  }
+}
+
+TEST(MyHashMap, IncrementalChaining_BucketInterface) {
+  util::hash_map<int, int, std::equal_to<>, util::hash<int>, util::incremental_chaining> map;
+  for (int i = 0; i < 500; i++) {
+    map[i] = i;
+  }
+
+  // Every element is in the bucket reported for its key, even while an
+  // old bucket array is still being drained.
+  size_t count = 0;
+  for (size_t n = 0; n < map.bucket_count(); n++) {
+    for (auto it = map.begin(n); it != map.end(n); ++it) {
+      EXPECT_EQ(n, map.bucket(it->first));
+      count++;
+    }
+  }
+  EXPECT_EQ(map.size(), count);
+}
+
+TEST(MyHashMap, TransparentLookup) {
+  util::hash_map<std::string, int> map;
+  map["alpha"] = 1;
+  map[std::string_view("beta")] = 2;
+  map[std::string("gamma")] = 3;
+  EXPECT_EQ(map.size(), 3u);
+
+  std::string_view view = "alpha";
+  EXPECT_NE(map.find(view), map.end());
+  EXPECT_EQ(map.find(view)->second, 1);
+  EXPECT_EQ(map.count("beta"), 1u);
+  EXPECT_EQ(map.count(std::string_view("delta")), 0u);
+  EXPECT_EQ(map.find("delta"), map.end());
+
+  const auto& constMap = map;
+  auto range = constMap.equal_range(std::string_view("gamma"));
+  ASSERT_NE(range.first, constMap.end());
+  EXPECT_EQ(range.first->first, "gamma");
+  EXPECT_EQ(std::next(range.first), range.second);
+  range = constMap.equal_range(std::string_view("delta"));
+  EXPECT_EQ(range.first, range.second);
+
+  EXPECT_EQ(map.erase(std::string_view("alpha")), 1u);
+  EXPECT_EQ(map.erase("alpha"), 0u);
+  EXPECT_EQ(map.size(), 2u);
+}
+
+TEST(MyHashMap, GroupProbing_TransparentLookup) {
+  util::hash_map<std::string, int, std::equal_to<>, util::hash<std::string>,
+    util::group_probing> map;
+  for (int i = 0; i < 100; i++) {
+    map[std::to_string(i)] = i;
+  }
+  for (int i = 0; i < 100; i++) {
+    std::string key = std::to_string(i);
+    auto it = map.find(std::string_view(key));
+    ASSERT_NE(it, map.end());
+    EXPECT_EQ(it->second, i);
+  }
+  EXPECT_EQ(map.erase("42"), 1u);
+  EXPECT_EQ(map.count("42"), 0u);
+  EXPECT_EQ(map.size(), 99u);
+}
+
+TEST(MyHashMap, EmplaceAndTryEmplace) {
+  util::hash_map<std::string, std::unique_ptr<int>> map;
+  auto result = map.emplace("one", std::make_unique<int>(1));
+  EXPECT_TRUE(result.second);
+  EXPECT_EQ(*result.first->second, 1);
+  EXPECT_FALSE(map.emplace("one", std::make_unique<int>(2)).second);
+
+  // A failed try_emplace() leaves its arguments alone.
+  auto value = std::make_unique<int>(3);
+  EXPECT_FALSE(map.try_emplace("one", std::move(value)).second);
+  ASSERT_NE(value, nullptr);
+  EXPECT_TRUE(map.try_emplace("three", std::move(value)).second);
+  EXPECT_EQ(value, nullptr);
+  EXPECT_EQ(*map["three"], 3);
+
+  std::pair<const std::string, std::unique_ptr<int>> element("four", std::make_unique<int>(4));
+  EXPECT_TRUE(map.insert(std::move(element)).second);
+  EXPECT_EQ(*map["four"], 4);
+  EXPECT_EQ(map.size(), 3u);
+}
+
+TEST(MyHashMap, InsertOrAssign) {
+  util::hash_map<std::string, std::string, std::equal_to<>, util::hash<std::string>,
+    util::group_probing> map;
+  EXPECT_TRUE(map.insert_or_assign("key", "first").second);
+  EXPECT_FALSE(map.insert_or_assign("key", "second").second);
+  EXPECT_EQ(map["key"], "second");
+  EXPECT_EQ(map.size(), 1u);
+}
+
+TEST(MyHashMap, ExtractAndInsertNode) {
+  util::hash_map<int, std::string> source;
+  util::hash_map<int, std::string> target;
+  for (int i = 0; i < 100; i++) {
+    source[i] = std::to_string(i);
+  }
+  const std::string* address = &source[42];
+
+  auto node = source.extract(42);
+  ASSERT_FALSE(node.empty());
+  EXPECT_EQ(node.key(), 42);
+  EXPECT_EQ(node.mapped(), "42");
+  EXPECT_EQ(source.size(), 99u);
+  EXPECT_EQ(source.count(42), 0u);
+  EXPECT_TRUE(source.extract(42).empty());
+
+  auto result = target.insert(std::move(node));
+  EXPECT_TRUE(result.inserted);
+  EXPECT_TRUE(result.node.empty());
+  EXPECT_EQ(result.position->second, "42");
+  // Chaining moves the element's memory along with the node.
+  EXPECT_EQ(&target[42], address);
+
+  // A node whose key is taken comes back.
+  source[7] = "other";
+  target[7] = "seven";
+  result = target.insert(source.extract(source.find(7)));
+  EXPECT_FALSE(result.inserted);
+  EXPECT_EQ(result.node.mapped(), "other");
+  EXPECT_EQ(result.position->second, "seven");
+}
+
+TEST(MyHashMap, GroupProbing_ExtractAndInsertNode) {
+  using Map = util::hash_map<int, std::unique_ptr<int>, std::equal_to<>, util::hash<int>,
+    util::group_probing>;
+  Map source;
+  Map target;
+  for (int i = 0; i < 100; i++) {
+    source.try_emplace(i, std::make_unique<int>(i));
+  }
+  for (int i = 0; i < 100; i += 2) {
+    EXPECT_TRUE(target.insert(source.extract(i)).inserted);
+  }
+  EXPECT_EQ(source.size(), 50u);
+  EXPECT_EQ(target.size(), 50u);
+  for (int i = 0; i < 100; i++) {
+    Map& holder = i % 2 == 0 ? target : source;
+    ASSERT_NE(holder.find(i), holder.end());
+    EXPECT_EQ(*holder.find(i)->second, i);
+  }
+}
+
+TEST(MyHashMap, FindBatch) {
+  util::hash_map<int, int> map;
+  for (int i = 0; i < 1000; i += 2) {
+    map[i] = i * 10;
+  }
+  // More keys than one batch, half of them missing.
+  std::vector<int> keys;
+  for (int i = 0; i < 100; i++) {
+    keys.push_back(i * 7 % 1000);
+  }
+  std::vector<util::hash_map<int, int>::iterator> found;
+  map.find_batch(keys.begin(), keys.end(), std::back_inserter(found));
+  ASSERT_EQ(found.size(), keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    EXPECT_EQ(found[i], map.find(keys[i]));
+  }
+  found[0]->second = -1;
+  EXPECT_EQ(map[0], -1);
+
+  bool present[100];
+  const auto& constMap = map;
+  bool* end = constMap.contains_batch(keys.begin(), keys.end(), present);
+  EXPECT_EQ(end, present + 100);
+  for (size_t i = 0; i < keys.size(); i++) {
+    EXPECT_EQ(present[i], keys[i] % 2 == 0);
+  }
+  std::vector<util::hash_map<int, int>::const_iterator> constFound(keys.size());
+  constMap.find_batch(keys.begin(), keys.end(), constFound.begin());
+  EXPECT_EQ(constFound[1], constMap.find(7));
+
+  // An empty range writes nothing.
+  EXPECT_EQ(map.contains_batch(keys.begin(), keys.begin(), present), present);
+}
+
+TEST(MyHashMap, GroupProbing_FindBatch) {
+  util::hash_map<std::string, int, std::equal_to<>, util::hash<std::string>, util::group_probing> map;
+  for (int i = 0; i < 50; i++) {
+    map[std::to_string(i)] = i;
+  }
+  // Transparent keys are looked up without building strings.
+  std::vector<std::string_view> keys = { "0", "49", "50", "7", "", "12" };
+  std::vector<bool> present;
+  map.contains_batch(keys.begin(), keys.end(), std::back_inserter(present));
+  EXPECT_EQ(present, std::vector<bool>({ true, true, false, true, false, true }));
+
+  std::vector<decltype(map)::iterator> found;
+  map.find_batch(keys.begin(), keys.end(), std::back_inserter(found));
+  EXPECT_EQ(found[1]->second, 49);
+  EXPECT_EQ(found[2], map.end());
+}
+
+// Inserts a few keys into a map with many buckets, then checks forward
+// and backward iteration, and erasing from the front until it's empty.
+template <typename Map>
+void checkSparseIteration(Map& map) {
+  map.reserve(100000);
+  std::set<int> keys;
+  for (int i = 0; i < 20; i++) {
+    map[i * 7919] = i;
+    keys.insert(i * 7919);
+  }
+  std::set<int> seen;
+  for (const auto& element : map) {
+    seen.insert(element.first);
+  }
+  EXPECT_EQ(seen, keys);
+  seen.clear();
+  for (auto it = map.end(); it != map.begin();) {
+    --it;
+    seen.insert(it->first);
+  }
+  EXPECT_EQ(seen, keys);
+
+  // Erasing the first element moves begin() on to the next one.
+  size_t erased = 0;
+  while (!map.empty()) {
+    auto first = map.begin();
+    EXPECT_EQ(keys.erase(first->first), 1u);
+    map.erase(first);
+    erased++;
+    if (erased == 10) {
+      map[-1] = -1;
+      keys.insert(-1);
+    }
+  }
+  EXPECT_EQ(erased, 21u);
+  EXPECT_TRUE(keys.empty());
+  EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(MyHashMap, SparseIteration) {
+  util::hash_map<int, int> map;
+  checkSparseIteration(map);
+}
+
+TEST(MyHashMap, IncrementalChaining_SparseIteration) {
+  util::hash_map<int, int, std::equal_to<>, util::hash<int>, util::incremental_chaining> map;
+  // Stop halfway through a migration first.
+  for (int i = 0; i < 1000; i++) {
+    map[-i - 2] = i;
+  }
+  std::set<int> seen;
+  for (const auto& element : map) {
+    seen.insert(element.first);
+  }
+  EXPECT_EQ(seen.size(), 1000u);
+
+  // Keep inserting, which moves the migration along, while evicting from
+  // the front.
+  for (int i = 0; i < 2000; i++) {
+    map[i] = i;
+    seen.insert(i);
+    EXPECT_EQ(seen.erase(map.begin()->first), 1u);
+    map.erase(map.begin());
+  }
+  EXPECT_EQ(map.size(), 1000u);
+  for (int key : seen) {
+    EXPECT_NE(map.find(key), map.end());
+  }
+  map.clear();
+  checkSparseIteration(map);
+}
+
+TEST(MyHashMap, GroupProbing_SparseIteration) {
+  util::hash_map<int, int, std::equal_to<>, util::hash<int>, util::group_probing> map;
+  checkSparseIteration(map);
+}
+
+TEST(MyHashMap, RobinHood_InsertFindErase) {
+  util::hash_map<int, int, std::equal_to<>, util::hash<int>, util::robin_hood> map;
+  for (int i = 0; i < 10000; i++) {
+    map[i] = i * 2;
+  }
+  EXPECT_EQ(10000u, map.size());
+  EXPECT_LE(map.load_factor(), map.max_load_factor());
+  for (int i = 0; i < 10000; i++) {
+    ASSERT_EQ(i * 2, map.find(i)->second);
+  }
+  EXPECT_TRUE(map.find(10000) == map.end());
+
+  for (int i = 0; i < 10000; i += 2) {
+    EXPECT_EQ(1u, map.erase(i));
+  }
+  EXPECT_EQ(5000u, map.size());
+  for (int i = 0; i < 10000; i++) {
+    ASSERT_EQ(i % 2, static_cast<int>(map.count(i)));
+  }
+}
+
+TEST(MyHashMap, RobinHood_EraseThroughIterators) {
+  util::hash_map<std::string, int, std::equal_to<>, util::hash<std::string>, util::robin_hood> map;
+  for (int i = 0; i < 500; i++) {
+    map[std::to_string(i)] = i;
+  }
+
+  // Backward-shift deletion moves the following elements into the erased
+  // slot; none of them may be skipped.
+  size_t visited = 0;
+  for (auto it = map.begin(); it != map.end();) {
+    visited++;
+    if (it->second % 3 == 0) {
+      it = map.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  EXPECT_EQ(500u, visited);
+  EXPECT_EQ(333u, map.size());
+  for (int i = 0; i < 500; i++) {
+    ASSERT_EQ(i % 3 != 0, map.count(std::to_string(i)) == 1);
+  }
+
+  auto it = map.erase(map.begin(), map.end());
+  EXPECT_TRUE(it == map.end());
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(MyHashMap, RobinHood_CopyAndMove) {
+  util::hash_map<std::string, int, std::equal_to<>, util::hash<std::string>, util::robin_hood>
+    map1{ { "one", 1 }, { "two", 2 }, { "three", 3 } };
+  map1.erase("two");
+
+  auto map2 = map1;
+  EXPECT_EQ(2u, map2.size());
+  EXPECT_EQ(3, map2.find("three")->second);
+  EXPECT_TRUE(map2.find("two") == map2.end());
+
+  auto map3 = std::move(map1);
+  EXPECT_EQ(2u, map3.size());
+  EXPECT_EQ(1, map3.find("one")->second);
+}
+
+TEST(MyHashMap, RobinHood_SparseIteration) {
+  util::hash_map<int, int, std::equal_to<>, util::hash<int>, util::robin_hood> map;
+  checkSparseIteration(map);
+}
+
+TEST(MyHashMap, Cuckoo_InsertFindErase) {
+  util::hash_map<int, int, std::equal_to<>, util::hash<int>, util::cuckoo> map;
+  for (int i = 0; i < 10000; i++) {
+    map[i] = i * 2;
+  }
+  EXPECT_EQ(10000u, map.size());
+  EXPECT_LE(map.load_factor(), map.max_load_factor());
+  for (int i = 0; i < 10000; i++) {
+    ASSERT_EQ(i * 2, map.find(i)->second);
+  }
+  EXPECT_TRUE(map.find(10000) == map.end());
+
+  for (int i = 0; i < 10000; i += 2) {
+    EXPECT_EQ(1u, map.erase(i));
+  }
+  EXPECT_EQ(5000u, map.size());
+  for (int i = 0; i < 10000; i++) {
+    ASSERT_EQ(i % 2, static_cast<int>(map.count(i)));
+  }
+}
+
+TEST(MyHashMap, Cuckoo_HighLoadFactor) {
+  util::hash_map<std::string, int, std::equal_to<>, util::hash<std::string>, util::cuckoo> map;
+  map.max_load_factor(0.95f);
+  map.reserve(4000);
+  size_t buckets = map.bucket_count();
+  for (int i = 0; i < 3800; i++) {
+    map[std::to_string(i)] = i;
+  }
+  EXPECT_EQ(buckets, map.bucket_count());
+  for (int i = 0; i < 3800; i++) {
+    ASSERT_EQ(i, map.find(std::to_string(i))->second);
+  }
+
+  auto map2 = map;
+  EXPECT_EQ(3800u, map2.size());
+  EXPECT_EQ(17, map2.find("17")->second);
+}
+
+TEST(MyHashMap, Cuckoo_SparseIteration) {
+  util::hash_map<int, int, std::equal_to<>, util::hash<int>, util::cuckoo> map;
+  checkSparseIteration(map);
+}
+
+TEST(MyHashMap, ProbeStats) {
+  util::hash_map<int, int, std::equal_to<>, util::hash<int>, util::robin_hood> robinHood;
+  util::hash_map<int, int, std::equal_to<>, util::hash<int>, util::cuckoo> cuckoo;
+  util::hash_map<int, int> chaining;
+  EXPECT_EQ(0u, robinHood.probe_stats().size);
+  EXPECT_EQ(0.0, robinHood.probe_stats().mean_probe_length);
+
+  for (int i = 0; i < 5000; i++) {
+    robinHood[i] = i;
+    cuckoo[i] = i;
+    chaining[i] = i;
+  }
+  for (auto stats : { robinHood.probe_stats(), cuckoo.probe_stats(), chaining.probe_stats() }) {
+    EXPECT_EQ(5000u, stats.size);
+    EXPECT_GE(stats.mean_probe_length, 1.0);
+    EXPECT_LE(stats.mean_probe_length, stats.max_probe_length);
+    EXPECT_EQ(stats.max_probe_length, stats.displacement_histogram.size());
+    size_t total = 0;
+    for (size_t count : stats.displacement_histogram) {
+      total += count;
+    }
+    EXPECT_EQ(5000u, total);
+  }
+  EXPECT_LE(cuckoo.probe_stats().max_probe_length, 2u);
+  EXPECT_GT(cuckoo.probe_stats().kicks, 0u);
+}
+
+TEST(MyHashMap, RejectsConstantHash) {
+  struct constant_hash {
+    size_t operator()(int) const { return 42; }
+  };
+  util::hash_map<int, int, std::equal_to<>, constant_hash, util::robin_hood> robinHood;
+  util::hash_map<int, int, std::equal_to<>, constant_hash, util::cuckoo> cuckoo;
+  for (int i = 0; i < 4; i++) {
+    robinHood[i] = i;
+    cuckoo[i] = i;
+  }
+  EXPECT_THROW(for (int i = 0; i < 1000; i++) robinHood[i] = i, std::overflow_error);
+  EXPECT_THROW(for (int i = 0; i < 1000; i++) cuckoo[i] = i, std::overflow_error);
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(i, robinHood.find(i)->second);
+    EXPECT_EQ(i, cuckoo.find(i)->second);
+  }
+}
+
+// After reserve(n), n insertions don't grow the table.
+template <typename Policy>
+void ExpectReserveMakesRoom() {
+  for (size_t n : { 1, 10, 56, 100, 1000, 5000, 100000 }) {
+    util::hash_map<size_t, size_t, std::equal_to<>, util::hash<size_t>, Policy> map;
+    map.reserve(n);
+    size_t buckets = map.bucket_count();
+    for (size_t i = 0; i < n; i++) {
+      map.emplace(i, i);
+    }
+    EXPECT_EQ(buckets, map.bucket_count()) << n << " elements";
+  }
+}
+
+TEST(MyHashMap, ReserveMakesRoom) {
+  ExpectReserveMakesRoom<util::chaining>();
+  ExpectReserveMakesRoom<util::incremental_chaining>();
+  ExpectReserveMakesRoom<util::group_probing>();
+  ExpectReserveMakesRoom<util::robin_hood>();
+  ExpectReserveMakesRoom<util::cuckoo>();
+  ExpectReserveMakesRoom<util::cached_hash<util::robin_hood>>();
+}
+
+// Throws once more than *mBudget calls are made, if mBudget is set.
+struct budget_hash {
+  std::shared_ptr<size_t> mBudget = std::make_shared<size_t>(std::numeric_limits<size_t>::max());
+
+  size_t operator()(int key) const {
+    if (*mBudget == 0) {
+      throw std::runtime_error("out of hashes");
+    }
+    --*mBudget;
+    return util::hash<int>()(key);
+  }
+};
+
+// Inserts keys with a budget of hash calls too small for a resize, and
+// checks that the failed resizes lose nothing.
+template <typename Policy>
+void ExpectResizeSurvivesThrowingHash(size_t budget = 20) {
+  budget_hash hasher;
+  util::hash_map<int, std::string, std::equal_to<>, budget_hash, Policy> map(std::equal_to<>(), 16, hasher);
+  int inserted = 0;
+  int failed = 0;
+  for (int i = 0; i < 1000; i++) {
+    *hasher.mBudget = budget;
+    try {
+      map.emplace(i, std::to_string(i));
+      inserted++;
+    } catch (const std::runtime_error&) {
+      failed++;
+    }
+  }
+  *hasher.mBudget = std::numeric_limits<size_t>::max();
+  EXPECT_GT(failed, 0);
+  EXPECT_EQ(static_cast<size_t>(inserted), map.size());
+  for (int i = 0; i < inserted; i++) {
+    auto itr = map.find(i);
+    ASSERT_TRUE(itr != map.end());
+    EXPECT_EQ(std::to_string(i), itr->second);
+  }
+  size_t count = 0;
+  for (const auto& entry : map) {
+    EXPECT_EQ(std::to_string(entry.first), entry.second);
+    count++;
+  }
+  EXPECT_EQ(map.size(), count);
+
+  // Once the hash works again, the table still grows.
+  for (int i = inserted; i < 1000; i++) {
+    map.emplace(i, std::to_string(i));
+  }
+  EXPECT_EQ(1000u, map.size());
+}
+
+TEST(MyHashMap, RobinHood_ResizeSurvivesThrowingHash) {
+  ExpectResizeSurvivesThrowingHash<util::robin_hood>();
+}
+
+TEST(MyHashMap, Cuckoo_ResizeSurvivesThrowingHash) {
+  ExpectResizeSurvivesThrowingHash<util::cuckoo>();
+}
+
+TEST(MyHashMap, GroupProbing_ResizeSurvivesThrowingHash) {
+  ExpectResizeSurvivesThrowingHash<util::group_probing>();
+}
+
+TEST(MyHashMap, Chaining_ResizeSurvivesThrowingHash) {
+  ExpectResizeSurvivesThrowingHash<util::chaining>();
+}
+
+TEST(MyHashMap, IncrementalChaining_ResizeSurvivesThrowingHash) {
+  // Each insert migrates a few buckets, so only a tight budget fails.
+  ExpectResizeSurvivesThrowingHash<util::incremental_chaining>(3);
+}
+
+TEST(MyHashMap, CachedHash_InsertFindErase) {
+  util::hash_map<std::string, int, std::equal_to<>, util::hash<std::string>,
+    util::cached_hash<util::chaining>> map;
+  for (int i = 0; i < 2000; i++) {
+    map[std::to_string(i)] = i;
+  }
+  EXPECT_EQ(2000u, map.size());
+  EXPECT_EQ(1234, map.find("1234")->second);
+  EXPECT_EQ(1234, map.find(std::string_view("1234"))->second);
+  EXPECT_TRUE(map.find("2000") == map.end());
+  EXPECT_TRUE(map.emplace("2000", 2000).second);
+  EXPECT_FALSE(map.emplace("1234", 0).second);
+  EXPECT_EQ(1u, map.erase("2000"));
+
+  for (int i = 0; i < 2000; i += 2) {
+    EXPECT_EQ(1u, map.erase(std::to_string(i)));
+  }
+  EXPECT_EQ(1000u, map.size());
+  size_t count = 0;
+  for (const auto& element : map) {
+    EXPECT_EQ(1, element.second % 2);
+    count++;
+  }
+  EXPECT_EQ(1000u, count);
+
+  size_t inBuckets = 0;
+  for (size_t n = 0; n < map.bucket_count(); n++) {
+    for (auto it = map.begin(n); it != map.end(n); ++it) {
+      EXPECT_EQ(n, map.bucket(it->first));
+      inBuckets++;
+    }
+  }
+  EXPECT_EQ(1000u, inBuckets);
+}
+
+TEST(MyHashMap, CachedHash_GroupProbing) {
+  util::hash_map<std::string, int, std::equal_to<>, util::hash<std::string>,
+    util::cached_hash<util::group_probing>> map1;
+  for (int i = 0; i < 2000; i++) {
+    map1[std::to_string(i)] = i;
+  }
+  auto map2 = map1;
+  for (auto it = map1.begin(); it != map1.end();) {
+    it = map1.erase(it);
+  }
+  EXPECT_TRUE(map1.empty());
+  EXPECT_EQ(2000u, map2.size());
+  for (int i = 0; i < 2000; i++) {
+    ASSERT_EQ(i, map2.find(std::to_string(i))->second);
+  }
+}
+
+TEST(MyHashMap, CachedHash_HashesEachKeyOnce) {
+  using counting = util::counting_hash<util::hash<std::string>>;
+  util::hash_map<std::string, int, std::equal_to<>, counting> plain;
+  util::hash_map<std::string, int, std::equal_to<>, counting, util::cached_hash<util::chaining>> cached;
+  for (int i = 0; i < 10000; i++) {
+    plain[std::to_string(i)] = i;
+    cached[std::to_string(i)] = i;
+  }
+  // Growing the plain map rehashes the keys it holds at the time.
+  EXPECT_GT(plain.hash_function().calls(), 15000u);
+  EXPECT_EQ(10000u, cached.hash_function().calls());
+
+  cached.rehash(100000);
+  cached.erase(cached.begin());
+  EXPECT_EQ(10000u, cached.hash_function().calls());
+  EXPECT_EQ(9999u, cached.size());
+}
+
+TEST(MyHashMap, CachedHash_SkipsComparisons) {
+  using equal = util::counting_equal<>;
+  util::hash_map<int, int, equal> plain;
+  util::hash_map<int, int, equal, util::hash<int>, util::cached_hash<util::chaining>> cached;
+  for (int i = 0; i < 1000; i++) {
+    plain[i] = i;
+    cached[i] = i;
+  }
+  plain.key_eq().reset_calls();
+  cached.key_eq().reset_calls();
+
+  // Integer hashes never collide, so the cached map never compares keys
+  // that differ.
+  for (int i = 1000; i < 2000; i++) {
+    EXPECT_TRUE(plain.find(i) == plain.end());
+    EXPECT_TRUE(cached.find(i) == cached.end());
+  }
+  EXPECT_GT(plain.key_eq().calls(), 0u);
+  EXPECT_EQ(0u, cached.key_eq().calls());
+
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(i, cached.find(i)->second);
+  }
+  EXPECT_EQ(1000u, cached.key_eq().calls());
+}
+
+TEST(MyHashMap, CachedHash_NodeKeepsUpWithSeeds) {
+  using map_type = util::hash_map<int, int, std::equal_to<>, util::hash<int>,
+    util::cached_hash<util::chaining>>;
+  map_type map1(std::equal_to<>(), 101, util::hash<int>(1));
+  map_type map2(std::equal_to<>(), 101, util::hash<int>(2));
+  for (int i = 0; i < 100; i++) {
+    map1[i] = i;
+  }
+  for (int i = 0; i < 100; i++) {
+    EXPECT_TRUE(map2.insert(map1.extract(i)).inserted);
+  }
+  EXPECT_TRUE(map1.empty());
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(i, map2.find(i)->second);
+  }
+  map2.rehash(1000);
+  EXPECT_EQ(42, map2.find(42)->second);
+}
+
+TEST(MyHashMap, BucketStats) {
+  util::hash_map<int, int> map;
+  util::bucket_stats empty = map.bucket_stats();
+  EXPECT_EQ(0u, empty.longest_chain);
+
+  for (int i = 0; i < 1000; i++) {
+    map[i] = i;
+  }
+  util::bucket_stats stats = map.bucket_stats();
+  EXPECT_EQ(map.bucket_count(), stats.bucket_count);
+  EXPECT_EQ(stats.longest_chain + 1, stats.occupancy_histogram.size());
+  size_t buckets = 0;
+  size_t elements = 0;
+  for (size_t k = 0; k < stats.occupancy_histogram.size(); k++) {
+    buckets += stats.occupancy_histogram[k];
+    elements += k * stats.occupancy_histogram[k];
+  }
+  EXPECT_EQ(stats.bucket_count, buckets);
+  EXPECT_EQ(1000u, elements);
+  EXPECT_LT(stats.longest_chain, 10u);
+
+  // A hash that ignores the key puts everything in one bucket.
+  struct constant_hash {
+    size_t operator()(int) const { return 7; }
+  };
+  util::hash_map<int, int, std::equal_to<>, constant_hash> bad;
+  for (int i = 0; i < 100; i++) {
+    bad[i] = i;
+  }
+  EXPECT_EQ(100u, bad.bucket_stats().longest_chain);
+}
+
+// Builds a map from 200000 pairs, about one in four with a key seen
+// before, on four threads, and checks it against the range constructor.
+template <typename Map>
+void checkParallelBuild(unsigned threads) {
+  std::vector<std::pair<int, int>> pairs;
+  for (int i = 0; i < 200000; i++) {
+    int key = i % 4 == 3 ? i / 2 : i;
+    pairs.emplace_back(key, i);
+  }
+  Map expected(pairs.begin(), pairs.end());
+  Map map(util::parallel_build{ threads }, pairs.begin(), pairs.end());
+  ASSERT_EQ(expected.size(), map.size());
+  for (const auto& element : expected) {
+    auto it = map.find(element.first);
+    ASSERT_TRUE(it != map.end());
+    // The first occurrence of a key wins.
+    ASSERT_EQ(element.second, it->second);
+  }
+  size_t count = 0;
+  for (auto it = map.begin(); it != map.end(); ++it) {
+    count++;
+  }
+  EXPECT_EQ(map.size(), count);
+
+  // The map is an ordinary one afterwards.
+  for (int i = 0; i < 100000; i++) {
+    map[-i - 1] = i;
+  }
+  EXPECT_EQ(expected.size() + 100000, map.size());
+  EXPECT_EQ(5, map.find(-6)->second);
+}
+
+TEST(MyHashMap, ParallelBuild) {
+  using Equal = std::equal_to<>;
+  using Hash = util::hash<int>;
+  checkParallelBuild<util::hash_map<int, int>>(4);
+  checkParallelBuild<util::hash_map<int, int, Equal, Hash, util::incremental_chaining>>(3);
+  checkParallelBuild<util::hash_map<int, int, Equal, Hash, util::group_probing>>(4);
+  checkParallelBuild<util::hash_map<int, int, Equal, Hash, util::cached_hash<util::group_probing>>>(8);
+  // Policies without partitioned filling hash in parallel only.
+  checkParallelBuild<util::hash_map<int, int, Equal, Hash, util::robin_hood>>(4);
+  checkParallelBuild<util::hash_map<int, int, Equal, Hash, util::cuckoo>>(2);
+  // One thread, or a small range, is the ordinary range constructor.
+  checkParallelBuild<util::hash_map<int, int, Equal, Hash, util::group_probing>>(1);
+
+  std::vector<std::pair<int, int>> few{ { 1, 1 }, { 2, 2 }, { 1, 3 } };
+  util::hash_map<int, int> small(util::parallel_build{}, few.begin(), few.end());
+  EXPECT_EQ(2u, small.size());
+  EXPECT_EQ(1, small.find(1)->second);
+}
+
+TEST(MyHashMap, ParallelBuildRethrows) {
+  struct throwing_hash {
+    size_t operator()(int key) const {
+      if (key == 123456) {
+        throw std::runtime_error("bad key");
+      }
+      return util::hash<int>()(key);
+    }
+  };
+  std::vector<std::pair<int, int>> pairs;
+  for (int i = 0; i < 200000; i++) {
+    pairs.emplace_back(i, i);
+  }
+  using Map = util::hash_map<int, int, std::equal_to<>, throwing_hash, util::group_probing>;
+  EXPECT_THROW(Map(util::parallel_build{ 4 }, pairs.begin(), pairs.end()), std::runtime_error);
+}
+
+TEST(MyHash, StringsDependOnOrder) {
+  util::hash<std::string> hasher;
+  EXPECT_NE(hasher("ab"), hasher("ba"));
+  EXPECT_NE(hasher(""), hasher(std::string(1, '\0')));
+  EXPECT_EQ(hasher("hash_map"), util::hash<std::string_view>()("hash_map"));
+
+  // Long inputs take the multi-lane path.
+  std::string longKey(1000, 'x');
+  std::string otherKey = longKey;
+  otherKey[500] = 'y';
+  EXPECT_NE(hasher(longKey), hasher(otherKey));
+}
+
+TEST(MyHash, Seeds) {
+  util::hash<int> hasher1(1);
+  util::hash<int> hasher2(2);
+  EXPECT_NE(hasher1(42), hasher2(42));
+  EXPECT_EQ(hasher1(42), util::hash<int>(1)(42));
+
+  util::hash<std::string> stringHasher1(1);
+  util::hash<std::string> stringHasher2(2);
+  EXPECT_NE(stringHasher1("key"), stringHasher2("key"));
+}
+
+TEST(MyHash, FloatingPoint) {
+  util::hash<double> hasher;
+  EXPECT_EQ(hasher(0.0), hasher(-0.0));
+  EXPECT_NE(hasher(1.0), hasher(2.0));
+}
+
+TEST(MyHash, SmallIntegersSpreadOverBuckets) {
+  // Under a byte-sum hash, these keys fill only a handful of buckets.
+  util::hash_map<int, int> map(std::equal_to<>(), 1031);
+  map.max_load_factor(100.0f);
+  for (int i = 0; i < 10000; i++) {
+    map[i] = i;
+  }
+  size_t longest = 0;
+  for (size_t n = 0; n < map.bucket_count(); n++) {
+    longest = std::max(longest, map.bucket_size(n));
+  }
+  EXPECT_LT(longest, 40u);
+}
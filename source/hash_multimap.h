@@ -0,0 +1,721 @@
+#ifndef HASH_MULTIMAP_H_
+#define HASH_MULTIMAP_H_
+
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "hash_map.h"
+
+namespace util {
+
+	// A hash map that can hold any number of elements with the same key.
+	// Elements with equal keys are stored next to each other: a new one
+	// is linked in right after the last of them, and rehashing keeps the
+	// run together. equal_range() is therefore one contiguous span of the
+	// iteration order, and count() and erase() of a key walk only that
+	// span instead of the whole bucket.
+	//
+	// Keeping runs together needs a storage policy that can link an
+	// element in at a chosen spot, so Policy must be chaining,
+	// incremental_chaining, or cached_hash of either. Iterators, node
+	// handles and the bucket interface work as in hash_map.
+	template <typename Key, typename T,
+		typename KeyEqual = std::equal_to<>,
+		typename Hash = hash<Key>,
+		typename Policy = chaining,
+		typename Allocator = std::allocator<std::pair<const Key, T>>>
+	class hash_multimap
+	{
+	public:
+		using key_type = Key;
+		using mapped_type = T;
+		using value_type = std::pair<const Key, T>;
+		using hasher = Hash;
+		using key_equal = KeyEqual;
+		using storage_policy = Policy;
+		using allocator_type = Allocator;
+		using reference = value_type&;
+		using const_reference = const value_type&;
+		using size_type = size_t;
+		using difference_type = ptrdiff_t;
+		using hash_multimap_type = hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>;
+		using iterator = hash_map_iterator<hash_multimap_type>;
+		using const_iterator = const_hash_map_iterator<hash_multimap_type>;
+
+	private:
+		using table_type = typename Policy::template table<value_type, Allocator>;
+		using position = typename table_type::position;
+		// Yields K if both Hash and KeyEqual are transparent, and fails to
+		// substitute otherwise.
+		template <typename K>
+		using transparent_key = std::enable_if_t<
+			detail::is_transparent<Hash>::value && detail::is_transparent<KeyEqual>::value, K>;
+	public:
+		using local_iterator = typename table_type::local_iterator;
+		using const_local_iterator = typename table_type::const_local_iterator;
+		using node_type = hash_map_node<hash_multimap_type>;
+
+		// The iterator and node classes need access to all members of the hash_multimap
+		friend class hash_map_iterator<hash_multimap_type>;
+		friend class const_hash_map_iterator<hash_multimap_type>;
+		friend class hash_map_node<hash_multimap_type>;
+
+		// Virtual destructor
+		virtual ~hash_multimap() = default;
+
+		// Throws invalid_argument if the number of buckets is illegal.
+		explicit hash_multimap(const KeyEqual& equal = KeyEqual(), size_type numBuckets = 101, const Hash& hash = Hash(),
+			const Allocator& alloc = Allocator());
+
+		// Uses alloc for all of its memory, with the other defaults.
+		explicit hash_multimap(const Allocator& alloc);
+
+		// Throws invalid_argument if the number of buckets is illegal.
+		template <typename InputIterator>
+		hash_multimap(InputIterator first, InputIterator last, const KeyEqual& equal = KeyEqual(),
+			size_type numBuckets = 101, const Hash& hash = Hash(), const Allocator& alloc = Allocator());
+
+		// Throws invalid_argument if the number of buckets is illegal.
+		explicit hash_multimap(std::initializer_list<value_type> il, const KeyEqual& equal = KeyEqual(),
+			size_type numBuckets = 101, const Hash& hash = Hash(), const Allocator& alloc = Allocator());
+
+		hash_multimap(const hash_multimap_type& src) = default;
+		hash_multimap(hash_multimap_type&& src) noexcept = default;
+
+		hash_multimap_type& operator=(const hash_multimap_type& rhs);
+		hash_multimap_type& operator=(hash_multimap_type&& rhs) noexcept;
+		hash_multimap_type& operator=(std::initializer_list<value_type> il);
+
+		// Iterator methods
+		iterator begin();
+		iterator end();
+		const_iterator begin() const;
+		const_iterator end() const;
+		const_iterator cbegin() const;
+		const_iterator cend() const;
+
+		// Size methods
+		bool empty() const;
+		size_type size() const;
+		size_type max_size() const;
+
+		// Element insert methods. These always insert; the new element
+		// goes after those with an equal key.
+		iterator insert(const value_type& x);
+		iterator insert(value_type&& x);
+		iterator insert(const_iterator hint, const value_type& x);
+		iterator insert(const_iterator hint, value_type&& x);
+		template <typename InputIterator>
+		void insert(InputIterator first, InputIterator last);
+		void insert(std::initializer_list<value_type> il);
+		// Inserting an empty node does nothing, and returns end().
+		iterator insert(node_type&& node);
+		iterator insert(const_iterator hint, node_type&& node);
+
+		template <typename... Args>
+		iterator emplace(Args&&... args);
+		template <typename... Args>
+		iterator emplace_hint(const_iterator hint, Args&&... args);
+
+		// Element delete methods
+		// Takes an element out of the map without destroying it. extract()
+		// of a key returns the first element with it, or an empty node.
+		node_type extract(const_iterator position);
+		node_type extract(const key_type& k);
+		// Erases every element with key k, and returns how many there were.
+		size_type erase(const key_type& k);
+		template <typename K, typename = transparent_key<K>,
+			typename = std::enable_if_t<!std::is_convertible<const K&, const_iterator>::value>>
+		size_type erase(const K& k);
+		iterator erase(iterator position);
+		iterator erase(iterator first, iterator last);
+
+		// Other modifying utilities
+		void swap(hash_multimap_type& other) noexcept;
+		void clear() noexcept;
+
+		// Access methods for Standard Library conformity
+		key_equal key_eq() const;
+		hasher hash_function() const;
+		allocator_type get_allocator() const;
+
+		// Lookup methods. find() returns the first element with key k.
+		iterator find(const key_type& k);
+		const_iterator find(const key_type& k) const;
+		std::pair<iterator, iterator> equal_range(const key_type& k);
+		std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const;
+		size_type count(const key_type& k) const;
+
+		// Heterogeneous lookup, as in hash_map.
+		template <typename K, typename = transparent_key<K>>
+		iterator find(const K& k);
+		template <typename K, typename = transparent_key<K>>
+		const_iterator find(const K& k) const;
+		template <typename K, typename = transparent_key<K>>
+		std::pair<iterator, iterator> equal_range(const K& k);
+		template <typename K, typename = transparent_key<K>>
+		std::pair<const_iterator, const_iterator> equal_range(const K& k) const;
+		template <typename K, typename = transparent_key<K>>
+		size_type count(const K& k) const;
+
+		// Bucket interface, as in hash_map.
+		size_type bucket_count() const;
+		size_type max_bucket_count() const;
+		size_type bucket(const Key& k) const;
+		size_type bucket_size(size_type n) const;
+		local_iterator begin(size_type n);
+		const_local_iterator begin(size_type n) const;
+		const_local_iterator cbegin(size_type n) const;
+		local_iterator end(size_type n);
+		const_local_iterator end(size_type n) const;
+		const_local_iterator cend(size_type n) const;
+
+		// Hash policy methods, as in hash_map.
+		float load_factor() const;
+		float max_load_factor() const;
+		// Throws invalid_argument if ml is not positive.
+		void max_load_factor(float ml);
+		void rehash(size_type n);
+		void reserve(size_type n);
+
+		// Statistics, as in hash_map.
+		util::probe_stats probe_stats() const;
+		util::bucket_stats bucket_stats() const;
+
+	private:
+		// Returns the table positions of the first element with key k and
+		// of the element after the last one. Both are the table's end
+		// position if there is none.
+		template <typename K>
+		std::pair<position, position> findRange(const K& k) const;
+
+		template <typename K>
+		size_type eraseKey(const K& k);
+
+		// Links the element of a non-empty table node in after the
+		// elements with an equal key.
+		position insertNode(typename table_type::node& node);
+
+		// Returns a function object computing the hash of a stored element.
+		auto elementHasher() const;
+
+		table_type mTable;
+		KeyEqual mEqual;
+		Hash mHash;
+	};
+
+
+
+
+	// Create the storage table with the number of buckets.
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::hash_multimap(const KeyEqual& equal, size_type numBuckets, const Hash& hash, const Allocator& alloc)
+		: mTable((numBuckets == 0 ? throw std::invalid_argument("Number of buckets must be positive") : numBuckets), alloc),
+		mEqual(equal), mHash(hash)
+	{
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::hash_multimap(const Allocator& alloc)
+		: hash_multimap(KeyEqual(), 101, Hash(), alloc)
+	{
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename InputIterator>
+	hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::hash_multimap(InputIterator first, InputIterator last, const KeyEqual& equal, size_type numBuckets,
+		const Hash& hash, const Allocator& alloc)
+		: hash_multimap(equal, numBuckets, hash, alloc)
+	{
+		insert(first, last);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::hash_multimap(std::initializer_list<value_type> il, const KeyEqual& equal, size_type numBuckets,
+		const Hash& hash, const Allocator& alloc)
+		: hash_multimap(equal, numBuckets, hash, alloc)
+	{
+		insert(std::begin(il), std::end(il));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>& hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::operator=(const hash_multimap_type& rhs)
+	{
+		// Copy-and-swap idiom
+		if (this != &rhs) {
+			auto copy = rhs;
+			swap(copy);
+		}
+		return *this;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>& hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::operator=(hash_multimap_type&& rhs) noexcept
+	{
+		swap(rhs);
+		return *this;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>& hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::operator=(std::initializer_list<value_type> il)
+	{
+		hash_multimap_type newMap(il, mEqual, mTable.bucket_count(), mHash, get_allocator());
+		swap(newMap);
+		return *this;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K>
+	std::pair<typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::position, typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::position> hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::findRange(const K& k) const
+	{
+		auto equal = [this, &k](const value_type& element) { return mEqual(element.first, k); };
+		position first = mTable.find(mHash(k), equal);
+		position last = first;
+		if (first != mTable.end()) {
+			// The elements with key k are next to each other, so the range
+			// ends at the first one with another key.
+			do {
+				mTable.next(last);
+			} while (last != mTable.end() && equal(mTable.element(last)));
+		}
+		return std::make_pair(first, last);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	auto hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::elementHasher() const
+	{
+		return [this](const value_type& element) { return mHash(element.first); };
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::position hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::insertNode(typename table_type::node& node)
+	{
+		const Key& k = node.value().first;
+		return mTable.insert_equal(mHash(k),
+			[this, &k](const value_type& element) { return mEqual(element.first, k); }, elementHasher(), node);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::begin()
+	{
+		return iterator(mTable.first(), this);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::end()
+	{
+		return iterator(mTable.end(), this);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::begin() const
+	{
+		return const_iterator(mTable.first(), this);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::end() const
+	{
+		return const_iterator(mTable.end(), this);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::cbegin() const
+	{
+		return begin();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::cend() const
+	{
+		return end();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	bool hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::empty() const
+	{
+		return mTable.size() == 0;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::size() const
+	{
+		return mTable.size();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::max_size() const
+	{
+		return mTable.max_size();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::insert(const value_type& x)
+	{
+		const Key& k = x.first;
+		return iterator(mTable.emplace_equal(mHash(k),
+			[this, &k](const value_type& element) { return mEqual(element.first, k); }, elementHasher(), x), this);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::insert(value_type&& x)
+	{
+		// The table calls the predicate before it moves from x.
+		const Key& k = x.first;
+		return iterator(mTable.emplace_equal(mHash(k),
+			[this, &k](const value_type& element) { return mEqual(element.first, k); }, elementHasher(),
+			std::move(x)), this);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::insert(const_iterator /*hint*/, const value_type& x)
+	{
+		return insert(x);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::insert(const_iterator /*hint*/, value_type&& x)
+	{
+		return insert(std::move(x));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename InputIterator>
+	void hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::insert(InputIterator first, InputIterator last)
+	{
+		for (; first != last; ++first) {
+			insert(*first);
+		}
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::insert(std::initializer_list<value_type> il)
+	{
+		insert(std::begin(il), std::end(il));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::insert(node_type&& node)
+	{
+		if (node.empty()) {
+			return end();
+		}
+		return iterator(insertNode(node.mNode), this);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::insert(const_iterator /*hint*/, node_type&& node)
+	{
+		return insert(std::move(node));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename... Args>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::emplace(Args&&... args)
+	{
+		// Build the element in a node of its own to learn its key, then
+		// link that node into the table.
+		typename table_type::node node(mTable.get_allocator(), std::in_place, std::forward<Args>(args)...);
+		return iterator(insertNode(node), this);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename... Args>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::emplace_hint(const_iterator /*hint*/, Args&&... args)
+	{
+		return emplace(std::forward<Args>(args)...);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::node_type hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::extract(const_iterator position)
+	{
+		return node_type(mTable.extract(position.mPosition));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::node_type hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::extract(const key_type& k)
+	{
+		position pos = findRange(k).first;
+		if (pos == mTable.end()) {
+			return node_type();
+		}
+		node_type node(mTable.extract(pos));
+		// Give a pending incremental rehash the chance to progress.
+		mTable.rehash_step(elementHasher());
+		return node;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::erase(const key_type& k)
+	{
+		return eraseKey(k);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename, typename>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::erase(const K& k)
+	{
+		return eraseKey(k);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::eraseKey(const K& k)
+	{
+		auto[pos, last] = findRange(k);
+		size_type count = 0;
+		while (pos != last) {
+			// Chained elements stay where they are when a neighbour is
+			// erased, so last remains valid.
+			pos = mTable.erase(pos);
+			count++;
+		}
+		if (count != 0) {
+			// Give a pending incremental rehash the chance to progress.
+			mTable.rehash_step(elementHasher());
+		}
+		return count;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::erase(iterator position)
+	{
+		return iterator(mTable.erase(position.mPosition), this);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::erase(iterator first, iterator last)
+	{
+		while (first != last) {
+			first = erase(first);
+		}
+		return first;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::swap(hash_multimap_type& other) noexcept
+	{
+		using std::swap;
+
+		mTable.swap(other.mTable);
+		swap(mEqual, other.mEqual);
+		swap(mHash, other.mHash);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::clear() noexcept
+	{
+		mTable.clear();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::key_equal hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::key_eq() const
+	{
+		return mEqual;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::hasher hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::hash_function() const
+	{
+		return mHash;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::allocator_type hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::get_allocator() const
+	{
+		return mTable.get_allocator();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::find(const key_type& k)
+	{
+		return iterator(findRange(k).first, this);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::find(const key_type& k) const
+	{
+		return const_iterator(findRange(k).first, this);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	std::pair<typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator, typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator> hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::equal_range(const key_type& k)
+	{
+		auto[first, last] = findRange(k);
+		return std::make_pair(iterator(first, this), iterator(last, this));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	std::pair<typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator, typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator> hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::equal_range(const key_type& k) const
+	{
+		auto[first, last] = findRange(k);
+		return std::make_pair(const_iterator(first, this), const_iterator(last, this));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::count(const key_type& k) const
+	{
+		auto range = equal_range(k);
+		return static_cast<size_type>(std::distance(range.first, range.second));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::find(const K& k)
+	{
+		return iterator(findRange(k).first, this);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::find(const K& k) const
+	{
+		return const_iterator(findRange(k).first, this);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename>
+	std::pair<typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator, typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::iterator> hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::equal_range(const K& k)
+	{
+		auto[first, last] = findRange(k);
+		return std::make_pair(iterator(first, this), iterator(last, this));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename>
+	std::pair<typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator, typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::const_iterator> hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::equal_range(const K& k) const
+	{
+		auto[first, last] = findRange(k);
+		return std::make_pair(const_iterator(first, this), const_iterator(last, this));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::count(const K& k) const
+	{
+		auto range = equal_range(k);
+		return static_cast<size_type>(std::distance(range.first, range.second));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::bucket_count() const
+	{
+		return mTable.bucket_count();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::max_bucket_count() const
+	{
+		return mTable.max_bucket_count();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::bucket(const Key& k) const
+	{
+		return mTable.bucket(mHash(k), [this, &k](const value_type& element) { return mEqual(element.first, k); });
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::size_type hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::bucket_size(size_type n) const
+	{
+		return mTable.bucket_size(n);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::local_iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::begin(size_type n)
+	{
+		return mTable.begin(n);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::const_local_iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::begin(size_type n) const
+	{
+		return mTable.begin(n);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::const_local_iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::cbegin(size_type n) const
+	{
+		return mTable.begin(n);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::local_iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::end(size_type n)
+	{
+		return mTable.end(n);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::const_local_iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::end(size_type n) const
+	{
+		return mTable.end(n);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::const_local_iterator hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::cend(size_type n) const
+	{
+		return mTable.end(n);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	float hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::load_factor() const
+	{
+		return static_cast<float>(size()) / static_cast<float>(bucket_count());
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	float hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::max_load_factor() const
+	{
+		return mTable.max_load_factor();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::max_load_factor(float ml)
+	{
+		if (!(ml > 0.0f)) {
+			throw std::invalid_argument("Maximum load factor must be positive");
+		}
+		mTable.max_load_factor(ml);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::rehash(size_type n)
+	{
+		mTable.rehash(n, elementHasher());
+	}
+
+	// Enough buckets for n elements is n / max_load_factor(), rounded up.
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::reserve(size_type n)
+	{
+		rehash(static_cast<size_type>(std::ceil(n / static_cast<double>(max_load_factor()))));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	util::probe_stats hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::probe_stats() const
+	{
+		return mTable.probe_stats(elementHasher());
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	util::bucket_stats hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>::bucket_stats() const
+	{
+		return detail::bucket_stats_of(mTable);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void swap(hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>& first, hash_multimap<Key, T, KeyEqual, Hash, Policy, Allocator>& second) noexcept
+	{
+		first.swap(second);
+	}
+
+} //namespace util
+
+#endif // HASH_MULTIMAP_H_
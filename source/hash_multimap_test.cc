@@ -0,0 +1,89 @@
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "hash_multimap.h"
+#include "gtest/gtest.h"
+
+TEST(MyHashMultimap, InsertFindErase) {
+  util::hash_multimap<int, int> map;
+  for (int i = 0; i < 1000; i++) {
+    map.insert(std::make_pair(i % 100, i));
+  }
+  EXPECT_EQ(1000u, map.size());
+  EXPECT_EQ(10u, map.count(7));
+  EXPECT_EQ(7, map.find(7)->first);
+  EXPECT_TRUE(map.find(100) == map.end());
+
+  EXPECT_EQ(10u, map.erase(7));
+  EXPECT_EQ(0u, map.erase(7));
+  EXPECT_EQ(990u, map.size());
+}
+
+TEST(MyHashMultimap, EqualRangeIsContiguous) {
+  util::hash_multimap<int, int> map(std::equal_to<>(), 5);
+  for (int i = 0; i < 2000; i++) {
+    map.emplace(i % 50, i);
+  }
+  // Growing from 5 buckets rehashed the table several times.
+  std::vector<int> keys;
+  for (auto it = map.begin(); it != map.end(); ++it) {
+    if (it == map.begin() || std::prev(it)->first != it->first) {
+      keys.push_back(it->first);
+    }
+  }
+  EXPECT_EQ(50u, keys.size());
+
+  for (int k = 0; k < 50; k++) {
+    auto range = map.equal_range(k);
+    int expected = k;
+    for (auto it = range.first; it != range.second; ++it) {
+      // Elements with a key keep the order they were inserted in.
+      ASSERT_EQ(k, it->first);
+      ASSERT_EQ(expected, it->second);
+      expected += 50;
+    }
+    ASSERT_EQ(2000 + k, expected);
+  }
+}
+
+TEST(MyHashMultimap, MappedValuesAreWritable) {
+  util::hash_multimap<std::string, int> map{ { "a", 1 }, { "b", 2 }, { "a", 3 } };
+  auto range = map.equal_range("a");
+  for (auto it = range.first; it != range.second; ++it) {
+    it->second *= 10;
+  }
+  range = map.equal_range("a");
+  EXPECT_EQ(10, range.first->second);
+  EXPECT_EQ(30, std::next(range.first)->second);
+  EXPECT_EQ(2, map.find("b")->second);
+}
+
+TEST(MyHashMultimap, NodeHandles) {
+  util::hash_multimap<std::string, int> map{ { "a", 1 }, { "b", 2 }, { "b", 3 } };
+  auto node = map.extract("b");
+  ASSERT_FALSE(node.empty());
+  EXPECT_EQ(2, node.mapped());
+  EXPECT_EQ(1u, map.count("b"));
+
+  util::hash_multimap<std::string, int> other{ { "b", 4 } };
+  auto it = other.insert(std::move(node));
+  EXPECT_EQ(2, it->second);
+  EXPECT_EQ(2u, other.count("b"));
+  EXPECT_TRUE(other.insert(util::hash_multimap<std::string, int>::node_type()) == other.end());
+}
+
+TEST(MyHashMultimap, CachedHashIncremental) {
+  util::hash_multimap<int, int, std::equal_to<>, util::hash<int>,
+    util::cached_hash<util::incremental_chaining>> map(std::equal_to<>(), 3);
+  for (int i = 0; i < 3000; i++) {
+    map.insert(std::make_pair(i % 300, i));
+  }
+  for (int k = 0; k < 300; k++) {
+    ASSERT_EQ(10u, map.count(k));
+  }
+  auto range = map.equal_range(5);
+  auto it = map.erase(range.first, range.second);
+  EXPECT_TRUE(it == range.second);
+  EXPECT_EQ(2990u, map.size());
+}
@@ -0,0 +1,140 @@
+// Compares util::hash with the byte-sum hashes it replaced. First the
+// quality: inserts sequential integers, integers with a stride of 1024 and
+// short strings into a hash_map with each hash, and prints the longest
+// chain and the histogram of bucket occupancy from bucket_stats(). Then
+// the speed: GB/s of hash_bytes() over keys of several lengths, and of
+// hash_integer() over 8-byte keys.
+// Usage: hash_quality_benchmark [keys]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "hash_map.h"
+
+namespace {
+
+// The old util::hash: the sum of the bytes of the key.
+template <typename T>
+struct byte_sum_hash {
+  size_t operator()(const T& key) const {
+    size_t sum = 0;
+    for (size_t i = 0; i < sizeof(key); ++i) {
+      sum += reinterpret_cast<const unsigned char*>(&key)[i];
+    }
+    return sum;
+  }
+};
+
+// The old util::hash<std::string>: the sum of the characters.
+struct byte_sum_string_hash {
+  size_t operator()(const std::string& key) const {
+    size_t sum = 0;
+    for (auto c : key) {
+      sum += static_cast<unsigned char>(c);
+    }
+    return sum;
+  }
+};
+
+uint64_t byte_sum(const void* data, size_t len) {
+  uint64_t sum = 0;
+  for (size_t i = 0; i < len; ++i) {
+    sum += static_cast<const unsigned char*>(data)[i];
+  }
+  return sum;
+}
+
+template <typename Hash, typename Key>
+void quality(const char* name, const std::vector<Key>& keys) {
+  util::hash_map<Key, int, std::equal_to<>, Hash> map;
+  for (const Key& key : keys) {
+    map.try_emplace(key, 0);
+  }
+  util::bucket_stats stats = map.bucket_stats();
+  std::printf("%-28s buckets: %8zu  longest chain: %6zu  occupancy:", name, stats.bucket_count,
+    stats.longest_chain);
+  // Buckets with more than 4 elements are lumped together.
+  size_t more = 0;
+  for (size_t k = 0; k < stats.occupancy_histogram.size(); k++) {
+    if (k <= 4) {
+      std::printf(" %zu:%zu", k, stats.occupancy_histogram[k]);
+    } else {
+      more += stats.occupancy_histogram[k];
+    }
+  }
+  std::printf(" 5+:%zu\n", more);
+}
+
+// Hashes the buffer in pieces of len bytes until about total bytes have
+// gone through, and returns GB/s.
+template <typename HashFn>
+double throughput(HashFn hashOf, const std::vector<unsigned char>& buffer, size_t len, size_t total) {
+  using Clock = std::chrono::steady_clock;
+
+  uint64_t sink = 0;
+  size_t hashed = 0;
+  auto start = Clock::now();
+  while (hashed < total) {
+    for (size_t offset = 0; offset + len <= buffer.size(); offset += len) {
+      sink += hashOf(buffer.data() + offset, len);
+    }
+    hashed += buffer.size() / len * len;
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  if (sink == 1) {
+    std::printf("\n");
+  }
+  return hashed / seconds / 1e9;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  size_t elements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+
+  std::vector<uint64_t> sequential(elements);
+  std::vector<uint64_t> strided(elements);
+  std::vector<std::string> strings(elements);
+  for (size_t i = 0; i < elements; i++) {
+    sequential[i] = i;
+    strided[i] = static_cast<uint64_t>(i) * 1024;
+    strings[i] = "key" + std::to_string(i);
+  }
+  quality<byte_sum_hash<uint64_t>>("byte sum, sequential", sequential);
+  quality<util::hash<uint64_t>>("util::hash, sequential", sequential);
+  quality<byte_sum_hash<uint64_t>>("byte sum, stride 1024", strided);
+  quality<util::hash<uint64_t>>("util::hash, stride 1024", strided);
+  quality<byte_sum_string_hash>("byte sum, strings", strings);
+  quality<util::hash<std::string>>("util::hash, strings", strings);
+
+  // Fits in the L2 cache, so that memory bandwidth doesn't hide the
+  // hashes.
+  std::vector<unsigned char> buffer(256 * 1024);
+  for (size_t i = 0; i < buffer.size(); i++) {
+    buffer[i] = static_cast<unsigned char>(i * 131 + 7);
+  }
+  const size_t total = size_t(1) << 30;
+  auto hashBytes = [](const unsigned char* data, size_t len) { return util::hash_bytes(data, len); };
+  auto sumBytes = [](const unsigned char* data, size_t len) { return byte_sum(data, len); };
+  for (size_t len : { 8, 16, 64, 1024, 65536 }) {
+    std::printf("%5zu-byte keys  hash_bytes: %5.2f GB/s  byte sum: %5.2f GB/s\n", len,
+      throughput(hashBytes, buffer, len, total), throughput(sumBytes, buffer, len, total));
+  }
+  auto hashInteger = [](const unsigned char* data, size_t /*len*/) {
+    uint64_t x;
+    std::memcpy(&x, data, sizeof(x));
+    return util::hash_integer(x);
+  };
+  auto sumInteger = [](const unsigned char* data, size_t /*len*/) {
+    uint64_t x;
+    std::memcpy(&x, data, sizeof(x));
+    return static_cast<uint64_t>(byte_sum_hash<uint64_t>()(x));
+  };
+  std::printf("uint64_t keys   hash_integer: %5.2f GB/s  byte sum: %5.2f GB/s\n",
+    throughput(hashInteger, buffer, sizeof(uint64_t), total), throughput(sumInteger, buffer, sizeof(uint64_t), total));
+  return 0;
+}
@@ -0,0 +1,847 @@
+#ifndef HASH_SET_H_
+#define HASH_SET_H_
+
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "hash_map.h"
+
+namespace util {
+
+	// A node handle: owns one element that has been extracted from a
+	// hash_set or hash_multiset, and can be inserted into another set of
+	// the same type whose allocator compares equal. Unlike in the set, the
+	// element can be changed while it is in the node.
+	template <typename HashSet>
+	class hash_set_node
+	{
+		// The set class needs access to the table node
+		friend HashSet;
+
+	public:
+		using value_type = typename HashSet::value_type;
+
+		// Constructs an empty node.
+		hash_set_node() = default;
+
+		// Nodes can only be moved; the source is left empty.
+		hash_set_node(hash_set_node<HashSet>&& src) = default;
+		hash_set_node<HashSet>& operator=(hash_set_node<HashSet>&& rhs) = default;
+
+		bool empty() const;
+		explicit operator bool() const;
+
+		// Behavior is undefined if the node is empty.
+		value_type& value();
+		const value_type& value() const;
+
+		void swap(hash_set_node<HashSet>& other) noexcept;
+
+	private:
+		using node_type = typename HashSet::table_type::node;
+
+		explicit hash_set_node(node_type&& node);
+
+		node_type mNode;
+	};
+
+	// Hash sets, built on the storage policies and hash objects of
+	// hash_map. The table stores the keys themselves, with no mapped value
+	// next to them. Use them through the hash_set and hash_multiset
+	// aliases below.
+	//
+	// With Multi, a key can be stored any number of times. Equal keys are
+	// kept next to each other, so equal_range() is a run of consecutive
+	// elements and count() walks only that run. Only the chaining
+	// policies (chaining, incremental_chaining, and cached_hash of either)
+	// can keep them together, and multisets need one of those.
+	//
+	// Elements are const: changing one in place would change its hash.
+	// Iterators are the const_hash_map_iterator of the set.
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	class basic_hash_set
+	{
+	public:
+		using key_type = Key;
+		using value_type = Key;
+		using hasher = Hash;
+		using key_equal = KeyEqual;
+		using storage_policy = Policy;
+		using allocator_type = Allocator;
+		using reference = value_type&;
+		using const_reference = const value_type&;
+		using size_type = size_t;
+		using difference_type = ptrdiff_t;
+		using hash_set_type = basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>;
+		using iterator = const_hash_map_iterator<hash_set_type>;
+		using const_iterator = iterator;
+
+	private:
+		using table_type = typename Policy::template table<value_type, Allocator>;
+		using position = typename table_type::position;
+		// Yields K if both Hash and KeyEqual are transparent, and fails to
+		// substitute otherwise.
+		template <typename K>
+		using transparent_key = std::enable_if_t<
+			detail::is_transparent<Hash>::value && detail::is_transparent<KeyEqual>::value, K>;
+	public:
+		using local_iterator = typename table_type::const_local_iterator;
+		using const_local_iterator = local_iterator;
+		using node_type = hash_set_node<hash_set_type>;
+
+		// The result of inserting a node into a hash_set: where the element
+		// with the node's key is, whether the node was inserted, and the
+		// node itself if it wasn't.
+		struct insert_return_type
+		{
+			iterator position;
+			bool inserted;
+			node_type node;
+		};
+
+		// What inserting returns. A hash_set says whether the element went
+		// in; a hash_multiset always inserts, and returns just where.
+		using insert_result = std::conditional_t<Multi, iterator, std::pair<iterator, bool>>;
+		using node_insert_result = std::conditional_t<Multi, iterator, insert_return_type>;
+
+		// The iterator and node classes need access to all members of the set
+		friend class const_hash_map_iterator<hash_set_type>;
+		friend class hash_set_node<hash_set_type>;
+
+		// Virtual destructor
+		virtual ~basic_hash_set() = default;
+
+		// Throws invalid_argument if the number of buckets is illegal.
+		explicit basic_hash_set(const KeyEqual& equal = KeyEqual(), size_type numBuckets = 101,
+			const Hash& hash = Hash(), const Allocator& alloc = Allocator());
+
+		// Uses alloc for all of its memory, with the other defaults.
+		explicit basic_hash_set(const Allocator& alloc);
+
+		// Throws invalid_argument if the number of buckets is illegal.
+		template <typename InputIterator>
+		basic_hash_set(InputIterator first, InputIterator last, const KeyEqual& equal = KeyEqual(),
+			size_type numBuckets = 101, const Hash& hash = Hash(), const Allocator& alloc = Allocator());
+
+		// Throws invalid_argument if the number of buckets is illegal.
+		explicit basic_hash_set(std::initializer_list<value_type> il, const KeyEqual& equal = KeyEqual(),
+			size_type numBuckets = 101, const Hash& hash = Hash(), const Allocator& alloc = Allocator());
+
+		basic_hash_set(const hash_set_type& src) = default;
+		basic_hash_set(hash_set_type&& src) noexcept = default;
+
+		hash_set_type& operator=(const hash_set_type& rhs);
+		hash_set_type& operator=(hash_set_type&& rhs) noexcept;
+		hash_set_type& operator=(std::initializer_list<value_type> il);
+
+		// Iterator methods
+		iterator begin() const;
+		iterator end() const;
+		iterator cbegin() const;
+		iterator cend() const;
+
+		// Size methods
+		bool empty() const;
+		size_type size() const;
+		size_type max_size() const;
+
+		// Element insert methods. Into a multiset, a new element goes after
+		// the equal ones already there.
+		insert_result insert(const value_type& x);
+		insert_result insert(value_type&& x);
+		iterator insert(const_iterator hint, const value_type& x);
+		iterator insert(const_iterator hint, value_type&& x);
+		template <typename InputIterator>
+		void insert(InputIterator first, InputIterator last);
+		void insert(std::initializer_list<value_type> il);
+		// Inserting an empty node does nothing.
+		node_insert_result insert(node_type&& node);
+		iterator insert(const_iterator hint, node_type&& node);
+
+		// Constructs an element from args in place. The element is built
+		// before it can be looked up, and dropped again if a hash_set
+		// holds it already.
+		template <typename... Args>
+		insert_result emplace(Args&&... args);
+		template <typename... Args>
+		iterator emplace_hint(const_iterator hint, Args&&... args);
+
+		// Element delete methods
+		// Takes an element out of the set without destroying it. extract()
+		// of a missing key returns an empty node; of a key stored several
+		// times, the first of them.
+		node_type extract(const_iterator position);
+		node_type extract(const key_type& k);
+		// Erases every element equal to k, and returns how many there were.
+		size_type erase(const key_type& k);
+		template <typename K, typename = transparent_key<K>,
+			typename = std::enable_if_t<!std::is_convertible<const K&, const_iterator>::value>>
+		size_type erase(const K& k);
+		iterator erase(const_iterator position);
+		iterator erase(const_iterator first, const_iterator last);
+
+		// Other modifying utilities
+		void swap(hash_set_type& other) noexcept;
+		void clear() noexcept;
+
+		// Access methods for Standard Library conformity
+		key_equal key_eq() const;
+		hasher hash_function() const;
+		allocator_type get_allocator() const;
+
+		// Lookup methods. find() returns the first of the elements equal to
+		// k, and equal_range() all of them.
+		iterator find(const key_type& k) const;
+		size_type count(const key_type& k) const;
+		std::pair<iterator, iterator> equal_range(const key_type& k) const;
+
+		// Heterogeneous lookup, as in hash_map.
+		template <typename K, typename = transparent_key<K>>
+		iterator find(const K& k) const;
+		template <typename K, typename = transparent_key<K>>
+		size_type count(const K& k) const;
+		template <typename K, typename = transparent_key<K>>
+		std::pair<iterator, iterator> equal_range(const K& k) const;
+
+		// Bucket interface, as in hash_map. Elements can't be changed
+		// through local iterators either.
+		size_type bucket_count() const;
+		size_type max_bucket_count() const;
+		size_type bucket(const Key& k) const;
+		size_type bucket_size(size_type n) const;
+		local_iterator begin(size_type n) const;
+		local_iterator cbegin(size_type n) const;
+		local_iterator end(size_type n) const;
+		local_iterator cend(size_type n) const;
+
+		// Hash policy methods, as in hash_map.
+		float load_factor() const;
+		float max_load_factor() const;
+		// Throws invalid_argument if ml is not positive.
+		void max_load_factor(float ml);
+		void rehash(size_type n);
+		void reserve(size_type n);
+
+		// Statistics, as in hash_map.
+		util::probe_stats probe_stats() const;
+		util::bucket_stats bucket_stats() const;
+
+	private:
+		// Returns a pair containing the table position of the first element
+		// equal to k (the table's end position if there is none), and the
+		// hash of k.
+		template <typename K>
+		std::pair<position, size_t> findElement(const K& k) const;
+
+		// Returns the table positions of the first element equal to k and of
+		// the element after the last one.
+		template <typename K>
+		std::pair<position, position> findRange(const K& k) const;
+
+		template <typename K>
+		size_type eraseKey(const K& k);
+
+		// The work of insert(): constructs an element from x unless a
+		// hash_set holds an equal one already.
+		template <typename V>
+		insert_result insertValue(V&& x);
+
+		// Links the element of a non-empty table node into the table, unless
+		// a hash_set holds an equal one already. Returns where the element
+		// equal to the node's is, and whether the node was linked in.
+		std::pair<position, bool> insertNode(typename table_type::node& node);
+
+		insert_result makeInsertResult(position pos, bool inserted) const;
+
+		// Returns a function object computing the hash of a stored element.
+		auto elementHasher() const;
+
+		table_type mTable;
+		KeyEqual mEqual;
+		Hash mHash;
+	};
+
+	template <typename Key, typename KeyEqual = std::equal_to<>, typename Hash = hash<Key>,
+		typename Policy = chaining, typename Allocator = std::allocator<Key>>
+	using hash_set = basic_hash_set<Key, false, KeyEqual, Hash, Policy, Allocator>;
+
+	template <typename Key, typename KeyEqual = std::equal_to<>, typename Hash = hash<Key>,
+		typename Policy = chaining, typename Allocator = std::allocator<Key>>
+	using hash_multiset = basic_hash_set<Key, true, KeyEqual, Hash, Policy, Allocator>;
+
+
+
+
+	template <typename HashSet>
+	hash_set_node<HashSet>::hash_set_node(node_type&& node)
+		: mNode(std::move(node))
+	{
+	}
+
+	template <typename HashSet>
+	bool hash_set_node<HashSet>::empty() const
+	{
+		return mNode.empty();
+	}
+
+	template <typename HashSet>
+	hash_set_node<HashSet>::operator bool() const
+	{
+		return !empty();
+	}
+
+	template <typename HashSet>
+	typename hash_set_node<HashSet>::value_type& hash_set_node<HashSet>::value()
+	{
+		return mNode.value();
+	}
+
+	template <typename HashSet>
+	const typename hash_set_node<HashSet>::value_type& hash_set_node<HashSet>::value() const
+	{
+		return mNode.value();
+	}
+
+	template <typename HashSet>
+	void hash_set_node<HashSet>::swap(hash_set_node<HashSet>& other) noexcept
+	{
+		node_type temp(std::move(mNode));
+		mNode = std::move(other.mNode);
+		other.mNode = std::move(temp);
+	}
+
+
+
+
+	// Create the storage table with the number of buckets.
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::basic_hash_set(const KeyEqual& equal, size_type numBuckets, const Hash& hash, const Allocator& alloc)
+		: mTable((numBuckets == 0 ? throw std::invalid_argument("Number of buckets must be positive") : numBuckets), alloc),
+		mEqual(equal), mHash(hash)
+	{
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::basic_hash_set(const Allocator& alloc)
+		: basic_hash_set(KeyEqual(), 101, Hash(), alloc)
+	{
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename InputIterator>
+	basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::basic_hash_set(InputIterator first, InputIterator last, const KeyEqual& equal, size_type numBuckets,
+		const Hash& hash, const Allocator& alloc)
+		: basic_hash_set(equal, numBuckets, hash, alloc)
+	{
+		insert(first, last);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::basic_hash_set(std::initializer_list<value_type> il, const KeyEqual& equal, size_type numBuckets,
+		const Hash& hash, const Allocator& alloc)
+		: basic_hash_set(equal, numBuckets, hash, alloc)
+	{
+		insert(std::begin(il), std::end(il));
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>& basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::operator=(const hash_set_type& rhs)
+	{
+		// Copy-and-swap idiom
+		if (this != &rhs) {
+			auto copy = rhs;
+			swap(copy);
+		}
+		return *this;
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>& basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::operator=(hash_set_type&& rhs) noexcept
+	{
+		swap(rhs);
+		return *this;
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>& basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::operator=(std::initializer_list<value_type> il)
+	{
+		hash_set_type newSet(il, mEqual, mTable.bucket_count(), mHash, get_allocator());
+		swap(newSet);
+		return *this;
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K>
+	std::pair<typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::position, size_t> basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::findElement(const K& k) const
+	{
+		size_t hash = mHash(k);
+		auto pos = mTable.find(hash, [this, &k](const value_type& element) { return mEqual(element, k); });
+		return std::make_pair(pos, hash);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K>
+	std::pair<typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::position, typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::position> basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::findRange(const K& k) const
+	{
+		auto[first, hash] = findElement(k);
+		position last = first;
+		if (first != mTable.end()) {
+			// Equal elements are next to each other, so the range ends at
+			// the first element that differs.
+			do {
+				mTable.next(last);
+			} while (Multi && last != mTable.end() && mEqual(mTable.element(last), k));
+		}
+		return std::make_pair(first, last);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	auto basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::elementHasher() const
+	{
+		return [this](const value_type& element) { return mHash(element); };
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::insert_result basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::makeInsertResult(position pos, bool inserted) const
+	{
+		if constexpr (Multi) {
+			return iterator(pos, this);
+		} else {
+			return std::make_pair(iterator(pos, this), inserted);
+		}
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename V>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::insert_result basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::insertValue(V&& x)
+	{
+		size_t hash = mHash(x);
+		auto equal = [this, &x](const value_type& element) { return mEqual(element, x); };
+		if constexpr (Multi) {
+			// equal is only called before x is moved from.
+			return makeInsertResult(mTable.emplace_equal(hash, equal, elementHasher(), std::forward<V>(x)), true);
+		} else {
+			position pos = mTable.find(hash, equal);
+			if (pos != mTable.end()) {
+				return makeInsertResult(pos, false);
+			}
+			return makeInsertResult(mTable.emplace(hash, elementHasher(), std::forward<V>(x)), true);
+		}
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	std::pair<typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::position, bool> basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::insertNode(typename table_type::node& node)
+	{
+		const value_type& x = node.value();
+		size_t hash = mHash(x);
+		auto equal = [this, &x](const value_type& element) { return mEqual(element, x); };
+		if constexpr (Multi) {
+			return std::make_pair(mTable.insert_equal(hash, equal, elementHasher(), node), true);
+		} else {
+			position pos = mTable.find(hash, equal);
+			if (pos != mTable.end()) {
+				return std::make_pair(pos, false);
+			}
+			return std::make_pair(mTable.insert(hash, elementHasher(), node), true);
+		}
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::iterator basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::begin() const
+	{
+		return iterator(mTable.first(), this);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::iterator basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::end() const
+	{
+		return iterator(mTable.end(), this);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::iterator basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::cbegin() const
+	{
+		return begin();
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::iterator basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::cend() const
+	{
+		return end();
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	bool basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::empty() const
+	{
+		return mTable.size() == 0;
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::size_type basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::size() const
+	{
+		return mTable.size();
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::size_type basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::max_size() const
+	{
+		return mTable.max_size();
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::insert_result basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::insert(const value_type& x)
+	{
+		return insertValue(x);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::insert_result basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::insert(value_type&& x)
+	{
+		return insertValue(std::move(x));
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::iterator basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::insert(const_iterator /*hint*/, const value_type& x)
+	{
+		if constexpr (Multi) {
+			return insert(x);
+		} else {
+			return insert(x).first;
+		}
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::iterator basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::insert(const_iterator /*hint*/, value_type&& x)
+	{
+		if constexpr (Multi) {
+			return insert(std::move(x));
+		} else {
+			return insert(std::move(x)).first;
+		}
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename InputIterator>
+	void basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::insert(InputIterator first, InputIterator last)
+	{
+		for (; first != last; ++first) {
+			insert(*first);
+		}
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::insert(std::initializer_list<value_type> il)
+	{
+		insert(std::begin(il), std::end(il));
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::node_insert_result basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::insert(node_type&& node)
+	{
+		if constexpr (Multi) {
+			if (node.empty()) {
+				return end();
+			}
+			return iterator(insertNode(node.mNode).first, this);
+		} else {
+			if (node.empty()) {
+				return { end(), false, node_type() };
+			}
+			auto[pos, inserted] = insertNode(node.mNode);
+			if (!inserted) {
+				// The key is taken; hand the node back to the caller.
+				return { iterator(pos, this), false, std::move(node) };
+			}
+			return { iterator(pos, this), true, node_type() };
+		}
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::iterator basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::insert(const_iterator /*hint*/, node_type&& node)
+	{
+		if constexpr (Multi) {
+			return insert(std::move(node));
+		} else {
+			return insert(std::move(node)).position;
+		}
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename... Args>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::insert_result basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::emplace(Args&&... args)
+	{
+		// Build the element in a node of its own to learn its hash, then
+		// link that node into the table.
+		typename table_type::node node(mTable.get_allocator(), std::in_place, std::forward<Args>(args)...);
+		auto[pos, inserted] = insertNode(node);
+		return makeInsertResult(pos, inserted);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename... Args>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::iterator basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::emplace_hint(const_iterator /*hint*/, Args&&... args)
+	{
+		if constexpr (Multi) {
+			return emplace(std::forward<Args>(args)...);
+		} else {
+			return emplace(std::forward<Args>(args)...).first;
+		}
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::node_type basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::extract(const_iterator position)
+	{
+		return node_type(mTable.extract(position.mPosition));
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::node_type basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::extract(const key_type& k)
+	{
+		auto[pos, hash] = findElement(k);
+		if (pos == mTable.end()) {
+			return node_type();
+		}
+		node_type node(mTable.extract(pos));
+		// Give a pending incremental rehash the chance to progress.
+		mTable.rehash_step(elementHasher());
+		return node;
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::size_type basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::erase(const key_type& k)
+	{
+		return eraseKey(k);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename, typename>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::size_type basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::erase(const K& k)
+	{
+		return eraseKey(k);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::size_type basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::eraseKey(const K& k)
+	{
+		auto[pos, last] = findRange(k);
+		size_type count = 0;
+		for (position it = pos; it != last; mTable.next(it)) {
+			count++;
+		}
+		// Erasing may move the elements after it, last included, so
+		// erase by count.
+		for (size_type i = 0; i < count; i++) {
+			pos = mTable.erase(pos);
+		}
+		if (count != 0) {
+			// Give a pending incremental rehash the chance to progress.
+			mTable.rehash_step(elementHasher());
+		}
+		return count;
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::iterator basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::erase(const_iterator position)
+	{
+		return iterator(mTable.erase(position.mPosition), this);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::iterator basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::erase(const_iterator first, const_iterator last)
+	{
+		// Erasing may move the elements after it, last included, so count
+		// the range first.
+		for (auto count = std::distance(first, last); count > 0; --count) {
+			first = erase(first);
+		}
+		return first;
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::swap(hash_set_type& other) noexcept
+	{
+		using std::swap;
+
+		mTable.swap(other.mTable);
+		swap(mEqual, other.mEqual);
+		swap(mHash, other.mHash);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::clear() noexcept
+	{
+		mTable.clear();
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::key_equal basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::key_eq() const
+	{
+		return mEqual;
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::hasher basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::hash_function() const
+	{
+		return mHash;
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::allocator_type basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::get_allocator() const
+	{
+		return mTable.get_allocator();
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::iterator basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::find(const key_type& k) const
+	{
+		return iterator(findElement(k).first, this);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::size_type basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::count(const key_type& k) const
+	{
+		auto range = equal_range(k);
+		return static_cast<size_type>(std::distance(range.first, range.second));
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	std::pair<typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::iterator, typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::iterator> basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::equal_range(const key_type& k) const
+	{
+		auto[first, last] = findRange(k);
+		return std::make_pair(iterator(first, this), iterator(last, this));
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::iterator basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::find(const K& k) const
+	{
+		return iterator(findElement(k).first, this);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::size_type basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::count(const K& k) const
+	{
+		auto range = equal_range(k);
+		return static_cast<size_type>(std::distance(range.first, range.second));
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	template <typename K, typename>
+	std::pair<typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::iterator, typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::iterator> basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::equal_range(const K& k) const
+	{
+		auto[first, last] = findRange(k);
+		return std::make_pair(iterator(first, this), iterator(last, this));
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::size_type basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::bucket_count() const
+	{
+		return mTable.bucket_count();
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::size_type basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::max_bucket_count() const
+	{
+		return mTable.max_bucket_count();
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::size_type basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::bucket(const Key& k) const
+	{
+		return mTable.bucket(mHash(k), [this, &k](const value_type& element) { return mEqual(element, k); });
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::size_type basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::bucket_size(size_type n) const
+	{
+		return mTable.bucket_size(n);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::local_iterator basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::begin(size_type n) const
+	{
+		return mTable.begin(n);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::local_iterator basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::cbegin(size_type n) const
+	{
+		return mTable.begin(n);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::local_iterator basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::end(size_type n) const
+	{
+		return mTable.end(n);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	typename basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::local_iterator basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::cend(size_type n) const
+	{
+		return mTable.end(n);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	float basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::load_factor() const
+	{
+		return static_cast<float>(size()) / static_cast<float>(bucket_count());
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	float basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::max_load_factor() const
+	{
+		return mTable.max_load_factor();
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::max_load_factor(float ml)
+	{
+		if (!(ml > 0.0f)) {
+			throw std::invalid_argument("Maximum load factor must be positive");
+		}
+		mTable.max_load_factor(ml);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::rehash(size_type n)
+	{
+		mTable.rehash(n, elementHasher());
+	}
+
+	// Enough buckets for n elements is n / max_load_factor(), rounded up.
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::reserve(size_type n)
+	{
+		rehash(static_cast<size_type>(std::ceil(n / static_cast<double>(max_load_factor()))));
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	util::probe_stats basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::probe_stats() const
+	{
+		return mTable.probe_stats(elementHasher());
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	util::bucket_stats basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>::bucket_stats() const
+	{
+		return detail::bucket_stats_of(mTable);
+	}
+
+	template <typename Key, bool Multi, typename KeyEqual, typename Hash, typename Policy, typename Allocator>
+	void swap(basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>& first, basic_hash_set<Key, Multi, KeyEqual, Hash, Policy, Allocator>& second) noexcept
+	{
+		first.swap(second);
+	}
+
+} //namespace util
+
+#endif // HASH_SET_H_
@@ -0,0 +1,171 @@
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hash_set.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+// Checks that the elements equal to each key are next to each other in
+// iteration order.
+template <typename Set>
+bool EqualKeysTogether(const Set& set) {
+  std::vector<typename Set::key_type> seen;
+  for (auto it = set.begin(); it != set.end(); ++it) {
+    if (it != set.begin() && *std::prev(it) == *it) {
+      continue;
+    }
+    for (const auto& key : seen) {
+      if (key == *it) {
+        return false;
+      }
+    }
+    seen.push_back(*it);
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(MyHashSet, InsertFindErase) {
+  util::hash_set<int> set;
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(set.insert(i).second);
+  }
+  EXPECT_FALSE(set.insert(7).second);
+  EXPECT_EQ(1000u, set.size());
+  EXPECT_EQ(7, *set.find(7));
+  EXPECT_EQ(1u, set.count(7));
+
+  EXPECT_EQ(1u, set.erase(7));
+  EXPECT_EQ(0u, set.erase(7));
+  EXPECT_TRUE(set.find(7) == set.end());
+  EXPECT_EQ(999u, set.size());
+
+  auto range = set.equal_range(8);
+  EXPECT_EQ(8, *range.first);
+  EXPECT_TRUE(std::next(range.first) == range.second);
+}
+
+TEST(MyHashSet, Strings) {
+  util::hash_set<std::string> set{ "one", "two", "three", "two" };
+  EXPECT_EQ(3u, set.size());
+  EXPECT_TRUE(set.emplace("four").second);
+  EXPECT_TRUE(set.emplace(3, 'e').second);
+  EXPECT_FALSE(set.emplace("eee").second);
+  // Transparent lookup does not build a std::string.
+  EXPECT_EQ(1u, set.count(std::string_view("three")));
+  EXPECT_EQ(1u, set.erase(std::string_view("one")));
+  EXPECT_EQ(4u, set.size());
+}
+
+TEST(MyHashSet, OpenAddressingPolicies) {
+  util::hash_set<int, std::equal_to<>, util::hash<int>, util::group_probing> group;
+  util::hash_set<int, std::equal_to<>, util::hash<int>, util::robin_hood> robin;
+  for (int i = 0; i < 5000; i++) {
+    group.insert(i);
+    robin.insert(i);
+  }
+  for (int i = 0; i < 5000; i += 2) {
+    group.erase(i);
+    robin.erase(i);
+  }
+  EXPECT_EQ(2500u, group.size());
+  EXPECT_EQ(2500u, robin.size());
+  for (int i = 0; i < 5000; i++) {
+    ASSERT_EQ(i % 2, static_cast<int>(group.count(i)));
+    ASSERT_EQ(i % 2, static_cast<int>(robin.count(i)));
+  }
+}
+
+TEST(MyHashSet, NodeHandles) {
+  util::hash_set<std::string> set{ "a", "b" };
+  auto node = set.extract("a");
+  ASSERT_FALSE(node.empty());
+  EXPECT_EQ(1u, set.size());
+
+  // The element can be changed while it is out of the set.
+  node.value() = "b";
+  auto result = set.insert(std::move(node));
+  EXPECT_FALSE(result.inserted);
+  EXPECT_EQ("b", *result.position);
+  ASSERT_FALSE(result.node.empty());
+
+  result.node.value() = "c";
+  result = set.insert(std::move(result.node));
+  EXPECT_TRUE(result.inserted);
+  EXPECT_TRUE(result.node.empty());
+  EXPECT_EQ(1u, set.count("c"));
+  EXPECT_TRUE(set.extract("a").empty());
+}
+
+TEST(MyHashMultiset, EqualKeysStayTogether) {
+  util::hash_multiset<int> set(std::equal_to<>(), 7);
+  for (int round = 0; round < 5; round++) {
+    for (int i = 0; i < 200; i++) {
+      set.insert(i);
+    }
+  }
+  EXPECT_EQ(1000u, set.size());
+  EXPECT_TRUE(EqualKeysTogether(set));
+  for (int i = 0; i < 200; i++) {
+    ASSERT_EQ(5u, set.count(i));
+    auto range = set.equal_range(i);
+    ASSERT_EQ(5, std::distance(range.first, range.second));
+  }
+
+  set.rehash(1000);
+  EXPECT_TRUE(EqualKeysTogether(set));
+  EXPECT_EQ(5u, set.count(199));
+
+  EXPECT_EQ(5u, set.erase(3));
+  EXPECT_EQ(0u, set.count(3));
+  EXPECT_EQ(995u, set.size());
+}
+
+TEST(MyHashMultiset, IncrementalChaining) {
+  util::hash_multiset<int, std::equal_to<>, util::hash<int>, util::incremental_chaining> set(std::equal_to<>(), 3);
+  // Growing happens while the previous array is still being migrated,
+  // with equal keys in both of them.
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 500; i++) {
+      set.insert(i);
+      ASSERT_TRUE(round == 0 || set.count(i) == static_cast<size_t>(round + 1));
+    }
+  }
+  EXPECT_TRUE(EqualKeysTogether(set));
+  for (int i = 0; i < 500; i++) {
+    ASSERT_EQ(3u, set.count(i));
+  }
+}
+
+TEST(MyHashMultiset, CachedHashAndNodes) {
+  util::hash_multiset<std::string, std::equal_to<>, util::hash<std::string>,
+    util::cached_hash<util::chaining>> set{ "x", "y", "x" };
+  set.emplace("x");
+  set.emplace(1, 'y');
+  EXPECT_EQ(3u, set.count("x"));
+  EXPECT_EQ(2u, set.count("y"));
+
+  auto node = set.extract("x");
+  EXPECT_EQ(2u, set.count("x"));
+  node.value() = "y";
+  auto it = set.insert(std::move(node));
+  EXPECT_EQ("y", *it);
+  EXPECT_EQ(3u, set.count("y"));
+  EXPECT_TRUE(EqualKeysTogether(set));
+}
+
+TEST(MyHashMultiset, EraseThroughIterators) {
+  util::hash_multiset<int> set{ 1, 2, 2, 3, 3, 3 };
+  auto range = set.equal_range(3);
+  auto it = set.erase(range.first, range.second);
+  EXPECT_TRUE(it == range.second);
+  EXPECT_EQ(0u, set.count(3));
+
+  it = set.erase(set.find(2));
+  EXPECT_EQ(1u, set.count(2));
+  EXPECT_EQ(2u, set.size());
+}
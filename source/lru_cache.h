@@ -0,0 +1,535 @@
+#ifndef LRU_CACHE_H_
+#define LRU_CACHE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "hash_map.h"
+
+namespace util {
+
+	// How lru_cache picks the entry to evict.
+	enum class eviction_policy
+	{
+		// Least recently used, exactly. Every hit moves the entry to the
+		// front of its shard's list, so it takes the shard's lock
+		// exclusively.
+		lru,
+		// CLOCK, an approximation of LRU: a hit only sets the entry's
+		// visited bit, under a shared lock. A hand sweeps the entries in a
+		// circle, clearing visited bits and evicting the first entry that
+		// has none. New entries go just behind the hand.
+		clock,
+		// SIEVE: hits work as with clock, but new entries go to the front
+		// of the list and the hand keeps its place. Entries that are never
+		// hit again leave soon, and popular ones are never moved.
+		sieve
+	};
+
+	// The default weigher of lru_cache: every entry costs 1, so the
+	// capacity is a number of entries.
+	struct unit_weigher
+	{
+		template <typename Key, typename T>
+		size_t operator()(const Key& /*k*/, const T& /*value*/) const
+		{
+			return 1;
+		}
+	};
+
+	// Counters of an lru_cache, as returned by lru_cache::stats().
+	struct cache_stats
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		// Entries dropped to make room for others. Erasing, overwriting
+		// and clearing don't count.
+		uint64_t evictions = 0;
+	};
+
+	// A bounded cache that can be used from many threads at once. As in
+	// concurrent_hash_map, keys are partitioned over shards, each a
+	// hash_map guarded by its own lock. The recency list runs through the
+	// map's own elements, so an entry costs a single allocation and a hit
+	// touches nothing but the element it finds.
+	//
+	// Weigher(key, value) gives the cost of an entry, and the entries of a
+	// shard never cost more than the shard's share of the capacity: with a
+	// weigher that returns sizes in bytes, the capacity is a byte budget.
+	// An entry that costs more than a shard's share isn't cached at all.
+	// Shards evict independently, so recency is only tracked per shard.
+	//
+	// Values are returned by copy; cache a shared_ptr if they are large.
+	//
+	// Usage:
+	//   util::lru_cache<std::string, std::string, util::eviction_policy::sieve> pages(1000);
+	//   pages.put("index", render("index"));
+	//   std::optional<std::string> page = pages.get("index");
+	template <typename Key, typename T,
+		eviction_policy Eviction = eviction_policy::lru,
+		typename Weigher = unit_weigher,
+		typename KeyEqual = std::equal_to<>,
+		typename Hash = hash<Key>>
+	class lru_cache
+	{
+	public:
+		using key_type = Key;
+		using mapped_type = T;
+		using hasher = Hash;
+		using key_equal = KeyEqual;
+		using weigher = Weigher;
+		using size_type = size_t;
+
+		// Assumed size of a cache line.
+		static constexpr size_t kCacheLineSize = 64;
+
+		// The number of shards is rounded up to a power of two, and the
+		// capacity is split evenly between them. Throws invalid_argument if
+		// capacity or shardCount is 0.
+		explicit lru_cache(size_t capacity, size_type shardCount = 16, const Weigher& weigh = Weigher(),
+			const KeyEqual& equal = KeyEqual(), const Hash& hash = Hash());
+
+		// The shards hold locks, which can't be copied or moved.
+		lru_cache(const lru_cache& src) = delete;
+		lru_cache& operator=(const lru_cache& rhs) = delete;
+
+		// Returns a copy of the value of k, if it is cached, and marks it
+		// as used.
+		std::optional<mapped_type> get(const key_type& k);
+
+		// Inserts or overwrites the value of k, and marks it as used,
+		// evicting other entries as needed. Returns false, and drops any
+		// old value of k, if the entry costs more than a shard's share of
+		// the capacity.
+		bool put(const key_type& k, mapped_type value);
+
+		// Returns a copy of the value of k. If k isn't cached, the value is
+		// first computed with compute() and put in the cache; concurrent
+		// callers with the same key see the same value and only one of them
+		// runs compute(). compute() runs with k's shard locked.
+		template <typename F>
+		mapped_type compute_if_absent(const key_type& k, F compute);
+
+		// Whether k is cached. This doesn't count as a use, nor as a hit
+		// or a miss.
+		bool contains(const key_type& k) const;
+
+		size_type erase(const key_type& k);
+		void clear();
+
+		// The sum of the shard sizes, and of the costs of their entries.
+		size_type size() const;
+		bool empty() const;
+		size_t weight() const;
+		size_t capacity() const;
+
+		cache_stats stats() const;
+
+		size_type shard_count() const;
+
+	private:
+		struct entry;
+		using element = std::pair<const Key, entry>;
+		// chaining never moves an element, so the list can link the
+		// elements themselves.
+		using map_type = hash_map<Key, entry, KeyEqual, Hash, chaining>;
+
+		// A cached value, with its place in the shard's list.
+		struct entry
+		{
+			entry(mapped_type&& value, size_t charge)
+				: mValue(std::move(value)), mCharge(charge)
+			{
+			}
+
+			mapped_type mValue;
+			size_t mCharge;
+			// Toward the front (newer) and the back (older) of the list.
+			element* mPrev = nullptr;
+			element* mNext = nullptr;
+			// Set by hits with clock and sieve, which only hold the lock
+			// shared.
+			std::atomic<bool> mVisited{ false };
+		};
+
+		// Exact LRU takes every lock exclusively, and a plain mutex does
+		// that faster under contention than a shared_mutex.
+		using mutex_type = std::conditional_t<Eviction == eviction_policy::lru, std::mutex, std::shared_mutex>;
+		using shared_lock_type = std::conditional_t<Eviction == eviction_policy::lru,
+			std::unique_lock<mutex_type>, std::shared_lock<mutex_type>>;
+		using unique_lock_type = std::unique_lock<mutex_type>;
+
+		// One partition of the keys, and its list.
+		struct alignas(kCacheLineSize) shard
+		{
+			mutable mutex_type mMutex;
+			map_type mMap;
+			element* mFront = nullptr;
+			element* mBack = nullptr;
+			// The entry the clock and sieve sweep looks at next, moving
+			// toward the front. Null to start again at the back.
+			element* mHand = nullptr;
+			size_t mCapacity = 0;
+			size_t mWeight = 0;
+			// Hits and misses may be counted under a shared lock.
+			std::atomic<uint64_t> mHits{ 0 };
+			std::atomic<uint64_t> mMisses{ 0 };
+			uint64_t mEvictions = 0;
+		};
+
+		// The shard for a key, picked by the top bits of the remixed hash.
+		shard& shardFor(const key_type& k);
+		const shard& shardFor(const key_type& k) const;
+
+		// Marks e as used.
+		static void touch(shard& s, element* e);
+		// Puts e where the policy wants a new entry.
+		static void link(shard& s, element* e);
+		static void unlink(shard& s, element* e);
+		// Evicts one entry. The list must not be empty.
+		static void evict(shard& s);
+		// Inserts or overwrites with the shard locked exclusively.
+		bool putLocked(shard& s, const key_type& k, mapped_type&& value, size_t charge);
+
+		std::unique_ptr<shard[]> mShards;
+		size_type mShardCount;
+		unsigned mShardShift;
+		size_t mCapacity;
+		Weigher mWeigher;
+		Hash mHash;
+	};
+
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::lru_cache(size_t capacity, size_type shardCount,
+		const Weigher& weigh, const KeyEqual& equal, const Hash& hash)
+		: mCapacity(capacity), mWeigher(weigh), mHash(hash)
+	{
+		if (capacity == 0) {
+			throw std::invalid_argument("Capacity must be positive");
+		}
+		if (shardCount == 0) {
+			throw std::invalid_argument("Number of shards must be positive");
+		}
+
+		mShardCount = 1;
+		mShardShift = 64;
+		while (mShardCount < shardCount) {
+			mShardCount *= 2;
+			mShardShift--;
+		}
+
+		// The first capacity % mShardCount shards get one more than the
+		// rest.
+		mShards.reset(new shard[mShardCount]);
+		for (size_type i = 0; i < mShardCount; i++) {
+			mShards[i].mMap = map_type(equal, 101, hash);
+			mShards[i].mCapacity = capacity / mShardCount + (i < capacity % mShardCount ? 1 : 0);
+		}
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	typename lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::shard&
+		lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::shardFor(const key_type& k)
+	{
+		if (mShardCount == 1) {
+			return mShards[0];
+		}
+		uint64_t mixed = hash_integer(mHash(k));
+		return mShards[static_cast<size_type>(mixed >> mShardShift)];
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	const typename lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::shard&
+		lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::shardFor(const key_type& k) const
+	{
+		return const_cast<lru_cache*>(this)->shardFor(k);
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	void lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::touch(shard& s, element* e)
+	{
+		if constexpr (Eviction == eviction_policy::lru) {
+			if (s.mFront != e) {
+				unlink(s, e);
+				link(s, e);
+			}
+		}
+		else {
+			// Skip the store if the bit is set already, so that hot entries
+			// don't bounce their cache line between readers.
+			if (!e->second.mVisited.load(std::memory_order_relaxed)) {
+				e->second.mVisited.store(true, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	void lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::link(shard& s, element* e)
+	{
+		// The sweep moves toward the front and then starts again at the
+		// back, so with clock the entry right behind the hand is the one
+		// it reaches last. Without a hand, that is the front entry.
+		element* prev = nullptr;
+		if constexpr (Eviction == eviction_policy::clock) {
+			prev = s.mHand;
+		}
+
+		element* next = prev ? prev->second.mNext : s.mFront;
+		e->second.mPrev = prev;
+		e->second.mNext = next;
+		(prev ? prev->second.mNext : s.mFront) = e;
+		(next ? next->second.mPrev : s.mBack) = e;
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	void lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::unlink(shard& s, element* e)
+	{
+		element* prev = e->second.mPrev;
+		element* next = e->second.mNext;
+		(prev ? prev->second.mNext : s.mFront) = next;
+		(next ? next->second.mPrev : s.mBack) = prev;
+		// The hand moves on to the entry it would have looked at next.
+		if (s.mHand == e) {
+			s.mHand = prev;
+		}
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	void lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::evict(shard& s)
+	{
+		element* victim = s.mBack;
+		if constexpr (Eviction != eviction_policy::lru) {
+			// Give every visited entry a second chance. This ends within one
+			// round, since the bits it clears stay clear.
+			victim = s.mHand ? s.mHand : s.mBack;
+			while (victim->second.mVisited.load(std::memory_order_relaxed)) {
+				victim->second.mVisited.store(false, std::memory_order_relaxed);
+				victim = victim->second.mPrev ? victim->second.mPrev : s.mBack;
+			}
+			s.mHand = victim;
+		}
+
+		unlink(s, victim);
+		s.mWeight -= victim->second.mCharge;
+		s.mMap.erase(victim->first);
+		s.mEvictions++;
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	bool lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::putLocked(shard& s, const key_type& k,
+		mapped_type&& value, size_t charge)
+	{
+		auto it = s.mMap.find(k);
+		if (it != s.mMap.end()) {
+			element* e = &*it;
+			if (charge > s.mCapacity) {
+				unlink(s, e);
+				s.mWeight -= e->second.mCharge;
+				s.mMap.erase(it);
+				return false;
+			}
+
+			// Assign first: if that throws, nothing has changed. Then take
+			// the entry out of the list while making room, so that it can't
+			// be evicted itself, and put it back as a fresh use.
+			e->second.mValue = std::move(value);
+			unlink(s, e);
+			s.mWeight -= e->second.mCharge;
+			while (s.mWeight + charge > s.mCapacity) {
+				evict(s);
+			}
+			e->second.mCharge = charge;
+			s.mWeight += charge;
+			link(s, e);
+			touch(s, e);
+			return true;
+		}
+
+		if (charge > s.mCapacity) {
+			return false;
+		}
+		while (s.mWeight + charge > s.mCapacity) {
+			evict(s);
+		}
+		element* e = &*s.mMap.try_emplace(k, std::move(value), charge).first;
+		s.mWeight += charge;
+		link(s, e);
+		return true;
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	std::optional<typename lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::mapped_type>
+		lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::get(const key_type& k)
+	{
+		shard& s = shardFor(k);
+
+		// Only exact LRU has to move anything on a hit, and its shared
+		// lock is exclusive.
+		shared_lock_type lock(s.mMutex);
+
+		auto it = s.mMap.find(k);
+		if (it == s.mMap.end()) {
+			s.mMisses.fetch_add(1, std::memory_order_relaxed);
+			return std::nullopt;
+		}
+		s.mHits.fetch_add(1, std::memory_order_relaxed);
+		touch(s, &*it);
+		return it->second.mValue;
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	bool lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::put(const key_type& k, mapped_type value)
+	{
+		// Weigh before locking: the weigher may be slow.
+		size_t charge = mWeigher(k, static_cast<const mapped_type&>(value));
+		shard& s = shardFor(k);
+		unique_lock_type lock(s.mMutex);
+		return putLocked(s, k, std::move(value), charge);
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	template <typename F>
+	typename lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::mapped_type
+		lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::compute_if_absent(const key_type& k, F compute)
+	{
+		shard& s = shardFor(k);
+
+		// With clock and sieve, hits don't have to exclude each other.
+		if constexpr (Eviction != eviction_policy::lru) {
+			shared_lock_type lock(s.mMutex);
+			auto it = s.mMap.find(k);
+			if (it != s.mMap.end()) {
+				s.mHits.fetch_add(1, std::memory_order_relaxed);
+				touch(s, &*it);
+				return it->second.mValue;
+			}
+		}
+
+		// Look (again) under the exclusive lock: another thread may have
+		// put k in between. The miss was counted by whoever got the lock
+		// first.
+		unique_lock_type lock(s.mMutex);
+		auto it = s.mMap.find(k);
+		if (it != s.mMap.end()) {
+			if constexpr (Eviction == eviction_policy::lru) {
+				s.mHits.fetch_add(1, std::memory_order_relaxed);
+			}
+			touch(s, &*it);
+			return it->second.mValue;
+		}
+
+		s.mMisses.fetch_add(1, std::memory_order_relaxed);
+		mapped_type value = compute();
+		size_t charge = mWeigher(k, static_cast<const mapped_type&>(value));
+		if (charge > s.mCapacity) {
+			return value;
+		}
+		mapped_type result = value;
+		putLocked(s, k, std::move(value), charge);
+		return result;
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	bool lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::contains(const key_type& k) const
+	{
+		const shard& s = shardFor(k);
+		shared_lock_type lock(s.mMutex);
+		return s.mMap.count(k) != 0;
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	typename lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::size_type
+		lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::erase(const key_type& k)
+	{
+		shard& s = shardFor(k);
+		unique_lock_type lock(s.mMutex);
+		auto it = s.mMap.find(k);
+		if (it == s.mMap.end()) {
+			return 0;
+		}
+		unlink(s, &*it);
+		s.mWeight -= it->second.mCharge;
+		s.mMap.erase(it);
+		return 1;
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	void lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::clear()
+	{
+		for (size_type i = 0; i < mShardCount; i++) {
+			shard& s = mShards[i];
+			unique_lock_type lock(s.mMutex);
+			s.mMap.clear();
+			s.mFront = s.mBack = s.mHand = nullptr;
+			s.mWeight = 0;
+		}
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	typename lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::size_type
+		lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::size() const
+	{
+		size_type total = 0;
+		for (size_type i = 0; i < mShardCount; i++) {
+			shared_lock_type lock(mShards[i].mMutex);
+			total += mShards[i].mMap.size();
+		}
+		return total;
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	bool lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::empty() const
+	{
+		return size() == 0;
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	size_t lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::weight() const
+	{
+		size_t total = 0;
+		for (size_type i = 0; i < mShardCount; i++) {
+			shared_lock_type lock(mShards[i].mMutex);
+			total += mShards[i].mWeight;
+		}
+		return total;
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	size_t lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::capacity() const
+	{
+		return mCapacity;
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	cache_stats lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::stats() const
+	{
+		cache_stats result;
+		for (size_type i = 0; i < mShardCount; i++) {
+			const shard& s = mShards[i];
+			shared_lock_type lock(s.mMutex);
+			result.hits += s.mHits.load(std::memory_order_relaxed);
+			result.misses += s.mMisses.load(std::memory_order_relaxed);
+			result.evictions += s.mEvictions;
+		}
+		return result;
+	}
+
+	template <typename Key, typename T, eviction_policy Eviction, typename Weigher, typename KeyEqual, typename Hash>
+	typename lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::size_type
+		lru_cache<Key, T, Eviction, Weigher, KeyEqual, Hash>::shard_count() const
+	{
+		return mShardCount;
+	}
+
+} //namespace util
+
+#endif // LRU_CACHE_H_
@@ -0,0 +1,149 @@
+// Compares lru_cache with the usual hash_map + std::list LRU behind one
+// mutex: the latency of a hit from one thread, then the throughput of a
+// mix of nine gets to one put at doubling thread counts up to the number
+// of hardware threads (and at least 4).
+// Usage: lru_cache_benchmark [capacity]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "hash_map.h"
+#include "lru_cache.h"
+
+namespace {
+
+// The cache lru_cache replaces: the map points into a separate recency
+// list, and one lock guards both.
+class list_lru {
+public:
+  explicit list_lru(size_t capacity) : mCapacity(capacity) {}
+
+  std::optional<uint64_t> get(uint64_t k) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mMap.find(k);
+    if (it == mMap.end()) {
+      return std::nullopt;
+    }
+    mList.splice(mList.begin(), mList, it->second);
+    return it->second->second;
+  }
+
+  void put(uint64_t k, uint64_t value) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mMap.find(k);
+    if (it != mMap.end()) {
+      it->second->second = value;
+      mList.splice(mList.begin(), mList, it->second);
+      return;
+    }
+    if (mMap.size() == mCapacity) {
+      mMap.erase(mList.back().first);
+      mList.pop_back();
+    }
+    mList.emplace_front(k, value);
+    mMap.insert(std::make_pair(k, mList.begin()));
+  }
+
+private:
+  using list_type = std::list<std::pair<uint64_t, uint64_t>>;
+
+  std::mutex mMutex;
+  list_type mList;
+  util::hash_map<uint64_t, list_type::iterator> mMap;
+  size_t mCapacity;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double seconds(Clock::duration d) {
+  return std::chrono::duration<double>(d).count();
+}
+
+template <typename Cache>
+void run(const char* name, size_t capacity, const std::vector<uint64_t>& keys) {
+  // Hits only. Half the capacity leaves every shard of lru_cache room
+  // for its part of the keys.
+  {
+    Cache cache(capacity);
+    size_t cached = capacity / 2;
+    for (size_t k = 0; k < cached; k++) {
+      cache.put(k, k);
+    }
+    uint64_t sum = 0;
+    auto start = Clock::now();
+    for (uint64_t k : keys) {
+      sum += *cache.get(k % cached);
+    }
+    double elapsed = seconds(Clock::now() - start);
+    std::printf("%-10s hit latency: %6.1f ns  (checksum %llu)\n", name, elapsed * 1e9 / keys.size(),
+      static_cast<unsigned long long>(sum % 10));
+  }
+
+  // Keys range over twice the capacity, so some gets miss and puts
+  // evict. The hottest keys are cached to begin with.
+  unsigned maxThreads = std::max(4u, std::thread::hardware_concurrency());
+  for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+    Cache cache(capacity);
+    for (size_t k = 0; k < capacity / 2; k++) {
+      cache.put(k, k);
+    }
+    std::vector<std::thread> workers;
+    std::vector<size_t> hits(threads);
+    auto start = Clock::now();
+    for (unsigned t = 0; t < threads; t++) {
+      workers.emplace_back([&, t]() {
+        size_t found = 0;
+        size_t operations = 0;
+        for (size_t i = t; i < keys.size(); i += threads) {
+          uint64_t k = keys[i];
+          if (operations++ % 10 == 0) {
+            cache.put(k, k);
+          }
+          else if (cache.get(k)) {
+            found++;
+          }
+        }
+        hits[t] = found;
+      });
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    double elapsed = seconds(Clock::now() - start);
+    size_t found = 0;
+    for (size_t h : hits) {
+      found += h;
+    }
+    std::printf("%-10s %2u threads: %7.1f Mops/s  hit ratio %.2f\n", name, threads, keys.size() / elapsed / 1e6,
+      found / (keys.size() * 0.9));
+  }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  size_t capacity = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+  // Skewed keys: small ones come up far more often, as in real caches.
+  std::mt19937_64 rng(42);
+  std::vector<uint64_t> keys(10000000);
+  for (uint64_t& k : keys) {
+    double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+    k = static_cast<uint64_t>(u * u * u * 2 * capacity);
+  }
+
+  run<list_lru>("list+lock", capacity, keys);
+  run<util::lru_cache<uint64_t, uint64_t, util::eviction_policy::lru>>("lru", capacity, keys);
+  run<util::lru_cache<uint64_t, uint64_t, util::eviction_policy::clock>>("clock", capacity, keys);
+  run<util::lru_cache<uint64_t, uint64_t, util::eviction_policy::sieve>>("sieve", capacity, keys);
+  return 0;
+}
@@ -0,0 +1,194 @@
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lru_cache.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+  // Charges the bytes of the key and the value.
+  struct string_weigher {
+    size_t operator()(const std::string& k, const std::string& value) const {
+      return k.size() + value.size();
+    }
+  };
+
+}
+
+TEST(MyLruCache, EvictsLeastRecentlyUsed) {
+  util::lru_cache<int, int> cache(3, 1);
+  EXPECT_EQ(cache.shard_count(), 1u);
+  EXPECT_TRUE(cache.put(1, 10));
+  EXPECT_TRUE(cache.put(2, 20));
+  EXPECT_TRUE(cache.put(3, 30));
+  EXPECT_EQ(cache.get(1), 10);
+  EXPECT_TRUE(cache.put(4, 40));
+  EXPECT_FALSE(cache.contains(2));
+  EXPECT_EQ(cache.size(), 3u);
+
+  // Overwriting is a use too.
+  EXPECT_TRUE(cache.put(3, 31));
+  EXPECT_TRUE(cache.put(5, 50));
+  EXPECT_FALSE(cache.contains(1));
+  EXPECT_EQ(cache.get(3), 31);
+  EXPECT_EQ(cache.get(4), 40);
+  EXPECT_FALSE(cache.get(1).has_value());
+
+  util::cache_stats stats = cache.stats();
+  EXPECT_EQ(stats.hits, 3u);
+  EXPECT_EQ(stats.misses, 1u);
+  EXPECT_EQ(stats.evictions, 2u);
+
+  // Erasing isn't an eviction, and leaves room.
+  EXPECT_EQ(cache.erase(4), 1u);
+  EXPECT_EQ(cache.erase(4), 0u);
+  EXPECT_TRUE(cache.put(6, 60));
+  EXPECT_EQ(cache.stats().evictions, 2u);
+  EXPECT_TRUE(cache.put(7, 70));
+  EXPECT_FALSE(cache.contains(5));
+  EXPECT_EQ(cache.stats().evictions, 3u);
+
+  cache.clear();
+  EXPECT_TRUE(cache.empty());
+  EXPECT_EQ(cache.weight(), 0u);
+  EXPECT_TRUE(cache.put(8, 80));
+  EXPECT_EQ(cache.get(8), 80);
+}
+
+TEST(MyLruCache, ClockAndSieve) {
+  util::lru_cache<int, int, util::eviction_policy::clock> clock(3, 1);
+  util::lru_cache<int, int, util::eviction_policy::sieve> sieve(3, 1);
+  for (int i = 1; i <= 3; i++) {
+    clock.put(i, i);
+    sieve.put(i, i);
+  }
+
+  // 1 gets a second chance, so both evict 2 and then 3.
+  EXPECT_EQ(clock.get(1), 1);
+  EXPECT_EQ(sieve.get(1), 1);
+  for (int i = 4; i <= 5; i++) {
+    clock.put(i, i);
+    sieve.put(i, i);
+  }
+  for (int i : { 1, 4, 5 }) {
+    EXPECT_TRUE(clock.contains(i));
+    EXPECT_TRUE(sieve.contains(i));
+  }
+
+  // clock's hand has come round to 1, whose chance is used up. sieve's
+  // hand stays between the new entries, and 1 outlives them.
+  clock.put(6, 6);
+  sieve.put(6, 6);
+  EXPECT_FALSE(clock.contains(1));
+  EXPECT_TRUE(sieve.contains(1));
+  EXPECT_FALSE(sieve.contains(4));
+  EXPECT_EQ(clock.stats().evictions, 3u);
+  EXPECT_EQ(sieve.stats().evictions, 3u);
+
+  // An entry that is hit all the time is never evicted.
+  for (int i = 10; i < 100; i++) {
+    EXPECT_EQ(sieve.get(1), 1);
+    sieve.put(i, i);
+    EXPECT_EQ(sieve.size(), 3u);
+  }
+}
+
+TEST(MyLruCache, ByteCapacity) {
+  util::lru_cache<std::string, std::string, util::eviction_policy::lru, string_weigher> cache(19, 1);
+  EXPECT_TRUE(cache.put("a", "12345"));
+  EXPECT_TRUE(cache.put("b", "12345"));
+  EXPECT_TRUE(cache.put("c", "12345"));
+  EXPECT_EQ(cache.weight(), 18u);
+
+  // Growing b pushes out a, the least recently used.
+  EXPECT_TRUE(cache.put("b", "1234567"));
+  EXPECT_FALSE(cache.contains("a"));
+  EXPECT_EQ(cache.weight(), 14u);
+
+  // Too big to cache: the old value goes too.
+  EXPECT_FALSE(cache.put("c", std::string(20, 'x')));
+  EXPECT_FALSE(cache.contains("c"));
+  EXPECT_EQ(cache.weight(), 8u);
+  EXPECT_EQ(cache.compute_if_absent("d", []() { return std::string(30, 'y'); }), std::string(30, 'y'));
+  EXPECT_FALSE(cache.contains("d"));
+
+  EXPECT_TRUE(cache.put("e", std::string(18, 'z')));
+  EXPECT_EQ(cache.size(), 1u);
+  EXPECT_EQ(cache.weight(), 19u);
+  EXPECT_EQ(cache.stats().evictions, 2u);
+
+  // Each shard gets its share of the capacity.
+  util::lru_cache<int, int> sharded(1000, 5);
+  EXPECT_EQ(sharded.shard_count(), 8u);
+  EXPECT_EQ(sharded.capacity(), 1000u);
+  for (int i = 0; i < 10000; i++) {
+    sharded.put(i, i);
+  }
+  EXPECT_LE(sharded.size(), 1000u);
+  EXPECT_GT(sharded.size(), 900u);
+
+  EXPECT_THROW((util::lru_cache<int, int>(0)), std::invalid_argument);
+  EXPECT_THROW((util::lru_cache<int, int>(10, 0)), std::invalid_argument);
+}
+
+TEST(MyLruCache, ComputeIfAbsentRunsOnce) {
+  util::lru_cache<int, int, util::eviction_policy::sieve> cache(1000);
+  std::atomic<int> computations(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < 100; i++) {
+        int value = cache.compute_if_absent(i, [&]() { computations++; return i * 2; });
+        EXPECT_EQ(value, i * 2);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(computations.load(), 100);
+  util::cache_stats stats = cache.stats();
+  EXPECT_EQ(stats.misses, 100u);
+  EXPECT_EQ(stats.hits, 700u);
+}
+
+template <util::eviction_policy Eviction>
+void checkConcurrentUse() {
+  util::lru_cache<int, int, Eviction> cache(256, 4);
+  const int kThreads = 8;
+  const int kOperations = 5000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&cache, t]() {
+      for (int i = 0; i < kOperations; i++) {
+        int k = (i * 7 + t * 13) % 512;
+        if (i % 3 == 0) {
+          cache.put(k, k);
+        }
+        else if (std::optional<int> value = cache.get(k)) {
+          EXPECT_EQ(*value, k);
+        }
+        if (i % 101 == 0) {
+          cache.erase(k + 1);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_LE(cache.size(), 256u);
+  EXPECT_EQ(cache.weight(), cache.size());
+  util::cache_stats stats = cache.stats();
+  EXPECT_EQ(stats.hits + stats.misses, static_cast<uint64_t>(kThreads * (kOperations - (kOperations + 2) / 3)));
+}
+
+TEST(MyLruCache, ConcurrentUse) {
+  checkConcurrentUse<util::eviction_policy::lru>();
+  checkConcurrentUse<util::eviction_policy::clock>();
+  checkConcurrentUse<util::eviction_policy::sieve>();
+}
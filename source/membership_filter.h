@@ -0,0 +1,1211 @@
+#ifndef MEMBERSHIP_FILTER_H_
+#define MEMBERSHIP_FILTER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define UTIL_MEMBERSHIP_FILTER_AVX2 1
+#endif
+
+#include "hash_map.h"
+
+namespace util {
+
+	// Approximate membership filters: compact summaries of a set of keys
+	// that answer "maybe there" or "certainly not". A filter never calls a
+	// key it holds absent, and calls an absent key present with a small
+	// false-positive probability. In front of a map (see prefiltered_map
+	// below), they keep most lookups of absent keys away from the map.
+	//
+	// Each filter hashes a key once with Hash, remixes the result with
+	// hash_integer() and takes every position from those 64 bits. The
+	// batch contains() hashes a run of keys and prefetches their cache
+	// lines before testing any of them, so that the memory accesses of
+	// the run overlap.
+
+	namespace detail {
+
+		// Keys hashed and prefetched ahead by the batch lookups.
+		constexpr size_t kFilterBatch = 16;
+
+		// Odd multipliers that pick a bit in each word of a Bloom block.
+		alignas(32) constexpr uint32_t kBloomSalt[8] = {
+			0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+			0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U };
+
+		// The upper half of the 128-bit product, which maps a hash to
+		// [0, n) without a division.
+		inline uint64_t multiply_high(uint64_t a, uint64_t b)
+		{
+			multiply128(a, b);
+			return b;
+		}
+
+		// The false-positive rate of a split-block Bloom filter holding
+		// keysPerBlock keys per block on average. Keys fall into blocks
+		// by a Poisson distribution; a block with j keys has each bit of
+		// a word set with probability 1 - (31/32)^j, and a lookup tests
+		// one bit in each of 8 words.
+		inline double blocked_bloom_rate(double keysPerBlock)
+		{
+			double rate = 0.0;
+			double poisson = std::exp(-keysPerBlock);
+			double limit = keysPerBlock + 12.0 * std::sqrt(keysPerBlock) + 20.0;
+			for (double j = 0.0; j <= limit; j += 1.0) {
+				rate += poisson * std::pow(1.0 - std::pow(31.0 / 32.0, j), 8.0);
+				poisson *= keysPerBlock / (j + 1.0);
+			}
+			return rate;
+		}
+
+		// Yields true if F has insert(key_type), which the filters that
+		// can grow one key at a time have.
+		template <typename F, typename = void>
+		struct is_dynamic_filter : std::false_type {};
+		template <typename F>
+		struct is_dynamic_filter<F, std::void_t<
+			decltype(std::declval<F&>().insert(std::declval<const typename F::key_type&>()))>>
+			: std::true_type {};
+
+		// Yields true if F has erase(key_type).
+		template <typename F, typename = void>
+		struct has_filter_erase : std::false_type {};
+		template <typename F>
+		struct has_filter_erase<F, std::void_t<
+			decltype(std::declval<F&>().erase(std::declval<const typename F::key_type&>()))>>
+			: std::true_type {};
+
+		// Walks the keys of a range of map elements.
+		template <typename It>
+		class key_iterator
+		{
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = std::remove_cv_t<typename std::iterator_traits<It>::value_type::first_type>;
+			using difference_type = ptrdiff_t;
+			using pointer = const value_type*;
+			using reference = const value_type&;
+
+			explicit key_iterator(It it) : mIt(it) {}
+
+			reference operator*() const { return mIt->first; }
+			key_iterator& operator++() { ++mIt; return *this; }
+			bool operator==(const key_iterator& rhs) const { return mIt == rhs.mIt; }
+			bool operator!=(const key_iterator& rhs) const { return mIt != rhs.mIt; }
+
+		private:
+			It mIt;
+		};
+
+	} // namespace detail
+
+	// A split-block Bloom filter. A key selects one 256-bit block and
+	// sets one bit in each of its eight 32-bit words, so an insertion or a
+	// lookup touches a single cache line, and a lookup is one masked test
+	// of the whole block: a single instruction with AVX2, and eight
+	// independent word tests without it. Keys can't be removed.
+	//
+	// The filter is sized to have false-positive rate fpp once it holds
+	// capacity keys; past that, the rate keeps climbing. At 1% it takes
+	// about 10.5 bits per key, 10% more than a classic Bloom filter.
+	template <typename Key, typename Hash = hash<Key>>
+	class blocked_bloom_filter
+	{
+	public:
+		using key_type = Key;
+		using hasher = Hash;
+		using size_type = size_t;
+
+		// Throws invalid_argument unless 0 < fpp < 1.
+		explicit blocked_bloom_filter(size_type capacity = 0, double fpp = 0.01, const Hash& hash = Hash());
+
+		// Adds k. Always succeeds.
+		bool insert(const key_type& k);
+
+		bool contains(const key_type& k) const;
+		// Writes contains(k) for every key in [first, last) to result.
+		// Returns the end of the output.
+		template <typename InputIt, typename OutputIt>
+		OutputIt contains(InputIt first, InputIt last, OutputIt result) const;
+
+		void clear();
+
+		// Insertions so far, counting repeated keys each time.
+		size_type size() const;
+		size_type capacity() const;
+		// Bytes taken by the bit array.
+		size_t memory_usage() const;
+
+	private:
+		struct alignas(32) block
+		{
+			uint32_t mWords[8];
+		};
+
+		uint64_t hashOf(const key_type& k) const;
+		// The block of a hash, picked by its upper 32 bits. The lower 32
+		// pick the bits within the block.
+		size_t blockIndex(uint64_t h) const;
+		static bool test(const block& b, uint32_t h);
+		static void set(block& b, uint32_t h);
+
+		std::vector<block> mBlocks;
+		size_type mSize = 0;
+		size_type mCapacity;
+		Hash mHash;
+	};
+
+	// A cuckoo filter: a cuckoo hash table of fingerprints, four to a
+	// bucket. A key's fingerprint sits in one of two buckets, and either
+	// bucket can be found from the other and the fingerprint alone, so
+	// fingerprints can be kicked back and forth without their keys. Unlike
+	// a Bloom filter, it can erase keys.
+	//
+	// A lookup compares the fingerprint with the 8 in its buckets, so the
+	// rate is about 8 / 2^bits, and fpp picks the number of bits, from 2
+	// up to 16 (about 0.012%). Buckets are packed bit-tight, and the four
+	// fingerprints of a bucket are compared at once with a few word
+	// operations. The table has room for capacity keys at 95% of its
+	// slots: at 0.1% that is 13.7 bits per key, against 16.9 for a
+	// blocked_bloom_filter. insert() fails once the table is full.
+	//
+	// Keys are counted, not remembered: a key inserted twice takes two
+	// erasures to go away. Only erase keys that are in the filter:
+	// erasing another key may remove the fingerprint of one that is, and
+	// then that key is reported absent.
+	template <typename Key, typename Hash = hash<Key>>
+	class cuckoo_filter
+	{
+	public:
+		using key_type = Key;
+		using hasher = Hash;
+		using size_type = size_t;
+
+		static constexpr size_t kBucketSize = 4;
+		static constexpr unsigned kMaxFingerprintBits = 16;
+		// Kicks tried before an insertion gives up.
+		static constexpr size_t kMaxKicks = 500;
+
+		// Throws invalid_argument unless 0 < fpp < 1.
+		explicit cuckoo_filter(size_type capacity = 0, double fpp = 0.001, const Hash& hash = Hash());
+
+		// Adds k. Returns false, and changes nothing, if the filter is
+		// full.
+		bool insert(const key_type& k);
+		// Removes one fingerprint of k. Returns false if there is none.
+		bool erase(const key_type& k);
+
+		bool contains(const key_type& k) const;
+		// Writes contains(k) for every key in [first, last) to result.
+		// Returns the end of the output.
+		template <typename InputIt, typename OutputIt>
+		OutputIt contains(InputIt first, InputIt last, OutputIt result) const;
+
+		void clear();
+
+		size_type size() const;
+		size_type capacity() const;
+		unsigned fingerprint_bits() const;
+		// Bytes taken by the buckets.
+		size_t memory_usage() const;
+
+	private:
+		// The last fingerprint kicked out by an insertion that ran out of
+		// kicks. It still counts as stored, and marks the filter full.
+		struct victim
+		{
+			bool mUsed = false;
+			size_t mBucket = 0;
+			uint32_t mFingerprint = 0;
+		};
+
+		uint64_t hashOf(const key_type& k) const;
+		// A fingerprint is never 0, which marks an empty slot.
+		uint32_t fingerprintOf(uint64_t h) const;
+		size_t bucketOf(uint64_t h) const;
+		size_t alternateBucket(size_t bucket, uint32_t fp) const;
+		// A bucket's four fingerprints, lowest slot in the lowest bits.
+		uint64_t readBucket(size_t bucket) const;
+		void writeBucket(size_t bucket, uint64_t slots);
+		bool bucketHas(uint64_t slots, uint32_t fp) const;
+		bool addTo(size_t bucket, uint32_t fp);
+		bool removeFrom(size_t bucket, uint32_t fp);
+		bool found(uint64_t h) const;
+		// Stores fp in one of its buckets, kicking others out if need be.
+		void place(size_t bucket, uint32_t fp);
+
+		// The packed buckets, and 8 bytes more so that every bucket can
+		// be read as one unaligned word.
+		std::vector<uint8_t> mBits;
+		size_t mBucketCount;
+		unsigned mFingerprintBits;
+		uint32_t mFingerprintMask;
+		uint64_t mBucketMask;
+		// 1 and the top bit in each slot of a bucket.
+		uint64_t mSlotLow;
+		uint64_t mSlotHigh;
+		victim mVictim;
+		size_type mSize = 0;
+		size_type mCapacity;
+		uint64_t mKickState = 0;
+		Hash mHash;
+	};
+
+	// A binary fuse filter: a static filter, built once from a set of
+	// keys. Each key is hashed to three slots in nearby segments of one
+	// array, and the slots are filled so that the XOR of a key's three
+	// holds its fingerprint. A lookup reads three slots and compares.
+	//
+	// Fingerprint sets the rate: about 1/256 with uint8_t, at 9 bits per
+	// key, or 1/65536 with uint16_t, at 18 bits per key (for a million
+	// keys or more; small sets take relatively more room).
+	template <typename Key, typename Hash = hash<Key>, typename Fingerprint = uint8_t>
+	class binary_fuse_filter
+	{
+	public:
+		using key_type = Key;
+		using hasher = Hash;
+		using size_type = size_t;
+
+		// Attempts at construction, each with a new seed, before giving
+		// up. One attempt fails with a probability well below 1%.
+		static constexpr unsigned kMaxAttempts = 100;
+
+		// An empty filter.
+		binary_fuse_filter();
+		// Builds the filter from the keys in [first, last), which may
+		// repeat. Throws runtime_error if all attempts fail.
+		template <typename InputIt>
+		binary_fuse_filter(InputIt first, InputIt last, const Hash& hash = Hash());
+
+		bool contains(const key_type& k) const;
+		// Writes contains(k) for every key in [first, last) to result.
+		// Returns the end of the output.
+		template <typename InputIt, typename OutputIt>
+		OutputIt contains(InputIt first, InputIt last, OutputIt result) const;
+
+		// The number of distinct keys.
+		size_type size() const;
+		// Bytes taken by the fingerprints.
+		size_t memory_usage() const;
+
+	private:
+		struct slots
+		{
+			uint32_t mIndex[3];
+		};
+
+		uint64_t hashOf(const key_type& k) const;
+		static Fingerprint fingerprintOf(uint64_t h);
+		// The three slots of a hash, one in each of three consecutive
+		// segments.
+		slots slotsOf(uint64_t h) const;
+		// Sizes the segments and the array for size keys.
+		void layout(size_t size);
+		// Tries to fill the array with the current seed. Fails if the
+		// hashes can't all be peeled.
+		bool build(const std::vector<uint64_t>& hashes);
+
+		std::vector<Fingerprint> mFingerprints;
+		uint64_t mSeed = 0;
+		uint32_t mSegmentLength = 0;
+		uint32_t mSegmentLengthMask = 0;
+		uint32_t mSegmentCountLength = 0;
+		size_type mSize = 0;
+		Hash mHash;
+	};
+
+	// A map with a filter in front of its lookups: find() and friends ask
+	// Filter first, and only search the map if it says the key may be
+	// there. A missed find() in a chaining hash_map walks a whole chain,
+	// where a filter rejects most absent keys with one or three cache-line
+	// reads. Hits pay a little extra for the filter. group_probing already
+	// rejects most absent keys after one group of control bytes, and
+	// gains little or nothing from a filter.
+	//
+	// With blocked_bloom_filter or cuckoo_filter the map can be changed
+	// through the wrapper, which keeps the filter in step, and rebuilds
+	// it at twice the map's size once the filter has taken as many keys
+	// as it was built for. A Bloom filter can't forget erased keys, and
+	// counts them until that rebuild drops them, so a map that churns at
+	// a constant size still rebuilds its filter regularly. With
+	// binary_fuse_filter the wrapper is read-only, and fpp is ignored:
+	// the fingerprint type sets the rate.
+	//
+	// Usage:
+	//   util::prefiltered_map<util::hash_map<uint64_t, Row>,
+	//     util::blocked_bloom_filter<uint64_t>> rows;
+	//   rows.insert_or_assign(id, row);
+	//   auto it = rows.find(other);
+	template <typename Map, typename Filter>
+	class prefiltered_map
+	{
+	public:
+		using map_type = Map;
+		using filter_type = Filter;
+		using key_type = typename Map::key_type;
+		using mapped_type = typename Map::mapped_type;
+		using value_type = typename Map::value_type;
+		using size_type = typename Map::size_type;
+		using iterator = typename Map::iterator;
+		using const_iterator = typename Map::const_iterator;
+
+		// The least capacity a growable filter is built with.
+		static constexpr size_t kMinFilterCapacity = 64;
+
+		// Takes over map and builds the filter from its keys.
+		explicit prefiltered_map(Map map = Map(), double fpp = 0.01);
+
+		iterator find(const key_type& k);
+		const_iterator find(const key_type& k) const;
+		bool contains(const key_type& k) const;
+		size_type count(const key_type& k) const;
+		// Writes contains(k) for every key in [first, last) to result,
+		// querying the filter a batch at a time. Returns the end of the
+		// output.
+		template <typename ForwardIt, typename OutputIt>
+		OutputIt contains(ForwardIt first, ForwardIt last, OutputIt result) const;
+
+		// As in hash_map. Only for growable filters.
+		std::pair<iterator, bool> insert(const value_type& value);
+		template <typename... Args>
+		std::pair<iterator, bool> try_emplace(const key_type& k, Args&&... args);
+		template <typename M>
+		std::pair<iterator, bool> insert_or_assign(const key_type& k, M&& value);
+		mapped_type& operator[](const key_type& k);
+		size_type erase(const key_type& k);
+		void clear();
+
+		const_iterator begin() const;
+		const_iterator end() const;
+		size_type size() const;
+		bool empty() const;
+
+		const Map& map() const;
+		const Filter& filter() const;
+
+	private:
+		// Adds the key of a new element to the filter, rebuilding it if
+		// it is full.
+		void addKey(const key_type& k);
+		// Builds a new filter from the map's keys.
+		void rebuildFilter(size_t capacity);
+		// Adds the key of a new element, and takes the element out again
+		// if that fails, so that the filter never misses a key.
+		void added(iterator position);
+
+		Map mMap;
+		Filter mFilter;
+		double mFpp;
+	};
+
+
+
+
+	template <typename Key, typename Hash>
+	blocked_bloom_filter<Key, Hash>::blocked_bloom_filter(size_type capacity, double fpp, const Hash& hash)
+		: mCapacity(capacity), mHash(hash)
+	{
+		if (!(fpp > 0.0 && fpp < 1.0)) {
+			throw std::invalid_argument("False-positive rate must be between 0 and 1");
+		}
+
+		// The rate grows with the load, so bisect for the highest load
+		// per block that stays within fpp.
+		double low = 0.0, high = 256.0;
+		for (int i = 0; i < 64; i++) {
+			double mid = (low + high) / 2.0;
+			(detail::blocked_bloom_rate(mid) <= fpp ? low : high) = mid;
+		}
+		size_t blocks = low > 0.0 ? static_cast<size_t>(std::ceil(capacity / low)) : capacity;
+		mBlocks.assign(std::max<size_t>(blocks, 1), block{});
+	}
+
+	template <typename Key, typename Hash>
+	uint64_t blocked_bloom_filter<Key, Hash>::hashOf(const key_type& k) const
+	{
+		return hash_integer(mHash(k));
+	}
+
+	template <typename Key, typename Hash>
+	size_t blocked_bloom_filter<Key, Hash>::blockIndex(uint64_t h) const
+	{
+		return static_cast<size_t>(((h >> 32) * mBlocks.size()) >> 32);
+	}
+
+	template <typename Key, typename Hash>
+	bool blocked_bloom_filter<Key, Hash>::test(const block& b, uint32_t h)
+	{
+#ifdef UTIL_MEMBERSHIP_FILTER_AVX2
+		__m256i bits = _mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(h)),
+			_mm256_load_si256(reinterpret_cast<const __m256i*>(detail::kBloomSalt)));
+		__m256i mask = _mm256_sllv_epi32(_mm256_set1_epi32(1), _mm256_srli_epi32(bits, 27));
+		// testc is 1 if every bit of mask is set in the block.
+		return _mm256_testc_si256(_mm256_load_si256(reinterpret_cast<const __m256i*>(b.mWords)), mask) != 0;
+#else
+		// No early exit: the eight tests are independent, and compilers
+		// turn the loop into vector code.
+		uint32_t missing = 0;
+		for (size_t i = 0; i < 8; i++) {
+			missing |= ~b.mWords[i] & (1U << ((h * detail::kBloomSalt[i]) >> 27));
+		}
+		return missing == 0;
+#endif
+	}
+
+	template <typename Key, typename Hash>
+	void blocked_bloom_filter<Key, Hash>::set(block& b, uint32_t h)
+	{
+		for (size_t i = 0; i < 8; i++) {
+			b.mWords[i] |= 1U << ((h * detail::kBloomSalt[i]) >> 27);
+		}
+	}
+
+	template <typename Key, typename Hash>
+	bool blocked_bloom_filter<Key, Hash>::insert(const key_type& k)
+	{
+		uint64_t h = hashOf(k);
+		set(mBlocks[blockIndex(h)], static_cast<uint32_t>(h));
+		mSize++;
+		return true;
+	}
+
+	template <typename Key, typename Hash>
+	bool blocked_bloom_filter<Key, Hash>::contains(const key_type& k) const
+	{
+		uint64_t h = hashOf(k);
+		return test(mBlocks[blockIndex(h)], static_cast<uint32_t>(h));
+	}
+
+	template <typename Key, typename Hash>
+	template <typename InputIt, typename OutputIt>
+	OutputIt blocked_bloom_filter<Key, Hash>::contains(InputIt first, InputIt last, OutputIt result) const
+	{
+		uint64_t hashes[detail::kFilterBatch];
+		while (first != last) {
+			size_t n = 0;
+			for (; n < detail::kFilterBatch && first != last; ++first, ++n) {
+				hashes[n] = hashOf(*first);
+				detail::prefetch(&mBlocks[blockIndex(hashes[n])]);
+			}
+			for (size_t i = 0; i < n; i++) {
+				*result = test(mBlocks[blockIndex(hashes[i])], static_cast<uint32_t>(hashes[i]));
+				++result;
+			}
+		}
+		return result;
+	}
+
+	template <typename Key, typename Hash>
+	void blocked_bloom_filter<Key, Hash>::clear()
+	{
+		std::fill(mBlocks.begin(), mBlocks.end(), block{});
+		mSize = 0;
+	}
+
+	template <typename Key, typename Hash>
+	typename blocked_bloom_filter<Key, Hash>::size_type blocked_bloom_filter<Key, Hash>::size() const
+	{
+		return mSize;
+	}
+
+	template <typename Key, typename Hash>
+	typename blocked_bloom_filter<Key, Hash>::size_type blocked_bloom_filter<Key, Hash>::capacity() const
+	{
+		return mCapacity;
+	}
+
+	template <typename Key, typename Hash>
+	size_t blocked_bloom_filter<Key, Hash>::memory_usage() const
+	{
+		return mBlocks.size() * sizeof(block);
+	}
+
+
+
+
+	template <typename Key, typename Hash>
+	cuckoo_filter<Key, Hash>::cuckoo_filter(size_type capacity, double fpp, const Hash& hash)
+		: mCapacity(capacity), mHash(hash)
+	{
+		if (!(fpp > 0.0 && fpp < 1.0)) {
+			throw std::invalid_argument("False-positive rate must be between 0 and 1");
+		}
+
+		double bits = std::ceil(std::log2(2.0 * kBucketSize / fpp));
+		mFingerprintBits = static_cast<unsigned>(std::clamp(bits, 2.0, double(kMaxFingerprintBits)));
+		mFingerprintMask = (uint32_t(1) << mFingerprintBits) - 1;
+		unsigned bucketBits = kBucketSize * mFingerprintBits;
+		mBucketMask = bucketBits == 64 ? ~uint64_t(0) : (uint64_t(1) << bucketBits) - 1;
+		mSlotLow = 0;
+		for (size_t i = 0; i < kBucketSize; i++) {
+			mSlotLow |= uint64_t(1) << (i * mFingerprintBits);
+		}
+		mSlotHigh = mSlotLow << (mFingerprintBits - 1);
+
+		mBucketCount = std::max<size_t>(static_cast<size_t>(std::ceil(capacity / (kBucketSize * 0.95))), 1);
+		mBits.assign((mBucketCount * bucketBits + 7) / 8 + sizeof(uint64_t), 0);
+	}
+
+	template <typename Key, typename Hash>
+	uint64_t cuckoo_filter<Key, Hash>::hashOf(const key_type& k) const
+	{
+		return hash_integer(mHash(k));
+	}
+
+	template <typename Key, typename Hash>
+	uint32_t cuckoo_filter<Key, Hash>::fingerprintOf(uint64_t h) const
+	{
+		// The upper 32 bits, scaled to [1, mask].
+		return static_cast<uint32_t>(((h >> 32) * mFingerprintMask) >> 32) + 1;
+	}
+
+	template <typename Key, typename Hash>
+	size_t cuckoo_filter<Key, Hash>::bucketOf(uint64_t h) const
+	{
+		return static_cast<size_t>((static_cast<uint32_t>(h) * static_cast<uint64_t>(mBucketCount)) >> 32);
+	}
+
+	template <typename Key, typename Hash>
+	size_t cuckoo_filter<Key, Hash>::alternateBucket(size_t bucket, uint32_t fp) const
+	{
+		// (m - bucket) mod the bucket count, for m picked by fp: its own
+		// inverse, so the alternate of the alternate is bucket again.
+		// Unlike the usual XOR, this works for any bucket count.
+		size_t m = static_cast<size_t>((static_cast<uint32_t>(fp * 0x5bd1e995U) *
+			static_cast<uint64_t>(mBucketCount)) >> 32);
+		return m >= bucket ? m - bucket : m + mBucketCount - bucket;
+	}
+
+	template <typename Key, typename Hash>
+	uint64_t cuckoo_filter<Key, Hash>::readBucket(size_t bucket) const
+	{
+		// With an odd number of bits, buckets start half way through a
+		// byte, and 4 * 15 + 4 bits still fit in the word.
+		size_t bit = bucket * kBucketSize * mFingerprintBits;
+		uint64_t word;
+		std::memcpy(&word, &mBits[bit / 8], sizeof(word));
+		return (word >> (bit % 8)) & mBucketMask;
+	}
+
+	template <typename Key, typename Hash>
+	void cuckoo_filter<Key, Hash>::writeBucket(size_t bucket, uint64_t slots)
+	{
+		size_t bit = bucket * kBucketSize * mFingerprintBits;
+		uint64_t word;
+		std::memcpy(&word, &mBits[bit / 8], sizeof(word));
+		word = (word & ~(mBucketMask << (bit % 8))) | (slots << (bit % 8));
+		std::memcpy(&mBits[bit / 8], &word, sizeof(word));
+	}
+
+	template <typename Key, typename Hash>
+	bool cuckoo_filter<Key, Hash>::bucketHas(uint64_t slots, uint32_t fp) const
+	{
+		// XOR turns matching fingerprints into zero slots, and the classic
+		// zero-lane test finds those.
+		uint64_t x = slots ^ (mSlotLow * fp);
+		return ((x - mSlotLow) & ~x & mSlotHigh) != 0;
+	}
+
+	template <typename Key, typename Hash>
+	bool cuckoo_filter<Key, Hash>::addTo(size_t bucket, uint32_t fp)
+	{
+		uint64_t slots = readBucket(bucket);
+		for (size_t i = 0; i < kBucketSize; i++) {
+			unsigned shift = static_cast<unsigned>(i * mFingerprintBits);
+			if (((slots >> shift) & mFingerprintMask) == 0) {
+				writeBucket(bucket, slots | (uint64_t(fp) << shift));
+				return true;
+			}
+		}
+		return false;
+	}
+
+	template <typename Key, typename Hash>
+	bool cuckoo_filter<Key, Hash>::removeFrom(size_t bucket, uint32_t fp)
+	{
+		uint64_t slots = readBucket(bucket);
+		for (size_t i = 0; i < kBucketSize; i++) {
+			unsigned shift = static_cast<unsigned>(i * mFingerprintBits);
+			if (((slots >> shift) & mFingerprintMask) == fp) {
+				writeBucket(bucket, slots & ~(uint64_t(mFingerprintMask) << shift));
+				return true;
+			}
+		}
+		return false;
+	}
+
+	template <typename Key, typename Hash>
+	void cuckoo_filter<Key, Hash>::place(size_t bucket, uint32_t fp)
+	{
+		mSize++;
+		size_t other = alternateBucket(bucket, fp);
+		if (addTo(bucket, fp) || addTo(other, fp)) {
+			return;
+		}
+
+		// Both buckets are full: take the place of a random fingerprint,
+		// and move that one to its other bucket, and so on.
+		for (size_t kick = 0; kick < kMaxKicks; kick++) {
+			mKickState = hash_integer(mKickState);
+			if (kick == 0 && (mKickState & 4) != 0) {
+				bucket = other;
+			}
+			unsigned shift = static_cast<unsigned>((mKickState & (kBucketSize - 1)) * mFingerprintBits);
+			uint64_t slots = readBucket(bucket);
+			uint32_t kicked = static_cast<uint32_t>(slots >> shift) & mFingerprintMask;
+			writeBucket(bucket, (slots & ~(uint64_t(mFingerprintMask) << shift)) | (uint64_t(fp) << shift));
+			fp = kicked;
+			bucket = alternateBucket(bucket, fp);
+			if (addTo(bucket, fp)) {
+				return;
+			}
+		}
+		mVictim.mUsed = true;
+		mVictim.mBucket = bucket;
+		mVictim.mFingerprint = fp;
+	}
+
+	template <typename Key, typename Hash>
+	bool cuckoo_filter<Key, Hash>::insert(const key_type& k)
+	{
+		if (mVictim.mUsed) {
+			return false;
+		}
+		uint64_t h = hashOf(k);
+		place(bucketOf(h), fingerprintOf(h));
+		return true;
+	}
+
+	template <typename Key, typename Hash>
+	bool cuckoo_filter<Key, Hash>::erase(const key_type& k)
+	{
+		uint64_t h = hashOf(k);
+		uint32_t fp = fingerprintOf(h);
+		size_t bucket = bucketOf(h);
+		size_t other = alternateBucket(bucket, fp);
+
+		if (mVictim.mUsed && mVictim.mFingerprint == fp && (mVictim.mBucket == bucket || mVictim.mBucket == other)) {
+			mVictim.mUsed = false;
+			mSize--;
+			return true;
+		}
+		if (!removeFrom(bucket, fp) && !removeFrom(other, fp)) {
+			return false;
+		}
+		mSize--;
+
+		// There is a free slot now, so give the victim another try.
+		if (mVictim.mUsed) {
+			mVictim.mUsed = false;
+			mSize--;
+			place(mVictim.mBucket, mVictim.mFingerprint);
+		}
+		return true;
+	}
+
+	template <typename Key, typename Hash>
+	bool cuckoo_filter<Key, Hash>::found(uint64_t h) const
+	{
+		uint32_t fp = fingerprintOf(h);
+		size_t bucket = bucketOf(h);
+		size_t other = alternateBucket(bucket, fp);
+		bool inVictim = mVictim.mUsed && mVictim.mFingerprint == fp &&
+			(mVictim.mBucket == bucket || mVictim.mBucket == other);
+		return bucketHas(readBucket(bucket), fp) | bucketHas(readBucket(other), fp) | inVictim;
+	}
+
+	template <typename Key, typename Hash>
+	bool cuckoo_filter<Key, Hash>::contains(const key_type& k) const
+	{
+		return found(hashOf(k));
+	}
+
+	template <typename Key, typename Hash>
+	template <typename InputIt, typename OutputIt>
+	OutputIt cuckoo_filter<Key, Hash>::contains(InputIt first, InputIt last, OutputIt result) const
+	{
+		uint64_t hashes[detail::kFilterBatch];
+		while (first != last) {
+			size_t n = 0;
+			for (; n < detail::kFilterBatch && first != last; ++first, ++n) {
+				uint64_t h = hashOf(*first);
+				hashes[n] = h;
+				size_t bucket = bucketOf(h);
+				size_t other = alternateBucket(bucket, fingerprintOf(h));
+				detail::prefetch(&mBits[bucket * kBucketSize * mFingerprintBits / 8]);
+				detail::prefetch(&mBits[other * kBucketSize * mFingerprintBits / 8]);
+			}
+			for (size_t i = 0; i < n; i++) {
+				*result = found(hashes[i]);
+				++result;
+			}
+		}
+		return result;
+	}
+
+	template <typename Key, typename Hash>
+	void cuckoo_filter<Key, Hash>::clear()
+	{
+		std::fill(mBits.begin(), mBits.end(), 0);
+		mVictim.mUsed = false;
+		mSize = 0;
+	}
+
+	template <typename Key, typename Hash>
+	typename cuckoo_filter<Key, Hash>::size_type cuckoo_filter<Key, Hash>::size() const
+	{
+		return mSize;
+	}
+
+	template <typename Key, typename Hash>
+	typename cuckoo_filter<Key, Hash>::size_type cuckoo_filter<Key, Hash>::capacity() const
+	{
+		return mCapacity;
+	}
+
+	template <typename Key, typename Hash>
+	unsigned cuckoo_filter<Key, Hash>::fingerprint_bits() const
+	{
+		return mFingerprintBits;
+	}
+
+	template <typename Key, typename Hash>
+	size_t cuckoo_filter<Key, Hash>::memory_usage() const
+	{
+		return mBits.size();
+	}
+
+
+
+
+	template <typename Key, typename Hash, typename Fingerprint>
+	binary_fuse_filter<Key, Hash, Fingerprint>::binary_fuse_filter()
+	{
+		layout(0);
+	}
+
+	template <typename Key, typename Hash, typename Fingerprint>
+	template <typename InputIt>
+	binary_fuse_filter<Key, Hash, Fingerprint>::binary_fuse_filter(InputIt first, InputIt last, const Hash& hash)
+		: mHash(hash)
+	{
+		// Repeated keys would never peel, so drop them by their hash.
+		std::vector<uint64_t> hashes;
+		for (; first != last; ++first) {
+			hashes.push_back(mHash(*first));
+		}
+		std::sort(hashes.begin(), hashes.end());
+		hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+		layout(hashes.size());
+
+		for (unsigned attempt = 0; attempt < kMaxAttempts; attempt++) {
+			mSeed = hash_integer(attempt, 0x6a09e667f3bcc909ULL);
+			if (build(hashes)) {
+				return;
+			}
+		}
+		throw std::runtime_error("Could not build the binary fuse filter");
+	}
+
+	template <typename Key, typename Hash, typename Fingerprint>
+	void binary_fuse_filter<Key, Hash, Fingerprint>::layout(size_t size)
+	{
+		// Segments of a power of two slots, longer for larger sets, and
+		// about 1.13 slots per key for large sets; small sets need more to
+		// peel reliably. These are the constants of the 3-wise binary fuse
+		// filter as published.
+		mSize = size;
+		uint32_t segmentLength = 4;
+		if (size > 0) {
+			double shift = std::floor(std::log(static_cast<double>(size)) / std::log(3.33) + 2.25);
+			segmentLength = uint32_t(1) << std::min(static_cast<int>(shift), 18);
+		}
+		double sizeFactor = size <= 1 ? 0.0 :
+			std::max(1.125, 0.875 + 0.25 * std::log(1000000.0) / std::log(static_cast<double>(size)));
+		size_t capacity = static_cast<size_t>(std::round(size * sizeFactor));
+		size_t segmentCount = (capacity + segmentLength - 1) / segmentLength;
+		segmentCount = segmentCount > 2 ? segmentCount - 2 : 1;
+
+		mSegmentLength = segmentLength;
+		mSegmentLengthMask = segmentLength - 1;
+		mSegmentCountLength = static_cast<uint32_t>(segmentCount * segmentLength);
+		mFingerprints.assign((segmentCount + 2) * segmentLength, 0);
+	}
+
+	template <typename Key, typename Hash, typename Fingerprint>
+	uint64_t binary_fuse_filter<Key, Hash, Fingerprint>::hashOf(const key_type& k) const
+	{
+		return hash_integer(mHash(k), mSeed);
+	}
+
+	template <typename Key, typename Hash, typename Fingerprint>
+	Fingerprint binary_fuse_filter<Key, Hash, Fingerprint>::fingerprintOf(uint64_t h)
+	{
+		return static_cast<Fingerprint>(h ^ (h >> 32));
+	}
+
+	template <typename Key, typename Hash, typename Fingerprint>
+	typename binary_fuse_filter<Key, Hash, Fingerprint>::slots
+		binary_fuse_filter<Key, Hash, Fingerprint>::slotsOf(uint64_t h) const
+	{
+		uint32_t h0 = static_cast<uint32_t>(detail::multiply_high(h, mSegmentCountLength));
+		uint32_t h1 = h0 + mSegmentLength;
+		uint32_t h2 = h1 + mSegmentLength;
+		h1 ^= static_cast<uint32_t>(h >> 18) & mSegmentLengthMask;
+		h2 ^= static_cast<uint32_t>(h) & mSegmentLengthMask;
+		return slots{ { h0, h1, h2 } };
+	}
+
+	template <typename Key, typename Hash, typename Fingerprint>
+	bool binary_fuse_filter<Key, Hash, Fingerprint>::build(const std::vector<uint64_t>& keyHashes)
+	{
+		size_t size = keyHashes.size();
+		size_t arrayLength = mFingerprints.size();
+
+		// In hash order, the first slots of consecutive keys are close
+		// together, which keeps the passes below cache friendly.
+		std::vector<uint64_t> hashes(size);
+		for (size_t i = 0; i < size; i++) {
+			hashes[i] = hash_integer(keyHashes[i], mSeed);
+		}
+		std::sort(hashes.begin(), hashes.end());
+
+		// For every slot, the number of keys that use it times 4, plus
+		// the XOR of which of their three slots it is, and the XOR of
+		// their hashes. Once a slot has one key left, these name it.
+		std::vector<uint8_t> counts(arrayLength, 0);
+		std::vector<uint64_t> xors(arrayLength, 0);
+		for (uint64_t h : hashes) {
+			slots s = slotsOf(h);
+			for (uint32_t k = 0; k < 3; k++) {
+				uint32_t index = s.mIndex[k];
+				counts[index] += 4;
+				counts[index] ^= static_cast<uint8_t>(k);
+				xors[index] ^= h;
+				// More than 63 keys on one slot overflow the count.
+				if (counts[index] < 4) {
+					return false;
+				}
+			}
+		}
+
+		// Peel: repeatedly take a key that is alone in one of its slots,
+		// and remove it from the other two. Remember the order and the
+		// slot each key was alone in.
+		std::vector<uint32_t> alone;
+		for (size_t i = 0; i < arrayLength; i++) {
+			if ((counts[i] >> 2) == 1) {
+				alone.push_back(static_cast<uint32_t>(i));
+			}
+		}
+		std::vector<uint64_t> order;
+		std::vector<uint8_t> orderSlot;
+		order.reserve(size);
+		orderSlot.reserve(size);
+		while (!alone.empty()) {
+			uint32_t index = alone.back();
+			alone.pop_back();
+			if ((counts[index] >> 2) != 1) {
+				continue;
+			}
+			uint64_t h = xors[index];
+			uint32_t found = counts[index] & 3;
+			order.push_back(h);
+			orderSlot.push_back(static_cast<uint8_t>(found));
+
+			slots s = slotsOf(h);
+			for (uint32_t k = 1; k <= 2; k++) {
+				uint32_t slot = (found + k) % 3;
+				uint32_t other = s.mIndex[slot];
+				counts[other] -= 4;
+				counts[other] ^= static_cast<uint8_t>(slot);
+				xors[other] ^= h;
+				if ((counts[other] >> 2) == 1) {
+					alone.push_back(other);
+				}
+			}
+		}
+		if (order.size() != size) {
+			return false;
+		}
+
+		// Assign in reverse peeling order: each key's lone slot is still
+		// free when it is reached, and the other two are final.
+		std::fill(mFingerprints.begin(), mFingerprints.end(), 0);
+		for (size_t i = size; i-- > 0;) {
+			uint64_t h = order[i];
+			slots s = slotsOf(h);
+			uint32_t found = orderSlot[i];
+			mFingerprints[s.mIndex[found]] = static_cast<Fingerprint>(fingerprintOf(h) ^
+				mFingerprints[s.mIndex[(found + 1) % 3]] ^ mFingerprints[s.mIndex[(found + 2) % 3]]);
+		}
+		return true;
+	}
+
+	template <typename Key, typename Hash, typename Fingerprint>
+	bool binary_fuse_filter<Key, Hash, Fingerprint>::contains(const key_type& k) const
+	{
+		uint64_t h = hashOf(k);
+		slots s = slotsOf(h);
+		return fingerprintOf(h) == static_cast<Fingerprint>(
+			mFingerprints[s.mIndex[0]] ^ mFingerprints[s.mIndex[1]] ^ mFingerprints[s.mIndex[2]]);
+	}
+
+	template <typename Key, typename Hash, typename Fingerprint>
+	template <typename InputIt, typename OutputIt>
+	OutputIt binary_fuse_filter<Key, Hash, Fingerprint>::contains(InputIt first, InputIt last, OutputIt result) const
+	{
+		uint64_t hashes[detail::kFilterBatch];
+		slots positions[detail::kFilterBatch];
+		while (first != last) {
+			size_t n = 0;
+			for (; n < detail::kFilterBatch && first != last; ++first, ++n) {
+				hashes[n] = hashOf(*first);
+				positions[n] = slotsOf(hashes[n]);
+				for (uint32_t index : positions[n].mIndex) {
+					detail::prefetch(&mFingerprints[index]);
+				}
+			}
+			for (size_t i = 0; i < n; i++) {
+				const uint32_t* index = positions[i].mIndex;
+				*result = fingerprintOf(hashes[i]) == static_cast<Fingerprint>(
+					mFingerprints[index[0]] ^ mFingerprints[index[1]] ^ mFingerprints[index[2]]);
+				++result;
+			}
+		}
+		return result;
+	}
+
+	template <typename Key, typename Hash, typename Fingerprint>
+	typename binary_fuse_filter<Key, Hash, Fingerprint>::size_type
+		binary_fuse_filter<Key, Hash, Fingerprint>::size() const
+	{
+		return mSize;
+	}
+
+	template <typename Key, typename Hash, typename Fingerprint>
+	size_t binary_fuse_filter<Key, Hash, Fingerprint>::memory_usage() const
+	{
+		return mFingerprints.size() * sizeof(Fingerprint);
+	}
+
+
+
+
+	template <typename Map, typename Filter>
+	prefiltered_map<Map, Filter>::prefiltered_map(Map map, double fpp)
+		: mMap(std::move(map)), mFpp(fpp)
+	{
+		if constexpr (detail::is_dynamic_filter<Filter>::value) {
+			rebuildFilter(std::max(mMap.size(), kMinFilterCapacity));
+		}
+		else {
+			using key_iterator = detail::key_iterator<typename Map::const_iterator>;
+			const Map& keys = mMap;
+			mFilter = Filter(key_iterator(keys.begin()), key_iterator(keys.end()));
+		}
+	}
+
+	template <typename Map, typename Filter>
+	void prefiltered_map<Map, Filter>::rebuildFilter(size_t capacity)
+	{
+		// Build aside, so that the old filter stays if this throws. A
+		// cuckoo filter may fill up early, if rarely.
+		for (;;) {
+			Filter filter(capacity, mFpp);
+			bool complete = true;
+			for (const value_type& element : mMap) {
+				if (!filter.insert(element.first)) {
+					complete = false;
+					break;
+				}
+			}
+			if (complete) {
+				mFilter = std::move(filter);
+				return;
+			}
+			capacity *= 2;
+		}
+	}
+
+	template <typename Map, typename Filter>
+	void prefiltered_map<Map, Filter>::addKey(const key_type& k)
+	{
+		// The filter's size counts the erased keys a Bloom filter still
+		// holds, so churn leads to a rebuild as growth does. The map
+		// holds k already, so a rebuild adds it too.
+		if (mFilter.size() >= mFilter.capacity() || !mFilter.insert(k)) {
+			rebuildFilter(std::max(2 * mMap.size(), kMinFilterCapacity));
+		}
+	}
+
+	template <typename Map, typename Filter>
+	void prefiltered_map<Map, Filter>::added(iterator position)
+	{
+		try {
+			addKey(position->first);
+		}
+		catch (...) {
+			mMap.erase(position);
+			throw;
+		}
+	}
+
+	template <typename Map, typename Filter>
+	typename prefiltered_map<Map, Filter>::iterator prefiltered_map<Map, Filter>::find(const key_type& k)
+	{
+		return mFilter.contains(k) ? mMap.find(k) : mMap.end();
+	}
+
+	template <typename Map, typename Filter>
+	typename prefiltered_map<Map, Filter>::const_iterator prefiltered_map<Map, Filter>::find(const key_type& k) const
+	{
+		return mFilter.contains(k) ? mMap.find(k) : mMap.end();
+	}
+
+	template <typename Map, typename Filter>
+	bool prefiltered_map<Map, Filter>::contains(const key_type& k) const
+	{
+		return mFilter.contains(k) && mMap.find(k) != mMap.end();
+	}
+
+	template <typename Map, typename Filter>
+	typename prefiltered_map<Map, Filter>::size_type prefiltered_map<Map, Filter>::count(const key_type& k) const
+	{
+		return mFilter.contains(k) ? mMap.count(k) : 0;
+	}
+
+	template <typename Map, typename Filter>
+	template <typename ForwardIt, typename OutputIt>
+	OutputIt prefiltered_map<Map, Filter>::contains(ForwardIt first, ForwardIt last, OutputIt result) const
+	{
+		bool maybe[detail::kFilterBatch];
+		while (first != last) {
+			ForwardIt batchEnd = first;
+			size_t n = 0;
+			for (; n < detail::kFilterBatch && batchEnd != last; ++batchEnd, ++n) {
+			}
+			mFilter.contains(first, batchEnd, maybe);
+			for (size_t i = 0; i < n; ++i, ++first) {
+				*result = maybe[i] && mMap.find(*first) != mMap.end();
+				++result;
+			}
+		}
+		return result;
+	}
+
+	template <typename Map, typename Filter>
+	std::pair<typename prefiltered_map<Map, Filter>::iterator, bool>
+		prefiltered_map<Map, Filter>::insert(const value_type& value)
+	{
+		static_assert(detail::is_dynamic_filter<Filter>::value, "The filter can't take new keys");
+		auto result = mMap.insert(value);
+		if (result.second) {
+			added(result.first);
+		}
+		return result;
+	}
+
+	template <typename Map, typename Filter>
+	template <typename... Args>
+	std::pair<typename prefiltered_map<Map, Filter>::iterator, bool>
+		prefiltered_map<Map, Filter>::try_emplace(const key_type& k, Args&&... args)
+	{
+		static_assert(detail::is_dynamic_filter<Filter>::value, "The filter can't take new keys");
+		auto result = mMap.try_emplace(k, std::forward<Args>(args)...);
+		if (result.second) {
+			added(result.first);
+		}
+		return result;
+	}
+
+	template <typename Map, typename Filter>
+	template <typename M>
+	std::pair<typename prefiltered_map<Map, Filter>::iterator, bool>
+		prefiltered_map<Map, Filter>::insert_or_assign(const key_type& k, M&& value)
+	{
+		static_assert(detail::is_dynamic_filter<Filter>::value, "The filter can't take new keys");
+		auto result = mMap.insert_or_assign(k, std::forward<M>(value));
+		if (result.second) {
+			added(result.first);
+		}
+		return result;
+	}
+
+	template <typename Map, typename Filter>
+	typename prefiltered_map<Map, Filter>::mapped_type& prefiltered_map<Map, Filter>::operator[](const key_type& k)
+	{
+		return try_emplace(k).first->second;
+	}
+
+	template <typename Map, typename Filter>
+	typename prefiltered_map<Map, Filter>::size_type prefiltered_map<Map, Filter>::erase(const key_type& k)
+	{
+		static_assert(detail::is_dynamic_filter<Filter>::value, "The filter can't change");
+		if (mMap.erase(k) == 0) {
+			return 0;
+		}
+		if constexpr (detail::has_filter_erase<Filter>::value) {
+			mFilter.erase(k);
+		}
+		return 1;
+	}
+
+	template <typename Map, typename Filter>
+	void prefiltered_map<Map, Filter>::clear()
+	{
+		static_assert(detail::is_dynamic_filter<Filter>::value, "The filter can't change");
+		mMap.clear();
+		mFilter.clear();
+	}
+
+	template <typename Map, typename Filter>
+	typename prefiltered_map<Map, Filter>::const_iterator prefiltered_map<Map, Filter>::begin() const
+	{
+		return mMap.begin();
+	}
+
+	template <typename Map, typename Filter>
+	typename prefiltered_map<Map, Filter>::const_iterator prefiltered_map<Map, Filter>::end() const
+	{
+		return mMap.end();
+	}
+
+	template <typename Map, typename Filter>
+	typename prefiltered_map<Map, Filter>::size_type prefiltered_map<Map, Filter>::size() const
+	{
+		return mMap.size();
+	}
+
+	template <typename Map, typename Filter>
+	bool prefiltered_map<Map, Filter>::empty() const
+	{
+		return mMap.empty();
+	}
+
+	template <typename Map, typename Filter>
+	const Map& prefiltered_map<Map, Filter>::map() const
+	{
+		return mMap;
+	}
+
+	template <typename Map, typename Filter>
+	const Filter& prefiltered_map<Map, Filter>::filter() const
+	{
+		return mFilter;
+	}
+
+} //namespace util
+
+#endif // MEMBERSHIP_FILTER_H_
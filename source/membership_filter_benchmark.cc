@@ -0,0 +1,93 @@
+// Measures lookups that mostly miss, in a hash_map on its own and behind
+// each membership filter, one key at a time and in batches. 95% of the
+// lookups are of absent keys. Usage: membership_filter_benchmark [elements]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "hash_map.h"
+#include "membership_filter.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds(Clock::duration d) {
+  return std::chrono::duration<double>(d).count();
+}
+
+template <typename Lookup>
+void measure(const char* name, size_t queries, Lookup lookup) {
+  auto start = Clock::now();
+  size_t found = lookup();
+  double elapsed = seconds(Clock::now() - start);
+  std::printf("  %-26s %7.1f M lookups/s  (%zu found)\n", name, queries / elapsed / 1e6, found);
+}
+
+template <typename Map>
+void run(const char* name, const std::vector<std::pair<uint64_t, uint64_t>>& pairs,
+  const std::vector<uint64_t>& queries) {
+  std::printf("%s\n", name);
+  Map map(pairs.begin(), pairs.end());
+  measure("find", queries.size(), [&]() {
+    size_t found = 0;
+    for (uint64_t k : queries) {
+      found += map.find(k) != map.end();
+    }
+    return found;
+  });
+
+  auto runFiltered = [&](const char* filterName, auto&& filtered) {
+    std::printf("  %s: %.1f bits per key\n", filterName,
+      filtered.filter().memory_usage() * 8.0 / filtered.size());
+    measure("  find", queries.size(), [&]() {
+      size_t found = 0;
+      for (uint64_t k : queries) {
+        found += filtered.find(k) != filtered.map().end();
+      }
+      return found;
+    });
+    measure("  batch contains", queries.size(), [&]() {
+      std::vector<char> results(queries.size());
+      filtered.contains(queries.begin(), queries.end(), results.begin());
+      size_t found = 0;
+      for (char r : results) {
+        found += r;
+      }
+      return found;
+    });
+  };
+  runFiltered("blocked_bloom_filter, 1%",
+    util::prefiltered_map<Map, util::blocked_bloom_filter<uint64_t>>(map, 0.01));
+  runFiltered("cuckoo_filter, 0.1%",
+    util::prefiltered_map<Map, util::cuckoo_filter<uint64_t>>(map, 0.001));
+  runFiltered("binary_fuse_filter, 1/256",
+    util::prefiltered_map<Map, util::binary_fuse_filter<uint64_t>>(map));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  size_t elements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+  // Even keys are in the map. Queries are odd, and so absent, except
+  // for one in 20.
+  std::mt19937_64 rng(42);
+  std::vector<std::pair<uint64_t, uint64_t>> pairs(elements);
+  for (size_t i = 0; i < elements; i++) {
+    pairs[i] = std::make_pair((rng() >> 1) << 1, i);
+  }
+  std::vector<uint64_t> queries(10000000);
+  for (size_t i = 0; i < queries.size(); i++) {
+    queries[i] = i % 20 == 0 ? pairs[rng() % elements].first : rng() | 1;
+  }
+
+  run<util::hash_map<uint64_t, uint64_t>>("chaining", pairs, queries);
+  run<util::hash_map<uint64_t, uint64_t, std::equal_to<>, util::hash<uint64_t>, util::group_probing>>(
+    "group_probing", pairs, queries);
+  return 0;
+}
@@ -0,0 +1,266 @@
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "hash_map.h"
+#include "membership_filter.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+  // Keys 0, 2, 4, ... are inserted; the odd ones are absent.
+  std::vector<uint64_t> evenKeys(size_t n) {
+    std::vector<uint64_t> keys(n);
+    for (size_t i = 0; i < n; i++) {
+      keys[i] = 2 * i;
+    }
+    return keys;
+  }
+
+  // The share of the absent keys 1, 3, 5, ... that filter claims.
+  template <typename Filter>
+  double falsePositiveRate(const Filter& filter, size_t probes) {
+    size_t positives = 0;
+    for (size_t i = 0; i < probes; i++) {
+      positives += filter.contains(2 * i + 1);
+    }
+    return static_cast<double>(positives) / probes;
+  }
+
+  // The batch lookup agrees with the single one.
+  template <typename Filter>
+  void checkBatch(const Filter& filter, size_t n) {
+    std::vector<uint64_t> keys(n);
+    for (size_t i = 0; i < n; i++) {
+      keys[i] = i;
+    }
+    std::vector<char> batch(n);
+    EXPECT_EQ(filter.contains(keys.begin(), keys.end(), batch.begin()), batch.end());
+    for (size_t i = 0; i < n; i++) {
+      EXPECT_EQ(batch[i] != 0, filter.contains(keys[i]));
+    }
+  }
+
+}
+
+TEST(MyMembershipFilter, BlockedBloomFilter) {
+  const size_t kKeys = 100000;
+  for (double fpp : { 0.1, 0.01, 0.001 }) {
+    util::blocked_bloom_filter<uint64_t> filter(kKeys, fpp);
+    for (uint64_t k : evenKeys(kKeys)) {
+      EXPECT_TRUE(filter.insert(k));
+    }
+    EXPECT_EQ(filter.size(), kKeys);
+    EXPECT_EQ(filter.capacity(), kKeys);
+    for (uint64_t k : evenKeys(kKeys)) {
+      ASSERT_TRUE(filter.contains(k));
+    }
+    double rate = falsePositiveRate(filter, 1000000);
+    EXPECT_LT(rate, fpp * 1.25);
+    EXPECT_GT(rate, fpp * 0.5);
+    checkBatch(filter, 1000);
+  }
+
+  // About 10.5 bits per key at 1%.
+  util::blocked_bloom_filter<uint64_t> filter(kKeys, 0.01);
+  EXPECT_GT(filter.memory_usage() * 8.0 / kKeys, 9.5);
+  EXPECT_LT(filter.memory_usage() * 8.0 / kKeys, 11.5);
+  filter.insert(1);
+  filter.clear();
+  EXPECT_EQ(filter.size(), 0u);
+  EXPECT_FALSE(filter.contains(1));
+
+  util::blocked_bloom_filter<std::string> strings(10);
+  strings.insert("apple");
+  EXPECT_TRUE(strings.contains("apple"));
+  EXPECT_THROW((util::blocked_bloom_filter<int>(10, 0.0)), std::invalid_argument);
+  EXPECT_THROW((util::blocked_bloom_filter<int>(10, 1.0)), std::invalid_argument);
+}
+
+TEST(MyMembershipFilter, CuckooFilter) {
+  const size_t kKeys = 100000;
+  util::cuckoo_filter<uint64_t> filter(kKeys, 0.001);
+  EXPECT_EQ(filter.fingerprint_bits(), 13u);
+  for (uint64_t k : evenKeys(kKeys)) {
+    ASSERT_TRUE(filter.insert(k));
+  }
+  EXPECT_EQ(filter.size(), kKeys);
+  for (uint64_t k : evenKeys(kKeys)) {
+    ASSERT_TRUE(filter.contains(k));
+  }
+  EXPECT_LT(falsePositiveRate(filter, 1000000), 0.001);
+  EXPECT_LT(filter.memory_usage() * 8.0 / kKeys, 14.0);
+  checkBatch(filter, 1000);
+
+  // Erase every other key. The rest stay, and most erased ones go.
+  for (size_t i = 0; i < kKeys; i += 2) {
+    EXPECT_TRUE(filter.erase(2 * i));
+  }
+  EXPECT_EQ(filter.size(), kKeys / 2);
+  size_t stillThere = 0;
+  for (size_t i = 0; i < kKeys; i++) {
+    if (i % 2 == 1) {
+      ASSERT_TRUE(filter.contains(2 * i));
+    }
+    else {
+      stillThere += filter.contains(2 * i);
+    }
+  }
+  EXPECT_LT(stillThere, kKeys / 1000);
+
+  // A key inserted twice takes two erasures.
+  util::cuckoo_filter<uint64_t> small(100, 0.03);
+  EXPECT_EQ(small.fingerprint_bits(), 9u);
+  small.insert(7);
+  small.insert(7);
+  EXPECT_TRUE(small.erase(7));
+  EXPECT_TRUE(small.contains(7));
+  EXPECT_TRUE(small.erase(7));
+  EXPECT_FALSE(small.contains(7));
+  EXPECT_FALSE(small.erase(7));
+
+  // It holds at least its capacity, then fills up without losing keys.
+  size_t inserted = 0;
+  while (small.insert(inserted)) {
+    inserted++;
+  }
+  EXPECT_GE(inserted, 100u);
+  EXPECT_EQ(small.size(), inserted);
+  for (size_t k = 0; k < inserted; k++) {
+    ASSERT_TRUE(small.contains(k));
+  }
+  EXPECT_TRUE(small.erase(0));
+  EXPECT_TRUE(small.insert(0));
+  small.clear();
+  EXPECT_EQ(small.size(), 0u);
+  EXPECT_TRUE(small.insert(1));
+}
+
+TEST(MyMembershipFilter, BinaryFuseFilter) {
+  const size_t kKeys = 100000;
+  std::vector<uint64_t> keys = evenKeys(kKeys);
+  // Repeats are fine.
+  keys.insert(keys.end(), keys.begin(), keys.begin() + 1000);
+  util::binary_fuse_filter<uint64_t> filter(keys.begin(), keys.end());
+  EXPECT_EQ(filter.size(), kKeys);
+  for (uint64_t k : keys) {
+    ASSERT_TRUE(filter.contains(k));
+  }
+  double rate = falsePositiveRate(filter, 1000000);
+  EXPECT_LT(rate, 1.5 / 256);
+  EXPECT_GT(rate, 0.5 / 256);
+  EXPECT_LT(filter.memory_usage() * 8.0 / kKeys, 10.5);
+  checkBatch(filter, 1000);
+
+  util::binary_fuse_filter<uint64_t, util::hash<uint64_t>, uint16_t> wide(keys.begin(), keys.end());
+  for (uint64_t k : keys) {
+    ASSERT_TRUE(wide.contains(k));
+  }
+  EXPECT_LT(falsePositiveRate(wide, 1000000), 5.0 / 65536);
+
+  // Small sets build too.
+  for (size_t n = 0; n < 200; n++) {
+    std::vector<uint64_t> few = evenKeys(n);
+    util::binary_fuse_filter<uint64_t> smallFilter(few.begin(), few.end());
+    for (uint64_t k : few) {
+      ASSERT_TRUE(smallFilter.contains(k));
+    }
+  }
+  util::binary_fuse_filter<std::string> empty;
+  EXPECT_EQ(empty.size(), 0u);
+}
+
+TEST(MyMembershipFilter, PrefilteredMap) {
+  using map_type = util::hash_map<uint64_t, uint64_t>;
+  util::prefiltered_map<map_type, util::blocked_bloom_filter<uint64_t>> bloom;
+  util::prefiltered_map<map_type, util::cuckoo_filter<uint64_t>> cuckoo(map_type(), 0.001);
+
+  // Far past the first filter's capacity.
+  for (uint64_t k : evenKeys(10000)) {
+    EXPECT_TRUE(bloom.try_emplace(k, k + 1).second);
+    EXPECT_TRUE(cuckoo.insert(std::make_pair(k, k + 1)).second);
+  }
+  EXPECT_FALSE(bloom.insert_or_assign(0, 5).second);
+  cuckoo[0] = 5;
+  EXPECT_GE(bloom.filter().capacity(), 10000u);
+  EXPECT_GE(cuckoo.filter().capacity(), 10000u);
+  for (uint64_t k = 0; k < 20000; k++) {
+    bool present = k % 2 == 0;
+    ASSERT_EQ(bloom.contains(k), present);
+    ASSERT_EQ(cuckoo.count(k), present ? 1u : 0u);
+    if (present) {
+      EXPECT_EQ(bloom.find(k)->second, k == 0 ? 5 : k + 1);
+      EXPECT_EQ(cuckoo.find(k)->second, k == 0 ? 5 : k + 1);
+    }
+    else {
+      EXPECT_TRUE(bloom.find(k) == bloom.map().end());
+    }
+  }
+
+  EXPECT_EQ(bloom.erase(2), 1u);
+  EXPECT_EQ(cuckoo.erase(2), 1u);
+  EXPECT_EQ(cuckoo.erase(2), 0u);
+  EXPECT_FALSE(bloom.contains(2));
+  EXPECT_FALSE(cuckoo.filter().contains(2));
+  EXPECT_EQ(cuckoo.filter().size(), cuckoo.size());
+
+  std::vector<uint64_t> probes = { 0, 1, 2, 4, 19998, 19999 };
+  std::vector<char> found(probes.size());
+  cuckoo.contains(probes.begin(), probes.end(), found.begin());
+  EXPECT_EQ(found, std::vector<char>({ 1, 0, 0, 1, 1, 0 }));
+
+  // A static filter is built from the map it is given.
+  map_type rows;
+  for (uint64_t k : evenKeys(10000)) {
+    rows.insert(std::make_pair(k, k));
+  }
+  util::prefiltered_map<map_type, util::binary_fuse_filter<uint64_t>> frozen(rows);
+  EXPECT_EQ(frozen.filter().size(), 10000u);
+  for (uint64_t k = 0; k < 20000; k++) {
+    ASSERT_EQ(frozen.contains(k), k % 2 == 0);
+  }
+  size_t total = 0;
+  for (const auto& element : frozen) {
+    total += element.second;
+  }
+  EXPECT_EQ(total, 10000u * 9999u);
+
+  bloom.clear();
+  EXPECT_TRUE(bloom.empty());
+  EXPECT_FALSE(bloom.contains(4));
+}
+
+// A map that keeps replacing its keys at a constant size rebuilds its
+// Bloom filter, rather than filling it with erased keys.
+TEST(MyMembershipFilter, PrefilteredMapChurn) {
+  using map_type = util::hash_map<uint64_t, uint64_t>;
+  util::prefiltered_map<map_type, util::blocked_bloom_filter<uint64_t>> bloom;
+  util::prefiltered_map<map_type, util::cuckoo_filter<uint64_t>> cuckoo;
+  for (uint64_t k = 0; k < 1000; k++) {
+    bloom.try_emplace(2 * k, k);
+    cuckoo.try_emplace(2 * k, k);
+  }
+  for (uint64_t k = 1000; k < 201000; k++) {
+    EXPECT_EQ(bloom.erase(2 * (k - 1000)), 1u);
+    EXPECT_EQ(cuckoo.erase(2 * (k - 1000)), 1u);
+    bloom.try_emplace(2 * k, k);
+    cuckoo.try_emplace(2 * k, k);
+  }
+  EXPECT_EQ(bloom.size(), 1000u);
+  EXPECT_LE(bloom.filter().size(), bloom.filter().capacity());
+  EXPECT_LE(bloom.filter().capacity(), 4000u);
+  EXPECT_EQ(cuckoo.filter().size(), 1000u);
+  EXPECT_LE(cuckoo.filter().capacity(), 4000u);
+
+  // Far below 1, where a filter full of erased keys would be.
+  size_t positives = 0;
+  for (uint64_t k = 0; k < 100000; k++) {
+    positives += bloom.filter().contains(2 * k + 1);
+  }
+  EXPECT_LT(static_cast<double>(positives) / 100000, 0.05);
+  for (uint64_t k = 200000; k < 201000; k++) {
+    ASSERT_EQ(bloom.find(2 * k)->second, k);
+    ASSERT_EQ(cuckoo.find(2 * k)->second, k);
+  }
+}
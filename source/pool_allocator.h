@@ -0,0 +1,301 @@
+#ifndef POOL_ALLOCATOR_H_
+#define POOL_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <new>
+#include <limits>
+#include <type_traits>
+#include <algorithm>
+
+namespace util {
+
+	// A pool of small memory blocks carved out of large chunks. Node-based
+	// containers (such as hash_map with the chaining policy) allocate one
+	// small block per element; taking them from a pool avoids a call to
+	// operator new per element, keeps neighbouring nodes close together,
+	// and turns freeing them into pushing onto a free list.
+	//
+	// Blocks are rounded up to a multiple of kGranularity bytes and freed
+	// blocks are kept on one free list per size, for reuse. Chunks are
+	// only given back, all at once, by release() or the destructor, so a
+	// container that drains and refills reuses the same memory rather
+	// than freeing and allocating every chunk each time. Once every block
+	// is back, the free lists are dropped and blocks are carved from the
+	// first chunk again, in order, as in a new pool. Call release()
+	// once the containers using the pool are empty to return the memory
+	// sooner. The pool must outlive every allocator that refers to it. It
+	// is not thread-safe.
+	class node_pool
+	{
+	public:
+		// Blocks are aligned like operator new memory and sized in
+		// multiples of kGranularity. Requests for more than kMaxBlockSize
+		// bytes are not pooled.
+		static constexpr size_t kGranularity = alignof(std::max_align_t);
+		static constexpr size_t kMaxBlockSize = 256;
+
+		// The first chunk has chunkSize bytes; later ones double in size
+		// up to kMaxChunkGrowth times that.
+		explicit node_pool(size_t chunkSize = 64 * 1024);
+		~node_pool();
+
+		// A pool owns its chunks, so it can be neither copied nor moved.
+		node_pool(const node_pool& src) = delete;
+		node_pool& operator=(const node_pool& rhs) = delete;
+
+		// Throws bad_alloc if bytes is 0 or more than kMaxBlockSize, or if
+		// no new chunk can be allocated.
+		void* allocate(size_t bytes);
+		// bytes must be the size that p was allocated with.
+		void deallocate(void* p, size_t bytes) noexcept;
+
+		// Frees all chunks right away. Any block still handed out becomes
+		// invalid.
+		void release() noexcept;
+
+		// The number of blocks currently handed out.
+		size_t blocks_in_use() const;
+		// The total size of the chunks currently held.
+		size_t bytes_reserved() const;
+
+	private:
+		static constexpr size_t kMaxChunkGrowth = 16;
+		static constexpr size_t kSizeClasses = kMaxBlockSize / kGranularity;
+
+		// Freed blocks are linked through their first bytes.
+		struct free_block
+		{
+			free_block* mNext;
+		};
+
+		struct chunk
+		{
+			char* mData;
+			size_t mSize;
+		};
+
+		// Index of the free list for blocks of the given size.
+		static size_t sizeClass(size_t bytes);
+
+		// Takes a fresh block of blockSize bytes from the current chunk,
+		// moving on to the next chunk, or a new one, if it is used up.
+		void* carve(size_t blockSize);
+
+		free_block* mFreeLists[kSizeClasses] = {};
+		std::vector<chunk> mChunks;
+		// The chunks before mNextChunk have been carved from.
+		size_t mNextChunk = 0;
+		char* mCurrent = nullptr;
+		char* mEnd = nullptr;
+		size_t mChunkSize;
+		size_t mNextChunkSize;
+		size_t mBytesReserved = 0;
+		size_t mBlocksInUse = 0;
+	};
+
+	// A standard allocator that takes single objects and small arrays from
+	// a node_pool, and everything else from operator new. Copies and
+	// rebound copies share the pool, and compare equal if they do. A
+	// default-constructed pool_allocator has no pool and always uses
+	// operator new.
+	//
+	// Usage:
+	//   util::node_pool pool;
+	//   using value_type = std::pair<const int, int>;
+	//   util::hash_map<int, int, std::equal_to<>, util::hash<int>, util::chaining,
+	//       util::pool_allocator<value_type>> map(util::pool_allocator<value_type>(&pool));
+	template <typename T>
+	class pool_allocator
+	{
+	public:
+		using value_type = T;
+		using size_type = size_t;
+		using difference_type = ptrdiff_t;
+		// The pool goes wherever the elements go.
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+
+		pool_allocator() noexcept = default;
+		explicit pool_allocator(node_pool* pool) noexcept;
+
+		template <typename U>
+		pool_allocator(const pool_allocator<U>& src) noexcept;
+
+		T* allocate(size_t n);
+		void deallocate(T* p, size_t n) noexcept;
+
+		node_pool* pool() const noexcept;
+
+	private:
+		// Whether an array of n objects is taken from the pool.
+		bool pooled(size_t n) const;
+
+		node_pool* mPool = nullptr;
+	};
+
+	template <typename T, typename U>
+	bool operator==(const pool_allocator<T>& lhs, const pool_allocator<U>& rhs) noexcept;
+	template <typename T, typename U>
+	bool operator!=(const pool_allocator<T>& lhs, const pool_allocator<U>& rhs) noexcept;
+
+
+	inline node_pool::node_pool(size_t chunkSize)
+		: mChunkSize(std::max(chunkSize, kMaxBlockSize)), mNextChunkSize(mChunkSize)
+	{
+	}
+
+	inline node_pool::~node_pool()
+	{
+		release();
+	}
+
+	inline size_t node_pool::sizeClass(size_t bytes)
+	{
+		return (bytes - 1) / kGranularity;
+	}
+
+	inline void* node_pool::allocate(size_t bytes)
+	{
+		if (bytes == 0 || bytes > kMaxBlockSize) {
+			throw std::bad_alloc();
+		}
+
+		// Reuse a freed block of the same size if there is one.
+		size_t index = sizeClass(bytes);
+		void* block;
+		if (mFreeLists[index] != nullptr) {
+			block = mFreeLists[index];
+			mFreeLists[index] = mFreeLists[index]->mNext;
+		} else {
+			block = carve((index + 1) * kGranularity);
+		}
+		++mBlocksInUse;
+		return block;
+	}
+
+	inline void node_pool::deallocate(void* p, size_t bytes) noexcept
+	{
+		size_t index = sizeClass(bytes);
+		free_block* block = ::new (p) free_block{ mFreeLists[index] };
+		mFreeLists[index] = block;
+
+		// With nothing handed out any more, start over from the first
+		// chunk.
+		if (--mBlocksInUse == 0) {
+			std::fill(std::begin(mFreeLists), std::end(mFreeLists), nullptr);
+			mNextChunk = 0;
+			mCurrent = nullptr;
+			mEnd = nullptr;
+		}
+	}
+
+	inline void* node_pool::carve(size_t blockSize)
+	{
+		if (static_cast<size_t>(mEnd - mCurrent) < blockSize) {
+			// The tail of the old chunk, if any, is wasted.
+			if (mNextChunk == mChunks.size()) {
+				mChunks.reserve(mChunks.size() + 1);
+				char* data = static_cast<char*>(::operator new(mNextChunkSize));
+				mChunks.push_back(chunk{ data, mNextChunkSize });
+				mBytesReserved += mNextChunkSize;
+				mNextChunkSize = std::min(mNextChunkSize * 2, mChunkSize * kMaxChunkGrowth);
+			}
+			mCurrent = mChunks[mNextChunk].mData;
+			mEnd = mCurrent + mChunks[mNextChunk].mSize;
+			++mNextChunk;
+		}
+		void* block = mCurrent;
+		mCurrent += blockSize;
+		return block;
+	}
+
+	inline void node_pool::release() noexcept
+	{
+		for (const chunk& c : mChunks) {
+			::operator delete(c.mData);
+		}
+		mChunks.clear();
+		mNextChunk = 0;
+		std::fill(std::begin(mFreeLists), std::end(mFreeLists), nullptr);
+		mCurrent = nullptr;
+		mEnd = nullptr;
+		mNextChunkSize = mChunkSize;
+		mBytesReserved = 0;
+		mBlocksInUse = 0;
+	}
+
+	inline size_t node_pool::blocks_in_use() const
+	{
+		return mBlocksInUse;
+	}
+
+	inline size_t node_pool::bytes_reserved() const
+	{
+		return mBytesReserved;
+	}
+
+
+	template <typename T>
+	pool_allocator<T>::pool_allocator(node_pool* pool) noexcept
+		: mPool(pool)
+	{
+	}
+
+	template <typename T>
+	template <typename U>
+	pool_allocator<T>::pool_allocator(const pool_allocator<U>& src) noexcept
+		: mPool(src.pool())
+	{
+	}
+
+	template <typename T>
+	bool pool_allocator<T>::pooled(size_t n) const
+	{
+		return mPool != nullptr && n != 0 && alignof(T) <= node_pool::kGranularity &&
+			n <= node_pool::kMaxBlockSize / sizeof(T);
+	}
+
+	template <typename T>
+	T* pool_allocator<T>::allocate(size_t n)
+	{
+		if (pooled(n)) {
+			return static_cast<T*>(mPool->allocate(n * sizeof(T)));
+		}
+		return std::allocator<T>().allocate(n);
+	}
+
+	template <typename T>
+	void pool_allocator<T>::deallocate(T* p, size_t n) noexcept
+	{
+		if (pooled(n)) {
+			mPool->deallocate(p, n * sizeof(T));
+		} else {
+			std::allocator<T>().deallocate(p, n);
+		}
+	}
+
+	template <typename T>
+	node_pool* pool_allocator<T>::pool() const noexcept
+	{
+		return mPool;
+	}
+
+	template <typename T, typename U>
+	bool operator==(const pool_allocator<T>& lhs, const pool_allocator<U>& rhs) noexcept
+	{
+		return lhs.pool() == rhs.pool();
+	}
+
+	template <typename T, typename U>
+	bool operator!=(const pool_allocator<T>& lhs, const pool_allocator<U>& rhs) noexcept
+	{
+		return !(lhs == rhs);
+	}
+
+} //namespace util
+
+#endif // POOL_ALLOCATOR_H_
@@ -0,0 +1,66 @@
+// Compares a chaining hash_map with std::allocator and with
+// pool_allocator: the insert throughput while building a map of random
+// keys, and the time to tear it down again. The pool keeps its chunks, so
+// a second map built in it reuses them; giving them back is timed last.
+// Usage: pool_allocator_benchmark [keys]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "hash_map.h"
+#include "pool_allocator.h"
+
+namespace {
+
+using value_type = std::pair<const uint64_t, uint64_t>;
+
+template <typename Map>
+void run(const char* name, const std::vector<uint64_t>& keys, const typename Map::allocator_type& alloc) {
+  using Clock = std::chrono::steady_clock;
+
+  std::optional<Map> map(std::in_place, alloc);
+  auto start = Clock::now();
+  for (size_t i = 0; i < keys.size(); i++) {
+    map->try_emplace(keys[i], i);
+  }
+  double insert = std::chrono::duration<double>(Clock::now() - start).count();
+  size_t size = map->size();
+
+  start = Clock::now();
+  map.reset();
+  double teardown = std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::printf("%-16s insert: %6.2f M/s (%6.1f ns)  teardown: %7.1f ms%s\n", name,
+    keys.size() / insert / 1e6, insert * 1e9 / keys.size(), teardown * 1e3,
+    size == keys.size() ? "" : "  (MISMATCH)");
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  size_t elements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+
+  std::mt19937_64 rng(42);
+  std::vector<uint64_t> keys(elements);
+  for (auto& key : keys) {
+    key = rng();
+  }
+
+  run<util::hash_map<uint64_t, uint64_t>>("std::allocator", keys, std::allocator<value_type>());
+  {
+    util::node_pool pool;
+    using Map = util::hash_map<uint64_t, uint64_t, std::equal_to<>, util::hash<uint64_t>, util::chaining,
+      util::pool_allocator<value_type>>;
+    run<Map>("pool_allocator", keys, util::pool_allocator<value_type>(&pool));
+    run<Map>("pool, refilled", keys, util::pool_allocator<value_type>(&pool));
+    auto start = std::chrono::steady_clock::now();
+    pool.release();
+    double release = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-16s release: %7.1f ms\n", "pool_allocator", release * 1e3);
+  }
+  return 0;
+}
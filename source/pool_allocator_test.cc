@@ -0,0 +1,116 @@
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hash_map.h"
+#include "pool_allocator.h"
+#include "gtest/gtest.h"
+
+TEST(MyNodePool, ReusesFreedBlocks) {
+  util::node_pool pool;
+  void* keep = pool.allocate(24);
+  void* first = pool.allocate(24);
+  pool.deallocate(first, 24);
+  void* second = pool.allocate(20);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(pool.blocks_in_use(), 2u);
+  pool.deallocate(second, 20);
+  pool.deallocate(keep, 24);
+}
+
+TEST(MyNodePool, KeepsChunksUntilReleased) {
+  util::node_pool pool(1024);
+  std::vector<void*> blocks;
+  for (int i = 0; i < 1000; i++) {
+    blocks.push_back(pool.allocate(32));
+  }
+  size_t reserved = pool.bytes_reserved();
+  EXPECT_GE(reserved, 32000u);
+  void* first = blocks[0];
+
+  // Draining and refilling reuses the chunks, carving them in order from
+  // the start again.
+  for (int round = 0; round < 3; round++) {
+    for (void* block : blocks) {
+      pool.deallocate(block, 32);
+    }
+    EXPECT_EQ(pool.blocks_in_use(), 0u);
+    EXPECT_EQ(pool.bytes_reserved(), reserved);
+    for (void*& block : blocks) {
+      block = pool.allocate(32);
+    }
+    EXPECT_EQ(blocks[0], first);
+    EXPECT_EQ(pool.bytes_reserved(), reserved);
+  }
+
+  for (void* block : blocks) {
+    pool.deallocate(block, 32);
+  }
+  pool.release();
+  EXPECT_EQ(pool.blocks_in_use(), 0u);
+  EXPECT_EQ(pool.bytes_reserved(), 0u);
+}
+
+TEST(MyPoolAllocator, WorksWithStandardContainers) {
+  util::node_pool pool;
+  {
+    std::list<int, util::pool_allocator<int>> list{ util::pool_allocator<int>(&pool) };
+    for (int i = 0; i < 100; i++) {
+      list.push_back(i);
+    }
+    EXPECT_EQ(pool.blocks_in_use(), 100u);
+    // Large arrays bypass the pool.
+    std::vector<int, util::pool_allocator<int>> vector(1000, 0, util::pool_allocator<int>(&pool));
+    EXPECT_EQ(pool.blocks_in_use(), 100u);
+  }
+  EXPECT_EQ(pool.blocks_in_use(), 0u);
+  EXPECT_EQ(util::pool_allocator<int>(&pool), util::pool_allocator<double>(&pool));
+  EXPECT_NE(util::pool_allocator<int>(&pool), util::pool_allocator<int>());
+}
+
+TEST(MyPoolAllocator, HashMapChaining) {
+  using value_type = std::pair<const int, std::string>;
+  using Map = util::hash_map<int, std::string, std::equal_to<>, util::hash<int>,
+    util::chaining, util::pool_allocator<value_type>>;
+  util::node_pool pool;
+  {
+    Map map{ util::pool_allocator<value_type>(&pool) };
+    for (int i = 0; i < 1000; i++) {
+      map[i] = std::to_string(i);
+    }
+    EXPECT_GE(pool.blocks_in_use(), 1000u);
+    EXPECT_EQ(map.get_allocator().pool(), &pool);
+
+    // Copies share the pool, so nodes can move between them.
+    Map copy = map;
+    EXPECT_EQ(copy.get_allocator(), map.get_allocator());
+    auto node = copy.extract(5);
+    copy.erase(6);
+    EXPECT_TRUE(map.insert(std::move(node)).position != map.end());
+    EXPECT_EQ(map.size(), 1000u);
+
+    map.clear();
+    copy.clear();
+  }
+  // All nodes went back; the chunks stay until released.
+  EXPECT_EQ(pool.blocks_in_use(), 0u);
+  EXPECT_GT(pool.bytes_reserved(), 0u);
+  pool.release();
+  EXPECT_EQ(pool.bytes_reserved(), 0u);
+}
+
+TEST(MyPoolAllocator, HashMapGroupProbing) {
+  using value_type = std::pair<const int, int>;
+  using Map = util::hash_map<int, int, std::equal_to<>, util::hash<int>,
+    util::group_probing, util::pool_allocator<value_type>>;
+  util::node_pool pool;
+  Map map{ util::pool_allocator<value_type>(&pool) };
+  for (int i = 0; i < 1000; i++) {
+    map[i] = i;
+  }
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_EQ(map[i], i);
+  }
+}
@@ -0,0 +1,633 @@
+#ifndef RCU_HASH_MAP_H_
+#define RCU_HASH_MAP_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "hash_map.h"
+
+namespace util {
+
+	namespace detail {
+
+		// Epoch-based reclamation, shared by every rcu_hash_map in the
+		// process. A reader announces the global epoch in a record of its
+		// own thread while it looks at shared nodes. Writers retire unlinked
+		// nodes tagged with the epoch at that moment, and the epoch only
+		// advances once every active reader has caught up with it. So once
+		// the epoch has moved two steps past a retired node, no reader can
+		// still hold a pointer to it.
+		class epoch_domain
+		{
+		public:
+			// One per thread, each on a cache line of its own, so that
+			// readers on different threads never write to the same line.
+			struct alignas(64) record
+			{
+				// 0 while the thread is outside of any read section,
+				// otherwise the epoch it entered in.
+				std::atomic<uint64_t> mState{ 0 };
+				std::atomic<bool> mInUse{ false };
+				record* mNext = nullptr;
+				// Read sections can nest; only the outermost one counts.
+				unsigned mDepth = 0;
+			};
+
+			static epoch_domain& instance();
+
+			// The record of the calling thread.
+			record& threadRecord();
+
+			void enter(record& r);
+			void exit(record& r);
+
+			uint64_t epoch() const;
+
+			// Moves the epoch one step forward if every active reader has
+			// entered in the current epoch. Returns the epoch afterwards.
+			uint64_t tryAdvance();
+
+		private:
+			epoch_domain() = default;
+
+			// Takes a record left behind by a finished thread, or adds one.
+			record* acquireRecord();
+
+			// Starts at 1, so that 0 can mean "not reading".
+			std::atomic<uint64_t> mEpoch{ 1 };
+			// Records are never freed, so this list only ever grows.
+			std::atomic<record*> mRecords{ nullptr };
+		};
+
+		// Enters a read section for the lifetime of the object.
+		class epoch_guard
+		{
+		public:
+			epoch_guard();
+			~epoch_guard();
+
+			epoch_guard(const epoch_guard& src) = delete;
+			epoch_guard& operator=(const epoch_guard& rhs) = delete;
+
+		private:
+			epoch_domain::record& mRecord;
+		};
+
+	} // namespace detail
+
+	// A concurrent hash map for read-mostly data, in which readers never
+	// lock anything and never write to memory that other threads write to.
+	// Lookups follow atomically published pointers; writers lock the one
+	// bucket they change (through a fixed set of lock stripes) and
+	// replace, never modify, nodes that readers may be looking at.
+	// Unlinked nodes are freed through epoch-based reclamation once no
+	// reader can still see them.
+	//
+	// Since an element may be replaced at any moment, lookups return a
+	// copy of the value, or run a visitor on the current version of it.
+	// Values are therefore immutable in place; insert_or_assign() swaps
+	// in a new element. Growing the table copies every element into a new
+	// bucket array while holding all locks, so it suits tables that mostly
+	// get read.
+	//
+	// Usage:
+	//   util::rcu_hash_map<std::string, int> cache;
+	//   cache.insert({ "answer", 42 });
+	//   std::optional<int> value = cache.find("answer");
+	template <typename Key, typename T,
+		typename KeyEqual = std::equal_to<>,
+		typename Hash = hash<Key>>
+	class rcu_hash_map
+	{
+	public:
+		using key_type = Key;
+		using mapped_type = T;
+		using value_type = std::pair<const Key, T>;
+		using hasher = Hash;
+		using key_equal = KeyEqual;
+		using size_type = size_t;
+
+		// The number of bucket locks. The bucket count is a power of two
+		// and never less than this, so a bucket always maps to one lock.
+		static constexpr size_t kLockStripes = 64;
+
+		explicit rcu_hash_map(size_type numBuckets = kLockStripes, const KeyEqual& equal = KeyEqual(),
+			const Hash& hash = Hash());
+		// No thread may use the map while it is destroyed.
+		~rcu_hash_map();
+
+		rcu_hash_map(const rcu_hash_map& src) = delete;
+		rcu_hash_map& operator=(const rcu_hash_map& rhs) = delete;
+
+		// Lock-free lookups
+		std::optional<mapped_type> find(const key_type& k) const;
+		bool contains(const key_type& k) const;
+		size_type count(const key_type& k) const;
+		// Calls f(const value_type&) on the element with key k, if any.
+		// Returns whether there was one.
+		template <typename F>
+		bool visit(const key_type& k, F f) const;
+
+		// Writers. Returns whether an element was inserted.
+		bool insert(const value_type& x);
+		template <typename M>
+		bool insert_or_assign(const key_type& k, M&& obj);
+		size_type erase(const key_type& k);
+		void clear();
+
+		// The number of elements, as of some recent moment.
+		size_type size() const;
+		bool empty() const;
+		size_type bucket_count() const;
+
+	private:
+		struct node
+		{
+			template <typename... Args>
+			node(size_t hash, Args&&... args);
+
+			const size_t mHash;
+			const value_type mValue;
+			std::atomic<node*> mNext{ nullptr };
+		};
+
+		// A bucket array is published as a whole, so that readers always
+		// see a consistent number of buckets.
+		struct bucket_array
+		{
+			explicit bucket_array(size_t count);
+
+			size_t mMask;
+			std::unique_ptr<std::atomic<node*>[]> mBuckets;
+		};
+
+		// Something unlinked, waiting for readers to move on.
+		struct retired
+		{
+			uint64_t mEpoch;
+			void* mPointer;
+			void (*mDelete)(void*);
+		};
+
+		struct alignas(64) stripe
+		{
+			std::mutex mMutex;
+		};
+
+		// Returns the node with key k in a, or nullptr. A reader must be
+		// inside an epoch_guard, a writer must hold the bucket's lock.
+		node* findNode(const bucket_array& a, size_t hash, const key_type& k) const;
+
+		std::mutex& lockFor(size_t hash);
+
+		// Hands p to epoch-based reclamation. Requires mRetireMutex.
+		template <typename U>
+		void retire(U* p);
+		// Frees whatever no reader can see any more. Requires mRetireMutex.
+		void collect();
+
+		// Doubles the bucket count if the load factor exceeds 1.
+		void growIfNeeded();
+
+		// Retires a bucket array and all of its nodes. Requires all locks.
+		void retireAll(bucket_array* a);
+
+		std::atomic<bucket_array*> mArray;
+		std::atomic<size_type> mSize{ 0 };
+		stripe mStripes[kLockStripes];
+		std::mutex mRetireMutex;
+		std::vector<retired> mRetired;
+		// collect() runs once this many things wait for reclamation.
+		size_t mCollectThreshold = 64;
+		KeyEqual mEqual;
+		Hash mHash;
+	};
+
+
+	namespace detail {
+
+		inline epoch_domain& epoch_domain::instance()
+		{
+			static epoch_domain domain;
+			return domain;
+		}
+
+		inline epoch_domain::record* epoch_domain::acquireRecord()
+		{
+			for (record* r = mRecords.load(std::memory_order_acquire); r != nullptr; r = r->mNext) {
+				bool expected = false;
+				if (!r->mInUse.load(std::memory_order_relaxed) &&
+					r->mInUse.compare_exchange_strong(expected, true)) {
+					return r;
+				}
+			}
+
+			record* r = new record;
+			r->mInUse.store(true, std::memory_order_relaxed);
+			record* head = mRecords.load(std::memory_order_relaxed);
+			do {
+				r->mNext = head;
+			} while (!mRecords.compare_exchange_weak(head, r, std::memory_order_release, std::memory_order_relaxed));
+			return r;
+		}
+
+		inline epoch_domain::record& epoch_domain::threadRecord()
+		{
+			// Hands the record back when the thread exits.
+			struct owner
+			{
+				record* mRecord;
+				~owner()
+				{
+					mRecord->mState.store(0, std::memory_order_release);
+					mRecord->mInUse.store(false, std::memory_order_release);
+				}
+			};
+			static thread_local owner threadOwner{ instance().acquireRecord() };
+			return *threadOwner.mRecord;
+		}
+
+		inline void epoch_domain::enter(record& r)
+		{
+			if (r.mDepth++ == 0) {
+				r.mState.store(mEpoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+				// The announcement must be visible before any shared
+				// pointer is read.
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+			}
+		}
+
+		inline void epoch_domain::exit(record& r)
+		{
+			if (--r.mDepth == 0) {
+				r.mState.store(0, std::memory_order_release);
+			}
+		}
+
+		inline uint64_t epoch_domain::epoch() const
+		{
+			return mEpoch.load(std::memory_order_acquire);
+		}
+
+		inline uint64_t epoch_domain::tryAdvance()
+		{
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			uint64_t current = mEpoch.load(std::memory_order_acquire);
+			for (record* r = mRecords.load(std::memory_order_acquire); r != nullptr; r = r->mNext) {
+				uint64_t state = r->mState.load(std::memory_order_acquire);
+				if (state != 0 && state != current) {
+					return current;
+				}
+			}
+			mEpoch.compare_exchange_strong(current, current + 1);
+			return mEpoch.load(std::memory_order_acquire);
+		}
+
+		inline epoch_guard::epoch_guard()
+			: mRecord(epoch_domain::instance().threadRecord())
+		{
+			epoch_domain::instance().enter(mRecord);
+		}
+
+		inline epoch_guard::~epoch_guard()
+		{
+			epoch_domain::instance().exit(mRecord);
+		}
+
+	} // namespace detail
+
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	template <typename... Args>
+	rcu_hash_map<Key, T, KeyEqual, Hash>::node::node(size_t hash, Args&&... args)
+		: mHash(hash), mValue(std::forward<Args>(args)...)
+	{
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	rcu_hash_map<Key, T, KeyEqual, Hash>::bucket_array::bucket_array(size_t count)
+		: mMask(count - 1), mBuckets(new std::atomic<node*>[count])
+	{
+		for (size_t i = 0; i < count; i++) {
+			mBuckets[i].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	// Round the number of buckets up to a power of two, and to at least
+	// one bucket per lock.
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	rcu_hash_map<Key, T, KeyEqual, Hash>::rcu_hash_map(size_type numBuckets, const KeyEqual& equal, const Hash& hash)
+		: mEqual(equal), mHash(hash)
+	{
+		if (numBuckets == 0) {
+			throw std::invalid_argument("Number of buckets must be positive");
+		}
+		size_type count = kLockStripes;
+		while (count < numBuckets) {
+			count *= 2;
+		}
+		mArray.store(new bucket_array(count), std::memory_order_release);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	rcu_hash_map<Key, T, KeyEqual, Hash>::~rcu_hash_map()
+	{
+		// Nobody is reading any more, so everything can go right away.
+		bucket_array* a = mArray.load(std::memory_order_relaxed);
+		for (size_t i = 0; i <= a->mMask; i++) {
+			node* n = a->mBuckets[i].load(std::memory_order_relaxed);
+			while (n != nullptr) {
+				node* next = n->mNext.load(std::memory_order_relaxed);
+				delete n;
+				n = next;
+			}
+		}
+		delete a;
+		for (auto& r : mRetired) {
+			r.mDelete(r.mPointer);
+		}
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	typename rcu_hash_map<Key, T, KeyEqual, Hash>::node*
+		rcu_hash_map<Key, T, KeyEqual, Hash>::findNode(const bucket_array& a, size_t hash, const key_type& k) const
+	{
+		node* n = a.mBuckets[hash & a.mMask].load(std::memory_order_acquire);
+		while (n != nullptr) {
+			// Compare the stored hashes first; they rule out most nodes
+			// without touching the key.
+			if (n->mHash == hash && mEqual(n->mValue.first, k)) {
+				return n;
+			}
+			n = n->mNext.load(std::memory_order_acquire);
+		}
+		return nullptr;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	std::mutex& rcu_hash_map<Key, T, KeyEqual, Hash>::lockFor(size_t hash)
+	{
+		// The bucket count is a multiple of kLockStripes, so keys in the
+		// same bucket always share a lock, whatever the bucket count.
+		return mStripes[hash & (kLockStripes - 1)].mMutex;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	std::optional<typename rcu_hash_map<Key, T, KeyEqual, Hash>::mapped_type>
+		rcu_hash_map<Key, T, KeyEqual, Hash>::find(const key_type& k) const
+	{
+		std::optional<mapped_type> result;
+		visit(k, [&result](const value_type& element) { result = element.second; });
+		return result;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	bool rcu_hash_map<Key, T, KeyEqual, Hash>::contains(const key_type& k) const
+	{
+		return visit(k, [](const value_type&) {});
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	typename rcu_hash_map<Key, T, KeyEqual, Hash>::size_type
+		rcu_hash_map<Key, T, KeyEqual, Hash>::count(const key_type& k) const
+	{
+		return contains(k) ? 1 : 0;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	template <typename F>
+	bool rcu_hash_map<Key, T, KeyEqual, Hash>::visit(const key_type& k, F f) const
+	{
+		size_t hash = mHash(k);
+		detail::epoch_guard guard;
+		node* n = findNode(*mArray.load(std::memory_order_acquire), hash, k);
+		if (n == nullptr) {
+			return false;
+		}
+		f(n->mValue);
+		return true;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	bool rcu_hash_map<Key, T, KeyEqual, Hash>::insert(const value_type& x)
+	{
+		size_t hash = mHash(x.first);
+		{
+			std::lock_guard<std::mutex> lock(lockFor(hash));
+			// The array can't be swapped while we hold a lock.
+			bucket_array& a = *mArray.load(std::memory_order_acquire);
+			if (findNode(a, hash, x.first) != nullptr) {
+				return false;
+			}
+
+			// Fully build the node before publishing it at the head of the
+			// chain.
+			auto& head = a.mBuckets[hash & a.mMask];
+			node* n = new node(hash, x);
+			n->mNext.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			head.store(n, std::memory_order_release);
+			mSize.fetch_add(1, std::memory_order_relaxed);
+		}
+		growIfNeeded();
+		return true;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	template <typename M>
+	bool rcu_hash_map<Key, T, KeyEqual, Hash>::insert_or_assign(const key_type& k, M&& obj)
+	{
+		size_t hash = mHash(k);
+		node* old = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(lockFor(hash));
+			bucket_array& a = *mArray.load(std::memory_order_acquire);
+			node* n = new node(hash, k, std::forward<M>(obj));
+
+			// Replace the old node in its place in the chain, or push the
+			// new one at the head.
+			std::atomic<node*>* link = &a.mBuckets[hash & a.mMask];
+			for (node* cur = link->load(std::memory_order_relaxed); cur != nullptr;
+				cur = cur->mNext.load(std::memory_order_relaxed)) {
+				if (cur->mHash == hash && mEqual(cur->mValue.first, k)) {
+					old = cur;
+					break;
+				}
+				link = &cur->mNext;
+			}
+			if (old != nullptr) {
+				n->mNext.store(old->mNext.load(std::memory_order_relaxed), std::memory_order_relaxed);
+				link->store(n, std::memory_order_release);
+			} else {
+				auto& head = a.mBuckets[hash & a.mMask];
+				n->mNext.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+				head.store(n, std::memory_order_release);
+				mSize.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		if (old != nullptr) {
+			std::lock_guard<std::mutex> lock(mRetireMutex);
+			retire(old);
+			return false;
+		}
+		growIfNeeded();
+		return true;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	typename rcu_hash_map<Key, T, KeyEqual, Hash>::size_type
+		rcu_hash_map<Key, T, KeyEqual, Hash>::erase(const key_type& k)
+	{
+		size_t hash = mHash(k);
+		node* old = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(lockFor(hash));
+			bucket_array& a = *mArray.load(std::memory_order_acquire);
+			std::atomic<node*>* link = &a.mBuckets[hash & a.mMask];
+			for (node* cur = link->load(std::memory_order_relaxed); cur != nullptr;
+				cur = cur->mNext.load(std::memory_order_relaxed)) {
+				if (cur->mHash == hash && mEqual(cur->mValue.first, k)) {
+					old = cur;
+					break;
+				}
+				link = &cur->mNext;
+			}
+			if (old == nullptr) {
+				return 0;
+			}
+			// Readers standing on the old node can still follow its next
+			// pointer, which stays intact until the node is freed.
+			link->store(old->mNext.load(std::memory_order_relaxed), std::memory_order_release);
+			mSize.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		std::lock_guard<std::mutex> lock(mRetireMutex);
+		retire(old);
+		return 1;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	void rcu_hash_map<Key, T, KeyEqual, Hash>::clear()
+	{
+		std::unique_lock<std::mutex> locks[kLockStripes];
+		for (size_t i = 0; i < kLockStripes; i++) {
+			locks[i] = std::unique_lock<std::mutex>(mStripes[i].mMutex);
+		}
+
+		bucket_array* old = mArray.load(std::memory_order_acquire);
+		mArray.store(new bucket_array(old->mMask + 1), std::memory_order_release);
+		mSize.store(0, std::memory_order_relaxed);
+		retireAll(old);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	void rcu_hash_map<Key, T, KeyEqual, Hash>::growIfNeeded()
+	{
+		if (mSize.load(std::memory_order_relaxed) <= bucket_count()) {
+			return;
+		}
+
+		// Take every lock, in order, so no writer is inside a bucket.
+		std::unique_lock<std::mutex> locks[kLockStripes];
+		for (size_t i = 0; i < kLockStripes; i++) {
+			locks[i] = std::unique_lock<std::mutex>(mStripes[i].mMutex);
+		}
+
+		// Somebody else may have grown the table in the meantime.
+		bucket_array* old = mArray.load(std::memory_order_acquire);
+		if (mSize.load(std::memory_order_relaxed) <= old->mMask + 1) {
+			return;
+		}
+
+		// Readers may still be walking the old chains, so their nodes
+		// can't be relinked; the new array gets copies.
+		bucket_array* grown = new bucket_array((old->mMask + 1) * 2);
+		for (size_t i = 0; i <= old->mMask; i++) {
+			for (node* n = old->mBuckets[i].load(std::memory_order_relaxed); n != nullptr;
+				n = n->mNext.load(std::memory_order_relaxed)) {
+				auto& head = grown->mBuckets[n->mHash & grown->mMask];
+				node* copy = new node(n->mHash, n->mValue);
+				copy->mNext.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+				head.store(copy, std::memory_order_relaxed);
+			}
+		}
+		mArray.store(grown, std::memory_order_release);
+		retireAll(old);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	void rcu_hash_map<Key, T, KeyEqual, Hash>::retireAll(bucket_array* a)
+	{
+		std::lock_guard<std::mutex> lock(mRetireMutex);
+		for (size_t i = 0; i <= a->mMask; i++) {
+			for (node* n = a->mBuckets[i].load(std::memory_order_relaxed); n != nullptr;
+				n = n->mNext.load(std::memory_order_relaxed)) {
+				retire(n);
+			}
+		}
+		retire(a);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	template <typename U>
+	void rcu_hash_map<Key, T, KeyEqual, Hash>::retire(U* p)
+	{
+		mRetired.push_back({ detail::epoch_domain::instance().epoch(), p,
+			[](void* q) { delete static_cast<U*>(q); } });
+
+		// Try to reclaim in batches, so each retirement costs O(1)
+		// amortized.
+		if (mRetired.size() >= mCollectThreshold) {
+			collect();
+			mCollectThreshold = std::max<size_t>(64, mRetired.size() * 2);
+		}
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	void rcu_hash_map<Key, T, KeyEqual, Hash>::collect()
+	{
+		uint64_t epoch = detail::epoch_domain::instance().tryAdvance();
+		auto kept = std::begin(mRetired);
+		for (auto& r : mRetired) {
+			if (r.mEpoch + 2 <= epoch) {
+				r.mDelete(r.mPointer);
+			} else {
+				*kept++ = r;
+			}
+		}
+		mRetired.erase(kept, std::end(mRetired));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	typename rcu_hash_map<Key, T, KeyEqual, Hash>::size_type
+		rcu_hash_map<Key, T, KeyEqual, Hash>::size() const
+	{
+		return mSize.load(std::memory_order_relaxed);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	bool rcu_hash_map<Key, T, KeyEqual, Hash>::empty() const
+	{
+		return size() == 0;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	typename rcu_hash_map<Key, T, KeyEqual, Hash>::size_type
+		rcu_hash_map<Key, T, KeyEqual, Hash>::bucket_count() const
+	{
+		// A writer may swap the array at any moment; the guard keeps it
+		// alive while it is looked at.
+		detail::epoch_guard guard;
+		return mArray.load(std::memory_order_acquire)->mMask + 1;
+	}
+
+} //namespace util
+
+#endif // RCU_HASH_MAP_H_
@@ -0,0 +1,73 @@
+// Compares rcu_hash_map with concurrent_hash_map on a read-mostly mix
+// of 99 finds to 1 insert_or_assign, at doubling thread counts from 1 up
+// to the given maximum. Keys range over twice the number preloaded, so
+// about half of the finds miss.
+// Usage: rcu_hash_map_benchmark [max threads] [keys]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "concurrent_hash_map.h"
+#include "rcu_hash_map.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template <typename Map>
+void run(const char* name, unsigned maxThreads, size_t elements, const std::vector<uint64_t>& keys) {
+  for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+    Map map;
+    for (size_t k = 0; k < elements; k++) {
+      map.insert_or_assign(k * 2, k);
+    }
+    std::vector<std::thread> workers;
+    std::vector<size_t> hits(threads);
+    auto start = Clock::now();
+    for (unsigned t = 0; t < threads; t++) {
+      workers.emplace_back([&, t]() {
+        size_t found = 0;
+        for (size_t i = t; i < keys.size(); i += threads) {
+          if (i % 100 == 0) {
+            map.insert_or_assign(keys[i], i);
+          } else if (map.find(keys[i])) {
+            found++;
+          }
+        }
+        hits[t] = found;
+      });
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    size_t found = 0;
+    for (size_t h : hits) {
+      found += h;
+    }
+    std::printf("%-21s %2u threads: %7.1f Mops/s  (%zu hits)\n", name, threads, keys.size() / elapsed / 1e6, found);
+  }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  unsigned maxThreads = argc > 1 ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10)) : 64;
+  size_t elements = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+  maxThreads = std::max(1u, std::min(maxThreads, 64u));
+
+  std::mt19937_64 rng(42);
+  std::vector<uint64_t> keys(10000000);
+  for (uint64_t& k : keys) {
+    k = rng() % (elements * 2);
+  }
+
+  run<util::concurrent_hash_map<uint64_t, uint64_t>>("concurrent_hash_map", maxThreads, elements, keys);
+  run<util::rcu_hash_map<uint64_t, uint64_t>>("rcu_hash_map", maxThreads, elements, keys);
+  return 0;
+}
@@ -0,0 +1,82 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rcu_hash_map.h"
+#include "gtest/gtest.h"
+
+TEST(MyRcuHashMap, InsertFindErase) {
+  util::rcu_hash_map<std::string, int> map;
+  EXPECT_TRUE(map.insert({ "one", 1 }));
+  EXPECT_FALSE(map.insert({ "one", 2 }));
+  EXPECT_EQ(map.find("one"), 1);
+  EXPECT_FALSE(map.find("two").has_value());
+
+  EXPECT_FALSE(map.insert_or_assign("one", 3));
+  EXPECT_TRUE(map.insert_or_assign("two", 2));
+  EXPECT_EQ(map.find("one"), 3);
+  EXPECT_EQ(map.count("two"), 1u);
+
+  EXPECT_EQ(map.erase("one"), 1u);
+  EXPECT_EQ(map.erase("one"), 0u);
+  EXPECT_FALSE(map.contains("one"));
+  EXPECT_EQ(map.size(), 1u);
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_FALSE(map.contains("two"));
+}
+
+TEST(MyRcuHashMap, Grows) {
+  util::rcu_hash_map<int, int> map;
+  for (int i = 0; i < 10000; i++) {
+    EXPECT_TRUE(map.insert({ i, i * 2 }));
+  }
+  EXPECT_GE(map.bucket_count(), 10000u);
+  for (int i = 0; i < 10000; i++) {
+    EXPECT_EQ(map.find(i), i * 2);
+  }
+}
+
+TEST(MyRcuHashMap, ReadersDuringWrites) {
+  util::rcu_hash_map<int, int> map;
+  // Even keys stay put; odd keys come and go.
+  for (int i = 0; i < 1000; i += 2) {
+    map.insert({ i, i });
+  }
+
+  std::atomic<bool> done(false);
+  std::atomic<int> errors(0);
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back([&]() {
+      while (!done) {
+        for (int i = 0; i < 1000; i++) {
+          auto value = map.find(i);
+          if ((i % 2 == 0 && value != i) || (value.has_value() && *value != i)) {
+            errors++;
+          }
+        }
+      }
+    });
+  }
+
+  for (int round = 0; round < 20; round++) {
+    for (int i = 1; i < 1000; i += 2) {
+      map.insert({ i, i });
+    }
+    for (int i = 0; i < 1000; i += 2) {
+      map.insert_or_assign(i, i);
+    }
+    for (int i = 1; i < 1000; i += 2) {
+      map.erase(i);
+    }
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(errors.load(), 0);
+  EXPECT_EQ(map.size(), 500u);
+}
@@ -0,0 +1,610 @@
+#ifndef STATIC_HASH_MAP_H_
+#define STATIC_HASH_MAP_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "hash_map.h"
+
+namespace util {
+
+	namespace detail {
+
+		// Maps x uniformly onto [0, n) with a multiply instead of a
+		// division. Uses the high bits of x.
+		inline uint64_t fast_range(uint64_t x, uint64_t n)
+		{
+			multiply128(x, n);
+			return n;
+		}
+
+		// An array of unsigned integers packed with a fixed number of bits
+		// each, just enough for the largest of them.
+		class compact_array
+		{
+		public:
+			compact_array() = default;
+			explicit compact_array(const std::vector<uint64_t>& values);
+
+			uint64_t operator[](size_t i) const;
+			size_t size() const;
+			// Bits per value
+			unsigned width() const;
+			size_t bytes() const;
+
+		private:
+			// One spare word, so that reading a value never has to check
+			// whether it straddles the end.
+			std::vector<uint64_t> mWords;
+			size_t mSize = 0;
+			unsigned mWidth = 0;
+			uint64_t mMask = 0;
+		};
+
+		inline compact_array::compact_array(const std::vector<uint64_t>& values)
+			: mSize(values.size())
+		{
+			uint64_t largest = values.empty() ? 0 : *std::max_element(values.begin(), values.end());
+			while (mWidth < 64 && (largest >> mWidth) != 0) {
+				++mWidth;
+			}
+			mMask = mWidth == 64 ? ~uint64_t(0) : (uint64_t(1) << mWidth) - 1;
+			mWords.assign((mSize * mWidth + 63) / 64 + 1, 0);
+			for (size_t i = 0; i < mSize; ++i) {
+				size_t bit = i * mWidth;
+				mWords[bit / 64] |= values[i] << (bit % 64);
+				if (bit % 64 + mWidth > 64) {
+					mWords[bit / 64 + 1] |= values[i] >> (64 - bit % 64);
+				}
+			}
+		}
+
+		inline uint64_t compact_array::operator[](size_t i) const
+		{
+			size_t bit = i * mWidth;
+			size_t shift = bit % 64;
+			uint64_t value = mWords[bit / 64] >> shift;
+			if (shift + mWidth > 64) {
+				value |= mWords[bit / 64 + 1] << (64 - shift);
+			}
+			return value & mMask;
+		}
+
+		inline size_t compact_array::size() const
+		{
+			return mSize;
+		}
+
+		inline unsigned compact_array::width() const
+		{
+			return mWidth;
+		}
+
+		inline size_t compact_array::bytes() const
+		{
+			return mWords.size() * sizeof(uint64_t);
+		}
+
+	} // namespace detail
+
+	// A read-only map over a fixed set of keys, built around a minimal
+	// perfect hash function in the style of PTHash. Every key has a slot
+	// of its own in a dense array of exactly size() elements, so a lookup
+	// is one hash computation, one slot access and one key comparison;
+	// there are no empty buckets and no probing.
+	//
+	// The perfect hash splits the keys over about c * n / log2(n)
+	// buckets and stores one small "pilot" number per bucket, chosen so
+	// that the keys of all buckets land on distinct positions. Pilots are
+	// bit-packed, which comes to about 3 bits per key.
+	//
+	// Lookup works like hash_map's: the same Hash and KeyEqual objects,
+	// the same transparent overloads, and iterators over value_type. The
+	// keys can't change after construction, but mapped values can.
+	//
+	// Usage:
+	//   util::static_hash_map<std::string, int> codes({ { "one", 1 }, { "two", 2 } });
+	//   auto it = codes.find("two");
+	template <typename Key, typename T,
+		typename KeyEqual = std::equal_to<>,
+		typename Hash = hash<Key>>
+	class static_hash_map
+	{
+	public:
+		using key_type = Key;
+		using mapped_type = T;
+		using value_type = std::pair<const Key, T>;
+		using hasher = Hash;
+		using key_equal = KeyEqual;
+		using reference = value_type&;
+		using const_reference = const value_type&;
+		using size_type = size_t;
+		using difference_type = ptrdiff_t;
+		using iterator = typename std::vector<value_type>::iterator;
+		using const_iterator = typename std::vector<value_type>::const_iterator;
+
+	private:
+		// Yields K if both Hash and KeyEqual are transparent, and fails to
+		// substitute otherwise.
+		template <typename K>
+		using transparent_key = std::enable_if_t<
+			detail::is_transparent<Hash>::value && detail::is_transparent<KeyEqual>::value, K>;
+
+	public:
+		// Average keys per bucket is log2(n) / kBucketDensity. Larger
+		// values build faster and take more memory.
+		static constexpr double kBucketDensity = 5.0;
+		// The fraction of positions left over for easier placement; the
+		// overflow is folded back onto [0, size()).
+		static constexpr double kLoadFactor = 0.98;
+
+		static_hash_map(const KeyEqual& equal = KeyEqual(), const Hash& hash = Hash());
+
+		// Builds the map from the elements in [first, last). Throws
+		// invalid_argument if two keys are equal, or if two keys have the
+		// same Hash value.
+		template <typename InputIterator>
+		static_hash_map(InputIterator first, InputIterator last, const KeyEqual& equal = KeyEqual(),
+			const Hash& hash = Hash());
+
+		// Initializer list constructor
+		explicit static_hash_map(std::initializer_list<value_type> il, const KeyEqual& equal = KeyEqual(),
+			const Hash& hash = Hash());
+
+		// Iterator methods. Elements are in slot order.
+		iterator begin();
+		iterator end();
+		const_iterator begin() const;
+		const_iterator end() const;
+		const_iterator cbegin() const;
+		const_iterator cend() const;
+
+		// Size methods
+		bool empty() const;
+		size_type size() const;
+
+		// Access methods for Standard Library conformity
+		key_equal key_eq() const;
+		hasher hash_function() const;
+
+		// Lookup methods
+		iterator find(const key_type& k);
+		const_iterator find(const key_type& k) const;
+		std::pair<iterator, iterator> equal_range(const key_type& k);
+		std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const;
+		size_type count(const key_type& k) const;
+		bool contains(const key_type& k) const;
+		// Throws out_of_range if k is missing.
+		T& at(const key_type& k);
+		const T& at(const key_type& k) const;
+
+		// Heterogeneous lookup, as in hash_map.
+		template <typename K, typename = transparent_key<K>>
+		iterator find(const K& k);
+		template <typename K, typename = transparent_key<K>>
+		const_iterator find(const K& k) const;
+		template <typename K, typename = transparent_key<K>>
+		size_type count(const K& k) const;
+		template <typename K, typename = transparent_key<K>>
+		bool contains(const K& k) const;
+
+		// Bytes taken by the perfect hash function itself: the pilots and
+		// the overflow table, but not the elements.
+		size_type index_bytes() const;
+
+	private:
+		// The hash of a key, mixed with the seed of the current build.
+		uint64_t keyHash(size_t hash) const;
+		size_t bucketOf(uint64_t keyHash) const;
+		// Where a key lands in [0, mTableSize) under a given pilot.
+		size_t positionOf(uint64_t keyHash, uint64_t pilot) const;
+
+		// Returns the slot the key with this hash would be in. Any key
+		// maps to some slot, so the caller still has to compare keys.
+		size_t slotOf(size_t hash) const;
+
+		template <typename K>
+		size_t findSlot(const K& k) const;
+
+		// Builds the hash function and puts the elements in their slots.
+		void build(std::vector<std::pair<Key, T>>&& items);
+
+		// One attempt at choosing pilots for the given key hashes with the
+		// current seed. Returns false if some bucket can't be placed.
+		bool tryBuild(const std::vector<uint64_t>& hashes, std::vector<size_t>& slots);
+
+		std::vector<value_type> mSlots;
+		uint64_t mSeed = 0;
+		size_t mBucketCount = 0;
+		// Keys are skewed towards the first mDenseBuckets buckets, which
+		// are placed first, while there is most room.
+		size_t mDenseBuckets = 0;
+		size_t mTableSize = 0;
+		detail::compact_array mPilots;
+		// The slot of each position past size().
+		detail::compact_array mOverflow;
+		KeyEqual mEqual;
+		Hash mHash;
+	};
+
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	static_hash_map<Key, T, KeyEqual, Hash>::static_hash_map(const KeyEqual& equal, const Hash& hash)
+		: mEqual(equal), mHash(hash)
+	{
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	template <typename InputIterator>
+	static_hash_map<Key, T, KeyEqual, Hash>::static_hash_map(InputIterator first, InputIterator last,
+		const KeyEqual& equal, const Hash& hash)
+		: mEqual(equal), mHash(hash)
+	{
+		std::vector<std::pair<Key, T>> items(first, last);
+		build(std::move(items));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	static_hash_map<Key, T, KeyEqual, Hash>::static_hash_map(std::initializer_list<value_type> il,
+		const KeyEqual& equal, const Hash& hash)
+		: static_hash_map(std::begin(il), std::end(il), equal, hash)
+	{
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	uint64_t static_hash_map<Key, T, KeyEqual, Hash>::keyHash(size_t hash) const
+	{
+		return hash_integer(static_cast<uint64_t>(hash), mSeed);
+	}
+
+	// 60% of the keys go to the first 30% of the buckets. Bucket sizes
+	// then vary more, which makes the small buckets placed last cheap.
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	size_t static_hash_map<Key, T, KeyEqual, Hash>::bucketOf(uint64_t keyHash) const
+	{
+		constexpr uint64_t kDenseShare = static_cast<uint64_t>(0.6 * 4294967296.0);
+		if ((keyHash & 0xffffffff) < kDenseShare) {
+			return static_cast<size_t>(detail::fast_range(keyHash, mDenseBuckets));
+		}
+		return mDenseBuckets + static_cast<size_t>(detail::fast_range(keyHash, mBucketCount - mDenseBuckets));
+	}
+
+	// The bucket is taken from the high bits of keyHash, which keys in a
+	// bucket mostly share, so the multiply moves the low bits up first.
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	size_t static_hash_map<Key, T, KeyEqual, Hash>::positionOf(uint64_t keyHash, uint64_t pilot) const
+	{
+		uint64_t h = (keyHash * 0x9e3779b97f4a7c15ULL) ^ hash_integer(pilot, mSeed);
+		return static_cast<size_t>(detail::fast_range(h, mTableSize));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	size_t static_hash_map<Key, T, KeyEqual, Hash>::slotOf(size_t hash) const
+	{
+		uint64_t h = keyHash(hash);
+		size_t position = positionOf(h, mPilots[bucketOf(h)]);
+		if (position < mSlots.size()) {
+			return position;
+		}
+		return static_cast<size_t>(mOverflow[position - mSlots.size()]);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	template <typename K>
+	size_t static_hash_map<Key, T, KeyEqual, Hash>::findSlot(const K& k) const
+	{
+		if (mSlots.empty()) {
+			return 0;
+		}
+		size_t slot = slotOf(mHash(k));
+		return mEqual(mSlots[slot].first, k) ? slot : mSlots.size();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	void static_hash_map<Key, T, KeyEqual, Hash>::build(std::vector<std::pair<Key, T>>&& items)
+	{
+		size_t n = items.size();
+		if (n == 0) {
+			return;
+		}
+
+		std::vector<size_t> userHashes(n);
+		for (size_t i = 0; i < n; ++i) {
+			userHashes[i] = mHash(items[i].first);
+		}
+
+		// Equal hashes can't be told apart by any perfect hash function.
+		// That happens for equal keys, and (very rarely) for colliding ones.
+		std::vector<size_t> sorted(userHashes);
+		std::sort(sorted.begin(), sorted.end());
+		if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+			throw std::invalid_argument("static_hash_map: duplicate keys or colliding hashes");
+		}
+
+		double log2n = std::max(1.0, std::log2(static_cast<double>(n)));
+		mBucketCount = std::max<size_t>(1, static_cast<size_t>(std::ceil(kBucketDensity * n / log2n)));
+		mDenseBuckets = std::max<size_t>(1, static_cast<size_t>(0.3 * mBucketCount));
+		if (mDenseBuckets >= mBucketCount) {
+			mBucketCount = mDenseBuckets + 1;
+		}
+		// Tiny sets get a few spare positions too, or the last keys
+		// placed would have next to no room.
+		mTableSize = std::max(n + 8, static_cast<size_t>(std::ceil(n / kLoadFactor)));
+
+		// Hashing is a bijection for every seed, so distinct hashes stay
+		// distinct; another seed just gives the pilot search a new chance.
+		std::vector<uint64_t> hashes(n);
+		std::vector<size_t> slots(n);
+		for (mSeed = 0; ; ++mSeed) {
+			for (size_t i = 0; i < n; ++i) {
+				hashes[i] = keyHash(userHashes[i]);
+			}
+			if (tryBuild(hashes, slots)) {
+				break;
+			}
+		}
+
+		// Put the elements in their slots.
+		std::vector<size_t> itemAt(n);
+		for (size_t i = 0; i < n; ++i) {
+			itemAt[slots[i]] = i;
+		}
+		mSlots.reserve(n);
+		for (size_t slot = 0; slot < n; ++slot) {
+			mSlots.emplace_back(std::move(items[itemAt[slot]]));
+		}
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	bool static_hash_map<Key, T, KeyEqual, Hash>::tryBuild(const std::vector<uint64_t>& hashes, std::vector<size_t>& slots)
+	{
+		// Give up on a seed if some bucket needs an absurd pilot.
+		constexpr uint64_t kMaxPilot = uint64_t(1) << 20;
+		size_t n = hashes.size();
+
+		// Group the keys by bucket, with a counting sort.
+		std::vector<size_t> bucketStart(mBucketCount + 1, 0);
+		for (uint64_t h : hashes) {
+			++bucketStart[bucketOf(h) + 1];
+		}
+		for (size_t b = 0; b < mBucketCount; ++b) {
+			bucketStart[b + 1] += bucketStart[b];
+		}
+		std::vector<size_t> keysByBucket(n);
+		{
+			std::vector<size_t> fill(bucketStart.begin(), bucketStart.end() - 1);
+			for (size_t i = 0; i < n; ++i) {
+				keysByBucket[fill[bucketOf(hashes[i])]++] = i;
+			}
+		}
+
+		// Place the largest buckets first.
+		std::vector<size_t> order(mBucketCount);
+		for (size_t b = 0; b < mBucketCount; ++b) {
+			order[b] = b;
+		}
+		auto bucketSize = [&bucketStart](size_t b) { return bucketStart[b + 1] - bucketStart[b]; };
+		std::stable_sort(order.begin(), order.end(),
+			[&bucketSize](size_t a, size_t b) { return bucketSize(a) > bucketSize(b); });
+
+		// For each bucket, find the first pilot that sends all of its
+		// keys to free positions, distinct from each other.
+		std::vector<bool> taken(mTableSize, false);
+		std::vector<uint64_t> pilots(mBucketCount, 0);
+		std::vector<size_t> positions;
+		for (size_t b : order) {
+			size_t count = bucketSize(b);
+			if (count == 0) {
+				break;
+			}
+			const size_t* keys = &keysByBucket[bucketStart[b]];
+			for (uint64_t pilot = 0; ; ++pilot) {
+				if (pilot == kMaxPilot) {
+					return false;
+				}
+				positions.clear();
+				bool fits = true;
+				for (size_t j = 0; j < count && fits; ++j) {
+					size_t position = positionOf(hashes[keys[j]], pilot);
+					fits = !taken[position] &&
+						std::find(positions.begin(), positions.end(), position) == positions.end();
+					positions.push_back(position);
+				}
+				if (fits) {
+					for (size_t j = 0; j < count; ++j) {
+						taken[positions[j]] = true;
+						slots[keys[j]] = positions[j];
+					}
+					pilots[b] = pilot;
+					break;
+				}
+			}
+		}
+
+		// Positions past n are folded onto the free positions below n,
+		// in order.
+		std::vector<uint64_t> overflow(mTableSize - n, 0);
+		size_t freeSlot = 0;
+		for (size_t position = n; position < mTableSize; ++position) {
+			if (taken[position]) {
+				while (taken[freeSlot]) {
+					++freeSlot;
+				}
+				overflow[position - n] = freeSlot++;
+			}
+		}
+		for (size_t i = 0; i < n; ++i) {
+			if (slots[i] >= n) {
+				slots[i] = static_cast<size_t>(overflow[slots[i] - n]);
+			}
+		}
+
+		mPilots = detail::compact_array(pilots);
+		mOverflow = detail::compact_array(overflow);
+		return true;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	typename static_hash_map<Key, T, KeyEqual, Hash>::iterator static_hash_map<Key, T, KeyEqual, Hash>::begin()
+	{
+		return mSlots.begin();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	typename static_hash_map<Key, T, KeyEqual, Hash>::iterator static_hash_map<Key, T, KeyEqual, Hash>::end()
+	{
+		return mSlots.end();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	typename static_hash_map<Key, T, KeyEqual, Hash>::const_iterator static_hash_map<Key, T, KeyEqual, Hash>::begin() const
+	{
+		return mSlots.begin();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	typename static_hash_map<Key, T, KeyEqual, Hash>::const_iterator static_hash_map<Key, T, KeyEqual, Hash>::end() const
+	{
+		return mSlots.end();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	typename static_hash_map<Key, T, KeyEqual, Hash>::const_iterator static_hash_map<Key, T, KeyEqual, Hash>::cbegin() const
+	{
+		return begin();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	typename static_hash_map<Key, T, KeyEqual, Hash>::const_iterator static_hash_map<Key, T, KeyEqual, Hash>::cend() const
+	{
+		return end();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	bool static_hash_map<Key, T, KeyEqual, Hash>::empty() const
+	{
+		return mSlots.empty();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	typename static_hash_map<Key, T, KeyEqual, Hash>::size_type static_hash_map<Key, T, KeyEqual, Hash>::size() const
+	{
+		return mSlots.size();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	typename static_hash_map<Key, T, KeyEqual, Hash>::key_equal static_hash_map<Key, T, KeyEqual, Hash>::key_eq() const
+	{
+		return mEqual;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	typename static_hash_map<Key, T, KeyEqual, Hash>::hasher static_hash_map<Key, T, KeyEqual, Hash>::hash_function() const
+	{
+		return mHash;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	typename static_hash_map<Key, T, KeyEqual, Hash>::iterator static_hash_map<Key, T, KeyEqual, Hash>::find(const key_type& k)
+	{
+		return mSlots.begin() + findSlot(k);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	typename static_hash_map<Key, T, KeyEqual, Hash>::const_iterator static_hash_map<Key, T, KeyEqual, Hash>::find(const key_type& k) const
+	{
+		return mSlots.begin() + findSlot(k);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	std::pair<typename static_hash_map<Key, T, KeyEqual, Hash>::iterator,
+		typename static_hash_map<Key, T, KeyEqual, Hash>::iterator>
+		static_hash_map<Key, T, KeyEqual, Hash>::equal_range(const key_type& k)
+	{
+		// A key is either in its slot or missing.
+		auto it = find(k);
+		return std::make_pair(it, it == end() ? it : std::next(it));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	std::pair<typename static_hash_map<Key, T, KeyEqual, Hash>::const_iterator,
+		typename static_hash_map<Key, T, KeyEqual, Hash>::const_iterator>
+		static_hash_map<Key, T, KeyEqual, Hash>::equal_range(const key_type& k) const
+	{
+		auto it = find(k);
+		return std::make_pair(it, it == end() ? it : std::next(it));
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	typename static_hash_map<Key, T, KeyEqual, Hash>::size_type static_hash_map<Key, T, KeyEqual, Hash>::count(const key_type& k) const
+	{
+		return contains(k) ? 1 : 0;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	bool static_hash_map<Key, T, KeyEqual, Hash>::contains(const key_type& k) const
+	{
+		return findSlot(k) != mSlots.size();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	T& static_hash_map<Key, T, KeyEqual, Hash>::at(const key_type& k)
+	{
+		size_t slot = findSlot(k);
+		if (slot == mSlots.size()) {
+			throw std::out_of_range("static_hash_map::at: key not found");
+		}
+		return mSlots[slot].second;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	const T& static_hash_map<Key, T, KeyEqual, Hash>::at(const key_type& k) const
+	{
+		return const_cast<static_hash_map*>(this)->at(k);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	template <typename K, typename>
+	typename static_hash_map<Key, T, KeyEqual, Hash>::iterator static_hash_map<Key, T, KeyEqual, Hash>::find(const K& k)
+	{
+		return mSlots.begin() + findSlot(k);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	template <typename K, typename>
+	typename static_hash_map<Key, T, KeyEqual, Hash>::const_iterator static_hash_map<Key, T, KeyEqual, Hash>::find(const K& k) const
+	{
+		return mSlots.begin() + findSlot(k);
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	template <typename K, typename>
+	typename static_hash_map<Key, T, KeyEqual, Hash>::size_type static_hash_map<Key, T, KeyEqual, Hash>::count(const K& k) const
+	{
+		return contains(k) ? 1 : 0;
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	template <typename K, typename>
+	bool static_hash_map<Key, T, KeyEqual, Hash>::contains(const K& k) const
+	{
+		return findSlot(k) != mSlots.size();
+	}
+
+	template <typename Key, typename T, typename KeyEqual, typename Hash>
+	typename static_hash_map<Key, T, KeyEqual, Hash>::size_type static_hash_map<Key, T, KeyEqual, Hash>::index_bytes() const
+	{
+		return mPilots.bytes() + mOverflow.bytes();
+	}
+
+} //namespace util
+
+#endif // STATIC_HASH_MAP_H_
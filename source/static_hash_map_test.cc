@@ -0,0 +1,91 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "static_hash_map.h"
+#include "gtest/gtest.h"
+
+TEST(MyStaticHashMap, Lookup) {
+  std::vector<std::pair<int, int>> items;
+  for (int i = 0; i < 10000; i++) {
+    items.emplace_back(i * 7, i);
+  }
+  util::static_hash_map<int, int> map(items.begin(), items.end());
+  EXPECT_EQ(map.size(), 10000u);
+  for (int i = 0; i < 70000; i++) {
+    auto it = map.find(i);
+    if (i % 7 == 0) {
+      ASSERT_NE(it, map.end());
+      EXPECT_EQ(it->first, i);
+      EXPECT_EQ(it->second, i / 7);
+      EXPECT_EQ(map.at(i), i / 7);
+    } else {
+      EXPECT_EQ(it, map.end());
+      EXPECT_THROW(map.at(i), std::out_of_range);
+    }
+    EXPECT_EQ(map.count(i), i % 7 == 0 ? 1u : 0u);
+  }
+
+  // Every element is reachable by iteration, exactly once.
+  long long sum = 0;
+  for (const auto& element : map) {
+    sum += element.second;
+  }
+  EXPECT_EQ(sum, 9999LL * 10000 / 2);
+
+  // Mapped values can be changed in place.
+  map.at(14) = -1;
+  EXPECT_EQ(map.find(14)->second, -1);
+
+  // The index stays small: a few bits per key.
+  EXPECT_LT(map.index_bytes() * 8, map.size() * 6);
+}
+
+TEST(MyStaticHashMap, StringKeys) {
+  util::static_hash_map<std::string, int> map({ { "one", 1 }, { "two", 2 }, { "three", 3 } });
+  EXPECT_EQ(map.size(), 3u);
+  EXPECT_EQ(map.at("two"), 2);
+  EXPECT_TRUE(map.contains(std::string("three")));
+  EXPECT_FALSE(map.contains("four"));
+
+  // Heterogeneous lookup, without building a std::string.
+  std::string_view key("one");
+  auto it = map.find(key);
+  ASSERT_NE(it, map.end());
+  EXPECT_EQ(it->second, 1);
+
+  auto range = map.equal_range("three");
+  EXPECT_EQ(std::distance(range.first, range.second), 1);
+  range = map.equal_range("zero");
+  EXPECT_EQ(range.first, range.second);
+}
+
+TEST(MyStaticHashMap, SmallAndEmpty) {
+  util::static_hash_map<int, int> empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ(empty.find(1), empty.end());
+  EXPECT_FALSE(empty.contains(1));
+
+  std::vector<std::pair<int, int>> none;
+  util::static_hash_map<int, int> built(none.begin(), none.end());
+  EXPECT_EQ(built.begin(), built.end());
+
+  for (int n = 1; n < 64; n++) {
+    std::vector<std::pair<int, int>> items;
+    for (int i = 0; i < n; i++) {
+      items.emplace_back(i, -i);
+    }
+    util::static_hash_map<int, int> map(items.begin(), items.end());
+    ASSERT_EQ(map.size(), static_cast<size_t>(n));
+    for (int i = 0; i < n; i++) {
+      EXPECT_EQ(map.at(i), -i);
+    }
+    EXPECT_FALSE(map.contains(n));
+  }
+}
+
+TEST(MyStaticHashMap, DuplicateKeys) {
+  std::vector<std::pair<int, int>> items = { { 1, 1 }, { 2, 2 }, { 1, 3 } };
+  using Map = util::static_hash_map<int, int>;
+  EXPECT_THROW(Map(items.begin(), items.end()), std::invalid_argument);
+}
@@ -0,0 +1,742 @@
+#ifndef STRING_HASH_MAP_H_
+#define STRING_HASH_MAP_H_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "hash_map.h"
+
+namespace util {
+
+	namespace detail {
+
+		// A string key in 16 bytes. Keys of up to kInlineCapacity
+		// characters are stored in place, zero padded, with their length
+		// in the last byte. Longer keys live in the arena of their map;
+		// the key then holds their offset and length there, and kArenaTag
+		// in the last byte.
+		class alignas(8) packed_string
+		{
+		public:
+			static constexpr size_t kInlineCapacity = 15;
+			static constexpr size_t kMaxLength = UINT32_MAX;
+
+			// Requires k.size() <= kInlineCapacity.
+			static packed_string make_inline(std::string_view k);
+			static packed_string make_arena(uint64_t offset, size_t length);
+
+			bool is_inline() const;
+			size_t size() const;
+			// Requires !is_inline().
+			uint64_t offset() const;
+
+			std::string_view view(const char* arena) const;
+
+			// Compares the representation: for two inline keys, this is
+			// comparing the strings.
+			bool same_bytes(const packed_string& other) const;
+
+		private:
+			static constexpr unsigned char kArenaTag = 0xff;
+
+			char mBytes[16];
+		};
+
+	} // namespace detail
+
+	// A hash map from strings to T that keeps its keys compactly. Short
+	// keys (up to 15 characters) are stored inline in the table slot;
+	// longer ones are appended to one arena owned by the map, and the slot
+	// refers to them by offset. Every key thus costs 16 bytes plus, if it
+	// is long, exactly its characters: no heap block per key, and no
+	// std::string object. Keys are looked up, and handed out, as
+	// std::string_view.
+	//
+	// The table is one of hash_map's storage policies; group_probing, the
+	// default, keeps a slot at 16 bytes plus the mapped value. Hash must
+	// accept a std::string_view.
+	//
+	// Iterators yield pairs of a key view and a reference to the mapped
+	// value, by value. Iterators and key views are invalidated like the
+	// iterators of the policy; key views of long keys are also
+	// invalidated by inserting a long key, which may move the arena.
+	// Erasing a long key leaves its characters in the arena; once that
+	// waste reaches half the arena, the next growth of the arena is
+	// replaced by a compaction.
+	//
+	// Usage:
+	//   util::string_hash_map<int> ids;
+	//   ids["main"] = 1;
+	//   ids.try_emplace("std::chrono::steady_clock", 2);
+	//   int n = ids.at("main");
+	template <typename T, typename Hash = hash<std::string_view>, typename Policy = group_probing,
+		typename Allocator = std::allocator<char>>
+	class string_hash_map
+	{
+	private:
+		struct entry
+		{
+			template <typename... Args>
+			entry(const detail::packed_string& key, Args&&... args);
+
+			detail::packed_string mKey;
+			T mValue;
+		};
+
+		using entry_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<entry>;
+		using table_type = typename Policy::template table<entry, entry_allocator>;
+		using position = typename table_type::position;
+		using arena_type = std::vector<char, typename std::allocator_traits<Allocator>::template rebind_alloc<char>>;
+
+	public:
+		using key_type = std::string_view;
+		using mapped_type = T;
+		using hasher = Hash;
+		using storage_policy = Policy;
+		using allocator_type = Allocator;
+		using size_type = size_t;
+		using difference_type = ptrdiff_t;
+		using value_type = std::pair<std::string_view, T&>;
+		using const_value_type = std::pair<std::string_view, const T&>;
+
+		class iterator;
+		class const_iterator;
+
+		// Throws invalid_argument if the number of buckets is illegal.
+		explicit string_hash_map(size_type numBuckets = 101, const Hash& hash = Hash(),
+			const Allocator& alloc = Allocator());
+
+		// Throws invalid_argument if the number of buckets is illegal.
+		string_hash_map(std::initializer_list<std::pair<std::string_view, T>> il, size_type numBuckets = 101,
+			const Hash& hash = Hash(), const Allocator& alloc = Allocator());
+
+		string_hash_map(const string_hash_map& src) = default;
+		string_hash_map(string_hash_map&& src) noexcept = default;
+		string_hash_map& operator=(const string_hash_map& rhs);
+		string_hash_map& operator=(string_hash_map&& rhs) noexcept;
+
+		// Iterator methods
+		iterator begin();
+		iterator end();
+		const_iterator begin() const;
+		const_iterator end() const;
+		const_iterator cbegin() const;
+		const_iterator cend() const;
+
+		// Size methods
+		bool empty() const;
+		size_type size() const;
+		size_type max_size() const;
+
+		// Element insert methods. Keys are copied into the map only when a
+		// new element is inserted. Throws length_error for keys longer than
+		// 4 GiB.
+		T& operator[](std::string_view k);
+		template <typename... Args>
+		std::pair<iterator, bool> try_emplace(std::string_view k, Args&&... args);
+		template <typename M>
+		std::pair<iterator, bool> insert_or_assign(std::string_view k, M&& obj);
+
+		// Element delete methods
+		size_type erase(std::string_view k);
+		iterator erase(const_iterator position);
+		void clear() noexcept;
+		void swap(string_hash_map& other) noexcept;
+
+		// Lookup methods
+		iterator find(std::string_view k);
+		const_iterator find(std::string_view k) const;
+		bool contains(std::string_view k) const;
+		size_type count(std::string_view k) const;
+		// Throws out_of_range if k is missing.
+		T& at(std::string_view k);
+		const T& at(std::string_view k) const;
+
+		// Hash policy methods, as in hash_map.
+		size_type bucket_count() const;
+		float load_factor() const;
+		float max_load_factor() const;
+		// Throws invalid_argument if ml is not positive.
+		void max_load_factor(float ml);
+		void rehash(size_type n);
+		void reserve(size_type n);
+
+		// The arena: the bytes it holds, including those of erased keys,
+		// and the bytes of erased keys alone. compact() drops the latter,
+		// and invalidates key views of long keys.
+		size_type arena_size() const;
+		size_type arena_waste() const;
+		void compact();
+
+		hasher hash_function() const;
+		allocator_type get_allocator() const;
+
+	private:
+		std::string_view keyOf(const entry& e) const;
+
+		// Returns the position of the element with key k, or the table's
+		// end position.
+		position findPosition(std::string_view k, size_t hash) const;
+
+		// Stores k the way a new element keeps it, appending it to the
+		// arena if it is long.
+		detail::packed_string storeKey(std::string_view k);
+
+		// Returns a function object computing the hash of a stored element.
+		auto elementHasher() const;
+
+		table_type mTable;
+		arena_type mArena;
+		size_type mArenaWaste = 0;
+		Hash mHash;
+	};
+
+	// A forward iterator over the elements of a string_hash_map. It yields
+	// value_type by value, since the pairs aren't stored anywhere.
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	class string_hash_map<T, Hash, Policy, Allocator>::iterator
+	{
+	public:
+		using value_type = typename string_hash_map::value_type;
+		using difference_type = ptrdiff_t;
+		using iterator_category = std::forward_iterator_tag;
+		using reference = value_type;
+
+		// Makes -> work on a pair that only exists as a temporary.
+		struct pointer
+		{
+			value_type mValue;
+			const value_type* operator->() const { return &mValue; }
+		};
+
+		iterator() = default;
+
+		value_type operator*() const
+		{
+			entry& e = mMap->mTable.element(mPosition);
+			return value_type(mMap->keyOf(e), e.mValue);
+		}
+		pointer operator->() const { return pointer{ **this }; }
+
+		iterator& operator++()
+		{
+			mMap->mTable.next(mPosition);
+			return *this;
+		}
+		iterator operator++(int)
+		{
+			iterator old = *this;
+			++*this;
+			return old;
+		}
+
+		bool operator==(const iterator& rhs) const { return mMap == rhs.mMap && mPosition == rhs.mPosition; }
+		bool operator!=(const iterator& rhs) const { return !(*this == rhs); }
+
+	private:
+		friend class string_hash_map;
+
+		iterator(position pos, string_hash_map* map)
+			: mPosition(pos), mMap(map)
+		{
+		}
+
+		position mPosition{};
+		string_hash_map* mMap = nullptr;
+	};
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	class string_hash_map<T, Hash, Policy, Allocator>::const_iterator
+	{
+	public:
+		using value_type = typename string_hash_map::const_value_type;
+		using difference_type = ptrdiff_t;
+		using iterator_category = std::forward_iterator_tag;
+		using reference = value_type;
+
+		struct pointer
+		{
+			value_type mValue;
+			const value_type* operator->() const { return &mValue; }
+		};
+
+		const_iterator() = default;
+		const_iterator(const iterator& it)
+			: mPosition(it.mPosition), mMap(it.mMap)
+		{
+		}
+
+		value_type operator*() const
+		{
+			const entry& e = mMap->mTable.element(mPosition);
+			return value_type(mMap->keyOf(e), e.mValue);
+		}
+		pointer operator->() const { return pointer{ **this }; }
+
+		const_iterator& operator++()
+		{
+			mMap->mTable.next(mPosition);
+			return *this;
+		}
+		const_iterator operator++(int)
+		{
+			const_iterator old = *this;
+			++*this;
+			return old;
+		}
+
+		bool operator==(const const_iterator& rhs) const { return mMap == rhs.mMap && mPosition == rhs.mPosition; }
+		bool operator!=(const const_iterator& rhs) const { return !(*this == rhs); }
+
+	private:
+		friend class string_hash_map;
+
+		const_iterator(position pos, const string_hash_map* map)
+			: mPosition(pos), mMap(map)
+		{
+		}
+
+		position mPosition{};
+		const string_hash_map* mMap = nullptr;
+	};
+
+
+
+
+	namespace detail {
+
+		inline packed_string packed_string::make_inline(std::string_view k)
+		{
+			packed_string s;
+			std::memset(s.mBytes, 0, sizeof(s.mBytes));
+			std::memcpy(s.mBytes, k.data(), k.size());
+			s.mBytes[15] = static_cast<char>(k.size());
+			return s;
+		}
+
+		inline packed_string packed_string::make_arena(uint64_t offset, size_t length)
+		{
+			packed_string s;
+			uint32_t length32 = static_cast<uint32_t>(length);
+			std::memcpy(s.mBytes, &offset, sizeof(offset));
+			std::memcpy(s.mBytes + 8, &length32, sizeof(length32));
+			s.mBytes[12] = s.mBytes[13] = s.mBytes[14] = 0;
+			s.mBytes[15] = static_cast<char>(kArenaTag);
+			return s;
+		}
+
+		inline bool packed_string::is_inline() const
+		{
+			return static_cast<unsigned char>(mBytes[15]) != kArenaTag;
+		}
+
+		inline size_t packed_string::size() const
+		{
+			if (is_inline()) {
+				return static_cast<unsigned char>(mBytes[15]);
+			}
+			uint32_t length;
+			std::memcpy(&length, mBytes + 8, sizeof(length));
+			return length;
+		}
+
+		inline uint64_t packed_string::offset() const
+		{
+			uint64_t offset;
+			std::memcpy(&offset, mBytes, sizeof(offset));
+			return offset;
+		}
+
+		inline std::string_view packed_string::view(const char* arena) const
+		{
+			if (is_inline()) {
+				return std::string_view(mBytes, size());
+			}
+			return std::string_view(arena + offset(), size());
+		}
+
+		inline bool packed_string::same_bytes(const packed_string& other) const
+		{
+			return std::memcmp(mBytes, other.mBytes, sizeof(mBytes)) == 0;
+		}
+
+	} // namespace detail
+
+
+
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	template <typename... Args>
+	string_hash_map<T, Hash, Policy, Allocator>::entry::entry(const detail::packed_string& key, Args&&... args)
+		: mKey(key), mValue(std::forward<Args>(args)...)
+	{
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	string_hash_map<T, Hash, Policy, Allocator>::string_hash_map(size_type numBuckets, const Hash& hash, const Allocator& alloc)
+		: mTable((numBuckets == 0 ? throw std::invalid_argument("Number of buckets must be positive") : numBuckets),
+			entry_allocator(alloc)),
+		mArena(alloc), mHash(hash)
+	{
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	string_hash_map<T, Hash, Policy, Allocator>::string_hash_map(std::initializer_list<std::pair<std::string_view, T>> il, size_type numBuckets,
+		const Hash& hash, const Allocator& alloc)
+		: string_hash_map(numBuckets, hash, alloc)
+	{
+		for (const auto& element : il) {
+			try_emplace(element.first, element.second);
+		}
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	string_hash_map<T, Hash, Policy, Allocator>& string_hash_map<T, Hash, Policy, Allocator>::operator=(const string_hash_map& rhs)
+	{
+		// Copy-and-swap idiom
+		if (this != &rhs) {
+			auto copy = rhs;
+			swap(copy);
+		}
+		return *this;
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	string_hash_map<T, Hash, Policy, Allocator>& string_hash_map<T, Hash, Policy, Allocator>::operator=(string_hash_map&& rhs) noexcept
+	{
+		swap(rhs);
+		return *this;
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	std::string_view string_hash_map<T, Hash, Policy, Allocator>::keyOf(const entry& e) const
+	{
+		return e.mKey.view(mArena.data());
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	auto string_hash_map<T, Hash, Policy, Allocator>::elementHasher() const
+	{
+		return [this](const entry& e) { return mHash(keyOf(e)); };
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::position string_hash_map<T, Hash, Policy, Allocator>::findPosition(std::string_view k, size_t hash) const
+	{
+		if (k.size() <= detail::packed_string::kInlineCapacity) {
+			// Short keys are equal exactly when their packed forms are,
+			// which compares 16 bytes without looking at the lengths.
+			detail::packed_string packed = detail::packed_string::make_inline(k);
+			return mTable.find(hash, [&packed](const entry& e) { return e.mKey.same_bytes(packed); });
+		}
+		return mTable.find(hash, [this, k](const entry& e) {
+			return !e.mKey.is_inline() && e.mKey.size() == k.size()
+				&& std::memcmp(mArena.data() + e.mKey.offset(), k.data(), k.size()) == 0;
+		});
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	detail::packed_string string_hash_map<T, Hash, Policy, Allocator>::storeKey(std::string_view k)
+	{
+		if (k.size() <= detail::packed_string::kInlineCapacity) {
+			return detail::packed_string::make_inline(k);
+		}
+		if (k.size() > detail::packed_string::kMaxLength) {
+			throw std::length_error("Key too long for string_hash_map");
+		}
+		// k may view the arena itself (a part of a long key, say), which
+		// the code below can move.
+		std::less<const char*> before;
+		if (!before(k.data(), mArena.data()) && before(k.data(), mArena.data() + mArena.size())) {
+			std::string copy(k);
+			return storeKey(copy);
+		}
+		// Rather than growing an arena that is half garbage, rewrite it.
+		if (mArena.size() + k.size() > mArena.capacity() && mArenaWaste >= mArena.size() / 2) {
+			compact();
+		}
+		uint64_t offset = mArena.size();
+		mArena.insert(std::end(mArena), std::begin(k), std::end(k));
+		return detail::packed_string::make_arena(offset, k.size());
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::iterator string_hash_map<T, Hash, Policy, Allocator>::begin()
+	{
+		return iterator(mTable.first(), this);
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::iterator string_hash_map<T, Hash, Policy, Allocator>::end()
+	{
+		return iterator(mTable.end(), this);
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::const_iterator string_hash_map<T, Hash, Policy, Allocator>::begin() const
+	{
+		return const_iterator(mTable.first(), this);
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::const_iterator string_hash_map<T, Hash, Policy, Allocator>::end() const
+	{
+		return const_iterator(mTable.end(), this);
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::const_iterator string_hash_map<T, Hash, Policy, Allocator>::cbegin() const
+	{
+		return begin();
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::const_iterator string_hash_map<T, Hash, Policy, Allocator>::cend() const
+	{
+		return end();
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	bool string_hash_map<T, Hash, Policy, Allocator>::empty() const
+	{
+		return mTable.size() == 0;
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::size_type string_hash_map<T, Hash, Policy, Allocator>::size() const
+	{
+		return mTable.size();
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::size_type string_hash_map<T, Hash, Policy, Allocator>::max_size() const
+	{
+		return mTable.max_size();
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	T& string_hash_map<T, Hash, Policy, Allocator>::operator[](std::string_view k)
+	{
+		return mTable.element(try_emplace(k).first.mPosition).mValue;
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	template <typename... Args>
+	std::pair<typename string_hash_map<T, Hash, Policy, Allocator>::iterator, bool> string_hash_map<T, Hash, Policy, Allocator>::try_emplace(std::string_view k, Args&&... args)
+	{
+		size_t hash = mHash(k);
+		position pos = findPosition(k, hash);
+		if (pos != mTable.end()) {
+			return std::make_pair(iterator(pos, this), false);
+		}
+
+		detail::packed_string key = storeKey(k);
+		try {
+			pos = mTable.emplace(hash, elementHasher(), key, std::forward<Args>(args)...);
+		} catch (...) {
+			// The key was appended last; take it back out of the arena.
+			if (!key.is_inline()) {
+				mArena.resize(key.offset());
+			}
+			throw;
+		}
+		return std::make_pair(iterator(pos, this), true);
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	template <typename M>
+	std::pair<typename string_hash_map<T, Hash, Policy, Allocator>::iterator, bool> string_hash_map<T, Hash, Policy, Allocator>::insert_or_assign(std::string_view k, M&& obj)
+	{
+		auto result = try_emplace(k, std::forward<M>(obj));
+		if (!result.second) {
+			mTable.element(result.first.mPosition).mValue = std::forward<M>(obj);
+		}
+		return result;
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::size_type string_hash_map<T, Hash, Policy, Allocator>::erase(std::string_view k)
+	{
+		position pos = findPosition(k, mHash(k));
+		if (pos == mTable.end()) {
+			return 0;
+		}
+		erase(const_iterator(pos, this));
+		return 1;
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::iterator string_hash_map<T, Hash, Policy, Allocator>::erase(const_iterator position)
+	{
+		const detail::packed_string& key = mTable.element(position.mPosition).mKey;
+		if (!key.is_inline()) {
+			mArenaWaste += key.size();
+		}
+		auto next = mTable.erase(position.mPosition);
+		mTable.rehash_step(elementHasher());
+		return iterator(next, this);
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	void string_hash_map<T, Hash, Policy, Allocator>::clear() noexcept
+	{
+		mTable.clear();
+		mArena.clear();
+		mArenaWaste = 0;
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	void string_hash_map<T, Hash, Policy, Allocator>::swap(string_hash_map& other) noexcept
+	{
+		using std::swap;
+
+		mTable.swap(other.mTable);
+		mArena.swap(other.mArena);
+		swap(mArenaWaste, other.mArenaWaste);
+		swap(mHash, other.mHash);
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::iterator string_hash_map<T, Hash, Policy, Allocator>::find(std::string_view k)
+	{
+		return iterator(findPosition(k, mHash(k)), this);
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::const_iterator string_hash_map<T, Hash, Policy, Allocator>::find(std::string_view k) const
+	{
+		return const_iterator(findPosition(k, mHash(k)), this);
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	bool string_hash_map<T, Hash, Policy, Allocator>::contains(std::string_view k) const
+	{
+		return findPosition(k, mHash(k)) != mTable.end();
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::size_type string_hash_map<T, Hash, Policy, Allocator>::count(std::string_view k) const
+	{
+		return contains(k) ? 1 : 0;
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	T& string_hash_map<T, Hash, Policy, Allocator>::at(std::string_view k)
+	{
+		position pos = findPosition(k, mHash(k));
+		if (pos == mTable.end()) {
+			throw std::out_of_range("Key not found");
+		}
+		return mTable.element(pos).mValue;
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	const T& string_hash_map<T, Hash, Policy, Allocator>::at(std::string_view k) const
+	{
+		return const_cast<string_hash_map*>(this)->at(k);
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::size_type string_hash_map<T, Hash, Policy, Allocator>::bucket_count() const
+	{
+		return mTable.bucket_count();
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	float string_hash_map<T, Hash, Policy, Allocator>::load_factor() const
+	{
+		return static_cast<float>(size()) / static_cast<float>(bucket_count());
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	float string_hash_map<T, Hash, Policy, Allocator>::max_load_factor() const
+	{
+		return mTable.max_load_factor();
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	void string_hash_map<T, Hash, Policy, Allocator>::max_load_factor(float ml)
+	{
+		if (!(ml > 0.0f)) {
+			throw std::invalid_argument("Maximum load factor must be positive");
+		}
+		mTable.max_load_factor(ml);
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	void string_hash_map<T, Hash, Policy, Allocator>::rehash(size_type n)
+	{
+		mTable.rehash(n, elementHasher());
+	}
+
+	// Enough buckets for n elements is n / max_load_factor(), rounded up.
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	void string_hash_map<T, Hash, Policy, Allocator>::reserve(size_type n)
+	{
+		rehash(static_cast<size_type>(std::ceil(n / static_cast<double>(max_load_factor()))));
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::size_type string_hash_map<T, Hash, Policy, Allocator>::arena_size() const
+	{
+		return mArena.size();
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::size_type string_hash_map<T, Hash, Policy, Allocator>::arena_waste() const
+	{
+		return mArenaWaste;
+	}
+
+	// Copies the long keys of the live elements into a new arena, and
+	// points their slots at the copies. Elements stay where they are.
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	void string_hash_map<T, Hash, Policy, Allocator>::compact()
+	{
+		arena_type arena(mArena.get_allocator());
+		arena.reserve(mArena.size() - mArenaWaste);
+		for (position pos = mTable.first(); pos != mTable.end(); mTable.next(pos)) {
+			detail::packed_string& key = mTable.element(pos).mKey;
+			if (!key.is_inline()) {
+				uint64_t offset = arena.size();
+				const char* chars = mArena.data() + key.offset();
+				arena.insert(std::end(arena), chars, chars + key.size());
+				key = detail::packed_string::make_arena(offset, key.size());
+			}
+		}
+		mArena.swap(arena);
+		mArenaWaste = 0;
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::hasher string_hash_map<T, Hash, Policy, Allocator>::hash_function() const
+	{
+		return mHash;
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	typename string_hash_map<T, Hash, Policy, Allocator>::allocator_type string_hash_map<T, Hash, Policy, Allocator>::get_allocator() const
+	{
+		return Allocator(mArena.get_allocator());
+	}
+
+	template <typename T, typename Hash, typename Policy, typename Allocator>
+	void swap(string_hash_map<T, Hash, Policy, Allocator>& first, string_hash_map<T, Hash, Policy, Allocator>& second) noexcept
+	{
+		first.swap(second);
+	}
+
+} //namespace util
+
+#endif // STRING_HASH_MAP_H_
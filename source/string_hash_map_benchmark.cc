@@ -0,0 +1,160 @@
+// Compares string_hash_map with hash_map<std::string, T> on generated
+// identifier sets: heap bytes per entry, and the time to build the map
+// and to look up its keys. Usage: string_hash_map_benchmark [keys] [lookups]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hash_map.h"
+#include "string_hash_map.h"
+
+namespace {
+
+// Live heap bytes, counted by the replaced operator new and delete below.
+size_t gLiveBytes = 0;
+
+// Sits in front of every block from the replaced operator new, and keeps
+// the block after it aligned.
+struct alignas(std::max_align_t) block_header {
+  size_t size;
+};
+
+// A plausible identifier: a few syllables, sometimes joined by '_'.
+std::string Identifier(std::mt19937_64& rng) {
+  static const char* const kParts[] = { "get", "set", "id", "count", "max", "buf", "tmp", "node", "len",
+    "index", "value", "size", "ptr", "name", "str", "key", "it", "res", "data", "next" };
+  std::string s;
+  int parts = 1 + static_cast<int>(rng() % 3);
+  for (int i = 0; i < parts; i++) {
+    if (i > 0 && rng() % 2 == 0) {
+      s += '_';
+    }
+    s += kParts[rng() % 20];
+  }
+  s += std::to_string(rng() % 1000);
+  return s;
+}
+
+// A qualified C++ name, typically 25 to 60 characters.
+std::string QualifiedName(std::mt19937_64& rng) {
+  static const char* const kScopes[] = { "std", "util", "detail", "net", "http", "storage", "engine", "io" };
+  std::string s = kScopes[rng() % 8];
+  s += "::";
+  s += kScopes[rng() % 8];
+  s += "::";
+  std::string type = Identifier(rng);
+  type[0] = static_cast<char>(type[0] - 'a' + 'A');
+  s += type;
+  s += "::";
+  s += Identifier(rng);
+  return s;
+}
+
+// Distinct keys, each short with probability shortShare.
+std::vector<std::string> MakeKeys(size_t count, double shortShare) {
+  std::mt19937_64 rng(42);
+  std::bernoulli_distribution isShort(shortShare);
+  util::hash_map<std::string, int> seen;
+  std::vector<std::string> keys;
+  keys.reserve(count);
+  while (keys.size() < count) {
+    std::string key = isShort(rng) ? Identifier(rng) : QualifiedName(rng);
+    if (seen.try_emplace(key, 0).second) {
+      keys.push_back(std::move(key));
+    }
+  }
+  return keys;
+}
+
+template <typename Map>
+void run(const char* name, const std::vector<std::string>& keys, const std::vector<std::string_view>& lookups) {
+  using Clock = std::chrono::steady_clock;
+
+  size_t before = gLiveBytes;
+  auto start = Clock::now();
+  {
+    Map map;
+    for (size_t i = 0; i < keys.size(); i++) {
+      map[std::string_view(keys[i])] = static_cast<int>(i);
+    }
+    auto build = Clock::now() - start;
+    size_t bytes = gLiveBytes - before;
+
+    start = Clock::now();
+    long sum = 0;
+    for (std::string_view key : lookups) {
+      auto it = map.find(key);
+      if (it != map.end()) {
+        sum += it->second;
+      }
+    }
+    auto find = Clock::now() - start;
+
+    auto ns = [](Clock::duration d, size_t n) {
+      return std::chrono::duration<double, std::nano>(d).count() / n;
+    };
+    std::printf("  %-22s %6.1f bytes/entry  build: %6.1f ns/key  find: %6.1f ns/key  (%ld)\n",
+      name, static_cast<double>(bytes) / keys.size(), ns(build, keys.size()), ns(find, lookups.size()), sum);
+  }
+}
+
+void compare(const char* title, size_t count, size_t lookupCount, double shortShare) {
+  std::vector<std::string> keys = MakeKeys(count, shortShare);
+  size_t chars = 0;
+  for (const auto& key : keys) {
+    chars += key.size();
+  }
+  std::printf("%s: %zu keys, %.1f characters on average\n", title, keys.size(),
+    static_cast<double>(chars) / keys.size());
+
+  std::mt19937_64 rng(7);
+  std::vector<std::string_view> lookups(lookupCount);
+  for (auto& key : lookups) {
+    key = keys[rng() % keys.size()];
+  }
+
+  run<util::hash_map<std::string, int>>("hash_map (chaining)", keys, lookups);
+  run<util::hash_map<std::string, int, std::equal_to<>, util::hash<std::string>, util::group_probing>>(
+    "hash_map (group)", keys, lookups);
+  run<util::string_hash_map<int>>("string_hash_map", keys, lookups);
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+  void* block = std::malloc(sizeof(block_header) + size);
+  if (block == nullptr) {
+    throw std::bad_alloc();
+  }
+  block_header* header = new (block) block_header{ size };
+  gLiveBytes += size;
+  return header + 1;
+}
+
+void operator delete(void* p) noexcept {
+  if (p != nullptr) {
+    block_header* header = std::launder(static_cast<block_header*>(p) - 1);
+    gLiveBytes -= header->size;
+    std::free(header);
+  }
+}
+
+void operator delete(void* p, size_t /*size*/) noexcept {
+  operator delete(p);
+}
+
+int main(int argc, char* argv[]) {
+  size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : size_t(1) << 20;
+  size_t lookups = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : size_t(1) << 22;
+
+  compare("Short identifiers", count, lookups, 1.0);
+  compare("Mixed, 1 in 5 qualified", count, lookups, 0.8);
+  compare("Qualified names", count, lookups, 0.0);
+  return 0;
+}
@@ -0,0 +1,158 @@
+#include <map>
+#include <string>
+#include <string_view>
+
+#include "string_hash_map.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+std::string LongKey(int i) {
+  return "com.example.module" + std::to_string(i % 7) + ".Identifier" + std::to_string(i);
+}
+
+}  // namespace
+
+TEST(MyStringHashMap, ShortAndLongKeys) {
+  util::string_hash_map<int> map;
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_TRUE(map.try_emplace("k" + std::to_string(i), i).second);
+    EXPECT_TRUE(map.try_emplace(LongKey(i), -i).second);
+  }
+  EXPECT_FALSE(map.try_emplace("k7", 0).second);
+  EXPECT_FALSE(map.try_emplace(LongKey(7), 0).second);
+  EXPECT_EQ(2000u, map.size());
+
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(i, map.at("k" + std::to_string(i)));
+    ASSERT_EQ(-i, map.at(LongKey(i)));
+  }
+  EXPECT_FALSE(map.contains("k1000"));
+  EXPECT_FALSE(map.contains(LongKey(1000)));
+  EXPECT_THROW(map.at("missing"), std::out_of_range);
+
+  // Only the long keys went to the arena, character for character.
+  size_t longBytes = 0;
+  for (int i = 0; i < 1000; i++) {
+    longBytes += LongKey(i).size();
+  }
+  EXPECT_EQ(longBytes, map.arena_size());
+}
+
+TEST(MyStringHashMap, InlineBoundary) {
+  util::string_hash_map<int> map;
+  std::string key;
+  for (int length = 0; length < 40; length++) {
+    map[key] = length;
+    key += static_cast<char>('a' + length % 26);
+  }
+  // Keys that differ only in the padding of the inline form.
+  map[std::string_view("a\0", 2)] = 100;
+  EXPECT_EQ(41u, map.size());
+  EXPECT_EQ(1, map.at("a"));
+  EXPECT_EQ(100, map.at(std::string_view("a\0", 2)));
+  EXPECT_EQ(0, map.at(""));
+  EXPECT_EQ(15, map.at("abcdefghijklmno"));
+  EXPECT_EQ(16, map.at("abcdefghijklmnop"));
+
+  std::map<std::string, int> seen;
+  for (const auto& element : map) {
+    seen[std::string(element.first)] = element.second;
+  }
+  EXPECT_EQ(41u, seen.size());
+  EXPECT_EQ(16, seen["abcdefghijklmnop"]);
+}
+
+TEST(MyStringHashMap, EraseAndCompact) {
+  util::string_hash_map<int> map;
+  for (int i = 0; i < 1000; i++) {
+    map[LongKey(i)] = i;
+  }
+  size_t full = map.arena_size();
+  for (int i = 0; i < 1000; i += 2) {
+    EXPECT_EQ(1u, map.erase(LongKey(i)));
+  }
+  EXPECT_EQ(0u, map.erase(LongKey(0)));
+  EXPECT_EQ(500u, map.size());
+  EXPECT_EQ(full, map.arena_size());
+  EXPECT_GT(map.arena_waste(), full / 3);
+
+  map.compact();
+  EXPECT_EQ(0u, map.arena_waste());
+  EXPECT_LT(map.arena_size(), full);
+  for (int i = 1; i < 1000; i += 2) {
+    ASSERT_EQ(i, map.at(LongKey(i)));
+  }
+
+  // Churn: the arena is rewritten instead of growing without bound.
+  for (int round = 0; round < 50; round++) {
+    for (int i = 0; i < 100; i++) {
+      map[LongKey(10000 + i)] = i;
+    }
+    for (int i = 0; i < 100; i++) {
+      map.erase(LongKey(10000 + i));
+    }
+  }
+  EXPECT_LT(map.arena_size(), 4 * full);
+  EXPECT_EQ(500u, map.size());
+}
+
+TEST(MyStringHashMap, KeyViewingTheArena) {
+  util::string_hash_map<int> map;
+  map["a.rather.long.key.for.the.arena"] = 1;
+  // A long part of the stored key, inserted as a key of its own. The
+  // insertion may move the arena, so the view is taken afresh each time.
+  map[map.begin()->first.substr(2)] = 2;
+  map[map.find("a.rather.long.key.for.the.arena")->first.substr(0, 20)] = 3;
+  EXPECT_EQ(1, map.at("a.rather.long.key.for.the.arena"));
+  EXPECT_EQ(2, map.at("rather.long.key.for.the.arena"));
+  EXPECT_EQ(3, map.at("a.rather.long.key.fo"));
+}
+
+TEST(MyStringHashMap, CopyMoveAndAssign) {
+  util::string_hash_map<std::string> map{ { "short", "1" }, { "a.much.longer.identifier", "2" } };
+  auto copy = map;
+  map.insert_or_assign("short", "changed");
+  EXPECT_EQ("1", copy.at("short"));
+  EXPECT_EQ("2", copy.at("a.much.longer.identifier"));
+  EXPECT_EQ("changed", map.at("short"));
+
+  util::string_hash_map<std::string> moved(std::move(copy));
+  EXPECT_EQ(2u, moved.size());
+  copy = moved;
+  EXPECT_EQ("2", copy.at("a.much.longer.identifier"));
+
+  copy.clear();
+  EXPECT_TRUE(copy.empty());
+  EXPECT_EQ(0u, copy.arena_size());
+}
+
+TEST(MyStringHashMap, OtherPolicies) {
+  util::string_hash_map<int, util::hash<std::string_view>, util::chaining> chained;
+  util::string_hash_map<int, util::hash<std::string_view>, util::robin_hood> robin;
+  util::string_hash_map<int, util::hash<std::string_view>, util::cached_hash<util::group_probing>> cached;
+  for (int i = 0; i < 3000; i++) {
+    std::string key = i % 2 ? LongKey(i) : std::to_string(i);
+    chained[key] = i;
+    robin[key] = i;
+    cached[key] = i;
+  }
+  for (int i = 0; i < 3000; i += 3) {
+    std::string key = i % 2 ? LongKey(i) : std::to_string(i);
+    chained.erase(key);
+    robin.erase(key);
+    cached.erase(key);
+  }
+  for (int i = 0; i < 3000; i++) {
+    std::string key = i % 2 ? LongKey(i) : std::to_string(i);
+    ASSERT_EQ(i % 3 != 0, chained.contains(key));
+    ASSERT_EQ(i % 3 != 0, robin.contains(key));
+    ASSERT_EQ(i % 3 != 0, cached.contains(key));
+  }
+  size_t count = 0;
+  for (auto it = robin.begin(); it != robin.end(); it = robin.erase(it)) {
+    count++;
+  }
+  EXPECT_EQ(2000u, count);
+  EXPECT_TRUE(robin.empty());
+}